@@ -0,0 +1,81 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+
+#include "../t/runtime/AsyncIo.h"
+
+#if !defined( _WIN32 )
+namespace
+{
+    using namespace t::runtime;
+
+    constexpr size_t FILES = 1000;
+    constexpr size_t FILE_SIZE = 16 << 10;
+
+    struct Files
+    {
+        std::vector< std::string > paths;
+        std::vector< int > fds;
+
+        Files()
+        {
+            const std::string content( FILE_SIZE, 'x' );
+            for ( size_t i = 0; i < FILES; i++ )
+            {
+                paths.push_back( "t_bench_io_" + std::to_string( i ) );
+                std::ofstream( paths.back(), std::ios::binary ) << content;
+                fds.push_back( ::open( paths.back().c_str(), O_RDONLY ) );
+            }
+        }
+
+        ~Files()
+        {
+            for ( size_t i = 0; i < FILES; i++ )
+            {
+                ::close( fds[ i ] );
+                std::remove( paths[ i ].c_str() );
+            }
+        }
+    };
+
+    void readAll( IoBackend& io, const Files& files, std::vector< char >& buffer )
+    {
+        size_t bytes = 0;
+        for ( size_t i = 0; i < FILES; i++ )
+            io.read( files.fds[ i ], buffer.data() + i * FILE_SIZE, FILE_SIZE, 0, [ & ]( const IoResult& r ){ bytes += r.bytes; } );
+        drain( io );
+        bench::doNotOptimize( bytes );
+    }
+}
+
+T_BENCHMARK( async_reads )
+{
+    const Files files;
+    std::vector< char > buffer( FILES * FILE_SIZE );
+    const auto total = FILES * FILE_SIZE;
+
+    bench::report( "1000 reads [blocking pread]", bench::measure( [ & ]{
+        size_t bytes = 0;
+        for ( size_t i = 0; i < FILES; i++ )
+            bytes += ::pread( files.fds[ i ], buffer.data() + i * FILE_SIZE, FILE_SIZE, 0 );
+        bench::doNotOptimize( bytes );
+    } ), total );
+
+    ThreadPoolIo threads;
+    bench::report( "1000 reads [threads]", bench::measure( [ & ]{ readAll( threads, files, buffer ); } ), total );
+
+#if T_RUNTIME_IO_URING
+    try
+    {
+        UringIo uring { 256 };
+        bench::report( "1000 reads [io_uring]", bench::measure( [ & ]{ readAll( uring, files, buffer ); } ), total );
+    }
+    catch ( const std::runtime_error& e )
+    {
+        std::cout << "  io_uring unavailable: " << e.what() << '\n';
+    }
+#endif
+}
+#endif
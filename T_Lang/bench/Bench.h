@@ -0,0 +1,69 @@
+#pragma once
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    struct Case
+    {
+        std::string name;
+        void ( *run )();
+    };
+
+    inline std::vector< Case >& cases()
+    {
+        static std::vector< Case > list;
+        return list;
+    }
+
+    struct Register
+    {
+        Register( const char* name, void ( *run )() ) { cases().push_back( { name, run } ); }
+    };
+
+    // Keeps the compiler from discarding a result that is otherwise unused
+    template< typename T >
+    inline void doNotOptimize( const T& value )
+    {
+#if defined( __GNUC__ ) || defined( __clang__ )
+        asm volatile( "" : : "r"( &value ) : "memory" );
+#else
+        static const void* volatile sink;
+        sink = &value;
+#endif
+    }
+
+    // Calls 'f' in doubling batches until a batch takes at least 100ms and
+    // returns the nanoseconds per call of that batch
+    template< typename F >
+    double measure( F&& f )
+    {
+        using clock = std::chrono::steady_clock;
+        for ( size_t iterations = 1; ; iterations *= 2 )
+        {
+            const auto start = clock::now();
+            for ( size_t i = 0; i < iterations; i++ )
+                f();
+            const std::chrono::duration< double, std::nano > elapsed = clock::now() - start;
+            if ( elapsed.count() >= 1e8 || iterations >= ( size_t( 1 ) << 40 ) )
+                return elapsed.count() / iterations;
+        }
+    }
+
+    inline void report( const std::string& label, double nsPerOp, size_t bytesPerOp = 0 )
+    {
+        std::cout << "  " << std::left << std::setw( 44 ) << label << std::right << std::setw( 12 ) << std::fixed << std::setprecision( 2 ) << nsPerOp << " ns/op";
+        if ( bytesPerOp )
+            std::cout << std::setw( 10 ) << bytesPerOp / nsPerOp << " GB/s";
+        std::cout << '\n';
+    }
+}
+
+#define T_BENCHMARK( fn ) \
+    static void fn(); \
+    static const ::bench::Register fn##_registration( #fn, fn ); \
+    static void fn()
@@ -0,0 +1,50 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include "../t/runtime/File.h"
+
+namespace
+{
+    using namespace t::runtime;
+
+    // A 64MB log file that is written once and shared by every case
+    const std::string& logFile()
+    {
+        static const std::string path = []{
+            const std::string path = "t_bench_log.txt";
+            std::ofstream out { path, std::ios::binary };
+            const std::string line = "2024-01-01T00:00:00Z INFO request handled in 12ms path=/api/v1/items status=200\n";
+            for ( size_t written = 0; written < ( 64u << 20 ); written += line.size() )
+                out << line;
+            return path;
+        }();
+        return path;
+    }
+}
+
+T_BENCHMARK( file_lines )
+{
+    const auto& path = logFile();
+    const MappedFile probe { path };
+    const auto bytes = probe.size();
+
+    bench::report( "count lines [std::getline]", bench::measure( [ & ]{
+        std::ifstream in { path, std::ios::binary };
+        size_t n = 0;
+        for ( std::string line; std::getline( in, line ); )
+            n++;
+        bench::doNotOptimize( n );
+    } ), bytes );
+
+    bench::report( "count lines [MappedFile::lines]", bench::measure( [ & ]{
+        const MappedFile file { path };
+        size_t n = 0;
+        for ( const auto& line : file.lines() )
+            n += !line.empty();
+        bench::doNotOptimize( n );
+    } ), bytes );
+
+    std::remove( path.c_str() );
+}
@@ -0,0 +1,63 @@
+#include "Bench.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+
+#include "../t/runtime/Format.h"
+
+namespace
+{
+    using namespace t::runtime;
+
+    constexpr size_t LINES = 10000;
+
+    int openNull()
+    {
+#if defined( _WIN32 )
+        return _open( "NUL", _O_WRONLY );
+#else
+        return ::open( "/dev/null", O_WRONLY );
+#endif
+    }
+}
+
+T_BENCHMARK( format_report )
+{
+    // Every variant writes the same 10000 report lines to the null device
+    const auto line = format( "row {} value {} ok {}\n", uint64_t( 123456 ), 3.14159, true );
+    const auto bytes = LINES * line.size();
+
+    OutputBuffer buffer { openNull() };
+    bench::report( "print [OutputBuffer]", bench::measure( [ & ]{
+        for ( size_t i = 0; i < LINES; i++ )
+            print( buffer, "row {} value {} ok {}\n", uint64_t( 123456 + i ), 3.14159 + double( i ), true );
+        buffer.flush();
+    } ), bytes );
+
+    FILE* file = std::fopen( "/dev/null", "w" );
+    if ( file )
+    {
+        bench::report( "fprintf", bench::measure( [ & ]{
+            for ( size_t i = 0; i < LINES; i++ )
+                std::fprintf( file, "row %llu value %.17g ok %s\n", static_cast< unsigned long long >( 123456 + i ), 3.14159 + double( i ), "true" );
+            std::fflush( file );
+        } ), bytes );
+        std::fclose( file );
+    }
+
+    std::ofstream stream { "/dev/null" };
+    stream << std::boolalpha;
+    stream.precision( 17 );
+    bench::report( "std::ostream", bench::measure( [ & ]{
+        for ( size_t i = 0; i < LINES; i++ )
+            stream << "row " << 123456 + i << " value " << 3.14159 + double( i ) << " ok " << true << '\n';
+        stream.flush();
+    } ), bytes );
+
+    bench::report( "raw write of preformatted lines", bench::measure( [ & ]{
+        for ( size_t i = 0; i < LINES; i++ )
+            buffer.write( line.data(), line.size() );
+        buffer.flush();
+    } ), bytes );
+}
@@ -0,0 +1,107 @@
+#include "Bench.h"
+
+#include "../t/runtime/Json.h"
+
+namespace
+{
+    using namespace t::runtime;
+
+    constexpr size_t RECORDS = 100000;
+
+    // About 13MB of objects like a typical API dump, with nested objects,
+    // arrays, escapes and non-ASCII text
+    std::string makeDocument()
+    {
+        json::Writer w;
+        w.beginArray();
+        for ( size_t i = 0; i < RECORDS; i++ )
+        {
+            w.beginObject();
+            w.key( "id" ).value( uint64_t( 1000000 + i ) );
+            w.key( "name" ).value( "user " + std::to_string( i ) );
+            w.key( "score" ).value( double( i ) * 0.37 );
+            w.key( "active" ).value( i % 3 == 0 );
+            w.key( "bio" ).value( "Likes \"quotes\", tabs\tand caf\xC3\xA9s \xE2\x80\x94 line " + std::to_string( i ) );
+            w.key( "location" ).beginObject().key( "city" ).value( "Z\xC3\xBCrich" ).key( "zip" ).value( uint32_t( 8000 + i % 100 ) ).endObject();
+            w.key( "tags" ).beginArray().value( "a" ).value( "bb" ).value( "ccc" ).endArray();
+            w.endObject();
+        }
+        w.endArray();
+        return std::string( w.finish().view() );
+    }
+
+    serial::Schema userSchema()
+    {
+        serial::Schema schema;
+        schema.name = "User";
+        schema.fields = {
+            { "id", serial::FieldKind::UInt64, 0 },
+            { "name", serial::FieldKind::String, 0 },
+            { "score", serial::FieldKind::Double, 0 },
+            { "active", serial::FieldKind::Bool, 0 },
+            { "location.city", serial::FieldKind::String, 0 },
+            { "location.zip", serial::FieldKind::UInt32, 0 },
+        };
+        schema.layout();
+        return schema;
+    }
+}
+
+T_BENCHMARK( json_parse )
+{
+    const String text { makeDocument() };
+    std::cout << "  using " << json::kernels().name << ", " << text.size() / 1024 << "KB\n";
+
+    json::StructuralIndex index;
+    bench::report( "structural index", bench::measure( [ & ]{
+        index.build( text.view() );
+        bench::doNotOptimize( index.size() );
+    } ), text.size() );
+
+    bench::report( "parse [new Document]", bench::measure( [ & ]{
+        json::Document doc { text };
+        bench::doNotOptimize( doc.root().size() );
+    } ), text.size() );
+
+    json::Parser parser;
+    bench::report( "parse [reused Parser]", bench::measure( [ & ]{
+        bench::doNotOptimize( parser.parse( text ).root().size() );
+    } ), text.size() );
+
+    const json::Document doc { text };
+    bench::report( "read every field", bench::measure( [ & ]{
+        uint64_t sum = 0;
+        for ( const auto user : doc.root().elements() )
+        {
+            sum += user[ "id" ].asUInt64() + uint64_t( user[ "score" ].asDouble() ) + user[ "active" ].asBool();
+            sum += user[ "name" ].asString().size() + user[ "bio" ].asString().size() + user[ "location" ][ "city" ].asString().size();
+        }
+        bench::doNotOptimize( sum );
+    } ), text.size() );
+
+    const auto schema = userSchema();
+    json::RecordBinder binder { schema };
+    bench::report( "bind to records", bench::measure( [ & ]{
+        size_t bytes = 0;
+        for ( const auto user : doc.root().elements() )
+            bytes += binder.bind( user ).size();
+        bench::doNotOptimize( bytes );
+    } ), text.size() );
+}
+
+T_BENCHMARK( json_write )
+{
+    const String text { makeDocument() };
+    const json::Document doc { text };
+
+    bench::report( "write parsed document", bench::measure( [ & ]{
+        json::Writer w;
+        w.reserve( text.size() );
+        w.value( doc.root() );
+        bench::doNotOptimize( w.finish().size() );
+    } ), text.size() );
+
+    bench::report( "write from values", bench::measure( [ & ]{
+        bench::doNotOptimize( makeDocument().size() );
+    } ), text.size() );
+}
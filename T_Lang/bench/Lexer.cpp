@@ -0,0 +1,93 @@
+#include "Bench.h"
+
+#include "../t/CodeGen.h"
+#include "../t/Formatter.h"
+#include "../t/Parser.h"
+
+namespace
+{
+    // A few hundred KB of typical source: classes, functions, comments,
+    // literals and some non-ASCII identifiers
+    std::string makeSource()
+    {
+        std::string src;
+        for ( size_t i = 0; src.size() < 512 * 1024; i++ )
+        {
+            const auto n = std::to_string( i );
+            src += "// Shape number " + n + "\n";
+            src += "class Shape" + n + "\n{\npublic:\n    Shape" + n + " constructor() {}\n";
+            src += "    double area() { return width * height * 0.5 + " + n + "; }\n";
+            src += "    String name() { return \"shape " + n + "\"; }\nprivate:\n    mutable int32 width;\n    mutable int32 height;\n}\n";
+            src += "int64 gr\xC3\xB6\xC3\x9F" "e" + n + "( Shape" + n + "~ s, int64 x )\n{\n    if ( x != -1 ) { return x ** 2; }\n    return s.area() + x;\n}\n";
+            src += "mutable Shape" + n + " shape" + n + ";\nint64 size" + n + " = gr\xC3\xB6\xC3\x9F" "e" + n + "( shape" + n + ", " + n + " );\n\n";
+        }
+        return src;
+    }
+}
+
+T_BENCHMARK( lexer_tokenize )
+{
+    const auto src = makeSource();
+    size_t tokens = 0;
+    bench::report( "tokenize", bench::measure( [ & ]{
+        t::Lexer lexer { src };
+        tokens = lexer.tokenize().size();
+        bench::doNotOptimize( tokens );
+    } ), src.size() );
+    bench::report( "tokenize with trivia", bench::measure( [ & ]{
+        t::lexer::Trivia trivia;
+        t::Lexer lexer { src };
+        bench::doNotOptimize( lexer.tokenize( trivia ).size() + trivia.size() );
+    } ), src.size() );
+    std::cout << "  " << tokens << " tokens\n";
+}
+
+T_BENCHMARK( parser_produce_ast )
+{
+    const auto src = makeSource();
+    const auto tokens = t::Lexer( src ).tokenize();
+    bench::report( "produceAST", bench::measure( [ & ]{
+        auto program = t::Parser( tokens ).produceAST();
+        bench::doNotOptimize( program.getBody().size() );
+    } ), src.size() );
+
+    for ( const size_t threads : { 2, 4, 8 } )
+    {
+        if ( threads > std::thread::hardware_concurrency() )
+            break;
+        t::ThreadPool pool { threads };
+        bench::report( "produceAST [" + std::to_string( threads ) + " threads]", bench::measure( [ & ]{
+            auto program = t::Parser( tokens ).produceAST( pool );
+            bench::doNotOptimize( program.getBody().size() );
+        } ), src.size() );
+    }
+}
+
+T_BENCHMARK( codegen_generate )
+{
+    const auto src = makeSource();
+    auto program = t::Parser( t::Lexer( src ).tokenize() ).produceAST();
+    bench::report( "generate", bench::measure( [ & ]{
+        bench::doNotOptimize( t::codegen::CppGenerator( program ).generate().size() );
+    } ), src.size() );
+
+    for ( const size_t threads : { 2, 4, 8 } )
+    {
+        if ( threads > std::thread::hardware_concurrency() )
+            break;
+        t::ThreadPool pool { threads };
+        bench::report( "generate [" + std::to_string( threads ) + " threads]", bench::measure( [ & ]{
+            bench::doNotOptimize( t::codegen::CppGenerator( program ).generate( pool ).size() );
+        } ), src.size() );
+    }
+}
+
+T_BENCHMARK( formatter_run )
+{
+    const auto src = makeSource();
+    t::lexer::Trivia trivia;
+    const auto tokens = t::Lexer( src ).tokenize( trivia );
+    bench::report( "format", bench::measure( [ & ]{
+        bench::doNotOptimize( t::format::Formatter( tokens, trivia ).run().size() );
+    } ), src.size() );
+}
@@ -0,0 +1,134 @@
+#include "Bench.h"
+
+#include <cstring>
+
+#include "../t/runtime/Serial.h"
+
+namespace
+{
+    using namespace t::runtime;
+    using serial::FieldKind;
+
+    constexpr size_t RECORDS = 100000;
+
+    // What the compiler derives for
+    //     class Person { String name; uint32 age; double score; bool active; String email; }
+    serial::Schema personSchema()
+    {
+        serial::Schema schema;
+        schema.name = "Person";
+        schema.fields = {
+            { "name", FieldKind::String, 0 },
+            { "age", FieldKind::UInt32, 0 },
+            { "score", FieldKind::Double, 0 },
+            { "active", FieldKind::Bool, 0 },
+            { "email", FieldKind::String, 0 },
+        };
+        schema.layout();
+        return schema;
+    }
+
+    struct Person
+    {
+        std::string name;
+        uint32_t age;
+        double score;
+        bool active;
+        std::string email;
+    };
+
+    // The usual hand written encoder: length prefixed strings, fields in order
+    void encodeByHand( const Person& p, std::string& out )
+    {
+        const auto put = [ & ]( const void* data, size_t len ){ out.append( static_cast< const char* >( data ), len ); };
+        const auto putString = [ & ]( const std::string& s ){
+            const auto len = static_cast< uint32_t >( s.size() );
+            put( &len, 4 );
+            put( s.data(), s.size() );
+        };
+        putString( p.name );
+        put( &p.age, 4 );
+        put( &p.score, 8 );
+        put( &p.active, 1 );
+        putString( p.email );
+    }
+
+    Person decodeByHand( const char*& at )
+    {
+        Person p;
+        const auto getString = [ & ]( std::string& s ){
+            uint32_t len;
+            std::memcpy( &len, at, 4 );
+            s.assign( at + 4, len );
+            at += 4 + len;
+        };
+        getString( p.name );
+        std::memcpy( &p.age, at, 4 );
+        std::memcpy( &p.score, at + 4, 8 );
+        std::memcpy( &p.active, at + 12, 1 );
+        at += 13;
+        getString( p.email );
+        return p;
+    }
+}
+
+T_BENCHMARK( serial_records )
+{
+    std::vector< Person > people;
+    people.reserve( RECORDS );
+    for ( size_t i = 0; i < RECORDS; i++ )
+        people.push_back( { "person number " + std::to_string( i ), uint32_t( i % 90 ), double( i ) * 0.5, i % 3 == 0, "user" + std::to_string( i ) + "@example.com" } );
+
+    const auto schema = personSchema();
+    const auto name = schema.indexOf( "name" ), age = schema.indexOf( "age" ), score = schema.indexOf( "score" ),
+        active = schema.indexOf( "active" ), email = schema.indexOf( "email" );
+
+    std::string generated;
+    std::vector< std::pair< size_t, size_t > > records;
+    serial::RecordWriter writer { schema };
+    const auto encode = [ & ]{
+        generated.clear();
+        records.clear();
+        for ( const auto& p : people )
+        {
+            writer.reset();
+            const auto record = writer.setString( name, p.name ).set( age, p.age ).set( score, p.score )
+                .set( active, p.active ).setString( email, p.email ).finish();
+            records.emplace_back( generated.size(), record.size() );
+            generated.append( record.data(), record.size() );
+        }
+    };
+    encode();
+    bench::report( "encode [RecordWriter]", bench::measure( encode ), generated.size() );
+
+    std::string byHand;
+    const auto encodeAll = [ & ]{
+        byHand.clear();
+        for ( const auto& p : people )
+            encodeByHand( p, byHand );
+    };
+    encodeAll();
+    bench::report( "encode [by hand]", bench::measure( encodeAll ), byHand.size() );
+
+    // Reading touches every field so neither side can skip work
+    uint64_t sink = 0;
+    bench::report( "decode [RecordView, zero copy]", bench::measure( [ & ]{
+        for ( const auto& [ offset, len ] : records )
+        {
+            const serial::RecordView view { schema, std::string_view( generated ).substr( offset, len ) };
+            sink += view.getString( name ).size() + view.get< uint32_t >( age ) + uint64_t( view.get< double >( score ) ) +
+                view.get< bool >( active ) + view.getString( email ).size();
+        }
+    } ), generated.size() );
+
+    bench::report( "decode [by hand, copying]", bench::measure( [ & ]{
+        const char* at = byHand.data();
+        const char* end = at + byHand.size();
+        while ( at < end )
+        {
+            const auto p = decodeByHand( at );
+            sink += p.name.size() + p.age + uint64_t( p.score ) + p.active + p.email.size();
+        }
+    } ), byHand.size() );
+    bench::doNotOptimize( sink );
+}
@@ -0,0 +1,41 @@
+#include "Bench.h"
+
+#include "../t/runtime/StringBuilder.h"
+
+namespace
+{
+    using namespace t::runtime;
+
+    // What `a + b` does without fusion: a fresh String per operator
+    String plus( const String& a, const String& b ) { return concat( a, b ); }
+}
+
+T_BENCHMARK( string_concat_chain )
+{
+    const String a { "first name " }, b { "middle " }, c { "last name, " }, d { "suffix" };
+    const size_t bytes = a.size() + b.size() + c.size() + d.size();
+    bench::report( "a + b + c + d [pairwise]", bench::measure( [ & ]{ bench::doNotOptimize( plus( plus( plus( a, b ), c ), d ) ); } ), bytes );
+    bench::report( "a + b + c + d [fused]", bench::measure( [ & ]{ bench::doNotOptimize( concat( a, b, c, d ) ); } ), bytes );
+}
+
+T_BENCHMARK( string_concat_loop )
+{
+    const String piece { "line of report text\n" };
+    for ( const size_t count : { 100, 10000 } )
+    {
+        const auto label = std::to_string( count ) + " appends";
+        const auto bytes = count * piece.size();
+        bench::report( label + " [s = s + piece]", bench::measure( [ & ]{
+            String s;
+            for ( size_t i = 0; i < count; i++ )
+                s = plus( s, piece );
+            bench::doNotOptimize( s );
+        } ), bytes );
+        bench::report( label + " [StringBuilder]", bench::measure( [ & ]{
+            StringBuilder builder;
+            for ( size_t i = 0; i < count; i++ )
+                builder.append( piece );
+            bench::doNotOptimize( builder.build() );
+        } ), bytes );
+    }
+}
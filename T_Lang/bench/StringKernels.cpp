@@ -0,0 +1,90 @@
+#include "Bench.h"
+
+#include "../t/runtime/StringKernels.h"
+
+namespace
+{
+    using namespace t::runtime;
+
+    bool naiveEquals( std::string_view a, std::string_view b )
+    {
+        if ( a.size() != b.size() )
+            return false;
+        for ( size_t i = 0; i < a.size(); i++ )
+            if ( a[ i ] != b[ i ] )
+                return false;
+        return true;
+    }
+
+    size_t naiveFind( std::string_view hay, std::string_view needle )
+    {
+        for ( size_t i = 0; i + needle.size() <= hay.size(); i++ )
+        {
+            size_t j = 0;
+            while ( j < needle.size() && hay[ i + j ] == needle[ j ] )
+                j++;
+            if ( j == needle.size() )
+                return i;
+        }
+        return strings::npos;
+    }
+
+    // Text without the needle except at the very end, so every search scans it all
+    std::string haystack( size_t len, std::string_view needle )
+    {
+        std::string s;
+        s.reserve( len );
+        const char alphabet[] = "the quick brown fox jumps over a lazy dog ";
+        for ( size_t i = 0; s.size() + needle.size() < len; i++ )
+            s += alphabet[ i % ( sizeof( alphabet ) - 1 ) ];
+        s += needle;
+        return s;
+    }
+
+    template< typename F >
+    void eachTier( const std::string& label, size_t bytes, F&& f )
+    {
+        for ( const auto tier : { strings::Scalar, strings::SSE42, strings::AVX2 } )
+        {
+            if ( ( tier == strings::SSE42 && !cpuFeatures().sse42 ) || ( tier == strings::AVX2 && !cpuFeatures().avx2 ) )
+                continue;
+            strings::useTier( tier );
+            bench::report( label + " [" + strings::activeKernels()->name + "]", bench::measure( f ), bytes );
+        }
+        strings::useTier( strings::bestTier() );
+    }
+}
+
+T_BENCHMARK( string_equals )
+{
+    for ( const size_t len : { 16, 4096, 1 << 20 } )
+    {
+        const std::string a( len, 'x' );
+        const std::string b( len, 'x' );
+        const auto label = "equals " + std::to_string( len ) + "B";
+        bench::report( label + " [naive]", bench::measure( [ & ]{ bench::doNotOptimize( naiveEquals( a, b ) ); } ), len );
+        eachTier( label, len, [ & ]{ bench::doNotOptimize( strings::equals( a, b ) ); } );
+    }
+}
+
+T_BENCHMARK( string_find )
+{
+    for ( const std::string_view needle : { "zq", "zebra!", "a much longer needle that is not there!" } )
+    {
+        for ( const size_t len : { 24, 4096, 1 << 20 } )
+        {
+            const auto hay = haystack( len, needle );
+            const auto label = "find " + std::to_string( needle.size() ) + "B needle in " + std::to_string( len ) + "B";
+            bench::report( label + " [naive]", bench::measure( [ & ]{ bench::doNotOptimize( naiveFind( hay, needle ) ); } ), len );
+            eachTier( label, len, [ & ]{ bench::doNotOptimize( strings::find( hay, needle ) ); } );
+        }
+    }
+}
+
+T_BENCHMARK( string_split )
+{
+    std::string csv;
+    while ( csv.size() < ( 1 << 20 ) )
+        csv += "field,another field,3.14159,,last\n";
+    eachTier( "split 1MB on ','", csv.size(), [ & ]{ bench::doNotOptimize( strings::split( csv, ',' ) ); } );
+}
@@ -0,0 +1,44 @@
+#include "Bench.h"
+
+#include "../t/runtime/String.h"
+
+namespace
+{
+    using namespace t::runtime;
+
+    std::string text( size_t len, bool ascii )
+    {
+        const char* pieces[] = { "plain ascii words ", "caf\xC3\xA9 ", "\xE2\x82\xAC" "5 ", "\xF0\x9F\x98\x80 ", "\xCE\xB1\xCE\xB2\xCE\xB3 " };
+        std::string s;
+        for ( size_t i = 0; s.size() < len; i++ )
+            s += pieces[ ascii ? 0 : i % 5 ];
+        return s;
+    }
+
+    template< typename F >
+    void eachTier( const std::string& label, size_t bytes, F&& f )
+    {
+        bench::report( label + " [scalar]", bench::measure( [ & ]{ f( utf8::scalar::validate ); } ), bytes );
+#if T_RUNTIME_X86
+        if ( cpuFeatures().sse42 )
+            bench::report( label + " [sse4.2]", bench::measure( [ & ]{ f( utf8::sse::validate ); } ), bytes );
+        if ( cpuFeatures().avx2 )
+            bench::report( label + " [avx2]", bench::measure( [ & ]{ f( utf8::avx2::validate ); } ), bytes );
+#endif
+    }
+}
+
+T_BENCHMARK( utf8_validate )
+{
+    for ( const bool ascii : { true, false } )
+    {
+        const auto s = text( 1 << 20, ascii );
+        eachTier( std::string( "validate 1MB " ) + ( ascii ? "ascii" : "mixed" ), s.size(), [ & ]( auto validate ){ bench::doNotOptimize( validate( s.data(), s.size() ) ); } );
+    }
+}
+
+T_BENCHMARK( utf8_code_points )
+{
+    const String s { text( 1 << 20, false ) };
+    bench::report( "count code points 1MB", bench::measure( [ & ]{ bench::doNotOptimize( utf8::countCodePoints( s ) ); } ), s.size() );
+}
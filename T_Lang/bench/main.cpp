@@ -0,0 +1,17 @@
+#include "Bench.h"
+
+// Runs every registered benchmark, or those whose name contains argv[1]
+int main( int argc, char** argv )
+{
+    const std::string filter = argc > 1 ? argv[ 1 ] : "";
+
+    for ( const auto& c : bench::cases() )
+    {
+        if ( c.name.find( filter ) == std::string::npos )
+            continue;
+        std::cout << c.name << ":\n";
+        c.run();
+    }
+
+    return 0;
+}
@@ -1,18 +1,40 @@
-#pragma once
-
 #include <iostream>
 #include <fstream>
 
 #include "t/t.h"
 
+// Usage: tc [-j threads] [-o output.cpp] [--memoize] [source file]
+// The file defaults to test_lang.t in the working directory. With -j the
+// top-level declarations are parsed, the function bodies checked and C++
+// generated on that many threads, 0 for one per core. With -o the generated
+// C++ is written to the given file once the program checks cleanly.
+// `memoize` on a function with side effects is an error; with --memoize
+// every pure function taking only primitives is memoized as well.
 int main( int c, char** argv )
 {
+    size_t threads = 1;
+    std::string output;
+    bool memoizeAll = false;
+    int arg = 1;
+    for ( ; arg < c; arg++ )
+    {
+        const std::string flag = argv[ arg ];
+        if ( flag == "-j" && arg + 1 < c )
+            threads = std::stoul( argv[ ++arg ] );
+        else if ( flag == "-o" && arg + 1 < c )
+            output = argv[ ++arg ];
+        else if ( flag == "--memoize" )
+            memoizeAll = true;
+        else
+            break;
+    }
+    const std::string path = arg < c ? argv[ arg ] : "test_lang.t";
     std::string program_str;
-    std::ifstream input( "C:/dev/T_Lang/T_Lang/test_lang.t", std::ios::in );
+    std::ifstream input( path, std::ios::in );
 
     if ( input.fail() )
     {
-        std::cout << "Failed to open test file\n";
+        std::cout << "Failed to open " << path << '\n';
         exit( 1 );
     }
 
@@ -27,11 +49,51 @@ int main( int c, char** argv )
 
     t::Parser p { lex.tokenize() };
 
-    auto program = p.produceAST();
+    t::ThreadPool pool { threads };
+
+    auto program = p.produceAST( pool );
 
     std::cout << "Program AST:\n";
 
     program.print();
 
+    const auto diagnostics = t::analysis::Checker( program ).check( pool );
+    for ( const auto& diag : diagnostics )
+        std::cerr << "error in " << diag.function << ": " << diag.message << '\n';
+
+    if ( !diagnostics.empty() )
+        return 1;
+
+    try
+    {
+        t::GenericRegistry registry;
+        registry.addTemplates( p.getTemplates() );
+        t::Monomorphizer( program, registry ).run( p.getInstantiations() );
+        t::eval::ConstEvaluator( program ).run();
+
+        // After monomorphization, so instantiated functions have effects too
+        auto table = t::analysis::EffectAnalyzer( program ).analyze();
+        t::analysis::selectMemoized( table, memoizeAll );
+    }
+    catch ( const std::exception& e )
+    {
+        std::cerr << "error: " << e.what() << '\n';
+        return 1;
+    }
+
+    if ( !output.empty() )
+    {
+        t::analysis::ConcatFuser( program ).run();
+        t::analysis::MoveAnalyzer( program ).analyze();
+
+        std::ofstream out( output, std::ios::out | std::ios::binary );
+        out << t::codegen::CppGenerator( program ).generate( pool );
+        if ( !out )
+        {
+            std::cout << "Failed to write " << output << '\n';
+            return 1;
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,411 @@
+#include "AST.h"
+
+namespace t
+{
+    namespace ast
+    {
+        void Expression::printTabs()
+        {
+            for ( uint8_t i = 0; i < numOfTabs; i++ )
+            {
+                std::cout << "   ";
+            }
+        }
+
+        void Program::print() const
+        {
+            for ( const auto& elem : body )
+            {
+                elem.print();
+            }
+        }
+
+        void Statement::destroy() noexcept
+        {
+            switch ( kind )
+            {
+            case Type::Expression:
+                delete static_cast< Expression* >( ptr );
+                break;
+            case Type::Program:
+                delete static_cast< Program* >( ptr );
+                break;
+            case Type::Scope:
+                delete static_cast< StatementList* >( ptr );
+                break;
+            case Type::Statement:
+                break;
+            }
+            ptr = nullptr;
+        }
+
+        void Statement::print() const
+        {
+            switch ( kind )
+            {
+            case Type::Expression:
+                return static_cast< Expression* >( ptr )->print();
+            case Type::Program:
+                return static_cast< Program* >( ptr )->print();
+            case Type::Statement:
+                return;
+            case Type::Scope:
+                auto& stlist = *static_cast< StatementList* >( ptr );
+                std::for_each( stlist.cbegin(), stlist.cend(),
+                    []( const Statement& stmt ){ stmt.print(); });
+                return;
+            }
+        }
+
+        void AssignmentExpression::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Assignment expression:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "lhs:\n";
+            lhs.get()->print();
+            printTabs();
+            std::cout << "rhs:\n";
+            rhs.get()->print();
+            numOfTabs--;
+            std::cout << '\n';
+            numOfTabs--;
+        }
+
+        void TypeName::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << ( isMutable ? "mutable " : "" ) << name << ptr_or_ref << '\n';
+            numOfTabs--;
+        }
+
+        void Identifier::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << symbol << ( ownership == Ownership::Copy ? "" : " (moved)" ) << '\n';
+            numOfTabs--;
+        }
+
+        void VariableDeclaration::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Variable Declaration:" << ( constexpr_ ? " (constexpr)" : "" ) << '\n';
+            numOfTabs++;
+            printTabs();
+            std::cout << "Type:\n";
+            type.print();
+            printTabs();
+            std::cout << "Identifier:\n";
+            identifier.print();
+            printTabs();
+            std::cout << "Value:\n";
+            if ( value )
+                value->print();
+            else
+            {
+                numOfTabs++;
+                printTabs();
+                std::cout << "null\n";
+                numOfTabs--;
+            }
+            numOfTabs--;
+            numOfTabs--;
+        }
+
+        void BinaryExpression::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Binary expression:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "lhs:\n";
+            lhs.get()->print();
+            printTabs();
+            std::cout << "operator: " << op << '\n';
+            printTabs();
+            std::cout << "rhs:\n";
+            rhs.get()->print();
+            numOfTabs--;
+            std::cout << '\n';
+            numOfTabs--;
+        }
+
+        void ConcatExpression::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Concat expression: (" << parts.size() << " parts, " << literalBytes() << " literal bytes)\n";
+            numOfTabs++;
+            for ( const auto& part : parts )
+                part->print();
+            numOfTabs--;
+            numOfTabs--;
+        }
+
+        void StringLiteral::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "String Literal:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "Value: " << value << '\n';
+            numOfTabs--;
+            numOfTabs--;
+        }
+
+        void CharacterLiteral::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Character Literal:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "Value: " << value << '\n';
+            numOfTabs--;
+            numOfTabs--;
+        }
+
+        void BoolLiteral::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "BoolLiteral:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << ( value ? "true" : "false" ) << '\n';
+            numOfTabs--;
+            numOfTabs--;
+        }
+
+        void Parameter::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Parameter:\n";
+            type.print();
+            name.print();
+            numOfTabs--;
+        }
+
+        void FunctionDeclaration::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Function Declaration:" << ( constexpr_ ? " (constexpr)" : "" ) << ( memoized ? " (memoized)" : "" ) << '\n';
+            numOfTabs++;
+            printTabs();
+            std::cout << "Name:\n";
+            name.print();
+            printTabs();
+            std::cout << "Returns:\n";
+            returnType.print();
+            printTabs();
+            std::cout << "Parameters:\n";
+            if ( paramList.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( size_t i = 0; i < paramList.size(); i++ )
+            {
+                paramList[ i ].print();
+            }
+            printTabs();
+            std::cout << "Body:\n";
+            if ( body.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( const auto& stmt : body )
+            {
+                stmt.print();
+            }
+
+            numOfTabs--;
+
+            numOfTabs--;
+        }
+
+        std::string specToStr( AccessSpecifier spec )
+        {
+            switch ( spec )
+            {
+            case Public:
+                return "public";
+            case Private:
+                return "private";
+            case Protected:
+                return "protected";
+            }
+            return "";
+        }
+
+        void FieldDeclaration::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Field Declaration: (" << specToStr( spec ) << ")\n";
+
+            var.getType().print();
+            var.getIdentifier().print();
+            if ( var.getValue() )
+                var.getValue()->print();
+
+            numOfTabs--;
+        }
+
+        void MethodDeclaration::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Method Declaration: (" << specToStr( spec ) << ")" << ( func.isMemoized() ? " (memoized)" : "" ) << '\n';
+            numOfTabs++;
+            printTabs();
+            std::cout << "Name:\n";
+            func.getName().print();
+            printTabs();
+            std::cout << "Returns:\n";
+            func.getReturnType().print();
+            printTabs();
+            std::cout << "Parameters:\n";
+            if ( func.getParamList().empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( const auto& param : func.getParamList() )
+            {
+                param.print();
+            }
+            printTabs();
+            std::cout << "Body:\n";
+            if ( func.getBody().empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( const auto& stmt : func.getBody() )
+            {
+                stmt.print();
+            }
+
+            numOfTabs--;
+
+            numOfTabs--;
+        }
+
+        void ClassDeclaration::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Class Definition:\n";
+            type.print();
+            for ( const auto& f : fields )
+                f.print();
+            for ( const auto& m : methods )
+                m.print();
+            numOfTabs--;
+        }
+
+        void GenericDeclaration::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Generic " << ( isClass ? "Class" : "Function" ) << " Declaration: " << name << '<';
+            for ( size_t i = 0; i < params.size(); i++ )
+                std::cout << ( i ? ", " : "" ) << params[ i ];
+            std::cout << ">\n";
+            numOfTabs--;
+        }
+
+        void FunctionCall::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Function Call:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "Name:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << name.getSymbol() << '\n';
+            numOfTabs--;
+            printTabs();
+            std::cout << "Parameters:\n";
+            if ( parameters.empty() ){ numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( const auto& param : parameters )
+            {
+                param.print();
+            }
+
+            numOfTabs--;
+
+            numOfTabs--;
+        }
+
+        void ReturnStatement::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Return Statement:\n";
+            stmt.print();
+            numOfTabs--;
+        }
+
+        void NameSpaceDeclaration::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "Namespace Declaration:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "Name:\n";
+            name.print();
+            printTabs();
+            std::cout << "Body:\n";
+            if ( body.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( const auto& stmt : body )
+            {
+                stmt.print();
+            }
+            numOfTabs--;
+            numOfTabs--;
+        }
+
+        void IfStatement::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "If Statement:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "Condition:\n";
+            condition->print();
+            printTabs();
+            std::cout << "Body:\n";
+            if ( body.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( const auto& stmt : body )
+            {
+                stmt.print();
+            }
+            numOfTabs--;
+            numOfTabs--;
+        }
+
+        void ForInStatement::print() const
+        {
+            numOfTabs++;
+            printTabs();
+            std::cout << "For In Statement:\n";
+            numOfTabs++;
+            printTabs();
+            std::cout << "Variable:\n";
+            type.print();
+            var.print();
+            printTabs();
+            std::cout << "Range:\n";
+            range->print();
+            printTabs();
+            std::cout << "Body:\n";
+            if ( body.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
+            else for ( const auto& stmt : body )
+            {
+                stmt.print();
+            }
+            numOfTabs--;
+            numOfTabs--;
+        }
+    }
+}
@@ -42,7 +42,31 @@ namespace t
             };
         };
 
+        namespace effect
+        {
+            // Ordered so that the effect of a sequence is the max of its parts
+            enum Effect : uint8_t
+            {
+                Pure,
+                ReadOnly,
+                Writes,
+            };
+        };
+
+        namespace ownership
+        {
+            // How a use of a local hands its value to the consumer
+            enum Ownership : uint8_t
+            {
+                Copy,
+                ImplicitMove,
+                ExplicitMove,
+            };
+        };
+
         using type::Type;
+        using effect::Effect;
+        using ownership::Ownership;
 
         class Statement;
 
@@ -58,6 +82,9 @@ namespace t
 
             void print() const;
 
+            const StatementList& getBody() const { return body; }
+            StatementList& getBody() { return body; }
+
             ~Program() = default;
         private:
             StatementList body;
@@ -73,15 +100,27 @@ namespace t
             bool is() const { return dynamic_cast< const T* >( this ) != nullptr; }
             template< typename T >
             T* as() { return dynamic_cast< T* >( this ); }
+            template< typename T >
+            const T* as() const { return dynamic_cast< const T* >( this ); }
+
+            // Set by HashConsTable: immutable subexpressions with the same
+            // structure share an id, 0 means the node has none
+            uint32_t getConsId() const { return consId; }
+            void setConsId( uint32_t id ) const { consId = id; }
+
+            // O(1) once interned; nodes without an id never compare equal
+            bool sameStructure( const Expression& other ) const { return consId != 0 && consId == other.consId; }
+
+            // Set by hashTree() when the parser finishes, 0 until then
+            uint64_t getHash() const { return hash; }
+            void setHash( uint64_t h ) const { hash = h; }
         protected:
             static inline uint8_t numOfTabs = 0;
-            static void printTabs()
-            {
-                for ( uint8_t i = 0; i < numOfTabs; i++ )
-                {
-                    std::cout << "   ";
-                }
-            }
+            static void printTabs();
+        private:
+            // Annotations rather than part of the node, so they can be set on const trees
+            mutable uint32_t consId = 0;
+            mutable uint64_t hash = 0;
         };
 
         class Statement
@@ -115,7 +154,7 @@ namespace t
 
             Statement& operator=( Statement&& stmt ) noexcept
             {
-                delete ptr;
+                destroy();
                 ptr = stmt.ptr;
                 stmt.ptr = nullptr;
                 kind = stmt.kind;
@@ -123,7 +162,7 @@ namespace t
             }
 
             Type getKind() const { return kind; }
-            ~Statement() { delete ptr; }
+            ~Statement() { destroy(); }
 
             template< Type T >
             bool is() const { return T == kind; }
@@ -131,33 +170,16 @@ namespace t
             bool isNot() const { return !is< T >(); }
             template< typename T >
             T* as() { return static_cast< T* >( ptr ); }
-            void print() const
-            {
-                switch ( kind )
-                {
-                case Type::Expression:
-                    return static_cast< Expression* >( ptr )->print();
-                case Type::Program:
-                    return static_cast< Program* >( ptr )->print();
-                case Type::Scope:
-                    auto& stlist = *static_cast< StatementList* >( ptr );
-                    std::for_each( stlist.cbegin(), stlist.cend(),
-                        []( const Statement& stmt ){ stmt.print(); });
-                    return;
-                }
-            }
+            template< typename T >
+            const T* as() const { return static_cast< const T* >( ptr ); }
+            void print() const;
         private:
             Type kind;
             void* ptr = nullptr;
-        };
 
-        void Program::print() const
-        {
-            for ( const auto& elem : body )
-            {
-                elem.print();
-            }
-        }
+            // Deletes 'ptr' as the type 'kind' says it holds
+            void destroy() noexcept;
+        };
 
         class AssignmentExpression : public Expression
         {
@@ -165,22 +187,10 @@ namespace t
             AssignmentExpression( std::unique_ptr< Expression >&& lhs, std::unique_ptr< Expression >&& rhs ):
                 lhs( std::move( lhs ) ), rhs( std::move( rhs ) ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Assignment expression:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "lhs:\n";
-                lhs.get()->print();
-                printTabs();
-                std::cout << "rhs:\n";
-                rhs.get()->print();
-                numOfTabs--;
-                std::cout << '\n';
-                numOfTabs--;
-            }
+            virtual void print() const override;
+            const Expression* getLhs() const { return lhs.get(); }
+            const Expression* getRhs() const { return rhs.get(); }
+            std::unique_ptr< Expression >& getMutableRhs() { return rhs; }
         private:
             std::unique_ptr< Expression > lhs = nullptr;
             std::unique_ptr< Expression > rhs = nullptr;
@@ -200,13 +210,11 @@ namespace t
                     if ( isPtr )
                         ptr_or_ref = "->";
                 }
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << ( isMutable ? "mutable " : "" ) << name << ptr_or_ref << '\n';
-                numOfTabs--;
-            }
+            virtual void print() const override;
+            const std::string& getName() const { return name; }
+            bool isMutableType() const { return isMutable; }
+            bool isRef() const { return ptr_or_ref == "~"; }
+            bool isPtr() const { return ptr_or_ref == "->"; }
         private:
             std::string name;
             const bool isMutable = false;
@@ -219,115 +227,99 @@ namespace t
             Identifier( std::string&& symbol ):
                 symbol( std::move( symbol ) ) {}
             Identifier( Identifier&& id ) noexcept:
-                symbol( std::move( id.symbol ) ) {}
+                symbol( std::move( id.symbol ) ),
+                ownership( id.ownership ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << symbol << '\n';
-                numOfTabs--;
-            }
+            virtual void print() const override;
 
             void setSymbol( std::string&& sym ) { symbol = std::move( sym ); }
 
             const std::string& getSymbol() const { return symbol; }
+            Ownership getOwnership() const { return ownership; }
+            void setOwnership( Ownership o ) { ownership = o; }
         private:
             std::string symbol;
+            Ownership ownership = Ownership::Copy;
         };
 
         class VariableDeclaration : public Expression
         {
         public:
             VariableDeclaration( bool isMutable, TypeName&& type, std::string&& identifier ):
-                identifier( std::move( identifier ) ), isMutable( isMutable ),
+                isMutable( isMutable ), identifier( std::move( identifier ) ),
                 type( std::move( type ) ) {}
 
             VariableDeclaration( bool isMutable, TypeName&& type, std::string&& identifier, std::unique_ptr< Expression >&& value ):
-                identifier( std::move( identifier ) ), isMutable( isMutable ),
+                isMutable( isMutable ), identifier( std::move( identifier ) ),
                 type( std::move( type ) ), value( std::move( value ) ) {}
 
             VariableDeclaration( VariableDeclaration&& var ) noexcept:
-                identifier( std::move( var.identifier ) ), isMutable( var.isMutable ),
-                type( std::move( var.type ) ), value( std::move( var.value ) ) {}
+                isMutable( var.isMutable ), identifier( std::move( var.identifier ) ),
+                type( std::move( var.type ) ), value( std::move( var.value ) ),
+                constexpr_( var.constexpr_ ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Variable Declaration:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Type:\n";
-                type.print();
-                printTabs();
-                std::cout << "Identifier:\n";
-                identifier.print();
-                printTabs();
-                std::cout << "Value:\n";
-                if ( value )
-                    value->print();
-                else
-                {
-                    numOfTabs++;
-                    printTabs();
-                    std::cout << "null\n";
-                    numOfTabs--;
-                }
-                numOfTabs--;
-                numOfTabs--;
-            }
+            virtual void print() const override;
 
             bool isMutableVar() const { return isMutable; }
             const Identifier& getIdentifier() const { return identifier; }
             const TypeName& getType() const { return type; }
             const Expression* getValue() const { return value.get(); }
+            void setValue( std::unique_ptr< Expression >&& v ) { value = std::move( v ); }
+            std::unique_ptr< Expression >& getMutableValue() { return value; }
+            bool isConstexpr() const { return constexpr_; }
+            void setConstexpr( bool c ) { constexpr_ = c; }
         private:
             bool isMutable = false;
             Identifier identifier;
             TypeName type;
             std::unique_ptr< Expression > value = nullptr;
+            bool constexpr_ = false;
         };
 
         class BinaryExpression : public Expression
         {
         public:
             BinaryExpression( std::unique_ptr< Expression >&& lhs, std::string&& op, std::unique_ptr< Expression >&& rhs ):
-                op( std::move( op ) ),
                 lhs( std::move( lhs ) ),
-                rhs( std::move( rhs ) ) {}
-
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Binary expression:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "lhs:\n";
-                lhs.get()->print();
-                printTabs();
-                std::cout << "operator: " << op << '\n';
-                printTabs();
-                std::cout << "rhs:\n";
-                rhs.get()->print();
-                numOfTabs--;
-                std::cout << '\n';
-                numOfTabs--;
-            }
+                rhs( std::move( rhs ) ),
+                op( std::move( op ) ) {}
+
+            virtual void print() const override;
+            const Expression* getLhs() const { return lhs.get(); }
+            const Expression* getRhs() const { return rhs.get(); }
+            std::unique_ptr< Expression >& getMutableLhs() { return lhs; }
+            std::unique_ptr< Expression >& getMutableRhs() { return rhs; }
+            const std::string& getOperator() const { return op; }
         private:
             std::unique_ptr< Expression > lhs;
             std::unique_ptr< Expression > rhs;
             std::string op;
         };
 
+        // A chain of String `+` fused by analysis::ConcatFuser. The result is
+        // built in one allocation sized from all of its parts.
+        class ConcatExpression : public Expression
+        {
+        public:
+            ConcatExpression( std::vector< std::unique_ptr< Expression > >&& parts ):
+                parts( std::move( parts ) ) {}
+
+            virtual void print() const override;
+            const std::vector< std::unique_ptr< Expression > >& getParts() const { return parts; }
+            std::vector< std::unique_ptr< Expression > >& getParts() { return parts; }
+            // Bytes known at compile time, the rest is sized when the parts are evaluated
+            size_t literalBytes() const;
+        private:
+            std::vector< std::unique_ptr< Expression > > parts;
+        };
+
         template< bool isPre = false >
         class UnaryExpression : public Expression
         {
         public:
             UnaryExpression( std::string&& op, std::unique_ptr< Expression >&& rhs ):
                 op( std::move( op ) ),
-                expr( std::move( expr ) ) {}
+                expr( std::move( rhs ) ) {}
 
             virtual void print() const override
             {
@@ -345,6 +337,9 @@ namespace t
                 std::cout << '\n';
                 numOfTabs--;
             }
+            const Expression* getExpression() const { return expr.get(); }
+            std::unique_ptr< Expression >& getMutableExpression() { return expr; }
+            const std::string& getOperator() const { return op; }
         private:
             std::unique_ptr< Expression > expr;
             std::string op;
@@ -373,6 +368,7 @@ namespace t
                 numOfTabs--;
                 numOfTabs--;
             }
+            T getValue() const { return value; }
         private:
             T value = 0;
         };
@@ -383,17 +379,8 @@ namespace t
             StringLiteral( std::string&& value ):
                 value( std::move( value ) ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "String Literal:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Value: " << value << '\n';
-                numOfTabs--;
-                numOfTabs--;
-            }
+            virtual void print() const override;
+            const std::string& getValue() const { return value; }
         private:
             std::string value;
         };
@@ -404,17 +391,8 @@ namespace t
             CharacterLiteral( std::string&& value ):
                 value( std::move( value ) ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Character Literal:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Value: " << value << '\n';
-                numOfTabs--;
-                numOfTabs--;
-            }
+            virtual void print() const override;
+            const std::string& getValue() const { return value; }
         private:
             std::string value;
         };
@@ -431,21 +409,25 @@ namespace t
                         false :
                         throw std::runtime_error( "bad bool literal" )
                     ) {}
-            virtual void print() const
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "BoolLiteral:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << ( value ? "true" : "false" ) << '\n';
-                numOfTabs--;
-                numOfTabs--;
-            }
+            virtual void print() const;
+            bool getValue() const { return value; }
         private:
             bool value;
         };
 
+        inline size_t ConcatExpression::literalBytes() const
+        {
+            size_t bytes = 0;
+            for ( const auto& part : parts )
+            {
+                if ( auto lit = part->as< StringLiteral >() )
+                    bytes += lit->getValue().size();
+                else if ( auto lit = part->as< CharacterLiteral >() )
+                    bytes += lit->getValue().size();
+            }
+            return bytes;
+        }
+
         class Parameter : public Expression
         {
         public:
@@ -465,15 +447,7 @@ namespace t
                 type( std::move( param.type ) ),
                 name( std::move( param.name ) ) {}
             virtual ~Parameter() = default;
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Parameter:\n";
-                type.print();
-                name.print();
-                numOfTabs--;
-            }
+            virtual void print() const override;
             const TypeName& getTypeName() const { return type; }
             const Identifier& getIdentifier() const { return name; }
         private:
@@ -495,48 +469,37 @@ namespace t
                 returnType( std::move( func.returnType ) ),
                 name( std::move( func.name ) ),
                 paramList( std::move( func.paramList ) ),
-                body( std::move( func.body ) ) {}
-
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Function Declaration:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Name:\n";
-                name.print();
-                printTabs();
-                std::cout << "Returns:\n";
-                returnType.print();
-                printTabs();
-                std::cout << "Parameters:\n";
-                if ( paramList.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
-                else for ( size_t i = 0; i < paramList.size(); i++ )
-                {
-                    paramList[ i ].print();
-                }
-                printTabs();
-                std::cout << "Body:\n";
-                if ( body.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
-                else for ( const auto& stmt : body )
-                {
-                    stmt.print();
-                }
+                body( std::move( func.body ) ),
+                effect( func.effect ),
+                memoized( func.memoized ),
+                constexpr_( func.constexpr_ ),
+                external( func.external ) {}
 
-                numOfTabs--;
-
-                numOfTabs--;
-            }
+            virtual void print() const override;
             const TypeName& getReturnType() const { return returnType; }
             const Identifier& getName() const { return name; }
             const ParameterList& getParamList() const { return paramList; }
             const StatementList& getBody() const { return body; }
+            StatementList& getBody() { return body; }
+            Effect getEffect() const { return effect; }
+            void setEffect( Effect e ) { effect = e; }
+            bool isMemoized() const { return memoized; }
+            void setMemoized( bool m ) { memoized = m; }
+            bool isConstexpr() const { return constexpr_; }
+            void setConstexpr( bool c ) { constexpr_ = c; }
+            // Defined by another module, only its declaration is generated
+            bool isExternal() const { return external; }
+            void setExternal( bool e ) { external = e; }
         private:
             TypeName returnType;
             Identifier name;
             ParameterList paramList;
             StatementList body;
+            // Conservative until analysis::EffectAnalyzer proves otherwise
+            Effect effect = Effect::Writes;
+            bool memoized = false;
+            bool constexpr_ = false;
+            bool external = false;
         };
 
         enum AccessSpecifier : uint8_t
@@ -546,18 +509,7 @@ namespace t
             Protected,
         };
 
-        std::string specToStr( AccessSpecifier spec )
-        {
-            switch ( spec )
-            {
-            case Public:
-                return "public";
-            case Private:
-                return "private";
-            case Protected:
-                return "protected";
-            }
-        }
+        std::string specToStr( AccessSpecifier spec );
 
         struct FieldDeclaration : public Expression
         {
@@ -570,19 +522,7 @@ namespace t
                 var( std::move( field.var ) ),
                 spec( field.spec ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Field Declaration: (" << specToStr( spec ) << ")\n";
-
-                var.getType().print();
-                var.getIdentifier().print();
-                if ( var.getValue() )
-                    var.getValue()->print();
-
-                numOfTabs--;
-            }
+            virtual void print() const override;
         };
 
         struct MethodDeclaration : public Expression
@@ -596,37 +536,7 @@ namespace t
                 func( std::move( meth.func ) ),
                 spec( meth.spec ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Method Declaration: (" << specToStr( spec ) << ")\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Name:\n";
-                func.getName().print();
-                printTabs();
-                std::cout << "Returns:\n";
-                func.getReturnType().print();
-                printTabs();
-                std::cout << "Parameters:\n";
-                if ( func.getParamList().empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
-                else for ( const auto& param : func.getParamList() )
-                {
-                    param.print();
-                }
-                printTabs();
-                std::cout << "Body:\n";
-                if ( func.getBody().empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
-                else for ( const auto& stmt : func.getBody() )
-                {
-                    stmt.print();
-                }
-
-                numOfTabs--;
-
-                numOfTabs--;
-            }
+            virtual void print() const override;
         };
 
         using FieldList = std::vector< FieldDeclaration >;
@@ -640,24 +550,42 @@ namespace t
                 fields( std::move( fields ) ),
                 methods( std::move( methods ) ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Class Definition:\n";
-                type.print();
-                for ( const auto& f : fields )
-                    f.print();
-                for ( const auto& m : methods )
-                    m.print();
-                numOfTabs--;
-            }
+            virtual void print() const override;
+            const TypeName& getType() const { return type; }
+            const FieldList& getFields() const { return fields; }
+            FieldList& getFields() { return fields; }
+            const MethodList& getMethods() const { return methods; }
+            MethodList& getMethods() { return methods; }
         private:
             TypeName type;
             FieldList fields;
             MethodList methods;
         };
 
+        // Placeholder left where a `template` was declared, the code itself is
+        // produced per instantiation by the Monomorphizer
+        class GenericDeclaration : public Expression
+        {
+        public:
+            GenericDeclaration( std::string&& name, std::vector< std::string >&& params, bool isClass ):
+                name( std::move( name ) ),
+                params( std::move( params ) ),
+                isClass( isClass ) {}
+
+            virtual void print() const override;
+            const std::string& getName() const { return name; }
+            const std::vector< std::string >& getParams() const { return params; }
+            bool isClassTemplate() const { return isClass; }
+            // Structural hash of the parsed pattern, the placeholder has no body of its own
+            uint64_t getPatternHash() const { return patternHash; }
+            void setPatternHash( uint64_t h ) { patternHash = h; }
+        private:
+            std::string name;
+            std::vector< std::string > params;
+            bool isClass;
+            uint64_t patternHash = 0;
+        };
+
         class FunctionCall : public Expression
         {
         public:
@@ -665,30 +593,10 @@ namespace t
                 name( std::move( id ) ),
                 parameters( std::move( params ) ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Function Call:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Name:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << name.getSymbol() << '\n';
-                numOfTabs--;
-                printTabs();
-                std::cout << "Parameters:\n";
-                if ( parameters.empty() ){ numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
-                else for ( const auto& param : parameters )
-                {
-                    param.print();
-                }
-
-                numOfTabs--;
-
-                numOfTabs--;
-            }
+            virtual void print() const override;
+            const Identifier& getName() const { return name; }
+            const StatementList& getParameters() const { return parameters; }
+            StatementList& getParameters() { return parameters; }
         private:
             Identifier name;
             StatementList parameters;
@@ -700,14 +608,9 @@ namespace t
             ReturnStatement( Statement&& stmt ):
                 stmt( std::move( stmt ) ) {}
 
-            virtual void print() const override
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Return Statement:\n";
-                stmt.print();
-                numOfTabs--;
-            }
+            virtual void print() const override;
+            const Statement& getStatement() const { return stmt; }
+            Statement& getStatement() { return stmt; }
         private:
             Statement stmt;
         };
@@ -721,25 +624,10 @@ namespace t
             NameSpaceDeclaration( Identifier&& name, StatementList&& body ):
                 name( std::move( name ) ),
                 body( std::move( body ) ) {}
-            virtual void print() const
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "Namespace Declaration:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Name:\n";
-                name.print();
-                printTabs();
-                std::cout << "Body:\n";
-                if ( body.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
-                else for ( const auto& stmt : body )
-                {
-                    stmt.print();
-                }
-                numOfTabs--;
-                numOfTabs--;
-            }
+            virtual void print() const;
+            const Identifier& getName() const { return name; }
+            const StatementList& getBody() const { return body; }
+            StatementList& getBody() { return body; }
         private:
             Identifier name;
             StatementList body;
@@ -751,28 +639,37 @@ namespace t
             IfStatement( std::unique_ptr< Expression >&& condition, StatementList&& body ):
                 condition( std::move( condition ) ),
                 body( std::move( body ) ) {}
-            virtual void print() const
-            {
-                numOfTabs++;
-                printTabs();
-                std::cout << "If Statement:\n";
-                numOfTabs++;
-                printTabs();
-                std::cout << "Condition:\n";
-                condition->print();
-                printTabs();
-                std::cout << "Body:\n";
-                if ( body.empty() ) { numOfTabs++; printTabs(); std::cout << "null\n"; numOfTabs--; }
-                else for ( const auto& stmt : body )
-                {
-                    stmt.print();
-                }
-                numOfTabs--;
-                numOfTabs--;
-            }
+            virtual void print() const;
+            const Expression* getCondition() const { return condition.get(); }
+            std::unique_ptr< Expression >& getMutableCondition() { return condition; }
+            const StatementList& getBody() const { return body; }
+            StatementList& getBody() { return body; }
         private:
             std::unique_ptr< Expression > condition;
             StatementList body;
         };
+
+        // `for ( name in range )`, the loop variable takes each element in turn
+        class ForInStatement : public Expression
+        {
+        public:
+            ForInStatement( TypeName&& type, Identifier&& var, std::unique_ptr< Expression >&& range, StatementList&& body ):
+                type( std::move( type ) ),
+                var( std::move( var ) ),
+                range( std::move( range ) ),
+                body( std::move( body ) ) {}
+            virtual void print() const;
+            const TypeName& getType() const { return type; }
+            const Identifier& getVariable() const { return var; }
+            const Expression* getRange() const { return range.get(); }
+            std::unique_ptr< Expression >& getMutableRange() { return range; }
+            const StatementList& getBody() const { return body; }
+            StatementList& getBody() { return body; }
+        private:
+            TypeName type;
+            Identifier var;
+            std::unique_ptr< Expression > range;
+            StatementList body;
+        };
     }
 }
@@ -0,0 +1,201 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace t
+{
+    namespace analysis
+    {
+        std::vector< Diagnostic > Checker::check()
+        {
+            ThreadPool sequential { 1 };
+            return check( sequential );
+        }
+
+        std::vector< Diagnostic > Checker::check( ThreadPool& pool )
+        {
+            table.collect( program.getBody() );
+
+            const auto& bodies = table.getBodies();
+            std::vector< std::vector< Diagnostic > > results( bodies.size() );
+            pool.parallelFor( bodies.size(), [ & ]( size_t n ){
+                Body body { bodies[ n ], *table.findFunction( bodies[ n ].name ), {}, {} };
+                checkBody( body );
+                results[ n ] = std::move( body.diagnostics );
+            } );
+
+            std::vector< Diagnostic > diagnostics;
+            for ( auto& result : results )
+                std::move( result.begin(), result.end(), std::back_inserter( diagnostics ) );
+            return diagnostics;
+        }
+
+        void Checker::checkBody( Body& body ) const
+        {
+            const auto& func = *body.function.decl;
+            if ( func.getName().getSymbol() != "constructor" )
+                checkType( func.getReturnType(), body );
+            for ( const auto& param : func.getParamList() )
+            {
+                checkType( param.getTypeName(), body );
+                body.locals.push_back( param.getIdentifier().getSymbol() );
+            }
+            visitBlock( func.getBody(), body );
+        }
+
+        void Checker::visit( const ast::Statement& stmt, Body& body ) const
+        {
+            if ( stmt.is< ast::Type::Expression >() )
+                visit( stmt.as< ast::Expression >(), body );
+            else if ( stmt.is< ast::Type::Scope >() )
+                visitBlock( *stmt.as< ast::StatementList >(), body );
+        }
+
+        void Checker::visit( const ast::Expression* expr, Body& body ) const
+        {
+            if ( !expr )
+                return;
+            if ( auto id = expr->as< ast::Identifier >() )
+            {
+                const auto& name = id->getSymbol();
+                const auto& scope = body.info.scope;
+                if ( !isLocal( name, body ) && table.resolveGlobal( scope, name ).empty() &&
+                     table.resolveFunction( scope, name ).empty() && table.resolveClass( scope, name ).empty() )
+                    report( body, "'" + name + "' is not declared" );
+            }
+            else if ( auto var = expr->as< ast::VariableDeclaration >() )
+            {
+                checkType( var->getType(), body );
+                visit( var->getValue(), body );
+                body.locals.push_back( var->getIdentifier().getSymbol() );
+            }
+            else if ( auto assign = expr->as< ast::AssignmentExpression >() )
+            {
+                visit( assign->getRhs(), body );
+                visit( assign->getLhs(), body );
+            }
+            else if ( auto bin = expr->as< ast::BinaryExpression >() )
+            {
+                visit( bin->getLhs(), body );
+                // Members are looked up on the type of the left-hand side,
+                // which is not known here, so only the arguments are checked
+                if ( bin->getOperator() != "." )
+                    visit( bin->getRhs(), body );
+                else if ( auto call = bin->getRhs()->as< ast::FunctionCall >() )
+                    for ( const auto& arg : call->getParameters() )
+                        visit( arg, body );
+            }
+            else if ( auto concat = expr->as< ast::ConcatExpression >() )
+            {
+                for ( const auto& part : concat->getParts() )
+                    visit( part.get(), body );
+            }
+            else if ( auto call = expr->as< ast::FunctionCall >() )
+            {
+                visitCall( *call, body );
+            }
+            else if ( auto ret = expr->as< ast::ReturnStatement >() )
+            {
+                const auto& func = *body.function.decl;
+                const auto hasValue = ret->getStatement().is< ast::Type::Expression >();
+                const auto isVoid = func.getReturnType().getName() == "void";
+                if ( hasValue && isVoid )
+                    report( body, "void function returns a value" );
+                else if ( !hasValue && !isVoid && func.getName().getSymbol() != "constructor" )
+                    report( body, "return without a value in a function returning " + func.getReturnType().getName() );
+                visit( ret->getStatement(), body );
+            }
+            else if ( auto ifstmt = expr->as< ast::IfStatement >() )
+            {
+                visit( ifstmt->getCondition(), body );
+                visitBlock( ifstmt->getBody(), body );
+            }
+            else if ( auto loop = expr->as< ast::ForInStatement >() )
+            {
+                visit( loop->getRange(), body );
+                const auto outer = body.locals.size();
+                checkType( loop->getType(), body );
+                body.locals.push_back( loop->getVariable().getSymbol() );
+                visitBlock( loop->getBody(), body );
+                body.locals.resize( outer );
+            }
+            else if ( auto unary = expr->as< ast::UnaryExpression< true > >() )
+            {
+                visit( unary->getExpression(), body );
+            }
+            else if ( auto unary = expr->as< ast::UnaryExpression< false > >() )
+            {
+                visit( unary->getExpression(), body );
+            }
+        }
+
+        void Checker::visitBlock( const ast::StatementList& stmts, Body& body ) const
+        {
+            const auto outer = body.locals.size();
+            for ( const auto& stmt : stmts )
+                visit( stmt, body );
+            body.locals.resize( outer );
+        }
+
+        void Checker::visitCall( const ast::FunctionCall& call, Body& body ) const
+        {
+            const auto& name = call.getName().getSymbol();
+            const auto& scope = body.info.scope;
+            const auto args = call.getParameters().size();
+
+            for ( const auto& arg : call.getParameters() )
+                visit( arg, body );
+
+            if ( isLocal( name, body ) || !table.resolveClass( scope, name ).empty() )
+                return;
+
+            const auto callee = table.resolveFunction( scope, name );
+            if ( callee.empty() )
+            {
+                // Instantiations are only declared once the Monomorphizer ran
+                const auto generic = name.find( '<' );
+                if ( generic == std::string::npos || table.resolveGeneric( scope, name.substr( 0, generic ) ).empty() )
+                    report( body, "call to undeclared function '" + name + "'" );
+                return;
+            }
+
+            const auto& decls = table.findFunction( callee )->decls;
+            const auto takesArgs = [ args ]( const ast::FunctionDeclaration* decl ){ return decl->getParamList().size() == args; };
+            if ( std::any_of( decls.cbegin(), decls.cend(), takesArgs ) )
+                return;
+            if ( decls.size() == 1 )
+                report( body, "'" + name + "' takes " + std::to_string( decls.front()->getParamList().size() ) +
+                              " arguments, " + std::to_string( args ) + " given" );
+            else
+                report( body, "no overload of '" + name + "' takes " + std::to_string( args ) + " arguments" );
+        }
+
+        void Checker::checkType( const ast::TypeName& type, Body& body ) const
+        {
+            const auto& name = type.getName();
+            if ( lexer::DEFAULT_TYPES.find( name ) != lexer::DEFAULT_TYPES.cend() ||
+                 !table.resolveClass( body.info.scope, name ).empty() )
+                return;
+            const auto generic = name.find( '<' );
+            if ( generic != std::string::npos )
+            {
+                const auto base = name.substr( 0, generic );
+                if ( lexer::DEFAULT_TYPES.find( base ) != lexer::DEFAULT_TYPES.cend() ||
+                     !table.resolveGeneric( body.info.scope, base ).empty() )
+                    return;
+            }
+            report( body, "unknown type '" + name + "'" );
+        }
+
+        bool Checker::isLocal( const std::string& name, const Body& body ) const
+        {
+            return std::find( body.locals.crbegin(), body.locals.crend(), name ) != body.locals.crend();
+        }
+
+        void Checker::report( Body& body, std::string&& message )
+        {
+            body.diagnostics.push_back( Diagnostic { body.function.name, std::move( message ) } );
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Effects.h"
+#include "ThreadPool.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        struct Diagnostic
+        {
+            // Qualified name of the function or method the problem is in
+            std::string function;
+            std::string message;
+        };
+
+        // Resolves every name used in a function or method body and checks
+        // calls, types and returns against the declared signatures. The
+        // signatures of the whole program are collected first; after that a
+        // body only reads the symbol table, so bodies are checked in parallel,
+        // each into its own diagnostics. Those are merged in declaration
+        // order, so the result does not depend on the number of threads.
+        class Checker
+        {
+        public:
+            Checker( ast::Program& program ):
+                program( program ) {}
+
+            std::vector< Diagnostic > check();
+
+            std::vector< Diagnostic > check( ThreadPool& pool );
+
+            const SymbolTable& getTable() const { return table; }
+        private:
+            // Everything a single body check writes
+            struct Body
+            {
+                const FunctionBody& function;
+                const FunctionInfo& info;
+                // Locals in declaration order, blocks truncate it on exit
+                std::vector< std::string > locals;
+                std::vector< Diagnostic > diagnostics;
+            };
+
+            ast::Program& program;
+            SymbolTable table;
+
+            void checkBody( Body& body ) const;
+
+            void visit( const ast::Statement& stmt, Body& body ) const;
+
+            void visit( const ast::Expression* expr, Body& body ) const;
+
+            void visitBlock( const ast::StatementList& stmts, Body& body ) const;
+
+            void visitCall( const ast::FunctionCall& call, Body& body ) const;
+
+            void checkType( const ast::TypeName& type, Body& body ) const;
+
+            bool isLocal( const std::string& name, const Body& body ) const;
+
+            static void report( Body& body, std::string&& message );
+        };
+    }
+}
@@ -0,0 +1,667 @@
+#include "CodeGen.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+namespace t
+{
+    namespace codegen
+    {
+        namespace
+        {
+            const std::unordered_map< std::string, std::string > PRIMITIVES
+            {
+                { "int8", "int8_t" }, { "int16", "int16_t" }, { "int32", "int32_t" }, { "int64", "int64_t" },
+                { "uint8", "uint8_t" }, { "uint16", "uint16_t" }, { "uint32", "uint32_t" }, { "uint64", "uint64_t" },
+                { "float", "float" }, { "double", "double" }, { "bool", "bool" }, { "char", "char" },
+                { "void", "void" }, { "auto", "auto" },
+                { "String", "t::runtime::String" },
+            };
+
+            constexpr std::string_view PRELUDE =
+                "// Generated by tc, do not edit\n"
+                "#include <cmath>\n"
+                "#include <cstdint>\n"
+                "#include <utility>\n"
+                "\n"
+                "#include \"t/runtime/Map.h\"\n"
+                "#include \"t/runtime/MemoCache.h\"\n"
+                "#include \"t/runtime/StringBuilder.h\"\n"
+                "\n";
+
+            bool declaresClass( const ast::StatementList& body )
+            {
+                return std::any_of( body.cbegin(), body.cend(), []( const ast::Statement& stmt ){
+                    if ( stmt.isNot< ast::Type::Expression >() )
+                        return false;
+                    const auto expr = stmt.as< ast::Expression >();
+                    const auto nsp = expr->as< ast::NameSpaceDeclaration >();
+                    return expr->is< ast::ClassDeclaration >() || ( nsp && declaresClass( nsp->getBody() ) );
+                } );
+            }
+
+            // A method that writes no state is const, so it can be called
+            // through a `~` parameter, which is a const reference. One that
+            // hands out a mutable reference into the object cannot be.
+            bool isConstMethod( const ast::FunctionDeclaration& func )
+            {
+                const auto& type = func.getReturnType();
+                return func.getName().getSymbol() != "constructor" && func.getEffect() != ast::Effect::Writes &&
+                    !( type.isMutableType() && ( type.isRef() || type.isPtr() ) );
+            }
+
+            // Escapes each part of a scope such as `outer::inner`
+            std::string qualifiedName( const std::string& scope )
+            {
+                std::string result;
+                for ( size_t start = 0, end = 0; end != std::string::npos; start = end + 2 )
+                {
+                    end = scope.find( "::", start );
+                    result += ( start ? "::" : "" ) + CppGenerator::cppName( scope.substr( start, end - start ) );
+                }
+                return result;
+            }
+
+            bool isDeclaration( const ast::Expression* expr )
+            {
+                return expr->is< ast::FunctionDeclaration >() || expr->is< ast::ClassDeclaration >() ||
+                       expr->is< ast::NameSpaceDeclaration >() || expr->is< ast::VariableDeclaration >() ||
+                       expr->is< ast::GenericDeclaration >();
+            }
+
+            std::string baseType( const std::string& name )
+            {
+                if ( const auto it = PRIMITIVES.find( name ); it != PRIMITIVES.cend() )
+                    return it->second;
+                if ( name.compare( 0, 4, "Map<" ) != 0 )
+                    return CppGenerator::cppName( name );
+
+                // Split the arguments at the commas that are not nested
+                std::string result = "t::runtime::Map< ";
+                size_t depth = 0, start = 4;
+                for ( size_t at = start; at < name.size(); at++ )
+                {
+                    if ( name[ at ] == '<' )
+                        depth++;
+                    else if ( ( name[ at ] == ',' && depth == 0 ) || ( name[ at ] == '>' && depth-- == 0 ) )
+                    {
+                        result += baseType( name.substr( start, at - start ) ) + ( name[ at ] == ',' ? ", " : " >" );
+                        start = at + 1;
+                    }
+                }
+                return result;
+            }
+
+            // Writes statements and expressions of one function into an arena
+            class Emitter
+            {
+            public:
+                Emitter( TextArena& out ):
+                    out( out ) {}
+
+                // Locals that are moved from somewhere in body are declared
+                // without const, a const value would be copied instead
+                void findMoves( const ast::StatementList& body )
+                {
+                    for ( const auto& stmt : body )
+                    {
+                        if ( stmt.is< ast::Type::Scope >() )
+                            findMoves( *stmt.as< ast::StatementList >() );
+                        else if ( stmt.is< ast::Type::Expression >() )
+                            findMoves( stmt.as< ast::Expression >() );
+                    }
+                }
+
+                void indent( size_t depth )
+                {
+                    for ( size_t n = 0; n < depth; n++ )
+                        out.append( "    " );
+                }
+
+                void block( const ast::StatementList& stmts, size_t depth, std::string_view terminator = "" )
+                {
+                    indent( depth );
+                    out.append( "{\n" );
+                    for ( const auto& stmt : stmts )
+                        statement( stmt, depth + 1 );
+                    indent( depth );
+                    out.append( '}' ).append( terminator ).append( '\n' );
+                }
+
+                void statement( const ast::Statement& stmt, size_t depth )
+                {
+                    if ( stmt.is< ast::Type::Scope >() )
+                        return block( *stmt.as< ast::StatementList >(), depth );
+                    if ( stmt.isNot< ast::Type::Expression >() )
+                        return;
+
+                    const auto expr = stmt.as< ast::Expression >();
+                    if ( auto ifstmt = expr->as< ast::IfStatement >() )
+                    {
+                        indent( depth );
+                        out.append( "if ( " );
+                        expression( ifstmt->getCondition() );
+                        out.append( " )\n" );
+                        return block( ifstmt->getBody(), depth );
+                    }
+                    if ( auto loop = expr->as< ast::ForInStatement >() )
+                    {
+                        indent( depth );
+                        out.append( "for ( " ).append( CppGenerator::cppType( loop->getType(), !isMoved( loop->getVariable() ) ) ).append( ' ' );
+                        out.append( CppGenerator::cppName( loop->getVariable().getSymbol() ) ).append( " : " );
+                        expression( loop->getRange() );
+                        out.append( " )\n" );
+                        return block( loop->getBody(), depth );
+                    }
+                    if ( expr->is< ast::FunctionDeclaration >() || expr->is< ast::ClassDeclaration >() ||
+                         expr->is< ast::NameSpaceDeclaration >() || expr->is< ast::GenericDeclaration >() )
+                        throw std::runtime_error( "cannot generate a declaration nested in a function" );
+
+                    indent( depth );
+                    if ( auto var = expr->as< ast::VariableDeclaration >() )
+                        variable( *var, true );
+                    else if ( auto ret = expr->as< ast::ReturnStatement >() )
+                    {
+                        out.append( "return" );
+                        if ( ret->getStatement().is< ast::Type::Expression >() )
+                        {
+                            out.append( ' ' );
+                            // A returned local is moved by C++ itself, std::move would only stop NRVO
+                            const auto value = ret->getStatement().as< ast::Expression >();
+                            const auto id = value->as< ast::Identifier >();
+                            if ( id && isMoved( *id ) )
+                                out.append( CppGenerator::cppName( id->getSymbol() ) );
+                            else
+                                expression( value );
+                        }
+                    }
+                    else
+                        expression( expr );
+                    out.append( ";\n" );
+                }
+
+                // `const T name = value`, const is dropped when there is no value
+                // or the variable is moved from
+                void variable( const ast::VariableDeclaration& var, bool constValue )
+                {
+                    const auto constant = constValue && var.getValue() && !isMoved( var.getIdentifier() );
+                    auto type = CppGenerator::cppType( var.getType(), constant );
+                    out.append( type ).append( ' ' ).append( CppGenerator::cppName( var.getIdentifier().getSymbol() ) );
+                    if ( var.getValue() )
+                    {
+                        out.append( " = " );
+                        expression( var.getValue() );
+                    }
+                }
+
+                void expression( const ast::Expression* expr, bool nested = false )
+                {
+                    if ( !expr )
+                        return;
+                    if ( auto id = expr->as< ast::Identifier >() )
+                    {
+                        if ( id->getOwnership() == ast::Ownership::Copy )
+                            out.append( CppGenerator::cppName( id->getSymbol() ) );
+                        else
+                            out.append( "std::move( " ).append( CppGenerator::cppName( id->getSymbol() ) ).append( " )" );
+                    }
+                    else if ( auto lit = expr->as< ast::NumericLiteral< int64_t > >() )
+                        out.append( std::to_string( lit->getValue() ) );
+                    else if ( auto lit = expr->as< ast::NumericLiteral< uint64_t > >() )
+                        out.append( std::to_string( lit->getValue() ) ).append( lit->getValue() > INT64_MAX ? "u" : "" );
+                    else if ( auto lit = expr->as< ast::NumericLiteral< double > >() )
+                        floating( lit->getValue() );
+                    else if ( auto lit = expr->as< ast::StringLiteral >() )
+                        out.append( "t::runtime::String( \"" ).append( lit->getValue() ).append( "\" )" );
+                    else if ( auto lit = expr->as< ast::CharacterLiteral >() )
+                        out.append( '\'' ).append( lit->getValue() ).append( '\'' );
+                    else if ( auto lit = expr->as< ast::BoolLiteral >() )
+                        out.append( lit->getValue() ? "true" : "false" );
+                    else if ( auto bin = expr->as< ast::BinaryExpression >() )
+                        binary( *bin, nested );
+                    else if ( auto assign = expr->as< ast::AssignmentExpression >() )
+                    {
+                        out.append( nested ? "( " : "" );
+                        expression( assign->getLhs() );
+                        out.append( " = " );
+                        expression( assign->getRhs() );
+                        out.append( nested ? " )" : "" );
+                    }
+                    else if ( auto concat = expr->as< ast::ConcatExpression >() )
+                    {
+                        out.append( "t::runtime::concat( " );
+                        for ( size_t n = 0; n < concat->getParts().size(); n++ )
+                        {
+                            out.append( n ? ", " : "" );
+                            expression( concat->getParts()[ n ].get() );
+                        }
+                        out.append( " )" );
+                    }
+                    else if ( auto call = expr->as< ast::FunctionCall >() )
+                        functionCall( *call );
+                    else if ( auto unary = expr->as< ast::UnaryExpression< true > >() )
+                    {
+                        out.append( unary->getOperator() );
+                        expression( unary->getExpression(), true );
+                    }
+                    else if ( auto unary = expr->as< ast::UnaryExpression< false > >() )
+                    {
+                        expression( unary->getExpression(), true );
+                        out.append( unary->getOperator() );
+                    }
+                    else
+                        throw std::runtime_error( "cannot generate code for this expression" );
+                }
+
+                void parameters( const ast::ParameterList& params )
+                {
+                    out.append( params.empty() ? "()" : "( " );
+                    for ( size_t n = 0; n < params.size(); n++ )
+                    {
+                        const auto& name = params[ n ].getIdentifier();
+                        out.append( n ? ", " : "" ).append( CppGenerator::cppType( params[ n ].getTypeName(), !isMoved( name ) ) );
+                        out.append( ' ' ).append( CppGenerator::cppName( name.getSymbol() ) );
+                    }
+                    out.append( params.empty() ? "" : " )" );
+                }
+            private:
+                TextArena& out;
+                std::unordered_set< std::string > moved;
+
+                bool isMoved( const ast::Identifier& id ) const { return moved.count( id.getSymbol() ) != 0; }
+
+                void findMoves( const ast::Expression* expr )
+                {
+                    if ( !expr )
+                        return;
+                    if ( auto id = expr->as< ast::Identifier >() )
+                    {
+                        if ( id->getOwnership() != ast::Ownership::Copy )
+                            moved.insert( id->getSymbol() );
+                    }
+                    else if ( auto bin = expr->as< ast::BinaryExpression >() )
+                    {
+                        findMoves( bin->getLhs() );
+                        findMoves( bin->getRhs() );
+                    }
+                    else if ( auto assign = expr->as< ast::AssignmentExpression >() )
+                    {
+                        findMoves( assign->getLhs() );
+                        findMoves( assign->getRhs() );
+                    }
+                    else if ( auto concat = expr->as< ast::ConcatExpression >() )
+                    {
+                        for ( const auto& part : concat->getParts() )
+                            findMoves( part.get() );
+                    }
+                    else if ( auto call = expr->as< ast::FunctionCall >() )
+                        findMoves( call->getParameters() );
+                    else if ( auto unary = expr->as< ast::UnaryExpression< true > >() )
+                        findMoves( unary->getExpression() );
+                    else if ( auto unary = expr->as< ast::UnaryExpression< false > >() )
+                        findMoves( unary->getExpression() );
+                    else if ( auto var = expr->as< ast::VariableDeclaration >() )
+                        findMoves( var->getValue() );
+                    else if ( auto ret = expr->as< ast::ReturnStatement >() )
+                    {
+                        if ( ret->getStatement().is< ast::Type::Expression >() )
+                            findMoves( ret->getStatement().as< ast::Expression >() );
+                    }
+                    else if ( auto ifstmt = expr->as< ast::IfStatement >() )
+                    {
+                        findMoves( ifstmt->getCondition() );
+                        findMoves( ifstmt->getBody() );
+                    }
+                    else if ( auto loop = expr->as< ast::ForInStatement >() )
+                    {
+                        findMoves( loop->getRange() );
+                        findMoves( loop->getBody() );
+                    }
+                }
+
+                void binary( const ast::BinaryExpression& bin, bool nested )
+                {
+                    const auto& op = bin.getOperator();
+                    if ( op == "." )
+                    {
+                        expression( bin.getLhs(), true );
+                        out.append( '.' );
+                        return expression( bin.getRhs(), true );
+                    }
+                    if ( op == "**" )
+                    {
+                        out.append( "std::pow( " );
+                        expression( bin.getLhs() );
+                        out.append( ", " );
+                        expression( bin.getRhs() );
+                        out.append( " )" );
+                        return;
+                    }
+                    out.append( nested ? "( " : "" );
+                    expression( bin.getLhs(), true );
+                    out.append( ' ' ).append( op ).append( ' ' );
+                    expression( bin.getRhs(), true );
+                    out.append( nested ? " )" : "" );
+                }
+
+                void functionCall( const ast::FunctionCall& call )
+                {
+                    const auto& args = call.getParameters();
+                    out.append( CppGenerator::cppName( call.getName().getSymbol() ) ).append( args.empty() ? "()" : "( " );
+                    for ( size_t n = 0; n < args.size(); n++ )
+                    {
+                        out.append( n ? ", " : "" );
+                        if ( args[ n ].is< ast::Type::Expression >() )
+                            expression( args[ n ].as< ast::Expression >() );
+                    }
+                    out.append( args.empty() ? "" : " )" );
+                }
+
+                // Shortest text that reads back as the same double
+                void floating( double value )
+                {
+                    char text[ 32 ];
+                    for ( int precision = 15; precision <= 17; precision++ )
+                    {
+                        std::snprintf( text, sizeof( text ), "%.*g", precision, value );
+                        if ( std::strtod( text, nullptr ) == value )
+                            break;
+                    }
+                    out.append( text );
+                    if ( !std::strpbrk( text, ".eEni" ) )
+                        out.append( ".0" );
+                }
+            };
+        }
+
+        TextArena& TextArena::append( std::string_view text )
+        {
+            if ( size_t( end - at ) < text.size() )
+            {
+                // The piece has to stay contiguous, so it moves to a new chunk
+                const size_t length = at - piece;
+                const auto size = std::max( chunkSize, 2 * ( length + text.size() ) );
+                chunks.emplace_back( new char[ size ] );
+                if ( length )
+                    std::memcpy( chunks.back().get(), piece, length );
+                piece = chunks.back().get();
+                at = piece + length;
+                end = piece + size;
+                reserved += size;
+            }
+            if ( !text.empty() )
+                std::memcpy( at, text.data(), text.size() );
+            at += text.size();
+            return *this;
+        }
+
+        std::string_view TextArena::finish()
+        {
+            const std::string_view result { piece, size_t( at - piece ) };
+            piece = at;
+            return result;
+        }
+
+        std::string CppGenerator::generate()
+        {
+            ThreadPool sequential { 1 };
+            return generate( sequential );
+        }
+
+        std::string CppGenerator::generate( ThreadPool& pool )
+        {
+            analysis::SymbolTable table;
+            table.collect( program.getBody() );
+
+            TextArena header;
+            header.append( PRELUDE );
+            forwardDeclare( header, program.getBody(), 0 );
+            declare( header, program.getBody(), 0 );
+            const auto declarations = header.finish();
+
+            const auto& bodies = table.getBodies();
+            std::vector< TextArena > arenas( pool.size() );
+            std::vector< std::string_view > definitions( bodies.size() );
+            pool.parallelFor( bodies.size(), [ & ]( size_t n, size_t thread ){
+                defineFunction( arenas[ thread ], bodies[ n ], *table.findFunction( bodies[ n ].name ) );
+                definitions[ n ] = arenas[ thread ].finish();
+            } );
+
+            defineMain( header );
+            const auto main = header.finish();
+
+            // Link in declaration order, whichever thread produced each piece
+            size_t size = declarations.size() + main.size();
+            for ( const auto& definition : definitions )
+                size += definition.size();
+            std::string result;
+            result.reserve( size );
+            result.append( declarations );
+            for ( const auto& definition : definitions )
+                result.append( definition );
+            result.append( main );
+            return result;
+        }
+
+        std::string CppGenerator::cppType( const ast::TypeName& type, bool constValue )
+        {
+            const auto base = baseType( type.getName() );
+            const auto constant = !type.isMutableType() ? "const " : "";
+            if ( type.isRef() )
+                return constant + base + "&";
+            if ( type.isPtr() )
+                return constant + base + "*";
+            return constValue && base != "void" ? constant + base : base;
+        }
+
+        std::string CppGenerator::cppName( const std::string& name )
+        {
+            std::string result;
+            result.reserve( name.size() );
+            for ( const auto c : name )
+            {
+                if ( c == '<' )
+                    result += "__";
+                else if ( c == ',' )
+                    result += '_';
+                else if ( c != '>' && c != ' ' )
+                    result += c;
+            }
+            static const std::unordered_set< std::string > reserved { "t", "runtime", "std", "memo" };
+            if ( reserved.count( result ) || ( !result.empty() && result.back() == '_' ) )
+                result += '_';
+            return result;
+        }
+
+        void CppGenerator::forwardDeclare( TextArena& out, const ast::StatementList& body, size_t depth ) const
+        {
+            Emitter emit { out };
+            for ( const auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                const auto expr = stmt.as< ast::Expression >();
+                if ( auto cls = expr->as< ast::ClassDeclaration >() )
+                {
+                    emit.indent( depth );
+                    out.append( "class " ).append( cppName( cls->getType().getName() ) ).append( ";\n" );
+                }
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >(); nsp && declaresClass( nsp->getBody() ) )
+                {
+                    emit.indent( depth );
+                    out.append( "namespace " ).append( cppName( nsp->getName().getSymbol() ) ).append( '\n' );
+                    emit.indent( depth );
+                    out.append( "{\n" );
+                    forwardDeclare( out, nsp->getBody(), depth + 1 );
+                    emit.indent( depth );
+                    out.append( "}\n" );
+                }
+            }
+            if ( depth == 0 )
+                out.append( '\n' );
+        }
+
+        void CppGenerator::declare( TextArena& out, const ast::StatementList& body, size_t depth ) const
+        {
+            Emitter emit { out };
+            for ( const auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                const auto expr = stmt.as< ast::Expression >();
+                if ( auto cls = expr->as< ast::ClassDeclaration >() )
+                {
+                    declareClass( out, *cls, depth );
+                }
+                else if ( auto func = expr->as< ast::FunctionDeclaration >() )
+                {
+                    emit.indent( depth );
+                    out.append( cppType( func->getReturnType(), false ) ).append( ' ' ).append( cppName( func->getName().getSymbol() ) );
+                    emit.parameters( func->getParamList() );
+                    out.append( ";\n" );
+                }
+                else if ( auto var = expr->as< ast::VariableDeclaration >() )
+                {
+                    emit.indent( depth );
+                    emit.variable( *var, true );
+                    out.append( ";\n" );
+                }
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                {
+                    emit.indent( depth );
+                    out.append( "namespace " ).append( cppName( nsp->getName().getSymbol() ) ).append( '\n' );
+                    emit.indent( depth );
+                    out.append( "{\n" );
+                    declare( out, nsp->getBody(), depth + 1 );
+                    emit.indent( depth );
+                    out.append( "}\n" );
+                }
+            }
+            if ( depth == 0 )
+                out.append( '\n' );
+        }
+
+        void CppGenerator::declareClass( TextArena& out, const ast::ClassDeclaration& cls, size_t depth ) const
+        {
+            Emitter emit { out };
+            const auto name = cppName( cls.getType().getName() );
+            emit.indent( depth );
+            out.append( "class " ).append( name ).append( '\n' );
+            emit.indent( depth );
+            out.append( "{\n" );
+
+            // Classes are private by default in T as in C++
+            auto spec = ast::AccessSpecifier::Private;
+            const auto access = [ & ]( ast::AccessSpecifier next ){
+                if ( next == spec )
+                    return;
+                spec = next;
+                emit.indent( depth );
+                out.append( ast::specToStr( spec ) ).append( ":\n" );
+            };
+            for ( const auto& method : cls.getMethods() )
+            {
+                access( method.spec );
+                const auto& func = method.func;
+                emit.indent( depth + 1 );
+                if ( func.getName().getSymbol() == "constructor" )
+                    out.append( name );
+                else
+                    out.append( cppType( func.getReturnType(), false ) ).append( ' ' ).append( cppName( func.getName().getSymbol() ) );
+                emit.parameters( func.getParamList() );
+                out.append( isConstMethod( func ) ? " const;\n" : ";\n" );
+            }
+            for ( const auto& field : cls.getFields() )
+            {
+                access( field.spec );
+                emit.indent( depth + 1 );
+                emit.variable( field.var, false );
+                out.append( ";\n" );
+            }
+
+            emit.indent( depth );
+            out.append( "};\n\n" );
+        }
+
+        void CppGenerator::defineFunction( TextArena& out, const analysis::FunctionBody& body, const analysis::FunctionInfo& info ) const
+        {
+            Emitter emit { out };
+            const auto& func = *body.decl;
+            if ( func.isExternal() )
+                return;
+
+            auto nsp = info.scope;
+            std::string owner;
+            if ( !info.className.empty() )
+            {
+                owner = cppName( info.className );
+                nsp = nsp.size() == info.className.size() ? "" : nsp.substr( 0, nsp.size() - info.className.size() - 2 );
+            }
+            const auto depth = nsp.empty() ? 0 : 1;
+            if ( !nsp.empty() )
+                out.append( "namespace " ).append( qualifiedName( nsp ) ).append( "\n{\n" );
+
+            emit.findMoves( func.getBody() );
+            emit.indent( depth );
+            if ( func.getName().getSymbol() == "constructor" )
+                out.append( owner ).append( "::" ).append( owner );
+            else
+            {
+                out.append( cppType( func.getReturnType(), false ) ).append( ' ' );
+                out.append( owner ).append( owner.empty() ? "" : "::" ).append( cppName( func.getName().getSymbol() ) );
+            }
+            emit.parameters( func.getParamList() );
+            if ( !owner.empty() && isConstMethod( func ) )
+                out.append( " const" );
+            out.append( '\n' );
+
+            const auto& params = func.getParamList();
+            // selectMemoized() rejects the rest
+            const auto memoizable = func.isMemoized() && analysis::hasMemoizableSignature( func );
+            if ( !memoizable )
+                emit.block( func.getBody(), depth );
+            else
+            {
+                // The body becomes the compute step of a per-function cache.
+                // MemoCache has no lock, so each thread keeps its own.
+                const auto type = cppType( func.getReturnType(), false );
+                emit.indent( depth );
+                out.append( "{\n" );
+                emit.indent( depth + 1 );
+                out.append( "static thread_local t::runtime::MemoCache< " ).append( type ).append( " > memo;\n" );
+                emit.indent( depth + 1 );
+                out.append( "return memo.getOrCompute( t::runtime::MemoKey::of(" );
+                for ( size_t n = 0; n < params.size(); n++ )
+                    out.append( n ? ", " : " " ).append( cppName( params[ n ].getIdentifier().getSymbol() ) );
+                out.append( params.empty() ? ")" : " )" ).append( ", [ & ]() -> " ).append( type ).append( '\n' );
+                emit.block( func.getBody(), depth + 1, " );" );
+                emit.indent( depth );
+                out.append( "}\n" );
+            }
+
+            if ( !nsp.empty() )
+                out.append( "}\n" );
+            out.append( '\n' );
+        }
+
+        void CppGenerator::defineMain( TextArena& out ) const
+        {
+            const auto& body = program.getBody();
+            const auto isStatement = []( const ast::Statement& stmt ){
+                return stmt.is< ast::Type::Scope >() || ( stmt.is< ast::Type::Expression >() && !isDeclaration( stmt.as< ast::Expression >() ) );
+            };
+            if ( std::none_of( body.cbegin(), body.cend(), isStatement ) )
+                return;
+
+            Emitter emit { out };
+            out.append( "int main()\n{\n" );
+            for ( const auto& stmt : body )
+                if ( isStatement( stmt ) )
+                    emit.statement( stmt, 1 );
+            out.append( "    return 0;\n}\n" );
+        }
+    }
+}
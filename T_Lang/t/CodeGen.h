@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+
+#include "Effects.h"
+#include "ThreadPool.h"
+
+namespace t
+{
+    namespace codegen
+    {
+        // Bump allocated text owned by one thread. A piece is appended to and
+        // then finished; the view returned for it stays valid as long as the
+        // arena does, since chunks are never moved or freed early.
+        class TextArena
+        {
+        public:
+            explicit TextArena( size_t chunkSize = 64 * 1024 ):
+                chunkSize( chunkSize ) {}
+
+            TextArena& append( std::string_view text );
+
+            TextArena& append( char c ) { return append( std::string_view( &c, 1 ) ); }
+
+            // Ends the current piece and returns it
+            std::string_view finish();
+
+            // Bytes reserved for all chunks so far
+            size_t capacity() const { return reserved; }
+        private:
+            std::vector< std::unique_ptr< char[] > > chunks;
+            size_t chunkSize;
+            size_t reserved = 0;
+            char* piece = nullptr;
+            char* at = nullptr;
+            char* end = nullptr;
+        };
+
+        // Lowers a program to C++ that builds against t/runtime. Declarations
+        // are written first on the calling thread, then the body of every
+        // function and method is generated on the pool into the arena of the
+        // thread that picked it up. Linking concatenates the bodies in
+        // declaration order, so the output is byte for byte the same for any
+        // number of threads.
+        class CppGenerator
+        {
+        public:
+            CppGenerator( ast::Program& program ):
+                program( program ) {}
+
+            std::string generate();
+
+            std::string generate( ThreadPool& pool );
+
+            // The C++ spelling of a T type. Values are const unless they are
+            // mutable or constValue is false, as for fields and return types.
+            static std::string cppType( const ast::TypeName& type, bool constValue = true );
+
+            // Mangled instantiations such as `Box<int32>` become identifiers.
+            // Names the generated code relies on, `t`, `runtime`, `std` and
+            // `memo`, get a trailing underscore, as does any name that already
+            // ends in one so the escaped names cannot clash either.
+            static std::string cppName( const std::string& name );
+        private:
+            ast::Program& program;
+
+            // Classes are forward declared first so signatures can name any of them
+            void forwardDeclare( TextArena& out, const ast::StatementList& body, size_t depth ) const;
+
+            void declare( TextArena& out, const ast::StatementList& body, size_t depth ) const;
+
+            void declareClass( TextArena& out, const ast::ClassDeclaration& cls, size_t depth ) const;
+
+            void defineFunction( TextArena& out, const analysis::FunctionBody& body, const analysis::FunctionInfo& info ) const;
+
+            // Top-level statements run from main() in source order
+            void defineMain( TextArena& out ) const;
+        };
+    }
+}
@@ -0,0 +1,215 @@
+#include "Concat.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        size_t ConcatFuser::run()
+        {
+            collectDeclarations( program.getBody() );
+            visitDeclarations( program.getBody() );
+            return fused;
+        }
+
+        void ConcatFuser::collectDeclarations( const ast::StatementList& body )
+        {
+            for ( const auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                auto expr = stmt.as< ast::Expression >();
+                if ( auto func = expr->as< ast::FunctionDeclaration >() )
+                    functions[ func->getName().getSymbol() ] = isString( func->getReturnType() );
+                else if ( auto var = expr->as< ast::VariableDeclaration >() )
+                    globals[ var->getIdentifier().getSymbol() ] = isString( var->getType() );
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                    collectDeclarations( nsp->getBody() );
+            }
+        }
+
+        void ConcatFuser::visitDeclarations( ast::StatementList& body )
+        {
+            for ( auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                auto expr = stmt.as< ast::Expression >();
+                if ( auto func = expr->as< ast::FunctionDeclaration >() )
+                {
+                    locals.clear();
+                    visitFunction( *func );
+                }
+                else if ( auto cls = expr->as< ast::ClassDeclaration >() )
+                {
+                    locals.clear();
+                    for ( auto& field : cls->getFields() )
+                    {
+                        fuse( field.var.getMutableValue() );
+                        locals.emplace_back( field.var.getIdentifier().getSymbol(), isString( field.var.getType() ) );
+                    }
+                    const auto fields = locals;
+                    for ( auto& method : cls->getMethods() )
+                    {
+                        locals = fields;
+                        visitFunction( method.func );
+                    }
+                }
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                {
+                    visitDeclarations( nsp->getBody() );
+                }
+                else
+                {
+                    locals.clear();
+                    visit( stmt );
+                }
+            }
+        }
+
+        void ConcatFuser::visitFunction( ast::FunctionDeclaration& func )
+        {
+            for ( const auto& param : func.getParamList() )
+                locals.emplace_back( param.getIdentifier().getSymbol(), isString( param.getTypeName() ) );
+            visitBlock( func.getBody() );
+        }
+
+        void ConcatFuser::visitBlock( ast::StatementList& body )
+        {
+            const auto size = locals.size();
+            for ( auto& stmt : body )
+                visit( stmt );
+            locals.resize( size );
+        }
+
+        void ConcatFuser::visit( ast::Statement& stmt )
+        {
+            if ( stmt.is< ast::Type::Scope >() )
+                visitBlock( *stmt.as< ast::StatementList >() );
+            else if ( stmt.is< ast::Type::Expression >() )
+            {
+                std::unique_ptr< ast::Expression > expr { stmt.release< ast::Expression >() };
+                fuse( expr );
+                stmt = ast::Statement( expr.release() );
+            }
+        }
+
+        bool ConcatFuser::lookup( const Names& names, const std::string& name, bool& result ) const
+        {
+            const auto it = names.find( name );
+            if ( it == names.cend() )
+                return false;
+            result = it->second;
+            return true;
+        }
+
+        bool ConcatFuser::lookup( const Locals& names, const std::string& name, bool& result ) const
+        {
+            for ( auto it = names.crbegin(); it != names.crend(); ++it )
+            {
+                if ( it->first == name )
+                {
+                    result = it->second;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool ConcatFuser::isStringValued( const ast::Expression* expr ) const
+        {
+            if ( !expr )
+                return false;
+            if ( expr->is< ast::StringLiteral >() || expr->is< ast::ConcatExpression >() )
+                return true;
+            bool result = false;
+            if ( auto id = expr->as< ast::Identifier >() )
+                return lookup( locals, id->getSymbol(), result ) ? result : lookup( globals, id->getSymbol(), result ) && result;
+            if ( auto call = expr->as< ast::FunctionCall >() )
+                return lookup( functions, call->getName().getSymbol(), result ) && result;
+            if ( auto bin = expr->as< ast::BinaryExpression >() )
+                return isConcat( *bin );
+            return false;
+        }
+
+        bool ConcatFuser::isConcat( const ast::BinaryExpression& bin ) const
+        {
+            return bin.getOperator() == "+" && ( isStringValued( bin.getLhs() ) || isStringValued( bin.getRhs() ) );
+        }
+
+        void ConcatFuser::flatten( std::unique_ptr< ast::Expression >&& expr, std::vector< std::unique_ptr< ast::Expression > >& parts )
+        {
+            if ( auto bin = expr->as< ast::BinaryExpression >(); bin && isConcat( *bin ) )
+            {
+                flatten( std::move( bin->getMutableLhs() ), parts );
+                flatten( std::move( bin->getMutableRhs() ), parts );
+                return;
+            }
+            if ( auto concat = expr->as< ast::ConcatExpression >() )
+            {
+                for ( auto& part : concat->getParts() )
+                    parts.push_back( std::move( part ) );
+                return;
+            }
+            fuse( expr );
+            parts.push_back( std::move( expr ) );
+        }
+
+        void ConcatFuser::fuse( std::unique_ptr< ast::Expression >& expr )
+        {
+            if ( !expr )
+                return;
+            if ( auto bin = expr->as< ast::BinaryExpression >() )
+            {
+                if ( isConcat( *bin ) )
+                {
+                    std::vector< std::unique_ptr< ast::Expression > > parts;
+                    flatten( std::move( expr ), parts );
+                    expr = std::make_unique< ast::ConcatExpression >( std::move( parts ) );
+                    fused++;
+                    return;
+                }
+                fuse( bin->getMutableLhs() );
+                fuse( bin->getMutableRhs() );
+            }
+            else if ( auto var = expr->as< ast::VariableDeclaration >() )
+            {
+                fuse( var->getMutableValue() );
+                locals.emplace_back( var->getIdentifier().getSymbol(), isString( var->getType() ) );
+            }
+            else if ( auto assign = expr->as< ast::AssignmentExpression >() )
+            {
+                fuse( assign->getMutableRhs() );
+            }
+            else if ( auto call = expr->as< ast::FunctionCall >() )
+            {
+                for ( auto& arg : call->getParameters() )
+                    visit( arg );
+            }
+            else if ( auto ret = expr->as< ast::ReturnStatement >() )
+            {
+                visit( ret->getStatement() );
+            }
+            else if ( auto ifstmt = expr->as< ast::IfStatement >() )
+            {
+                fuse( ifstmt->getMutableCondition() );
+                visitBlock( ifstmt->getBody() );
+            }
+            else if ( auto loop = expr->as< ast::ForInStatement >() )
+            {
+                fuse( loop->getMutableRange() );
+                const auto size = locals.size();
+                locals.emplace_back( loop->getVariable().getSymbol(), isString( loop->getType() ) );
+                visitBlock( loop->getBody() );
+                locals.resize( size );
+            }
+            else if ( auto unary = expr->as< ast::UnaryExpression< true > >() )
+            {
+                fuse( unary->getMutableExpression() );
+            }
+            else if ( auto unary = expr->as< ast::UnaryExpression< false > >() )
+            {
+                fuse( unary->getMutableExpression() );
+            }
+        }
+    }
+}
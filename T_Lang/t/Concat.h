@@ -0,0 +1,62 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "AST.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        // Replaces chains of `+` on Strings with a single ConcatExpression so
+        // `a + b + c + d` allocates once instead of building every prefix.
+        // Only the part of a chain that is String typed is flattened, so in
+        // `1 + 2 + s` the integer addition still happens first.
+        class ConcatFuser
+        {
+        public:
+            ConcatFuser( ast::Program& program ):
+                program( program ) {}
+
+            // Returns the number of chains that were fused
+            size_t run();
+        private:
+            using Names = std::unordered_map< std::string, bool >;
+            // Innermost last, so a block ends by truncating to its size on entry
+            using Locals = std::vector< std::pair< std::string, bool > >;
+
+            ast::Program& program;
+            size_t fused = 0;
+            // Whether each global and each function returns or holds a String
+            Names globals;
+            Names functions;
+            Locals locals;
+
+            static bool isString( const ast::TypeName& type ) { return type.getName() == "String"; }
+
+            void collectDeclarations( const ast::StatementList& body );
+
+            void visitDeclarations( ast::StatementList& body );
+
+            void visitFunction( ast::FunctionDeclaration& func );
+
+            void visit( ast::Statement& stmt );
+
+            // Names declared in body go out of scope at its end
+            void visitBlock( ast::StatementList& body );
+
+            bool lookup( const Names& names, const std::string& name, bool& result ) const;
+
+            bool lookup( const Locals& names, const std::string& name, bool& result ) const;
+
+            bool isStringValued( const ast::Expression* expr ) const;
+
+            bool isConcat( const ast::BinaryExpression& bin ) const;
+
+            // Moves the operands of a String `+` chain into 'parts', left to right
+            void flatten( std::unique_ptr< ast::Expression >&& expr, std::vector< std::unique_ptr< ast::Expression > >& parts );
+
+            void fuse( std::unique_ptr< ast::Expression >& expr );
+        };
+    }
+}
@@ -0,0 +1,315 @@
+#include "ConstEval.h"
+
+namespace t
+{
+    namespace eval
+    {
+        void ConstEvaluator::run()
+        {
+            collect( program.getBody(), "" );
+            fold( program.getBody(), "" );
+        }
+
+        Value ConstEvaluator::evaluate( const ast::Expression* expr, const std::string& scope)
+        {
+            steps = 0;
+            depth = 0;
+            memory = 0;
+            Frame frame { scope };
+            return eval( expr, frame );
+        }
+
+        std::string ConstEvaluator::qualify( const std::string& scope, const std::string& name )
+        {
+            return scope.empty() ? name : scope + "::" + name;
+        }
+
+        void ConstEvaluator::collect( ast::StatementList& body, const std::string& scope )
+        {
+            for ( auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                auto expr = stmt.as< ast::Expression >();
+                if ( auto func = expr->as< ast::FunctionDeclaration >(); func && func->isConstexpr() )
+                    functions[ qualify( scope, func->getName().getSymbol() ) ] = func;
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                    collect( nsp->getBody(), qualify( scope, nsp->getName().getSymbol() ) );
+            }
+        }
+
+        void ConstEvaluator::fold( ast::StatementList& body, const std::string& scope )
+        {
+            for ( auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                auto expr = stmt.as< ast::Expression >();
+                if ( auto var = expr->as< ast::VariableDeclaration >(); var && var->isConstexpr() )
+                {
+                    const auto& name = var->getIdentifier().getSymbol();
+                    auto value = convert( evaluate( var->getValue(), scope ), var->getType(), name );
+                    var->setValue( toLiteral( value, name ) );
+                    constants[ qualify( scope, name ) ] = std::move( value );
+                }
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                    fold( nsp->getBody(), qualify( scope, nsp->getName().getSymbol() ) );
+            }
+        }
+
+        std::unique_ptr< ast::Expression > ConstEvaluator::toLiteral( const Value& value, const std::string& name )
+        {
+            ast::Expression* lit = nullptr;
+            switch ( value.index() )
+            {
+            case 1: lit = new ast::NumericLiteral< int64_t >( std::get< int64_t >( value ) ); break;
+            case 2: lit = new ast::NumericLiteral< uint64_t >( std::get< uint64_t >( value ) ); break;
+            case 3: lit = new ast::NumericLiteral< double >( std::get< double >( value ) ); break;
+            case 4: lit = new ast::BoolLiteral( std::get< bool >( value ) ); break;
+            case 5: lit = new ast::StringLiteral( std::string( std::get< std::string >( value ) ) ); break;
+            default: throw std::runtime_error( "constexpr variable " + name + " has no value" );
+            }
+            return std::unique_ptr< ast::Expression >( lit );
+        }
+
+        Value ConstEvaluator::convert( const Value& value, const ast::TypeName& type, const std::string& name )
+        {
+            static const std::unordered_map< std::string, std::pair< int64_t, uint64_t > > integers
+            {
+                { "int8", { INT8_MIN, INT8_MAX } }, { "int16", { INT16_MIN, INT16_MAX } },
+                { "int32", { INT32_MIN, INT32_MAX } }, { "int64", { INT64_MIN, INT64_MAX } },
+                { "uint8", { 0, UINT8_MAX } }, { "uint16", { 0, UINT16_MAX } },
+                { "uint32", { 0, UINT32_MAX } }, { "uint64", { 0, UINT64_MAX } },
+            };
+            const auto& typeName = type.getName();
+            if ( typeName == "float" || typeName == "double" )
+                return value.index() == 1 || value.index() == 2 ? Value( as< double >( value ) ) : value;
+
+            const auto range = integers.find( typeName );
+            if ( range == integers.cend() )
+                return value;
+            const auto doesNotFit = [ & ]{
+                return std::runtime_error( "value of constexpr " + name + " does not fit in " + typeName );
+            };
+            const auto [ min, max ] = range->second;
+            const bool isSigned = typeName[ 0 ] == 'i';
+            switch ( value.index() )
+            {
+            case 1:
+            {
+                const auto v = std::get< int64_t >( value );
+                if ( v < min || ( v > 0 && static_cast< uint64_t >( v ) > max ) )
+                    throw doesNotFit();
+                return isSigned ? value : Value( static_cast< uint64_t >( v ) );
+            }
+            case 2:
+            {
+                const auto v = std::get< uint64_t >( value );
+                if ( v > max )
+                    throw doesNotFit();
+                return isSigned ? Value( static_cast< int64_t >( v ) ) : value;
+            }
+            case 3:
+            {
+                // Only whole numbers convert, anything else would silently truncate
+                const auto v = std::get< double >( value );
+                if ( v != std::trunc( v ) || v < static_cast< double >( min ) || v >= static_cast< double >( max ) + 1.0 )
+                    throw doesNotFit();
+                return isSigned ? Value( static_cast< int64_t >( v ) ) : Value( static_cast< uint64_t >( v ) );
+            }
+            default:
+                throw doesNotFit();
+            }
+        }
+
+        void ConstEvaluator::step()
+        {
+            if ( ++steps > limits.maxSteps )
+                throw std::runtime_error( "constexpr evaluation exceeded step limit" );
+        }
+
+        void ConstEvaluator::charge( size_t bytes )
+        {
+            memory += bytes;
+            if ( memory > limits.maxMemory )
+                throw std::runtime_error( "constexpr evaluation exceeded memory limit" );
+        }
+
+        void ConstEvaluator::exec( const ast::Statement& stmt, Frame& frame )
+        {
+            if ( stmt.is< ast::Type::Scope >() )
+            {
+                for ( const auto& inner : *stmt.as< ast::StatementList >() )
+                {
+                    exec( inner, frame );
+                    if ( frame.returned )
+                        return;
+                }
+                return;
+            }
+            if ( stmt.isNot< ast::Type::Expression >() )
+                throw std::runtime_error( "statement is not allowed in a constant expression" );
+            exec( stmt.as< ast::Expression >(), frame );
+        }
+
+        void ConstEvaluator::exec( const ast::Expression* expr, Frame& frame )
+        {
+            if ( auto ret = expr->as< ast::ReturnStatement >() )
+            {
+                const auto& inner = ret->getStatement();
+                frame.result = inner.is< ast::Type::Expression >() ? eval( inner.as< ast::Expression >(), frame ) : Value();
+                frame.returned = true;
+            }
+            else if ( auto ifstmt = expr->as< ast::IfStatement >() )
+            {
+                if ( !truthy( eval( ifstmt->getCondition(), frame ) ) )
+                    return;
+                for ( const auto& stmt : ifstmt->getBody() )
+                {
+                    exec( stmt, frame );
+                    if ( frame.returned )
+                        return;
+                }
+            }
+            else if ( auto var = expr->as< ast::VariableDeclaration >() )
+            {
+                auto value = var->getValue() ? eval( var->getValue(), frame ) : Value();
+                frame.locals[ var->getIdentifier().getSymbol() ] = std::move( value );
+            }
+            else
+            {
+                eval( expr, frame );
+            }
+        }
+
+        Value ConstEvaluator::eval( const ast::Expression* expr, Frame& frame )
+        {
+            step();
+            if ( auto lit = expr->as< ast::NumericLiteral< int64_t > >() )
+                return lit->getValue();
+            if ( auto lit = expr->as< ast::NumericLiteral< uint64_t > >() )
+                return lit->getValue();
+            if ( auto lit = expr->as< ast::NumericLiteral< double > >() )
+                return lit->getValue();
+            if ( auto lit = expr->as< ast::BoolLiteral >() )
+                return lit->getValue();
+            if ( auto lit = expr->as< ast::CharacterLiteral >() )
+                return static_cast< uint64_t >( static_cast< unsigned char >( lit->getValue()[ 0 ] ) );
+            if ( auto lit = expr->as< ast::StringLiteral >() )
+            {
+                charge( lit->getValue().size() );
+                return lit->getValue();
+            }
+            if ( auto id = expr->as< ast::Identifier >() )
+            {
+                if ( const auto it = frame.locals.find( id->getSymbol() ); it != frame.locals.cend() )
+                    return it->second;
+                if ( const auto it = lookup( constants, frame.scope, id->getSymbol() ); it != constants.cend() )
+                    return it->second;
+                throw std::runtime_error( "'" + id->getSymbol() + "' is not a constant expression" );
+            }
+            if ( auto assign = expr->as< ast::AssignmentExpression >() )
+            {
+                const auto target = assign->getLhs()->as< ast::Identifier >();
+                if ( !target || frame.locals.find( target->getSymbol() ) == frame.locals.cend() )
+                    throw std::runtime_error( "constexpr functions may only assign to their own locals" );
+                auto value = eval( assign->getRhs(), frame );
+                frame.locals[ target->getSymbol() ] = value;
+                return value;
+            }
+            if ( auto bin = expr->as< ast::BinaryExpression >() )
+                return binary( bin->getOperator(), eval( bin->getLhs(), frame ), eval( bin->getRhs(), frame ) );
+            if ( auto concat = expr->as< ast::ConcatExpression >() )
+            {
+                Value result = eval( concat->getParts().front().get(), frame );
+                for ( size_t idx = 1; idx < concat->getParts().size(); idx++ )
+                    result = binary( "+", result, eval( concat->getParts()[ idx ].get(), frame ) );
+                return result;
+            }
+            if ( auto call = expr->as< ast::FunctionCall >() )
+                return invoke( *call, frame );
+            throw std::runtime_error( "expression is not allowed in a constant expression" );
+        }
+
+        Value ConstEvaluator::invoke( const ast::FunctionCall& call, Frame& caller )
+        {
+            const auto& name = call.getName().getSymbol();
+            const auto it = lookup( functions, caller.scope, name );
+            if ( it == functions.cend() )
+                throw std::runtime_error( "call to non-constexpr function " + name + " in a constant expression" );
+            const auto& func = *it->second;
+            const auto& params = func.getParamList();
+            const auto& args = call.getParameters();
+            if ( params.size() != args.size() )
+                throw std::runtime_error( "wrong number of arguments in constexpr call to " + name );
+
+            if ( ++depth > limits.maxCallDepth )
+                throw std::runtime_error( "constexpr evaluation exceeded call depth limit" );
+            charge( sizeof( Frame ) );
+
+            const auto pos = it->first.rfind( "::" );
+            Frame frame { pos == std::string::npos ? "" : it->first.substr( 0, pos ) };
+            for ( size_t idx = 0; idx < params.size(); idx++ )
+            {
+                if ( args[ idx ].isNot< ast::Type::Expression >() )
+                    throw std::runtime_error( "invalid argument in constexpr call to " + name );
+                const auto& param = params[ idx ].getIdentifier().getSymbol();
+                frame.locals[ param ] = convert( eval( args[ idx ].as< ast::Expression >(), caller ), params[ idx ].getTypeName(),
+                                                 "argument " + param + " of " + name );
+            }
+            for ( const auto& stmt : func.getBody() )
+            {
+                exec( stmt, frame );
+                if ( frame.returned )
+                    break;
+            }
+
+            depth--;
+            memory -= sizeof( Frame );
+            return convert( frame.result, func.getReturnType(), "result of " + name );
+        }
+
+        bool ConstEvaluator::truthy( const Value& v )
+        {
+            switch ( v.index() )
+            {
+            case 1: return std::get< int64_t >( v ) != 0;
+            case 2: return std::get< uint64_t >( v ) != 0;
+            case 3: return std::get< double >( v ) != 0.0;
+            case 4: return std::get< bool >( v );
+            case 5: return !std::get< std::string >( v ).empty();
+            default: throw std::runtime_error( "condition has no value" );
+            }
+        }
+
+        Value ConstEvaluator::binary( const std::string& op, const Value& lhs, const Value& rhs )
+        {
+            if ( lhs.index() == 5 || rhs.index() == 5 )
+            {
+                if ( lhs.index() != rhs.index() )
+                    throw std::runtime_error( "cannot mix String and non-String operands in constant expression" );
+                const auto& a = std::get< std::string >( lhs );
+                const auto& b = std::get< std::string >( rhs );
+                if ( op == "==" ) return a == b;
+                if ( op == "!=" ) return a != b;
+                if ( op != "+" )
+                    throw std::runtime_error( "operator " + op + " is not defined on String" );
+                charge( a.size() + b.size() );
+                return a + b;
+            }
+            if ( lhs.index() == 3 || rhs.index() == 3 )
+                return arithmetic( op, as< double >( lhs ), as< double >( rhs ) );
+            if ( lhs.index() == 1 || rhs.index() == 1 )
+            {
+                // Signed wins, an unsigned operand past its range would wrap
+                const auto tooLarge = []( const Value& v ){
+                    return v.index() == 2 && std::get< uint64_t >( v ) > static_cast< uint64_t >( INT64_MAX );
+                };
+                if ( tooLarge( lhs ) || tooLarge( rhs ) )
+                    throw std::runtime_error( "unsigned operand does not fit in int64 in constant expression" );
+                return arithmetic( op, as< int64_t >( lhs ), as< int64_t >( rhs ) );
+            }
+            return arithmetic( op, as< uint64_t >( lhs ), as< uint64_t >( rhs ) );
+        }
+    }
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+#include <variant>
+
+#include "AST.h"
+
+namespace t
+{
+    namespace eval
+    {
+        using Value = std::variant< std::monostate, int64_t, uint64_t, double, bool, std::string >;
+
+        struct Limits
+        {
+            // Expressions evaluated per top-level constexpr initializer
+            uint64_t maxSteps = 1'000'000;
+            uint32_t maxCallDepth = 512;
+            // Bytes allocated for strings and call frames per initializer
+            size_t maxMemory = 16 * 1024 * 1024;
+        };
+
+        // Interprets constexpr functions at build time and replaces the
+        // initializer of every constexpr variable with the resulting literal.
+        // Each initializer gets its own step budget so one runaway
+        // computation fails the build instead of hanging it.
+        class ConstEvaluator
+        {
+        public:
+            ConstEvaluator( ast::Program& program, Limits limits = Limits() ):
+                program( program ), limits( limits ) {}
+
+            void run();
+
+            Value evaluate( const ast::Expression* expr, const std::string& scope = "" );
+
+            const std::unordered_map< std::string, Value >& getConstants() const { return constants; }
+        private:
+            struct Frame
+            {
+                explicit Frame( std::string scope ):
+                    scope( std::move( scope ) ) {}
+
+                std::string scope;
+                std::unordered_map< std::string, Value > locals;
+                bool returned = false;
+                Value result;
+            };
+
+            ast::Program& program;
+            Limits limits;
+            std::unordered_map< std::string, const ast::FunctionDeclaration* > functions;
+            std::unordered_map< std::string, Value > constants;
+            uint64_t steps = 0;
+            uint32_t depth = 0;
+            size_t memory = 0;
+
+            static std::string qualify( const std::string& scope, const std::string& name );
+
+            template< typename Container >
+            static auto lookup( Container& names, std::string scope, const std::string& name )
+            {
+                while ( true )
+                {
+                    const auto it = names.find( qualify( scope, name ) );
+                    if ( it != names.end() || scope.empty() )
+                        return it;
+                    const auto pos = scope.rfind( "::" );
+                    scope = pos == std::string::npos ? "" : scope.substr( 0, pos );
+                }
+            }
+
+            void collect( ast::StatementList& body, const std::string& scope );
+
+            void fold( ast::StatementList& body, const std::string& scope );
+
+            static std::unique_ptr< ast::Expression > toLiteral( const Value& value, const std::string& name );
+
+            // Converts a folded value to the declared type of the variable,
+            // failing if it does not fit
+            static Value convert( const Value& value, const ast::TypeName& type, const std::string& name );
+
+            void step();
+
+            void charge( size_t bytes );
+
+            void exec( const ast::Statement& stmt, Frame& frame );
+
+            void exec( const ast::Expression* expr, Frame& frame );
+
+            Value eval( const ast::Expression* expr, Frame& frame );
+
+            Value invoke( const ast::FunctionCall& call, Frame& caller );
+
+            static bool truthy( const Value& v );
+
+            template< typename T >
+            static T as( const Value& v )
+            {
+                switch ( v.index() )
+                {
+                case 1: return static_cast< T >( std::get< int64_t >( v ) );
+                case 2: return static_cast< T >( std::get< uint64_t >( v ) );
+                case 3: return static_cast< T >( std::get< double >( v ) );
+                case 4: return static_cast< T >( std::get< bool >( v ) );
+                default: throw std::runtime_error( "expected numeric operand in constant expression" );
+                }
+            }
+
+            static void overflow() { throw std::runtime_error( "integer overflow in constant expression" ); }
+
+            // Integer results that do not fit are reported rather than left to
+            // wrap or trap, as the compiler itself would do either
+            template< typename T >
+            static T add( T a, T b )
+            {
+                if constexpr ( std::is_signed_v< T > )
+                {
+                    if ( ( b > 0 && a > std::numeric_limits< T >::max() - b ) || ( b < 0 && a < std::numeric_limits< T >::min() - b ) )
+                        overflow();
+                }
+                else if ( a > std::numeric_limits< T >::max() - b )
+                    overflow();
+                return a + b;
+            }
+
+            template< typename T >
+            static T subtract( T a, T b )
+            {
+                if constexpr ( std::is_signed_v< T > )
+                {
+                    if ( ( b < 0 && a > std::numeric_limits< T >::max() + b ) || ( b > 0 && a < std::numeric_limits< T >::min() + b ) )
+                        overflow();
+                }
+                else if ( a < b )
+                    overflow();
+                return a - b;
+            }
+
+            template< typename T >
+            static T multiply( T a, T b )
+            {
+                constexpr auto max = std::numeric_limits< T >::max();
+                constexpr auto min = std::numeric_limits< T >::min();
+                if ( a == 0 || b == 0 )
+                    return 0;
+                if constexpr ( std::is_signed_v< T > )
+                {
+                    if ( a > 0 ? ( b > 0 ? a > max / b : b < min / a ) : ( b > 0 ? a < min / b : b < max / a ) )
+                        overflow();
+                }
+                else if ( a > max / b )
+                    overflow();
+                return a * b;
+            }
+
+            // By squaring, so a large exponent costs at most 64 steps
+            template< typename T >
+            static T power( T base, T exponent )
+            {
+                if constexpr ( std::is_signed_v< T > )
+                {
+                    if ( exponent < 0 )
+                        return static_cast< T >( std::pow( base, exponent ) );
+                }
+                T result = 1;
+                while ( exponent )
+                {
+                    if ( exponent & 1 )
+                        result = multiply( result, base );
+                    exponent >>= 1;
+                    if ( exponent )
+                        base = multiply( base, base );
+                }
+                return result;
+            }
+
+            template< typename T >
+            static Value arithmetic( const std::string& op, T a, T b )
+            {
+                if ( op == "==" ) return a == b;
+                if ( op == "!=" ) return a != b;
+                if constexpr ( std::is_floating_point_v< T > )
+                {
+                    if ( op == "+" ) return a + b;
+                    if ( op == "-" ) return a - b;
+                    if ( op == "*" ) return a * b;
+                    if ( op == "**" ) return std::pow( a, b );
+                }
+                else
+                {
+                    if ( op == "+" ) return add( a, b );
+                    if ( op == "-" ) return subtract( a, b );
+                    if ( op == "*" ) return multiply( a, b );
+                    if ( op == "**" ) return power( a, b );
+                }
+                if ( ( op == "/" || op == "%" ) && b == 0 )
+                    throw std::runtime_error( "division by zero in constant expression" );
+                if constexpr ( std::is_signed_v< T > && std::is_integral_v< T > )
+                {
+                    // The one quotient that does not fit, and traps on most hardware
+                    if ( a == std::numeric_limits< T >::min() && b == -1 )
+                    {
+                        if ( op == "%" )
+                            return T( 0 );
+                        overflow();
+                    }
+                }
+                if ( op == "/" ) return a / b;
+                if ( op == "%" )
+                {
+                    if constexpr ( std::is_floating_point_v< T > )
+                        return std::fmod( a, b );
+                    else
+                        return a % b;
+                }
+                throw std::runtime_error( "operator " + op + " is not allowed in a constant expression" );
+            }
+
+            Value binary( const std::string& op, const Value& lhs, const Value& rhs );
+        };
+    }
+}
@@ -0,0 +1,483 @@
+#include "Diff.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "runtime/Hash.h"
+
+namespace t
+{
+    namespace ast
+    {
+        namespace
+        {
+            namespace hashing = runtime::hashing;
+
+            // Distinguishes node kinds whose fields would otherwise hash alike
+            enum Tag : uint64_t
+            {
+                EmptyTag = 1,
+                ScopeTag,
+                ListTag,
+                IdentifierTag,
+                TypeNameTag,
+                IntegerTag,
+                UnsignedTag,
+                FloatTag,
+                StringTag,
+                CharacterTag,
+                BoolTag,
+                BinaryTag,
+                ConcatTag,
+                PreUnaryTag,
+                PostUnaryTag,
+                AssignmentTag,
+                CallTag,
+                VariableTag,
+                ParameterTag,
+                FunctionTag,
+                FieldTag,
+                MethodTag,
+                ClassTag,
+                GenericTag,
+                ReturnTag,
+                NameSpaceTag,
+                IfTag,
+                ForInTag,
+                UnknownTag,
+            };
+
+            uint64_t combine( uint64_t h, uint64_t v ) { return hashing::mix( h ^ v, hashing::SEED1 ); }
+
+            uint64_t text( const std::string& s ) { return hashing::bytes( s.data(), s.size() ); }
+
+            template< typename T >
+            uint64_t bits( T value )
+            {
+                uint64_t word = 0;
+                std::memcpy( &word, &value, sizeof( T ) );
+                return word;
+            }
+
+            uint64_t hashTree( const Statement& stmt )
+            {
+                if ( stmt.is< Type::Expression >() )
+                    return hashTree( *stmt.as< Expression >() );
+                if ( stmt.is< Type::Scope >() )
+                    return combine( ScopeTag, hashTree( *stmt.as< StatementList >() ) );
+                return EmptyTag;
+            }
+
+            uint64_t hashOf( const Expression* expr ) { return expr ? hashTree( *expr ) : EmptyTag; }
+
+            uint64_t typeHash( const TypeName& type )
+            {
+                const auto flags = ( type.isMutableType() ? 1 : 0 ) | ( type.isRef() ? 2 : 0 ) | ( type.isPtr() ? 4 : 0 );
+                return combine( combine( TypeNameTag, text( type.getName() ) ), flags );
+            }
+
+            uint64_t compute( const Expression& expr )
+            {
+                if ( auto id = expr.as< Identifier >() )
+                    return combine( combine( IdentifierTag, text( id->getSymbol() ) ), id->getOwnership() == Ownership::ExplicitMove );
+                if ( auto type = expr.as< TypeName >() )
+                    return typeHash( *type );
+                if ( auto lit = expr.as< NumericLiteral< int64_t > >() )
+                    return combine( IntegerTag, bits( lit->getValue() ) );
+                if ( auto lit = expr.as< NumericLiteral< uint64_t > >() )
+                    return combine( UnsignedTag, lit->getValue() );
+                if ( auto lit = expr.as< NumericLiteral< double > >() )
+                    return combine( FloatTag, bits( lit->getValue() ) );
+                if ( auto lit = expr.as< StringLiteral >() )
+                    return combine( StringTag, text( lit->getValue() ) );
+                if ( auto lit = expr.as< CharacterLiteral >() )
+                    return combine( CharacterTag, text( lit->getValue() ) );
+                if ( auto lit = expr.as< BoolLiteral >() )
+                    return combine( BoolTag, lit->getValue() );
+                if ( auto bin = expr.as< BinaryExpression >() )
+                    return combine( combine( combine( BinaryTag, text( bin->getOperator() ) ), hashOf( bin->getLhs() ) ), hashOf( bin->getRhs() ) );
+                if ( auto concat = expr.as< ConcatExpression >() )
+                {
+                    uint64_t h = ConcatTag;
+                    for ( const auto& part : concat->getParts() )
+                        h = combine( h, hashOf( part.get() ) );
+                    return h;
+                }
+                if ( auto unary = expr.as< UnaryExpression< true > >() )
+                    return combine( combine( PreUnaryTag, text( unary->getOperator() ) ), hashOf( unary->getExpression() ) );
+                if ( auto unary = expr.as< UnaryExpression< false > >() )
+                    return combine( combine( PostUnaryTag, text( unary->getOperator() ) ), hashOf( unary->getExpression() ) );
+                if ( auto assign = expr.as< AssignmentExpression >() )
+                    return combine( combine( AssignmentTag, hashOf( assign->getLhs() ) ), hashOf( assign->getRhs() ) );
+                if ( auto call = expr.as< FunctionCall >() )
+                    return combine( combine( CallTag, text( call->getName().getSymbol() ) ), hashTree( call->getParameters() ) );
+                if ( auto var = expr.as< VariableDeclaration >() )
+                {
+                    auto h = combine( VariableTag, var->isMutableVar() | var->isConstexpr() << 1 );
+                    h = combine( h, hashTree( var->getType() ) );
+                    h = combine( h, text( var->getIdentifier().getSymbol() ) );
+                    return combine( h, hashOf( var->getValue() ) );
+                }
+                if ( auto param = expr.as< Parameter >() )
+                    return combine( combine( ParameterTag, hashTree( param->getTypeName() ) ), text( param->getIdentifier().getSymbol() ) );
+                if ( auto func = expr.as< FunctionDeclaration >() )
+                {
+                    auto h = combine( FunctionTag, func->isMemoized() | func->isConstexpr() << 1 );
+                    h = combine( h, hashTree( func->getReturnType() ) );
+                    h = combine( h, text( func->getName().getSymbol() ) );
+                    for ( const auto& param : func->getParamList() )
+                        h = combine( h, hashTree( param ) );
+                    return combine( h, hashTree( func->getBody() ) );
+                }
+                if ( auto field = expr.as< FieldDeclaration >() )
+                    return combine( combine( FieldTag, field->spec ), hashTree( field->var ) );
+                if ( auto method = expr.as< MethodDeclaration >() )
+                    return combine( combine( MethodTag, method->spec ), hashTree( method->func ) );
+                if ( auto cls = expr.as< ClassDeclaration >() )
+                {
+                    auto h = combine( ClassTag, hashTree( cls->getType() ) );
+                    for ( const auto& field : cls->getFields() )
+                        h = combine( h, hashTree( field ) );
+                    for ( const auto& method : cls->getMethods() )
+                        h = combine( h, hashTree( method ) );
+                    return h;
+                }
+                if ( auto generic = expr.as< GenericDeclaration >() )
+                {
+                    auto h = combine( combine( GenericTag, text( generic->getName() ) ), generic->isClassTemplate() );
+                    for ( const auto& param : generic->getParams() )
+                        h = combine( h, text( param ) );
+                    return combine( h, generic->getPatternHash() );
+                }
+                if ( auto ret = expr.as< ReturnStatement >() )
+                    return combine( ReturnTag, hashTree( ret->getStatement() ) );
+                if ( auto nsp = expr.as< NameSpaceDeclaration >() )
+                    return combine( combine( NameSpaceTag, text( nsp->getName().getSymbol() ) ), hashTree( nsp->getBody() ) );
+                if ( auto ifstmt = expr.as< IfStatement >() )
+                    return combine( combine( IfTag, hashOf( ifstmt->getCondition() ) ), hashTree( ifstmt->getBody() ) );
+                if ( auto loop = expr.as< ForInStatement >() )
+                {
+                    auto h = combine( ForInTag, hashTree( loop->getType() ) );
+                    h = combine( h, text( loop->getVariable().getSymbol() ) );
+                    h = combine( h, hashOf( loop->getRange() ) );
+                    return combine( h, hashTree( loop->getBody() ) );
+                }
+                return UnknownTag;
+            }
+
+            uint64_t stored( const Expression& expr ) { return expr.getHash() ? expr.getHash() : hashTree( expr ); }
+
+            std::string qualify( const std::string& scope, const std::string& name )
+            {
+                return scope.empty() ? name : scope + "::" + name;
+            }
+
+            std::string signature( const ParameterList& params )
+            {
+                std::string sig = "(";
+                for ( size_t n = 0; n < params.size(); n++ )
+                {
+                    const auto& type = params[ n ].getTypeName();
+                    sig += ( n ? "," : "" ) + std::string( type.isMutableType() ? "mutable " : "" ) + type.getName() +
+                           ( type.isRef() ? "~" : type.isPtr() ? "->" : "" );
+                }
+                return sig + ")";
+            }
+
+            using Uses = std::vector< std::string >;
+
+            // The identifiers in a name, `Map<String,Box>` gives Map, String and Box
+            void words( const std::string& name, Uses& uses )
+            {
+                size_t start = 0;
+                for ( size_t at = 0; at <= name.size(); at++ )
+                {
+                    const auto c = at < name.size() ? name[ at ] : ' ';
+                    if ( std::isalnum( static_cast< unsigned char >( c ) ) || c == '_' )
+                        continue;
+                    if ( at > start )
+                        uses.push_back( name.substr( start, at - start ) );
+                    start = at + 1;
+                }
+            }
+
+            void references( const StatementList& stmts, Uses& uses );
+
+            void references( const Expression* expr, Uses& uses )
+            {
+                if ( !expr )
+                    return;
+                if ( auto id = expr->as< Identifier >() )
+                    uses.push_back( id->getSymbol() );
+                else if ( auto type = expr->as< TypeName >() )
+                    words( type->getName(), uses );
+                else if ( auto bin = expr->as< BinaryExpression >() )
+                {
+                    references( bin->getLhs(), uses );
+                    references( bin->getRhs(), uses );
+                }
+                else if ( auto concat = expr->as< ConcatExpression >() )
+                {
+                    for ( const auto& part : concat->getParts() )
+                        references( part.get(), uses );
+                }
+                else if ( auto unary = expr->as< UnaryExpression< true > >() )
+                    references( unary->getExpression(), uses );
+                else if ( auto unary = expr->as< UnaryExpression< false > >() )
+                    references( unary->getExpression(), uses );
+                else if ( auto assign = expr->as< AssignmentExpression >() )
+                {
+                    references( assign->getLhs(), uses );
+                    references( assign->getRhs(), uses );
+                }
+                else if ( auto call = expr->as< FunctionCall >() )
+                {
+                    words( call->getName().getSymbol(), uses );
+                    references( call->getParameters(), uses );
+                }
+                else if ( auto var = expr->as< VariableDeclaration >() )
+                {
+                    references( &var->getType(), uses );
+                    references( var->getValue(), uses );
+                }
+                else if ( auto param = expr->as< Parameter >() )
+                    references( &param->getTypeName(), uses );
+                else if ( auto func = expr->as< FunctionDeclaration >() )
+                {
+                    references( &func->getReturnType(), uses );
+                    for ( const auto& param : func->getParamList() )
+                        references( &param, uses );
+                    references( func->getBody(), uses );
+                }
+                else if ( auto ret = expr->as< ReturnStatement >() )
+                {
+                    if ( ret->getStatement().is< Type::Expression >() )
+                        references( ret->getStatement().as< Expression >(), uses );
+                }
+                else if ( auto ifstmt = expr->as< IfStatement >() )
+                {
+                    references( ifstmt->getCondition(), uses );
+                    references( ifstmt->getBody(), uses );
+                }
+                else if ( auto loop = expr->as< ForInStatement >() )
+                {
+                    references( &loop->getType(), uses );
+                    references( loop->getRange(), uses );
+                    references( loop->getBody(), uses );
+                }
+            }
+
+            void references( const StatementList& stmts, Uses& uses )
+            {
+                for ( const auto& stmt : stmts )
+                {
+                    if ( stmt.is< Type::Expression >() )
+                        references( stmt.as< Expression >(), uses );
+                    else if ( stmt.is< Type::Scope >() )
+                        references( *stmt.as< StatementList >(), uses );
+                }
+            }
+
+            Uses sorted( Uses&& uses )
+            {
+                std::sort( uses.begin(), uses.end() );
+                uses.erase( std::unique( uses.begin(), uses.end() ), uses.end() );
+                return std::move( uses );
+            }
+
+            template< typename Node >
+            Uses usesOf( const Node& node )
+            {
+                Uses uses;
+                references( &node, uses );
+                return sorted( std::move( uses ) );
+            }
+
+            // The types in its fields and method signatures
+            Uses layoutUses( const ClassDeclaration& cls )
+            {
+                Uses uses;
+                for ( const auto& field : cls.getFields() )
+                    references( &field.var.getType(), uses );
+                for ( const auto& method : cls.getMethods() )
+                {
+                    references( &method.func.getReturnType(), uses );
+                    for ( const auto& param : method.func.getParamList() )
+                        references( &param, uses );
+                }
+                return sorted( std::move( uses ) );
+            }
+
+            // What users of a class see: its name, fields and method signatures
+            uint64_t layoutHash( const ClassDeclaration& cls )
+            {
+                auto h = combine( ClassTag, stored( cls.getType() ) );
+                for ( const auto& field : cls.getFields() )
+                    h = combine( h, stored( field ) );
+                for ( const auto& method : cls.getMethods() )
+                {
+                    const auto& func = method.func;
+                    h = combine( combine( h, method.spec ), stored( func.getReturnType() ) );
+                    h = combine( h, text( func.getName().getSymbol() ) );
+                    for ( const auto& param : func.getParamList() )
+                        h = combine( h, stored( param ) );
+                }
+                return h;
+            }
+
+            void collect( const StatementList& body, const std::string& scope, DeclarationHashes& out )
+            {
+                size_t statements = 0;
+                for ( const auto& stmt : body )
+                {
+                    const auto expr = stmt.is< Type::Expression >() ? stmt.as< Expression >() : nullptr;
+                    if ( auto func = expr ? expr->as< FunctionDeclaration >() : nullptr )
+                    {
+                        const auto& name = func->getName().getSymbol();
+                        out.push_back( { qualify( scope, name ) + signature( func->getParamList() ), stored( *func ), name, usesOf( *func ) } );
+                    }
+                    else if ( auto cls = expr ? expr->as< ClassDeclaration >() : nullptr )
+                    {
+                        const auto& className = cls->getType().getName();
+                        const auto classScope = qualify( scope, className );
+                        out.push_back( { classScope, layoutHash( *cls ), className, layoutUses( *cls ) } );
+                        for ( const auto& method : cls->getMethods() )
+                        {
+                            // A method reads the fields, so it uses the layout of its class
+                            auto uses = usesOf( method.func );
+                            uses.insert( std::lower_bound( uses.begin(), uses.end(), className ), className );
+                            const auto& name = method.func.getName().getSymbol();
+                            out.push_back( { qualify( classScope, name ) + signature( method.func.getParamList() ), stored( method ), name, sorted( std::move( uses ) ) } );
+                        }
+                    }
+                    else if ( auto var = expr ? expr->as< VariableDeclaration >() : nullptr )
+                    {
+                        const auto& name = var->getIdentifier().getSymbol();
+                        out.push_back( { qualify( scope, name ), stored( *var ), name, usesOf( *var ) } );
+                    }
+                    else if ( auto generic = expr ? expr->as< GenericDeclaration >() : nullptr )
+                    {
+                        // Only the pattern's hash is kept, not what it refers to
+                        out.push_back( { "template " + qualify( scope, generic->getName() ), stored( *generic ), generic->getName(), {} } );
+                    }
+                    else if ( auto nsp = expr ? expr->as< NameSpaceDeclaration >() : nullptr )
+                    {
+                        collect( nsp->getBody(), qualify( scope, nsp->getName().getSymbol() ), out );
+                    }
+                    else
+                    {
+                        // Top-level statements run in order, so each is keyed by its position
+                        const auto h = expr ? stored( *expr ) : hashTree( stmt );
+                        Uses uses;
+                        if ( expr )
+                            references( expr, uses );
+                        else if ( stmt.is< Type::Scope >() )
+                            references( *stmt.as< StatementList >(), uses );
+                        out.push_back( { qualify( scope, "statement #" + std::to_string( ++statements ) ), h, "", sorted( std::move( uses ) ) } );
+                    }
+                }
+            }
+        }
+
+        uint64_t hashTree( const Expression& expr )
+        {
+            auto h = compute( expr );
+            // 0 is kept for nodes that were never hashed
+            if ( h == 0 )
+                h = 1;
+            expr.setHash( h );
+            return h;
+        }
+
+        uint64_t hashTree( const StatementList& stmts )
+        {
+            auto h = combine( ListTag, stmts.size() );
+            for ( const auto& stmt : stmts )
+                h = combine( h, hashTree( stmt ) );
+            return h;
+        }
+
+        DeclarationHashes declarationHashes( const Program& program )
+        {
+            DeclarationHashes hashes;
+            collect( program.getBody(), "", hashes );
+
+            // Names the language rejects twice still need distinct keys
+            std::unordered_map< std::string, size_t > seen;
+            for ( auto& decl : hashes )
+                if ( const auto n = seen[ decl.name ]++ )
+                    decl.name += " #" + std::to_string( n + 1 );
+            return hashes;
+        }
+
+        std::vector< DeclarationChange > diff( const DeclarationHashes& before, const DeclarationHashes& after )
+        {
+            std::unordered_map< std::string, uint64_t > old;
+            for ( const auto& decl : before )
+                old.emplace( decl.name, decl.hash );
+
+            std::vector< DeclarationChange > changes;
+            for ( const auto& decl : after )
+            {
+                const auto it = old.find( decl.name );
+                if ( it == old.cend() )
+                    changes.push_back( { DeclarationChange::Added, decl.name } );
+                else
+                {
+                    if ( it->second != decl.hash )
+                        changes.push_back( { DeclarationChange::Changed, decl.name } );
+                    old.erase( it );
+                }
+            }
+            for ( const auto& decl : before )
+                if ( old.find( decl.name ) != old.cend() )
+                    changes.push_back( { DeclarationChange::Removed, decl.name } );
+
+            // Anything that names a listed declaration may resolve or behave
+            // differently now, and so may whatever names it in turn
+            std::unordered_set< std::string > listed;
+            for ( const auto& change : changes )
+                listed.insert( change.name );
+            std::unordered_set< std::string > dirty;
+            const auto mark = [ & ]( const DeclarationHashes& decls ){
+                for ( const auto& decl : decls )
+                    if ( !decl.symbol.empty() && listed.count( decl.name ) )
+                        dirty.insert( decl.symbol );
+            };
+            mark( before );
+            mark( after );
+
+            std::vector< uint8_t > affected( after.size(), 0 );
+            for ( bool grew = !dirty.empty(); grew; )
+            {
+                grew = false;
+                for ( size_t n = 0; n < after.size(); n++ )
+                {
+                    const auto& decl = after[ n ];
+                    if ( affected[ n ] || listed.count( decl.name ) )
+                        continue;
+                    const auto uses = std::any_of( decl.uses.cbegin(), decl.uses.cend(), [ & ]( const std::string& name ){
+                        return dirty.count( name ) != 0;
+                    } );
+                    if ( !uses )
+                        continue;
+                    affected[ n ] = 1;
+                    if ( !decl.symbol.empty() && dirty.insert( decl.symbol ).second )
+                        grew = true;
+                }
+            }
+            for ( size_t n = 0; n < after.size(); n++ )
+                if ( affected[ n ] )
+                    changes.push_back( { DeclarationChange::Affected, after[ n ].name } );
+            return changes;
+        }
+
+        std::vector< DeclarationChange > diff( const Program& before, const Program& after )
+        {
+            return diff( declarationHashes( before ), declarationHashes( after ) );
+        }
+    }
+}
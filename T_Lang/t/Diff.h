@@ -0,0 +1,65 @@
+#pragma once
+
+#include "AST.h"
+
+namespace t
+{
+    namespace ast
+    {
+        // Hash of what a tree means rather than how it was written: comments
+        // and layout never reach the AST, so editing them keeps every hash.
+        // Each node is hashed from its own kind and value and the hashes of
+        // its children, and the result is stored on the node. Analysis
+        // annotations such as effects are left out. Hashes are the same from
+        // run to run, so a build can keep them between invocations.
+        uint64_t hashTree( const Expression& expr );
+
+        uint64_t hashTree( const StatementList& stmts );
+
+        // One unit of recompilation: a function, method, class layout, global,
+        // template or top-level statement, with the hash of its tree
+        struct DeclarationHash
+        {
+            // Qualified, with the parameter types for functions and methods so
+            // overloads are told apart, e.g. "shapes::Box::scale(double)"
+            std::string name;
+            uint64_t hash;
+            // The unqualified name others refer to it by, "scale"; empty for
+            // a top-level statement
+            std::string symbol;
+            // Sorted names it refers to: callees, variables, types and
+            // templates. Names are not resolved, so this may list more than
+            // it really depends on, but never less.
+            std::vector< std::string > uses;
+        };
+
+        using DeclarationHashes = std::vector< DeclarationHash >;
+
+        // In declaration order, reusing the hashes stored by the parser
+        DeclarationHashes declarationHashes( const Program& program );
+
+        struct DeclarationChange
+        {
+            enum Kind : uint8_t
+            {
+                Added,
+                Removed,
+                Changed,
+                // Unchanged itself, but it uses a declaration that is listed
+                Affected,
+            };
+
+            Kind kind;
+            std::string name;
+        };
+
+        // Declarations of after that are new or whose hash differs, in the
+        // order of after, followed by those only in before, followed by the
+        // declarations of after that use a listed one, directly or through
+        // other affected ones. Declarations that are not listed do not need
+        // to be rebuilt.
+        std::vector< DeclarationChange > diff( const DeclarationHashes& before, const DeclarationHashes& after );
+
+        std::vector< DeclarationChange > diff( const Program& before, const Program& after );
+    }
+}
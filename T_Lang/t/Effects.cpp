@@ -0,0 +1,314 @@
+#include "Effects.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        std::string SymbolTable::qualify( const std::string& scope, const std::string& name )
+        {
+            return scope.empty() ? name : scope + "::" + name;
+        }
+
+        const FunctionInfo* SymbolTable::findFunction( const std::string& qualifiedName ) const
+        {
+            const auto it = functions.find( qualifiedName );
+            return it == functions.cend() ? nullptr : &it->second;
+        }
+
+        FunctionInfo* SymbolTable::findFunction( const std::string& qualifiedName )
+        {
+            const auto it = functions.find( qualifiedName );
+            return it == functions.end() ? nullptr : &it->second;
+        }
+
+        std::string SymbolTable::resolveFunction( const std::string& scope, const std::string& name ) const
+        {
+            return resolve( functions, scope, name );
+        }
+
+        std::string SymbolTable::resolveClass( const std::string& scope, const std::string& name ) const
+        {
+            return resolve( classes, scope, name );
+        }
+
+        std::string SymbolTable::resolveGlobal( const std::string& scope, const std::string& name ) const
+        {
+            return resolve( globals, scope, name );
+        }
+
+        std::string SymbolTable::resolveGeneric( const std::string& scope, const std::string& name ) const
+        {
+            return resolve( generics, scope, name );
+        }
+
+        void SymbolTable::collect( ast::StatementList& body, const std::string& scope )
+        {
+            for ( auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                auto expr = stmt.as< ast::Expression >();
+                if ( auto func = expr->as< ast::FunctionDeclaration >() )
+                {
+                    addFunction( *func, scope, "" );
+                }
+                else if ( auto cls = expr->as< ast::ClassDeclaration >() )
+                {
+                    const auto& className = cls->getType().getName();
+                    const auto classScope = qualify( scope, className );
+                    addClass( classScope );
+                    for ( const auto& field : cls->getFields() )
+                        addGlobal( qualify( classScope, field.var.getIdentifier().getSymbol() ), &field.var.getType() );
+                    for ( auto& method : cls->getMethods() )
+                        addFunction( method.func, classScope, className );
+                }
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                {
+                    collect( nsp->getBody(), qualify( scope, nsp->getName().getSymbol() ) );
+                }
+                else if ( auto var = expr->as< ast::VariableDeclaration >() )
+                {
+                    addGlobal( qualify( scope, var->getIdentifier().getSymbol() ), &var->getType() );
+                }
+                else if ( auto generic = expr->as< ast::GenericDeclaration >() )
+                {
+                    addGeneric( qualify( scope, generic->getName() ) );
+                }
+            }
+        }
+
+        void SymbolTable::addFunction( ast::FunctionDeclaration& func, const std::string& scope, const std::string& className )
+        {
+            auto name = qualify( scope, func.getName().getSymbol() );
+            auto& info = addFunction( name );
+            info.decls.push_back( &func );
+            info.scope = scope;
+            info.className = className;
+            bodies.push_back( FunctionBody { std::move( name ), &func } );
+        }
+
+        const ast::TypeName* SymbolTable::globalType( const std::string& qualifiedName ) const
+        {
+            const auto it = globals.find( qualifiedName );
+            return it == globals.cend() ? nullptr : it->second;
+        }
+
+        ast::Effect SymbolTable::effectOf( const std::string& qualifiedName ) const
+        {
+            const auto info = findFunction( qualifiedName );
+            return info ? info->effect : ast::Effect::Writes;
+        }
+
+        bool SymbolTable::canReorder( const std::string& first, const std::string& second ) const
+        {
+            const auto a = effectOf( first );
+            const auto b = effectOf( second );
+            if ( a == ast::Effect::Writes )
+                return b == ast::Effect::Pure;
+            if ( b == ast::Effect::Writes )
+                return a == ast::Effect::Pure;
+            return true;
+        }
+
+        SymbolTable EffectAnalyzer::analyze()
+        {
+            table.collect( program.getBody() );
+
+            for ( auto& [ name, info ] : table.getFunctions() )
+            {
+                for ( auto* decl : info.decls )
+                {
+                    Locals locals;
+                    for ( const auto& param : decl->getParamList() )
+                        locals.emplace_back( param.getIdentifier().getSymbol(), &param.getTypeName() );
+                    visitBlock( decl->getBody(), info, locals );
+                }
+                if ( info.hasUnresolvedCall )
+                    info.localEffect = ast::Effect::Writes;
+                info.effect = info.localEffect;
+            }
+
+            propagate();
+
+            for ( auto& [ name, info ] : table.getFunctions() )
+                for ( auto* decl : info.decls )
+                    decl->setEffect( info.effect );
+
+            return std::move( table );
+        }
+
+        void EffectAnalyzer::propagate()
+        {
+            auto& functions = table.getFunctions();
+            bool changed = true;
+            while ( changed )
+            {
+                changed = false;
+                for ( auto& [ name, info ] : functions )
+                {
+                    auto effect = info.effect;
+                    for ( const auto& callee : info.callees )
+                        effect = join( effect, table.effectOf( callee ) );
+                    if ( effect != info.effect )
+                    {
+                        info.effect = effect;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        void EffectAnalyzer::visit( const ast::Statement& stmt, FunctionInfo& info, Locals& locals )
+        {
+            switch ( stmt.getKind() )
+            {
+            case ast::Type::Expression:
+                return visit( stmt.as< ast::Expression >(), info, locals );
+            case ast::Type::Scope:
+                return visitBlock( *stmt.as< ast::StatementList >(), info, locals );
+            default:
+                raise( info, ast::Effect::Writes );
+            }
+        }
+
+        void EffectAnalyzer::visit( const ast::Expression* expr, FunctionInfo& info, Locals& locals )
+        {
+            if ( !expr )
+                return;
+            if ( auto var = expr->as< ast::VariableDeclaration >() )
+            {
+                visit( var->getValue(), info, locals );
+                locals.emplace_back( var->getIdentifier().getSymbol(), &var->getType() );
+            }
+            else if ( auto assign = expr->as< ast::AssignmentExpression >() )
+            {
+                visit( assign->getRhs(), info, locals );
+                visitWrite( assign->getLhs(), info, locals );
+            }
+            else if ( auto id = expr->as< ast::Identifier >() )
+            {
+                if ( !findLocal( locals, id->getSymbol() ) )
+                    raise( info, ast::Effect::ReadOnly );
+            }
+            else if ( auto bin = expr->as< ast::BinaryExpression >() )
+            {
+                visit( bin->getLhs(), info, locals );
+                if ( bin->getOperator() != "." )
+                    return visit( bin->getRhs(), info, locals );
+                if ( auto call = bin->getRhs()->as< ast::FunctionCall >() )
+                    visitMethodCall( bin->getLhs(), *call, info, locals );
+            }
+            else if ( auto concat = expr->as< ast::ConcatExpression >() )
+            {
+                for ( const auto& part : concat->getParts() )
+                    visit( part.get(), info, locals );
+            }
+            else if ( auto call = expr->as< ast::FunctionCall >() )
+            {
+                const auto callee = table.resolveFunction( info.scope, call->getName().getSymbol() );
+                addCallee( callee, info );
+                visitArguments( *call, info, locals );
+            }
+            else if ( auto ret = expr->as< ast::ReturnStatement >() )
+            {
+                visit( ret->getStatement(), info, locals );
+            }
+            else if ( auto ifstmt = expr->as< ast::IfStatement >() )
+            {
+                visit( ifstmt->getCondition(), info, locals );
+                visitBlock( ifstmt->getBody(), info, locals );
+            }
+            else if ( auto loop = expr->as< ast::ForInStatement >() )
+            {
+                visit( loop->getRange(), info, locals );
+                const auto outer = locals.size();
+                locals.emplace_back( loop->getVariable().getSymbol(), &loop->getType() );
+                visitBlock( loop->getBody(), info, locals );
+                locals.resize( outer );
+            }
+            else if ( auto unary = expr->as< ast::UnaryExpression< true > >() )
+            {
+                visitWrite( unary->getExpression(), info, locals );
+            }
+            else if ( auto unary = expr->as< ast::UnaryExpression< false > >() )
+            {
+                visitWrite( unary->getExpression(), info, locals );
+            }
+            else if ( expr->is< ast::FunctionDeclaration >() || expr->is< ast::ClassDeclaration >() || expr->is< ast::NameSpaceDeclaration >() )
+            {
+                raise( info, ast::Effect::Writes );
+            }
+        }
+
+        void EffectAnalyzer::visitBlock( const ast::StatementList& body, FunctionInfo& info, Locals& locals )
+        {
+            const auto outer = locals.size();
+            for ( const auto& stmt : body )
+                visit( stmt, info, locals );
+            locals.resize( outer );
+        }
+
+        const ast::TypeName* EffectAnalyzer::findLocal( const Locals& locals, const std::string& name )
+        {
+            for ( auto it = locals.crbegin(); it != locals.crend(); ++it )
+                if ( it->first == name )
+                    return it->second;
+            return nullptr;
+        }
+
+        void EffectAnalyzer::visitWrite( const ast::Expression* target, FunctionInfo& info, Locals& locals )
+        {
+            if ( auto bin = target->as< ast::BinaryExpression >(); bin && bin->getOperator() == "." )
+            {
+                visit( bin->getRhs()->is< ast::Identifier >() ? nullptr : bin->getRhs(), info, locals );
+                target = bin->getLhs();
+                while ( ( bin = target->as< ast::BinaryExpression >() ) && bin->getOperator() == "." )
+                    target = bin->getLhs();
+            }
+            const auto id = target->as< ast::Identifier >();
+            if ( !id )
+            {
+                visit( target, info, locals );
+                return raise( info, ast::Effect::Writes );
+            }
+            const auto local = findLocal( locals, id->getSymbol() );
+            if ( !local || local->isRef() || local->isPtr() )
+                raise( info, ast::Effect::Writes );
+        }
+
+        void EffectAnalyzer::visitMethodCall( const ast::Expression* receiver, const ast::FunctionCall& call, FunctionInfo& info, Locals& locals )
+        {
+            std::string callee;
+            if ( auto id = receiver->as< ast::Identifier >() )
+            {
+                const ast::TypeName* type = nullptr;
+                if ( const auto local = findLocal( locals, id->getSymbol() ) )
+                    type = local;
+                else
+                    type = table.globalType( table.resolveGlobal( info.scope, id->getSymbol() ) );
+                if ( type )
+                {
+                    const auto cls = table.resolveClass( info.scope, type->getName() );
+                    if ( !cls.empty() && table.findFunction( SymbolTable::qualify( cls, call.getName().getSymbol() ) ) )
+                        callee = SymbolTable::qualify( cls, call.getName().getSymbol() );
+                }
+            }
+            addCallee( callee, info );
+            visitArguments( call, info, locals );
+        }
+
+        void EffectAnalyzer::visitArguments( const ast::FunctionCall& call, FunctionInfo& info, Locals& locals )
+        {
+            for ( const auto& arg : call.getParameters() )
+                visit( arg, info, locals );
+        }
+
+        void EffectAnalyzer::addCallee( const std::string& callee, FunctionInfo& info )
+        {
+            if ( callee.empty() )
+                info.hasUnresolvedCall = true;
+            else
+                info.callees.insert( callee );
+        }
+    }
+}
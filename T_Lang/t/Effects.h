@@ -0,0 +1,200 @@
+#pragma once
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "AST.h"
+#include "Lexer.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        struct FunctionInfo
+        {
+            // Overloads share one summary, so a name can map to several declarations
+            std::vector< ast::FunctionDeclaration* > decls;
+            std::string scope;
+            std::string className;
+            ast::Effect localEffect = ast::Effect::Pure;
+            ast::Effect effect = ast::Effect::Pure;
+            std::unordered_set< std::string > callees;
+            bool hasUnresolvedCall = false;
+        };
+
+        // A function or method body, in declaration order
+        struct FunctionBody
+        {
+            std::string name;
+            ast::FunctionDeclaration* decl;
+        };
+
+        class SymbolTable
+        {
+        public:
+            static std::string qualify( const std::string& scope, const std::string& name );
+
+            // Records the signature of every function, method, class, field,
+            // global and template declared in body and its namespaces
+            void collect( ast::StatementList& body, const std::string& scope = "" );
+
+            FunctionInfo& addFunction( const std::string& qualifiedName ) { return functions[ qualifiedName ]; }
+            void addClass( const std::string& qualifiedName ) { classes.insert( qualifiedName ); }
+            void addGlobal( const std::string& qualifiedName, const ast::TypeName* type ) { globals[ qualifiedName ] = type; }
+            void addGeneric( const std::string& qualifiedName ) { generics.insert( qualifiedName ); }
+
+            const FunctionInfo* findFunction( const std::string& qualifiedName ) const;
+
+            FunctionInfo* findFunction( const std::string& qualifiedName );
+
+            // Looks a name up from the innermost scope outwards, returns "" if nothing matches
+            std::string resolveFunction( const std::string& scope, const std::string& name ) const;
+
+            std::string resolveClass( const std::string& scope, const std::string& name ) const;
+
+            std::string resolveGlobal( const std::string& scope, const std::string& name ) const;
+
+            std::string resolveGeneric( const std::string& scope, const std::string& name ) const;
+
+            const ast::TypeName* globalType( const std::string& qualifiedName ) const;
+
+            // Unknown functions are assumed to write
+            ast::Effect effectOf( const std::string& qualifiedName ) const;
+
+            bool isPure( const std::string& qualifiedName ) const { return effectOf( qualifiedName ) == ast::Effect::Pure; }
+
+            // Identical arguments always give identical results
+            bool canMemoize( const std::string& qualifiedName ) const { return isPure( qualifiedName ); }
+
+            // Two identical calls with no write in between give the same result
+            bool canEliminateCommonCall( const std::string& qualifiedName ) const { return effectOf( qualifiedName ) != ast::Effect::Writes; }
+
+            // Two calls commute if neither observes what the other writes
+            bool canReorder( const std::string& first, const std::string& second ) const;
+
+            bool canParallelize( const std::string& first, const std::string& second ) const { return canReorder( first, second ); }
+
+            const std::unordered_map< std::string, FunctionInfo >& getFunctions() const { return functions; }
+            std::unordered_map< std::string, FunctionInfo >& getFunctions() { return functions; }
+
+            const std::vector< FunctionBody >& getBodies() const { return bodies; }
+        private:
+            template< typename Container >
+            static std::string resolve( const Container& names, std::string scope, const std::string& name )
+            {
+                while ( true )
+                {
+                    auto qualified = qualify( scope, name );
+                    if ( names.find( qualified ) != names.cend() )
+                        return qualified;
+                    if ( scope.empty() )
+                        return "";
+                    const auto pos = scope.rfind( "::" );
+                    scope = pos == std::string::npos ? "" : scope.substr( 0, pos );
+                }
+            }
+
+            std::unordered_map< std::string, FunctionInfo > functions;
+            std::unordered_set< std::string > classes;
+            std::unordered_map< std::string, const ast::TypeName* > globals;
+            std::unordered_set< std::string > generics;
+            std::vector< FunctionBody > bodies;
+
+            void addFunction( ast::FunctionDeclaration& func, const std::string& scope, const std::string& className );
+        };
+
+        // Infers whether every function and method is pure, only reads
+        // non-local state or writes through mutable references, pointers,
+        // globals or fields. Calls are resolved per declaration and the
+        // summaries are propagated over the call graph until they settle.
+        class EffectAnalyzer
+        {
+        public:
+            EffectAnalyzer( ast::Program& program ):
+                program( program ) {}
+
+            SymbolTable analyze();
+        private:
+            // Innermost last, so a block ends by truncating to its size on entry
+            using Locals = std::vector< std::pair< std::string, const ast::TypeName* > >;
+
+            ast::Program& program;
+            SymbolTable table;
+
+            static ast::Effect join( ast::Effect a, ast::Effect b ) { return a > b ? a : b; }
+
+            static void raise( FunctionInfo& info, ast::Effect e ) { info.localEffect = join( info.localEffect, e ); }
+
+            void propagate();
+
+            void visit( const ast::Statement& stmt, FunctionInfo& info, Locals& locals );
+
+            void visit( const ast::Expression* expr, FunctionInfo& info, Locals& locals );
+
+            void visitBlock( const ast::StatementList& body, FunctionInfo& info, Locals& locals );
+
+            static const ast::TypeName* findLocal( const Locals& locals, const std::string& name );
+
+            // Writing a by-value local is invisible to callers, anything else is not
+            void visitWrite( const ast::Expression* target, FunctionInfo& info, Locals& locals );
+
+            void visitMethodCall( const ast::Expression* receiver, const ast::FunctionCall& call, FunctionInfo& info, Locals& locals );
+
+            void visitArguments( const ast::FunctionCall& call, FunctionInfo& info, Locals& locals );
+
+            static void addCallee( const std::string& callee, FunctionInfo& info );
+        };
+
+        inline bool isMemoizableParameter( const ast::TypeName& type )
+        {
+            const auto& name = type.getName();
+            return !type.isRef() && !type.isPtr() && name != "auto" &&
+                lexer::BUILTIN_CLASS_TYPES.find( name ) == lexer::BUILTIN_CLASS_TYPES.cend() &&
+                lexer::DEFAULT_TYPES.find( name ) != lexer::DEFAULT_TYPES.cend();
+        }
+
+        // The cache keys on the raw bits of the arguments and keeps the
+        // result by value, so both have to be primitives
+        inline bool hasMemoizableSignature( const ast::FunctionDeclaration& func )
+        {
+            const auto& params = func.getParamList();
+            return func.getReturnType().getName() != "void" && isMemoizableParameter( func.getReturnType() ) &&
+                std::all_of( params.cbegin(), params.cend(), []( const ast::Parameter& p ){ return isMemoizableParameter( p.getTypeName() ); } );
+        }
+
+        // Decides which functions get a runtime memo cache. An explicit
+        // `memoize` on a function that is not pure, or that takes or returns
+        // anything but primitives by value, is an error; in automatic mode
+        // every pure function taking only primitives by value is added.
+        inline std::vector< std::string > selectMemoized( SymbolTable& table, bool automatic )
+        {
+            std::vector< std::string > selected;
+            for ( auto& [ name, info ] : table.getFunctions() )
+            {
+                bool memoize = false;
+                for ( auto* decl : info.decls )
+                {
+                    if ( decl->isMemoized() && info.effect != ast::Effect::Pure )
+                        throw std::runtime_error( "cannot memoize function with side effects: " + name );
+                    if ( decl->isMemoized() && !hasMemoizableSignature( *decl ) )
+                        throw std::runtime_error( "cannot memoize function that takes or returns non-primitive values: " + name );
+                    memoize = memoize || decl->isMemoized();
+                }
+                if ( !memoize && automatic && info.effect == ast::Effect::Pure )
+                {
+                    memoize = std::all_of( info.decls.cbegin(), info.decls.cend(), []( const ast::FunctionDeclaration* decl )
+                    {
+                        return !decl->getParamList().empty() && hasMemoizableSignature( *decl );
+                    });
+                }
+                if ( !memoize )
+                    continue;
+                for ( auto* decl : info.decls )
+                    decl->setMemoized( true );
+                selected.push_back( name );
+            }
+            std::sort( selected.begin(), selected.end() );
+            return selected;
+        }
+    }
+}
@@ -0,0 +1,291 @@
+#include "Formatter.h"
+
+#include <algorithm>
+
+namespace t
+{
+    namespace format
+    {
+        namespace
+        {
+            using TokenType = lexer::TokenType;
+
+            bool isOperand( TokenType type )
+            {
+                switch ( type )
+                {
+                case TokenType::Identifier:
+                case TokenType::CParen:
+                case TokenType::string_literal:
+                case TokenType::char_literal:
+                case TokenType::bool_literal:
+                case TokenType::integer_literal:
+                case TokenType::negative_integer_literal:
+                case TokenType::float_literal:
+                    return true;
+                default:
+                    return false;
+                }
+            }
+
+            bool isType( TokenType type ) { return type == TokenType::ClassType || type == TokenType::PrimitiveType; }
+        }
+
+        std::string Formatter::run()
+        {
+            out.clear();
+            out.reserve( trivia.getSource().size() + trivia.getSource().size() / 8 );
+            findInlineBlocks();
+
+            for ( size_t n = 0; n < tokens.size(); n++ )
+            {
+                const auto lines = leadingTrivia( n );
+                if ( tokens[ n ].type == TokenType::EOF_ )
+                    break;
+                token( n, lines );
+                role = roleOf( n );
+            }
+            if ( !out.empty() )
+                out += '\n';
+            return std::move( out );
+        }
+
+        Formatter::Role Formatter::roleOf( size_t n )
+        {
+            const auto type = tokens[ n ].type;
+            const TokenType previous = n ? tokens[ n - 1 ].type : TokenType( TokenType::EOF_ );
+            switch ( type )
+            {
+            case TokenType::OParen:
+                parens++;
+                return Plain;
+            case TokenType::CParen:
+                parens -= parens ? 1 : 0;
+                return Plain;
+            case TokenType::OCurlyBrace:
+            case TokenType::CCurlyBrace:
+            case TokenType::Semicolon:
+                // A `<` taken for a template by mistake ends with the statement
+                angles = 0;
+                return Plain;
+            case TokenType::LessThan:
+                if ( !opensTemplate( n ) )
+                    return Plain;
+                angles++;
+                return OpenTemplate;
+            case TokenType::GreaterThan:
+                if ( !angles )
+                    return Plain;
+                angles--;
+                return CloseTemplate;
+            case TokenType::PlusPlus:
+            case TokenType::MinusMinus:
+                return isOperand( previous ) ? Plain : PrefixOperator;
+            case TokenType::Pointer:
+                return isType( previous ) || role == CloseTemplate ? TypeSuffix : Plain;
+            default:
+                return Plain;
+            }
+        }
+
+        void Formatter::findInlineBlocks()
+        {
+            inlineBrace.assign( tokens.size(), 0 );
+            // Each open brace with the number of line breaks up to it
+            std::vector< std::pair< size_t, size_t > > open;
+            size_t lines = 0;
+            for ( size_t n = 0; n < tokens.size(); n++ )
+            {
+                lines += trivia.newlines( n );
+                if ( tokens[ n ].type == TokenType::OCurlyBrace )
+                    open.emplace_back( n, lines );
+                else if ( tokens[ n ].type == TokenType::CCurlyBrace && !open.empty() )
+                {
+                    if ( open.back().second == lines )
+                        inlineBrace[ open.back().first ] = inlineBrace[ n ] = 1;
+                    open.pop_back();
+                }
+            }
+        }
+
+        size_t Formatter::leadingTrivia( size_t n )
+        {
+            if ( atStatementStart( n ) )
+                continuation = false;
+            // No blank lines at the top of a block
+            const auto blankAllowed = n && tokens[ n - 1 ].type != TokenType::OCurlyBrace;
+            const auto midStatement = !atStatementStart( n );
+
+            auto text = trivia.leading( n );
+            size_t lines = 0;
+            for ( ;; )
+            {
+                const auto at = text.find( "//" );
+                const auto gap = text.substr( 0, at );
+                lines += std::count( gap.cbegin(), gap.cend(), '\n' );
+                if ( at == std::string_view::npos )
+                    return blankAllowed ? lines : std::min< size_t >( lines, 1 );
+                text.remove_prefix( at );
+
+                const auto eol = std::min( text.find( '\n' ), text.size() );
+                auto body = text.substr( 0, eol );
+                while ( !body.empty() && ( body.back() == ' ' || body.back() == '\t' || body.back() == '\r' ) )
+                    body.remove_suffix( 1 );
+                if ( midStatement && lines )
+                    continuation = true;
+                comment( body, blankAllowed ? lines : std::min< size_t >( lines, 1 ) );
+                text.remove_prefix( eol );
+                lines = 0;
+            }
+        }
+
+        void Formatter::comment( std::string_view text, size_t lines )
+        {
+            if ( lines == 0 && !out.empty() )
+            {
+                // Stays at the end of the line it was on
+                out += ' ';
+                out += text;
+            }
+            else
+            {
+                breakPending = !out.empty();
+                startLine( lines, level() );
+                out += text;
+            }
+            breakPending = true;
+        }
+
+        void Formatter::startLine( size_t lines, size_t level )
+        {
+            if ( breakPending )
+            {
+                out += '\n';
+                if ( lines > 1 )
+                    out.append( std::min( lines - 1, style.maxBlankLines ), '\n' );
+            }
+            breakPending = false;
+            if ( style.indentWidth )
+                out.append( level * style.indentWidth, ' ' );
+            else
+                out.append( level, '\t' );
+        }
+
+        void Formatter::token( size_t n, size_t lines )
+        {
+            const auto type = tokens[ n ].type;
+            const auto place = [ & ]( size_t level ){
+                if ( breakPending )
+                    startLine( lines, level );
+                else if ( !out.empty() && spaceBefore( n ) )
+                    out += ' ';
+                out += trivia.spelling( n );
+            };
+            const auto next = tokens[ std::min( n + 1, tokens.size() - 1 ) ].type;
+
+            if ( type == TokenType::OCurlyBrace && !inlineBrace[ n ] )
+            {
+                breakPending = !out.empty();
+                continuation = false;
+                place( depth );
+                depth++;
+                breakPending = true;
+                return;
+            }
+            if ( type == TokenType::CCurlyBrace )
+            {
+                if ( inlineBrace[ n ] )
+                {
+                    place( level() );
+                    inlineBlocks -= inlineBlocks ? 1 : 0;
+                }
+                else
+                {
+                    depth -= depth ? 1 : 0;
+                    continuation = false;
+                    breakPending = !out.empty();
+                    lines = std::min< size_t >( lines, 1 );
+                    place( depth );
+                }
+                if ( !inlineBlocks && !parens )
+                    breakPending = next != TokenType::Semicolon && next != TokenType::Comma && next != TokenType::CParen;
+                return;
+            }
+            if ( type.isAccessSpecifier() && next == TokenType::Colon && !inlineBlocks )
+            {
+                breakPending = !out.empty();
+                place( depth ? depth - 1 : 0 );
+                return;
+            }
+
+            place( level() );
+            if ( type == TokenType::OCurlyBrace )
+                inlineBlocks++;
+            else if ( type == TokenType::Semicolon && !inlineBlocks && !parens )
+                breakPending = true;
+            else if ( type == TokenType::Colon && n && tokens[ n - 1 ].type.isAccessSpecifier() && !inlineBlocks )
+                breakPending = true;
+        }
+
+        bool Formatter::spaceBefore( size_t n ) const
+        {
+            const auto previous = tokens[ n - 1 ].type;
+            const auto type = tokens[ n ].type;
+
+            if ( type == TokenType::Semicolon || type == TokenType::Comma || type == TokenType::Colon )
+                return false;
+            if ( previous == TokenType::OParen )
+                return type != TokenType::CParen;
+            if ( type == TokenType::CParen )
+                return true;
+            if ( previous == TokenType::Dot || type == TokenType::Dot || previous == TokenType::ColonColon || type == TokenType::ColonColon )
+                return false;
+            if ( role == OpenTemplate || role == TypeSuffix )
+                return true;
+            // `String-> name`, `String~ name` and `y->z` all attach to the left
+            if ( type == TokenType::Pointer || type == TokenType::Reference || previous == TokenType::Pointer )
+                return false;
+            if ( previous == TokenType::Not || role == PrefixOperator )
+                return false;
+            if ( type == TokenType::LessThan )
+                return !opensTemplate( n );
+            if ( ( type == TokenType::PlusPlus || type == TokenType::MinusMinus ) && isOperand( previous ) )
+                return false;
+            if ( type == TokenType::OParen )
+                return !( previous == TokenType::Identifier || isType( previous ) || previous == TokenType::CParen || role == CloseTemplate );
+            if ( type == TokenType::CCurlyBrace )
+                return previous != TokenType::OCurlyBrace;
+            return true;
+        }
+
+        bool Formatter::opensTemplate( size_t n ) const
+        {
+            if ( tokens[ n ].type != TokenType::LessThan || !n )
+                return false;
+            const auto previous = tokens[ n - 1 ].type;
+            if ( previous == TokenType::template_ || previous == TokenType::cast_ || previous == TokenType::ClassType )
+                return true;
+            // `id< int64 >( 3 )` rather than `a < b`
+            return previous == TokenType::Identifier && n + 1 < tokens.size() && isType( tokens[ n + 1 ].type );
+        }
+
+        bool Formatter::atStatementStart( size_t n ) const
+        {
+            if ( !n )
+                return true;
+            const auto previous = tokens[ n - 1 ].type;
+            if ( previous == TokenType::Semicolon || previous == TokenType::OCurlyBrace || previous == TokenType::CCurlyBrace )
+                return true;
+            return previous == TokenType::Colon && n > 1 && tokens[ n - 2 ].type.isAccessSpecifier();
+        }
+
+        std::string formatSource( const std::string& source, const Style& style )
+        {
+            lexer::Trivia trivia;
+            const auto tokens = Lexer( source ).tokenize( trivia );
+            if ( tokens.empty() )
+                throw std::runtime_error( "source does not lex" );
+            return Formatter( tokens, trivia, style ).run();
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Lexer.h"
+
+namespace t
+{
+    namespace format
+    {
+        struct Style
+        {
+            // Spaces per level, 0 indents with one tab per level as test_lang.t does
+            size_t indentWidth = 0;
+            // Runs of blank lines between statements are cut down to this many
+            size_t maxBlankLines = 1;
+        };
+
+        // Lays out T source from its tokens and trivia alone, without parsing.
+        // Braces go on their own line (Allman style), except for blocks written
+        // on one line, such as `int8 getAge() { return age; }`, which stay on
+        // one line. Parentheses have a space inside them, `f( x, y )`, and
+        // binary operators have a space on each side. Access specifiers are
+        // dedented one level. Comments and single blank lines are kept, and
+        // every token is written exactly as it was spelled, so the output
+        // lexes to the same token stream.
+        class Formatter
+        {
+        public:
+            Formatter( const TokenList& tokens, const lexer::Trivia& trivia, const Style& style = {} ):
+                tokens( tokens ), trivia( trivia ), style( style ) {}
+
+            std::string run();
+        private:
+            const TokenList& tokens;
+            const lexer::Trivia& trivia;
+            Style style;
+
+            std::string out;
+            // Block depth, and how many enclosing blocks were written on one line
+            size_t depth = 0;
+            size_t inlineBlocks = 0;
+            size_t parens = 0;
+            // Template argument lists still open, `Box< int32` so far
+            size_t angles = 0;
+            // One per token, set on both braces of a block written on one line
+            std::vector< uint8_t > inlineBrace;
+            // Set when the next token or comment has to start on a new line
+            bool breakPending = false;
+            // A line broken inside a statement by a comment, the rest of the
+            // statement is indented one more level
+            bool continuation = false;
+            // What the previous token turned out to be, where its type alone does not say
+            enum Role : uint8_t
+            {
+                Plain,
+                OpenTemplate,
+                CloseTemplate,
+                PrefixOperator,
+                // `->` in `String-> name` rather than `y->z`
+                TypeSuffix,
+            };
+
+            Role role = Plain;
+
+            void findInlineBlocks();
+
+            // Comments and blank lines before token n; returns the line breaks
+            // between the last comment, or the previous token, and the token
+            size_t leadingTrivia( size_t n );
+
+            void comment( std::string_view text, size_t lines );
+
+            // Starts a new line if one is pending, with a blank line above it
+            // when the source had one
+            void startLine( size_t lines, size_t level );
+
+            void token( size_t n, size_t lines );
+
+            bool spaceBefore( size_t n ) const;
+
+            bool opensTemplate( size_t n ) const;
+
+            // The role token n has for the token after it
+            Role roleOf( size_t n );
+
+            bool atStatementStart( size_t n ) const;
+
+            size_t level() const { return depth + ( continuation ? 1 : 0 ); }
+        };
+
+        // Lexes source and formats it. Throws if it does not lex.
+        std::string formatSource( const std::string& source, const Style& style = {} );
+    }
+}
@@ -0,0 +1,277 @@
+#include "HashCons.h"
+
+#include <cstring>
+
+namespace t
+{
+    namespace ast
+    {
+        namespace
+        {
+            void putId( std::string& key, uint32_t id )
+            {
+                key.append( reinterpret_cast< const char* >( &id ), sizeof( id ) );
+            }
+
+            // Length prefixed, so adjacent strings cannot run into each other
+            void putText( std::string& key, const std::string& text )
+            {
+                putId( key, static_cast< uint32_t >( text.size() ) );
+                key += text;
+            }
+
+            template< typename T >
+            void putValue( std::string& key, T value )
+            {
+                char bytes[ sizeof( T ) ];
+                std::memcpy( bytes, &value, sizeof( T ) );
+                key.append( bytes, sizeof( T ) );
+            }
+
+            bool isMutating( const std::string& op ) { return op == "++" || op == "--"; }
+        }
+
+        void HashConsTable::intern( const StatementList& stmts )
+        {
+            const auto size = bindings.size();
+            declareGlobals( stmts );
+            block( stmts );
+            bindings.resize( size );
+        }
+
+        void HashConsTable::block( const StatementList& stmts )
+        {
+            const auto size = bindings.size();
+            for ( const auto& stmt : stmts )
+                intern( stmt );
+            bindings.resize( size );
+        }
+
+        void HashConsTable::declareGlobals( const StatementList& stmts )
+        {
+            for ( const auto& stmt : stmts )
+            {
+                const auto expr = stmt.is< Type::Expression >() ? stmt.as< Expression >() : nullptr;
+                if ( auto var = expr ? expr->as< VariableDeclaration >() : nullptr )
+                    bind( var->getIdentifier().getSymbol(), var->getType(), var->isMutableVar() );
+            }
+        }
+
+        void HashConsTable::bind( const std::string& name, const TypeName& type, bool isMutable )
+        {
+            uint32_t binding = 0;
+            if ( !isMutable && !type.isMutableType() && !type.isRef() && !type.isPtr() )
+            {
+                if ( depth )
+                    binding = ++locals;
+                else
+                {
+                    auto& global = globals[ scope.empty() ? name : scope + "::" + name ];
+                    if ( !global )
+                        global = ++locals;
+                    binding = global;
+                }
+            }
+            bindings.emplace_back( name, binding );
+        }
+
+        uint32_t HashConsTable::lookup( const std::string& name ) const
+        {
+            for ( auto it = bindings.crbegin(); it != bindings.crend(); ++it )
+                if ( it->first == name )
+                    return it->second;
+            return 0;
+        }
+
+        void HashConsTable::intern( const Statement& stmt )
+        {
+            if ( stmt.is< Type::Expression >() )
+                intern( *stmt.as< Expression >() );
+            else if ( stmt.is< Type::Scope >() )
+                block( *stmt.as< StatementList >() );
+        }
+
+        uint32_t HashConsTable::intern( const Expression& expr )
+        {
+            const auto child = [ this ]( const Expression* e ){ return e ? intern( *e ) : 0; };
+            // Interning again after a pass changed the tree must not keep stale ids
+            expr.setConsId( 0 );
+
+            if ( auto id = expr.as< Identifier >() )
+            {
+                const auto binding = lookup( id->getSymbol() );
+                if ( id->getOwnership() != Ownership::Copy || !binding )
+                    return 0;
+                std::string key = "I";
+                putId( key, binding );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto type = expr.as< TypeName >() )
+            {
+                std::string key = "T";
+                key += char( ( type->isMutableType() ? 1 : 0 ) | ( type->isRef() ? 2 : 0 ) | ( type->isPtr() ? 4 : 0 ) );
+                putText( key, type->getName() );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto lit = expr.as< NumericLiteral< int64_t > >() )
+            {
+                std::string key = "i";
+                putValue( key, lit->getValue() );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto lit = expr.as< NumericLiteral< uint64_t > >() )
+            {
+                std::string key = "u";
+                putValue( key, lit->getValue() );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto lit = expr.as< NumericLiteral< double > >() )
+            {
+                std::string key = "d";
+                putValue( key, lit->getValue() );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto lit = expr.as< StringLiteral >() )
+            {
+                std::string key = "s";
+                putText( key, lit->getValue() );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto lit = expr.as< CharacterLiteral >() )
+            {
+                std::string key = "c";
+                putText( key, lit->getValue() );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto lit = expr.as< BoolLiteral >() )
+                return assign( expr, lit->getValue() ? "b1" : "b0" );
+            if ( auto bin = expr.as< BinaryExpression >() )
+            {
+                // The member on the right is not a name in scope, and the
+                // field it reads may be mutable
+                if ( bin->getOperator() == "." )
+                {
+                    child( bin->getLhs() );
+                    return 0;
+                }
+                const auto lhs = child( bin->getLhs() );
+                const auto rhs = child( bin->getRhs() );
+                if ( !lhs || !rhs )
+                    return 0;
+                std::string key = "B";
+                putText( key, bin->getOperator() );
+                putId( key, lhs );
+                putId( key, rhs );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto concat = expr.as< ConcatExpression >() )
+            {
+                std::string key = "C";
+                bool pure = true;
+                for ( const auto& part : concat->getParts() )
+                {
+                    const auto id = child( part.get() );
+                    pure = pure && id;
+                    putId( key, id );
+                }
+                return pure ? assign( expr, std::move( key ) ) : 0;
+            }
+            if ( auto unary = expr.as< UnaryExpression< true > >() )
+            {
+                const auto operand = child( unary->getExpression() );
+                if ( !operand || isMutating( unary->getOperator() ) )
+                    return 0;
+                std::string key = "U";
+                putText( key, unary->getOperator() );
+                putId( key, operand );
+                return assign( expr, std::move( key ) );
+            }
+            if ( auto unary = expr.as< UnaryExpression< false > >() )
+            {
+                child( unary->getExpression() );
+                return 0;
+            }
+
+            // Not interned themselves, but their children may be
+            if ( auto assignment = expr.as< AssignmentExpression >() )
+            {
+                child( assignment->getLhs() );
+                child( assignment->getRhs() );
+            }
+            else if ( auto call = expr.as< FunctionCall >() )
+            {
+                for ( const auto& arg : call->getParameters() )
+                    intern( arg );
+            }
+            else if ( auto var = expr.as< VariableDeclaration >() )
+            {
+                intern( var->getType() );
+                // The value is read before the name is in scope
+                child( var->getValue() );
+                // Globals were bound up front
+                if ( depth )
+                    bind( var->getIdentifier().getSymbol(), var->getType(), var->isMutableVar() );
+            }
+            else if ( auto param = expr.as< Parameter >() )
+            {
+                intern( param->getTypeName() );
+                bind( param->getIdentifier().getSymbol(), param->getTypeName(), false );
+            }
+            else if ( auto func = expr.as< FunctionDeclaration >() )
+            {
+                const auto size = bindings.size();
+                depth++;
+                intern( func->getReturnType() );
+                for ( const auto& param : func->getParamList() )
+                    intern( param );
+                block( func->getBody() );
+                depth--;
+                bindings.resize( size );
+            }
+            else if ( auto cls = expr.as< ClassDeclaration >() )
+            {
+                const auto size = bindings.size();
+                depth++;
+                intern( cls->getType() );
+                for ( const auto& field : cls->getFields() )
+                    intern( field.var );
+                for ( const auto& method : cls->getMethods() )
+                    intern( method.func );
+                depth--;
+                bindings.resize( size );
+            }
+            else if ( auto ret = expr.as< ReturnStatement >() )
+                intern( ret->getStatement() );
+            else if ( auto ifstmt = expr.as< IfStatement >() )
+            {
+                child( ifstmt->getCondition() );
+                block( ifstmt->getBody() );
+            }
+            else if ( auto loop = expr.as< ForInStatement >() )
+            {
+                const auto size = bindings.size();
+                intern( loop->getType() );
+                child( loop->getRange() );
+                bind( loop->getVariable().getSymbol(), loop->getType(), false );
+                block( loop->getBody() );
+                bindings.resize( size );
+            }
+            else if ( auto nsp = expr.as< NameSpaceDeclaration >() )
+            {
+                const auto outer = scope;
+                scope = outer.empty() ? nsp->getName().getSymbol() : outer + "::" + nsp->getName().getSymbol();
+                intern( nsp->getBody() );
+                scope = outer;
+            }
+            return 0;
+        }
+
+        uint32_t HashConsTable::assign( const Expression& expr, std::string&& key )
+        {
+            const auto id = ids.emplace( std::move( key ), static_cast< uint32_t >( ids.size() + 1 ) ).first->second;
+            expr.setConsId( id );
+            interned++;
+            return id;
+        }
+    }
+}
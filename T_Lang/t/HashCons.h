@@ -0,0 +1,75 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "AST.h"
+
+namespace t
+{
+    namespace ast
+    {
+        // Hash-consing for the immutable parts of a tree. T values are const
+        // by default, so literals, type names, reads of a const name and
+        // operator trees over them mean the same thing wherever they appear.
+        // Each distinct shape is stored once, keyed by its own value and the
+        // ids of its children, and every node of that shape gets the same id,
+        // so structural equality is an id compare. A read is keyed by the
+        // declaration the name is bound to, not by its spelling, and only a
+        // read of a const value is interned: a mutable variable, a reference,
+        // a pointer, a member access or a name that is not declared may change
+        // between two reads. Calls, assignments, moves and increments are
+        // never interned, and neither is anything above them.
+        //
+        // Nodes keep their unique owners; ids are what is shared. One table
+        // can serve several modules so equal subtrees across files match.
+        class HashConsTable
+        {
+        public:
+            // Interns every subexpression of the program, bottom-up
+            void intern( const Program& program ) { intern( program.getBody() ); }
+
+            // Interns the top-level statements of a module
+            void intern( const StatementList& stmts );
+
+            // Returns the id of expr, 0 if it is not interned. Names are looked
+            // up in the declarations interned around it.
+            uint32_t intern( const Expression& expr );
+
+            // Distinct shapes seen so far
+            size_t size() const { return ids.size(); }
+
+            // Nodes that were given an id, shared or not
+            size_t internedNodes() const { return interned; }
+        private:
+            std::unordered_map< std::string, uint32_t > ids;
+            size_t interned = 0;
+
+            // Names in scope with their binding, innermost last; 0 for a name
+            // whose reads are not interned
+            std::vector< std::pair< std::string, uint32_t > > bindings;
+            // Globals are bound by qualified name, so the same global read
+            // from two modules is one shape
+            std::unordered_map< std::string, uint32_t > globals;
+            uint32_t locals = 0;
+            // Namespace of the declarations being interned, and whether they
+            // are inside a function or class
+            std::string scope;
+            size_t depth = 0;
+
+            void intern( const Statement& stmt );
+
+            // Names declared in stmts go out of scope at its end
+            void block( const StatementList& stmts );
+
+            // Binds the variables declared directly in stmts, so globals can
+            // be read before their declaration
+            void declareGlobals( const StatementList& stmts );
+
+            void bind( const std::string& name, const TypeName& type, bool isMutable );
+
+            uint32_t lookup( const std::string& name ) const;
+
+            uint32_t assign( const Expression& expr, std::string&& key );
+        };
+    }
+}
@@ -0,0 +1,404 @@
+#include "Lexer.h"
+
+#include <algorithm>
+
+namespace t
+{
+    namespace lexer
+    {
+        const std::unordered_map< std::string, TokenType > KEYWORDS
+        {
+            // Class words
+            {"class", TokenType::class_}, {"private", TokenType::private_}, {"public", TokenType::public_}, {"protected", TokenType::protected_},
+            // Generic
+            {"mutable", TokenType::mutable_},
+            {"cast", TokenType::cast_},
+            {"return", TokenType::return_},
+            {"for", TokenType::for_}, {"while", TokenType::while_}, {"in", TokenType::in_}, {"if", TokenType::if_},
+            {"null", TokenType::null_},
+            {"namespace", TokenType::namespace_},
+            {"memoize", TokenType::memoize_},
+            {"constexpr", TokenType::constexpr_},
+            {"template", TokenType::template_},
+            {"move", TokenType::move_},
+        };
+
+        const std::set< std::string > DEFAULT_TYPES
+        {
+            "auto",
+            "char",
+            "int8", "int16", "int32", "int64",
+            "uint8", "uint16", "uint32", "uint64",
+            "float", "double", "bool", "String",
+            "void",
+            "Map"
+        };
+
+        const std::set< std::string > BUILTIN_CLASS_TYPES
+        {
+            "String",
+            "Map"
+        };
+    }
+
+    namespace lexer
+    {
+        std::vector< std::string_view > Trivia::comments( size_t n ) const
+        {
+            std::vector< std::string_view > found;
+            auto text = leading( n );
+            for ( auto at = text.find( "//" ); at != std::string_view::npos; at = text.find( "//" ) )
+            {
+                text.remove_prefix( at );
+                const auto eol = std::min( text.find( '\n' ), text.size() );
+                auto comment = text.substr( 0, eol );
+                if ( !comment.empty() && comment.back() == '\r' )
+                    comment.remove_suffix( 1 );
+                found.push_back( comment );
+                text.remove_prefix( eol );
+            }
+            return found;
+        }
+
+        size_t Trivia::newlines( size_t n ) const
+        {
+            const auto text = leading( n );
+            return std::count( text.cbegin(), text.cend(), '\n' );
+        }
+    }
+
+    TokenList Lexer::tokenize( lexer::Trivia& capture )
+    {
+        trivia = &capture;
+        capture.spans.clear();
+        capture.source = srctext;
+        auto result = tokenize();
+        trivia = nullptr;
+        return result;
+    }
+
+    TokenList Lexer::tokenize()
+    {
+        LENGTH = srctext.length();
+
+        if ( !runtime::utf8::validate( srctext ) )
+            throw std::runtime_error( "source is not valid UTF-8" );
+        // Skip a byte order mark
+        if ( srctext.compare( 0, 3, "\xEF\xBB\xBF" ) == 0 )
+            i = 3;
+        if ( trivia )
+            trivia->start = static_cast< uint32_t >( i );
+
+        // Where the character that may start a token is, when capturing trivia.
+        // Every case leaves 'i' on the last character it consumed, so a token
+        // pushed since the last step ends just before the current 'i'.
+        size_t tokenStart = i;
+        const auto recordSpan = [ & ]{
+            if ( trivia && tokens.size() > trivia->spans.size() )
+                trivia->spans.push_back( { static_cast< uint32_t >( tokenStart ), static_cast< uint32_t >( std::min( i, LENGTH ) ) } );
+        };
+
+        for ( ; i < LENGTH; ++i )
+        {
+            recordSpan();
+            const auto cls = lexer::charClass( srctext[ i ] );
+            if ( cls & lexer::Space )
+                continue;
+            tokenStart = i;
+            if ( cls & lexer::Digit )
+            {
+                buildNumber();
+                continue;
+            }
+            if ( cls & lexer::IdentifierStart || ( cls & lexer::NonAscii && identifierCharLength() ) )
+            {
+                buildIdentifier();
+                continue;
+            }
+            if ( !( cls & lexer::OperatorStart ) )
+            {
+                std::cout << "Unrecognized character found in source: " << srctext[ i ] << '\n';
+                return TokenList();
+            }
+            switch ( srctext[ i ] )
+            {
+            case ';':
+                handleSingleCharacter( TokenType::Semicolon );
+                continue;
+            case ',':
+                handleSingleCharacter( TokenType::Comma );
+                continue;
+            case '(':
+                handleSingleCharacter( TokenType::OParen );
+                continue;
+            case ')':
+                handleSingleCharacter( TokenType::CParen );
+                continue;
+            case '{':
+                handleSingleCharacter( TokenType::OCurlyBrace );
+                continue;
+            case '}':
+                handleSingleCharacter( TokenType::CCurlyBrace );
+                continue;
+            case '<':
+            {
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ShiftLeft ) : handleSingleCharacter( TokenType::LessThan );
+                continue;
+            }
+            case '>':
+            {
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ShiftRight ) : handleSingleCharacter( TokenType::GreaterThan );
+                continue;
+            }
+            case '+':
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::PlusPlus ) : handleSingleCharacter( TokenType::Plus );
+                continue;
+            case '~':
+                handleSingleCharacter( TokenType::Reference );
+                continue;
+            case '-':
+                if ( nextCharacterIs( '>' ) )
+                {
+                    handleDoubleCharacter( TokenType::Pointer );
+                    continue;
+                }
+                if ( lastType.isBinaryOperator() || lastType == TokenType::Equals || lastType == TokenType::OParen || lastType == TokenType::Comma )
+                {
+                    i++;
+                    buildNumber< true >();
+                    continue;
+                }
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::MinusMinus ) : handleSingleCharacter( TokenType::Minus );
+                continue;
+            case '*':
+            {
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::Exponent ) : handleSingleCharacter( TokenType::Multiply );
+                continue;
+            }
+            case '/':
+                if ( nextCharacterIsSame() )
+                {
+                    // Leave 'i' on the newline, the loop steps over it
+                    const auto eol = srctext.find( '\n', i );
+                    i = eol == std::string::npos ? LENGTH : eol;
+                    continue;
+                }
+                handleSingleCharacter( TokenType::Divide );
+                continue;
+            case '%':
+                handleSingleCharacter( TokenType::Modulus );
+                continue;
+            case ':':
+            {
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ColonColon ) : handleSingleCharacter( TokenType::Colon );
+                continue;
+            }
+            case '&':
+            {
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ANDAND ) : handleSingleCharacter( TokenType::AND );
+                continue;
+            }
+            case '|':
+            {
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::OROR ) : handleSingleCharacter( TokenType::OR );
+                continue;
+            }
+            case '=':
+            {
+                nextCharacterIsSame() ? handleDoubleCharacter( TokenType::EqualsEquals ) : handleSingleCharacter( TokenType::Equals );
+                continue;
+            }
+            case '!':
+                if ( nextCharacterIs( '=' ) )
+                {
+                    handleDoubleCharacter( TokenType::NotEquals );
+                    continue;
+                }
+                handleSingleCharacter( TokenType::Not );
+                continue;
+            case '.':
+            {
+                if ( i+1 < LENGTH && lexer::charClass( srctext[ i+1 ] ) & lexer::Digit )
+                {
+                    buildNumber();
+                    continue;
+                }
+                handleSingleCharacter( TokenType::Dot );
+                continue;
+            }
+            case '\"':
+            {
+                buildString();
+                continue;
+            }
+            case '\'':
+                buildChar();
+                continue;
+            }               
+        }
+        recordSpan();
+        if ( trivia )
+            trivia->spans.push_back( { static_cast< uint32_t >( LENGTH ), static_cast< uint32_t >( LENGTH ) } );
+        tokens.push_back( lexer::Token( "", TokenType::EOF_ ) );
+        return tokens;
+    }
+
+    void Lexer::handleDoubleCharacter( lexer::TokenType type )
+    {
+        tokens.push_back( lexer::Token( srctext.substr( i++, 2 ), lastType = type ) );
+    }
+
+    void Lexer::handleSingleCharacter( lexer::TokenType type )
+    {
+        tokens.push_back( lexer::Token( srctext.substr( i, 1 ), lastType = type ) );
+    }
+
+    void Lexer::buildString()
+    {
+        std::string str = "";
+
+        if ( i+1 < LENGTH && srctext[ i+1 ] == '\"' )
+        {
+            // Leave 'i' on the closing quote, not on another opening one
+            i++;
+            tokens.push_back( lexer::Token( "", lastType = TokenType::string_literal ) );
+            return;
+        }
+
+        while ( ++i < LENGTH && srctext[ i ] != '\"' )
+        {
+            const auto c = srctext[ i ];
+            if ( c == '\n' || c == '\r' )
+                throw std::runtime_error( "invalid string literal!" );
+            str += c;
+        }
+        if ( i < LENGTH )
+        {
+            if ( srctext[ i ] != '\"' )
+                throw std::runtime_error( "invalid string literal!" );
+        }
+        
+        tokens.push_back( lexer::Token( std::move( str ), lastType = TokenType::string_literal ) );
+    }
+
+    void Lexer::buildChar()
+    {
+        std::string ch = srctext.substr( ++i, 1 );
+        if ( srctext[ i ] == '\\' && i+1 < LENGTH )
+        {
+            ch += srctext[ ++i ];
+        }
+        i++;
+        tokens.push_back( lexer::Token( std::move( ch ), lastType = TokenType::char_literal ) );
+    }
+
+    template< bool isNegative >
+    void Lexer::buildNumber()
+    {
+        const auto start = i;
+        skipDigits();
+
+        if ( i == LENGTH || srctext[ i ] != '.' )
+        {
+            auto num = numberText< isNegative >( start );
+            if constexpr ( isNegative )
+            {
+                tokens.push_back( lexer::Token( std::move( num ), lastType = TokenType::negative_integer_literal ) );
+            }
+            else
+            {
+                tokens.push_back( lexer::Token( std::move( num ), lastType = TokenType::integer_literal ) );
+            }
+            i--;
+            return;
+        }
+
+        i++;
+        skipDigits();
+        auto num = numberText< isNegative >( start );
+        i--;
+        tokens.push_back( lexer::Token( std::move( num ), lastType = TokenType::float_literal ) );
+    }
+
+    void Lexer::skipDigits()
+    {
+        while ( i < LENGTH && isInt() )
+            i++;
+    }
+
+    template< bool isNegative >
+    std::string Lexer::numberText( size_t start ) const
+    {
+        return ( isNegative ? "-" : "" ) + srctext.substr( start, i - start );
+    }
+
+    std::string Lexer::parseIdentifier()
+    {
+        const auto start = i;
+        while ( i < LENGTH )
+        {
+            const auto n = identifierCharLength();
+            if ( !n )
+                break;
+            i += n;
+        }
+        i--;
+        return srctext.substr( start, i + 1 - start );
+    }
+
+    void Lexer::buildIdentifier()
+    {
+        auto id { parseIdentifier() };
+
+        if ( id == "false" || id == "true" )
+        {
+            tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::bool_literal ) );
+            return;
+        }
+
+        if ( isKeyWord( id ) )
+        {
+            lastType = lexer::KEYWORDS.at( id );
+
+            tokens.push_back( lexer::Token( std::move( id ), lastType ) );
+            return;
+        }
+
+        if ( isDefaultType( id ) )
+        {
+            if ( lexer::BUILTIN_CLASS_TYPES.find( id ) != lexer::BUILTIN_CLASS_TYPES.cend() )
+            {
+                tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::ClassType ) );
+                return;
+            }
+            tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::PrimitiveType ) );
+            return;
+        }
+
+        if ( lastType == TokenType::class_ )
+        {
+            classNames.insert( id );
+            goto PushBackToken;
+        }
+
+        if ( isUserDefinedClass( id ) )
+        {
+            PushBackToken:
+            tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::ClassType ) );
+            return;
+        }
+
+        tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::Identifier ) );
+    }
+
+    size_t Lexer::identifierCharLength()
+    {
+        const auto cls = lexer::charClass( srctext[ i ] );
+        if ( cls & lexer::IdentifierContinue )
+            return 1;
+        if ( !( cls & lexer::NonAscii ) )
+            return 0;
+        size_t at = i;
+        return runtime::utf8::isIdentifierCodePoint( runtime::utf8::decode( srctext, at ) ) ? at - i : 0;
+    }
+}
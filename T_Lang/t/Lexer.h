@@ -1,12 +1,17 @@
 #pragma once
 
 #include "common.h"
+#include "runtime/Utf8.h"
 
+#include <array>
 #include <set>
+#include <string_view>
 #include <unordered_map>
 
 namespace t
 {
+    class Lexer;
+
     namespace lexer
     {
         class TokenType
@@ -104,6 +109,9 @@ namespace t
                 if_,
                 constexpr_,
                 namespace_,
+                memoize_,
+                template_,
+                move_,
 
                 // '('
                 OParen,
@@ -152,345 +160,164 @@ namespace t
             Type m_type;
         };
 
-        const std::unordered_map< std::string, TokenType > KEYWORDS
+        extern const std::unordered_map< std::string, TokenType > KEYWORDS;
+
+        extern const std::set< std::string > DEFAULT_TYPES;
+
+        // Default types that are classes rather than primitives
+        extern const std::set< std::string > BUILTIN_CLASS_TYPES;
+
+        // What a source byte can be to the lexer. Every decision in the lexer
+        // looks the byte up once in CHAR_CLASSES instead of comparing it
+        // against ranges.
+        enum CharClass : uint8_t
         {
-            // Class words
-            {"class", TokenType::class_}, {"private", TokenType::private_}, {"public", TokenType::public_}, {"protected", TokenType::protected_},
-            // Generic
-            {"mutable", TokenType::mutable_},
-            {"cast", TokenType::cast_},
-            {"return", TokenType::return_},
-            {"for", TokenType::for_}, {"while", TokenType::while_}, {"in", TokenType::in_}, {"if", TokenType::if_},
-            {"null", TokenType::null_},
-            {"namespace", TokenType::namespace_},
+            Space = 1 << 0,
+            Digit = 1 << 1,
+            IdentifierStart = 1 << 2,
+            IdentifierContinue = 1 << 3,
+            // Bytes that begin an operator, punctuation, a literal or a comment
+            OperatorStart = 1 << 4,
+            // Part of a multi-byte UTF-8 sequence, an identifier only if the
+            // decoded code point is one
+            NonAscii = 1 << 5,
         };
 
-        const std::set< std::string > DEFAULT_TYPES
+        constexpr std::array< uint8_t, 256 > makeCharClasses()
         {
-            "auto",
-            "char",
-            "int8", "int16", "int32", "int64",
-            "uint8", "uint16", "uint32", "uint64",
-            "float", "double", "bool", "String",
-            "void"
-        };
+            std::array< uint8_t, 256 > classes {};
+            for ( const char c : { ' ', '\t', '\n', '\r' } )
+                classes[ static_cast< unsigned char >( c ) ] = Space;
+            for ( int c = '0'; c <= '9'; c++ )
+                classes[ c ] = Digit | IdentifierContinue;
+            for ( int c = 'a'; c <= 'z'; c++ )
+            {
+                classes[ c ] = IdentifierStart | IdentifierContinue;
+                classes[ c - 'a' + 'A' ] = IdentifierStart | IdentifierContinue;
+            }
+            classes[ '_' ] = IdentifierStart | IdentifierContinue;
+            for ( const char c : { ';', ',', '(', ')', '{', '}', '<', '>', '+', '~', '-', '*', '/', '%', ':', '&', '|', '=', '!', '.', '"', '\'' } )
+                classes[ static_cast< unsigned char >( c ) ] = OperatorStart;
+            for ( int c = 0x80; c < 0x100; c++ )
+                classes[ c ] = NonAscii;
+            return classes;
+        }
+
+        constexpr std::array< uint8_t, 256 > CHAR_CLASSES = makeCharClasses();
+
+        constexpr uint8_t charClass( char c ) { return CHAR_CLASSES[ static_cast< unsigned char >( c ) ]; }
 
         struct Token
         {
             Token( std::string&& value, TokenType type ):
-                value( value ), type( type ) {}
+                value( std::move( value ) ), type( type ) {}
             std::string value;
             TokenType type;
             bool isMultParseLevel() const { return type == TokenType::Multiply || type == TokenType::Divide || type == TokenType::Modulus; }
             bool isDefaultType() const { return DEFAULT_TYPES.find( value ) != DEFAULT_TYPES.cend(); }
+            bool isBuiltinClassType() const { return BUILTIN_CLASS_TYPES.find( value ) != BUILTIN_CLASS_TYPES.cend(); }
             bool isRefOrPtr() const { return type == TokenType::Reference || type == TokenType::Pointer; }
             bool isBooleanOperator() const { return type == TokenType::EqualsEquals || type == TokenType::NotEquals; }
         };
-    }
-
-    using TokenList = std::vector< lexer::Token >;
-
-    std::set< std::string > user_defined_classnames;
 
-    class Lexer
-    {
-    public:
-        using TokenType = lexer::TokenType;
-        Lexer( const std::string& text ):
-            srctext( text ), LENGTH( srctext.length() ) {}
-        Lexer( std::string&& text ):
-            srctext( std::move( text ) ) {}
-        TokenList tokenize()
+        // What the lexer drops between tokens, kept beside the token list
+        // for tools that need the source back: whitespace, comments and the
+        // exact spelling of each token. Only the source and one span per
+        // token are stored, so capture costs 8 bytes a token and tokens
+        // themselves are unchanged.
+        class Trivia
         {
-            LENGTH = srctext.length();
-            
-            for ( ; i < LENGTH; ++i )
-            {
-                if ( isSkippable() )
-                    continue;
-                switch ( srctext[ i ] )
-                {
-                case ';':
-                    handleSingleCharacter( TokenType::Semicolon );
-                    continue;
-                case ',':
-                    handleSingleCharacter( TokenType::Comma );
-                    continue;
-                case '(':
-                    handleSingleCharacter( TokenType::OParen );
-                    continue;
-                case ')':
-                    handleSingleCharacter( TokenType::CParen );
-                    continue;
-                case '{':
-                    handleSingleCharacter( TokenType::OCurlyBrace );
-                    continue;
-                case '}':
-                    handleSingleCharacter( TokenType::CCurlyBrace );
-                    continue;
-                case '<':
-                {
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ShiftLeft ) : handleSingleCharacter( TokenType::LessThan );
-                    continue;
-                }
-                case '>':
-                {
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ShiftRight ) : handleSingleCharacter( TokenType::GreaterThan );
-                    continue;
-                }
-                case '+':
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::PlusPlus ) : handleSingleCharacter( TokenType::Plus );
-                    continue;
-                case '~':
-                    handleSingleCharacter( TokenType::Reference );
-                    continue;
-                case '-':
-                    if ( nextCharacterIs( '>' ) )
-                    {
-                        handleDoubleCharacter( TokenType::Pointer );
-                        continue;
-                    }
-                    if ( lastType.isBinaryOperator() || lastType == TokenType::Equals || lastType == TokenType::OParen || lastType == TokenType::Comma )
-                    {
-                        i++;
-                        buildNumber< true >();
-                        continue;
-                    }
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::MinusMinus ) : handleSingleCharacter( TokenType::Minus );
-                    continue;
-                case '*':
-                {
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::Exponent ) : handleSingleCharacter( TokenType::Multiply );
-                    continue;
-                }
-                case '/':
-                    if ( nextCharacterIsSame() )
-                    {
-                        auto c = srctext[ i ];
-                        while ( i < LENGTH && c != '\n' )
-                        {
-                            c = srctext[ ++i ];
-                        }
-                        continue;
-                    }
-                    handleSingleCharacter( TokenType::Divide );
-                    continue;
-                case '%':
-                    handleSingleCharacter( TokenType::Modulus );
-                    continue;
-                case ':':
-                {
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ColonColon ) : handleSingleCharacter( TokenType::Colon );
-                    continue;
-                }
-                case '&':
-                {
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::ANDAND ) : handleSingleCharacter( TokenType::AND );
-                    continue;
-                }
-                case '|':
-                {
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::OROR ) : handleSingleCharacter( TokenType::OR );
-                    continue;
-                }
-                case '=':
-                {
-                    nextCharacterIsSame() ? handleDoubleCharacter( TokenType::EqualsEquals ) : handleSingleCharacter( TokenType::Equals );
-                    continue;
-                }
-                case '!':
-                    if ( nextCharacterIs( '=' ) )
-                    {
-                        handleDoubleCharacter( TokenType::NotEquals );
-                        continue;
-                    }
-                    handleSingleCharacter( TokenType::Not );
-                    continue;
-                case '.':
-                {
-                    if ( i+1 < LENGTH )
-                    {
-                        i++;
-                        if ( isInt() )
-                        {
-                            i--;
-                            buildNumber();
-                            continue;
-                        }
-                        i--;
-                    }
-                    handleSingleCharacter( TokenType::Dot );
-                    continue;
-                }
-                case '\"':
-                {
-                    buildString();
-                    continue;
-                }
-                case '\'':
-                    buildChar();
-                    continue;
-                default:
-                {
-                    if ( isInt() )
-                    {
-                        buildNumber();
-                        continue;
-                    }
-                    if ( isAlpha() )
-                    {
-                        buildIdentifier();
-                        continue;
-                    }
-                    std::cout << "Unrecognized character found in source: " + srctext[ i ] << '\n';
-                    return TokenList();
-                }
-                }               
-            }
-            tokens.push_back( lexer::Token( "", TokenType::EOF_ ) );
-            return tokens;
-        }
-    private:
-        TokenType lastType;
-        void handleDoubleCharacter( lexer::TokenType type )
-        {
-            tokens.push_back( lexer::Token( srctext.substr( i++, 2 ), lastType = type ) );
-        }
-        void handleSingleCharacter( lexer::TokenType type )
-        {
-            tokens.push_back( lexer::Token( srctext.substr( i, 1 ), lastType = type ) );
-        }
-        void buildString()
-        {
-            std::string str = "";
-
-            if ( i < LENGTH && srctext[ i+1 ] == '\"' )
-            {
-                tokens.push_back( lexer::Token( "", lastType = TokenType::string_literal ) );
-                return;
-            }
+        public:
+            // One per token, including the EOF token
+            size_t size() const { return spans.size(); }
 
-            while ( ++i < LENGTH && srctext[ i ] != '\"' )
-            {
-                const auto c = srctext[ i ];
-                if ( c == '\n' || c == '\r' )
-                    throw std::runtime_error( "invalid string literal!" );
-                str += c;
-            }
-            if ( i < LENGTH )
-            {
-                if ( srctext[ i ] != '\"' )
-                    throw std::runtime_error( "invalid string literal!" );
-            }
-            
-            tokens.push_back( lexer::Token( std::move( str ), lastType = TokenType::string_literal ) );
-        }
-        void buildChar()
-        {
-            std::string ch = srctext.substr( ++i, 1 );
-            if ( srctext[ i ] == '\\' )
+            // Whitespace and comments before token n. For the EOF token this
+            // is everything after the last real token.
+            std::string_view leading( size_t n ) const
             {
-                ch += srctext[ i ];
+                return view( n ? spans[ n - 1 ].end : start, spans[ n ].begin );
             }
-            i++;
-            tokens.push_back( lexer::Token( std::move( ch ), lastType = TokenType::char_literal ) );
-        }
-        template< bool isNegative = false >
-        void buildNumber()
-        {
-            std::string num = isNegative ? "-" : "";
-            while ( i < LENGTH && isInt() )
-                num += srctext[ i++ ];
 
-            if ( i < LENGTH && srctext[ i ] != '.' )
-            {
-                if constexpr ( isNegative )
-                {
-                    tokens.push_back( lexer::Token( std::move( num ), lastType = TokenType::negative_integer_literal ) );
-                }
-                else
-                {
-                    tokens.push_back( lexer::Token( std::move( num ), lastType = TokenType::integer_literal ) );
-                }
-                i--;
-                return;
-            }
+            // Token n as written, with quotes and the sign of negative numbers
+            std::string_view spelling( size_t n ) const { return view( spans[ n ].begin, spans[ n ].end ); }
 
-            num += srctext[ i++ ];
+            // The '//' comments in leading( n ), without their line breaks
+            std::vector< std::string_view > comments( size_t n ) const;
 
-            while ( i < LENGTH && isInt() )
-            {
-                num += srctext[ i++ ];
-            }
-            i--;
-            tokens.push_back( lexer::Token( std::move( num ), lastType = TokenType::float_literal ) );
-        }
-        std::string parseIdentifier()
-        {
-            std::string id = "";
-            while ( i < LENGTH && ( isInt() || isAlpha() || srctext[i] == '_' ) )
-                id += srctext[i++];
-            i--;
-            return id;
-        }
-        void buildIdentifier()
-        {
-            auto id { parseIdentifier() };
+            // Line breaks in leading( n ), 2 or more means a blank line
+            size_t newlines( size_t n ) const;
 
-            if ( id == "false" || id == "true" )
-            {
-                tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::bool_literal ) );
-                return;
-            }
+            const std::string& getSource() const { return source; }
+        private:
+            friend class t::Lexer;
 
-            if ( isKeyWord( id ) )
+            struct Span
             {
-                lastType = lexer::KEYWORDS.at( id );
-
-                tokens.push_back( lexer::Token( std::move( id ), lastType ) );
-                return;
-            }
+                uint32_t begin;
+                uint32_t end;
+            };
 
-            if ( isDefaultType( id ) )
-            {
-                if ( id == "String" )
-                {
-                    tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::ClassType ) );
-                    return;
-                }
-                tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::PrimitiveType ) );
-                return;
-            }
+            std::string source;
+            std::vector< Span > spans;
+            // Past a byte order mark
+            uint32_t start = 0;
 
-            if ( lastType == TokenType::class_ )
+            std::string_view view( uint32_t begin, uint32_t end ) const
             {
-                user_defined_classnames.insert( id );
-                goto PushBackToken;
+                return std::string_view( source ).substr( begin, end - begin );
             }
+        };
+    }
 
-            if ( isUserDefinedClass( id ) )
-            {
-                PushBackToken:
-                tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::ClassType ) );
-                return;
-            }
+    using TokenList = std::vector< lexer::Token >;
 
-            tokens.push_back( lexer::Token( std::move( id ), lastType = TokenType::Identifier ) );
-        }
+    class Lexer
+    {
+    public:
+        using TokenType = lexer::TokenType;
+        // classNames are those declared by modules lexed before this one,
+        // they lex as a ClassType even before this module declares them
+        Lexer( const std::string& text, std::set< std::string > classNames = {} ):
+            srctext( text ), LENGTH( srctext.length() ), classNames( std::move( classNames ) ) {}
+        Lexer( std::string&& text, std::set< std::string > classNames = {} ):
+            srctext( std::move( text ) ), classNames( std::move( classNames ) ) {}
+        TokenList tokenize();
+
+        // Also fills trivia, token n of the result is trivia entry n
+        TokenList tokenize( lexer::Trivia& trivia );
+
+        // The given class names and those this module declared
+        const std::set< std::string >& getClassNames() const { return classNames; }
+    private:
+        TokenType lastType;
+        void handleDoubleCharacter( lexer::TokenType type );
+        void handleSingleCharacter( lexer::TokenType type );
+        void buildString();
+        void buildChar();
+        template< bool isNegative = false >
+        void buildNumber();
+        void skipDigits();
+        template< bool isNegative >
+        std::string numberText( size_t start ) const;
+        std::string parseIdentifier();
+        void buildIdentifier();
 
         bool isKeyWord( const std::string& str ) const { return lexer::KEYWORDS.find( str ) != lexer::KEYWORDS.cend(); }
         bool isDefaultType( const std::string& str ) const { return lexer::DEFAULT_TYPES.find( str ) != lexer::DEFAULT_TYPES.cend(); }
-        bool isUserDefinedClass( const std::string& str ) const { return user_defined_classnames.find( str ) != user_defined_classnames.cend(); }
+        bool isUserDefinedClass( const std::string& str ) const { return classNames.find( str ) != classNames.cend(); }
 
         std::string srctext;
         TokenList tokens;
+        lexer::Trivia* trivia = nullptr;
         size_t i = 0;
         size_t LENGTH = 0;
+        std::set< std::string > classNames;
 
         inline bool nextCharacterIsSame() { return srctext.length() > i+1 && srctext[ i ] == srctext[ i+1 ]; }
         inline bool nextCharacterIs( char c ) { return srctext.length() > i+1 && srctext[ i+1 ] == c; }
-        inline bool isSkippable() { return srctext[ i ] == ' ' || srctext[ i ] == '\t' || srctext[ i ] == '\n' || srctext[ i ] == '\r'; }
-        inline bool isInt() { return srctext[ i ] >= '0' && srctext[ i ] <= '9'; }
-        inline bool isAlpha() { return toupper( srctext[ i ] ) != tolower( srctext[ i ] ); }
+        inline bool isInt() { return lexer::charClass( srctext[ i ] ) & lexer::Digit; }
+        // Bytes taken by the identifier character at 'i', or 0 if there is none.
+        // Digits only reach here after the first character, numbers are lexed first.
+        size_t identifierCharLength();
     };
 }
@@ -0,0 +1,179 @@
+#include "Monomorphize.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace t
+{
+    void GenericRegistry::addTemplates( const std::vector< GenericTemplate >& list )
+    {
+        for ( const auto& tmpl : list )
+        {
+            if ( !templates.emplace( tmpl.name, tmpl ).second )
+                throw std::runtime_error( "template " + tmpl.name + " is declared more than once" );
+        }
+    }
+
+    const GenericTemplate* GenericRegistry::findTemplate( const std::string& name ) const
+    {
+        const auto it = templates.find( name );
+        return it == templates.cend() ? nullptr : &it->second;
+    }
+
+    namespace
+    {
+        bool isNameChar( char c ) { return std::isalnum( static_cast< unsigned char >( c ) ) || c == '_'; }
+
+        // `Box<int32>` in `Map<String,Box<int32>>` but not in `MyBox<int32>`
+        bool names( const std::string& name, const std::string& mangled )
+        {
+            for ( auto at = name.find( mangled ); at != std::string::npos; at = name.find( mangled, at + 1 ) )
+                if ( at == 0 || !isNameChar( name[ at - 1 ] ) )
+                    return true;
+            return false;
+        }
+
+        bool mentions( const ast::StatementList& stmts, const std::string& mangled );
+
+        bool mentions( const ast::Expression* expr, const std::string& mangled )
+        {
+            if ( !expr )
+                return false;
+            if ( auto id = expr->as< ast::Identifier >() )
+                return names( id->getSymbol(), mangled );
+            if ( auto type = expr->as< ast::TypeName >() )
+                return names( type->getName(), mangled );
+            if ( auto bin = expr->as< ast::BinaryExpression >() )
+                return mentions( bin->getLhs(), mangled ) || mentions( bin->getRhs(), mangled );
+            if ( auto concat = expr->as< ast::ConcatExpression >() )
+                return std::any_of( concat->getParts().cbegin(), concat->getParts().cend(), [ & ]( const auto& part ){
+                    return mentions( part.get(), mangled );
+                } );
+            if ( auto unary = expr->as< ast::UnaryExpression< true > >() )
+                return mentions( unary->getExpression(), mangled );
+            if ( auto unary = expr->as< ast::UnaryExpression< false > >() )
+                return mentions( unary->getExpression(), mangled );
+            if ( auto assign = expr->as< ast::AssignmentExpression >() )
+                return mentions( assign->getLhs(), mangled ) || mentions( assign->getRhs(), mangled );
+            if ( auto call = expr->as< ast::FunctionCall >() )
+                return names( call->getName().getSymbol(), mangled ) || mentions( call->getParameters(), mangled );
+            if ( auto var = expr->as< ast::VariableDeclaration >() )
+                return mentions( &var->getType(), mangled ) || mentions( var->getValue(), mangled );
+            if ( auto param = expr->as< ast::Parameter >() )
+                return mentions( &param->getTypeName(), mangled );
+            if ( auto func = expr->as< ast::FunctionDeclaration >() )
+            {
+                const auto& params = func->getParamList();
+                return mentions( &func->getReturnType(), mangled ) || mentions( func->getBody(), mangled ) ||
+                    std::any_of( params.cbegin(), params.cend(), [ & ]( const ast::Parameter& param ){ return mentions( &param, mangled ); } );
+            }
+            if ( auto cls = expr->as< ast::ClassDeclaration >() )
+            {
+                const auto& fields = cls->getFields();
+                const auto& methods = cls->getMethods();
+                return std::any_of( fields.cbegin(), fields.cend(), [ & ]( const auto& field ){ return mentions( &field.var, mangled ); } ) ||
+                    std::any_of( methods.cbegin(), methods.cend(), [ & ]( const auto& method ){ return mentions( &method.func, mangled ); } );
+            }
+            if ( auto ret = expr->as< ast::ReturnStatement >() )
+                return ret->getStatement().is< ast::Type::Expression >() && mentions( ret->getStatement().as< ast::Expression >(), mangled );
+            if ( auto ifstmt = expr->as< ast::IfStatement >() )
+                return mentions( ifstmt->getCondition(), mangled ) || mentions( ifstmt->getBody(), mangled );
+            if ( auto loop = expr->as< ast::ForInStatement >() )
+                return mentions( &loop->getType(), mangled ) || mentions( loop->getRange(), mangled ) || mentions( loop->getBody(), mangled );
+            if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                return mentions( nsp->getBody(), mangled );
+            return false;
+        }
+
+        bool mentions( const ast::StatementList& stmts, const std::string& mangled )
+        {
+            return std::any_of( stmts.cbegin(), stmts.cend(), [ & ]( const ast::Statement& stmt ){
+                if ( stmt.is< ast::Type::Scope >() )
+                    return mentions( *stmt.as< ast::StatementList >(), mangled );
+                return stmt.is< ast::Type::Expression >() && mentions( stmt.as< ast::Expression >(), mangled );
+            } );
+        }
+    }
+
+    std::vector< std::string > Monomorphizer::run( const std::vector< Instantiation >& uses )
+    {
+        std::vector< Instantiation > work { uses };
+        std::vector< std::string > added;
+
+        while ( !work.empty() )
+        {
+            const auto inst = std::move( work.back() );
+            work.pop_back();
+
+            // Built-in generics such as Map are provided by the runtime
+            if ( lexer::BUILTIN_CLASS_TYPES.find( inst.name ) != lexer::BUILTIN_CLASS_TYPES.cend() )
+                continue;
+
+            const auto tmpl = registry.findTemplate( inst.name );
+            if ( !tmpl )
+                throw std::runtime_error( "no template named " + inst.name );
+            if ( tmpl->params.size() != inst.args.size() )
+                throw std::runtime_error( "wrong number of type arguments for " + inst.mangled );
+            if ( !generated.insert( inst.mangled ).second )
+                continue;
+            // A class is defined in every module that uses it, a function
+            // body only in the first and declared in the others
+            const auto external = !registry.claim( inst.mangled ) && !tmpl->isClass;
+
+            Parser parser { instantiate( *tmpl, inst ) };
+            auto specialized = parser.produceAST();
+            // Declarations are emitted in order, so the specialization goes
+            // before the first one that uses it
+            auto& body = program.getBody();
+            const auto user = std::find_if( body.begin(), body.end(), [ & ]( const ast::Statement& stmt ){
+                return stmt.is< ast::Type::Expression >() && mentions( stmt.as< ast::Expression >(), inst.mangled );
+            } );
+            auto at = user - body.begin();
+            for ( auto& stmt : specialized.getBody() )
+            {
+                if ( external && stmt.is< ast::Type::Expression >() )
+                    if ( auto func = stmt.as< ast::Expression >()->as< ast::FunctionDeclaration >() )
+                        func->setExternal( true );
+                body.insert( body.begin() + at++, std::move( stmt ) );
+            }
+
+            const auto& nested = parser.getInstantiations();
+            work.insert( work.end(), nested.cbegin(), nested.cend() );
+            added.push_back( inst.mangled );
+        }
+        return added;
+    }
+
+    TokenList Monomorphizer::instantiate( const GenericTemplate& tmpl, const Instantiation& inst )
+    {
+        TokenList tokens { tmpl.tokens };
+        bool renamed = false;
+
+        for ( size_t at = 0; at < tokens.size(); at++ )
+        {
+            auto& tk = tokens[ at ];
+            const auto param = std::find( tmpl.params.cbegin(), tmpl.params.cend(), tk.value );
+            const bool followedByArgs = at + 1 < tokens.size() && tokens[ at + 1 ].type == lexer::TokenType::LessThan;
+
+            if ( tk.type == lexer::TokenType::ClassType && param != tmpl.params.cend() )
+            {
+                tk = lexer::Token( std::string( inst.args[ param - tmpl.params.cbegin() ] ), lexer::TokenType::ClassType );
+                if ( tk.isDefaultType() && !tk.isBuiltinClassType() )
+                    tk.type = lexer::TokenType::PrimitiveType;
+            }
+            // Inside a class template the bare class name means this instantiation
+            else if ( tmpl.isClass && tk.type == lexer::TokenType::ClassType && tk.value == tmpl.name && !followedByArgs )
+            {
+                tk.value = inst.mangled;
+            }
+            else if ( !tmpl.isClass && !renamed && tk.type == lexer::TokenType::Identifier && tk.value == tmpl.name )
+            {
+                tk.value = inst.mangled;
+                renamed = true;
+            }
+        }
+
+        tokens.push_back( lexer::Token( "", lexer::TokenType::EOF_ ) );
+        return tokens;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <map>
+#include <set>
+
+#include "Parser.h"
+
+namespace t
+{
+    // Templates and already emitted instantiations shared by every module of
+    // a build, so the body of each function specialization is generated
+    // exactly once
+    class GenericRegistry
+    {
+    public:
+        void addTemplates( const std::vector< GenericTemplate >& list );
+
+        const GenericTemplate* findTemplate( const std::string& name ) const;
+
+        // Returns false if another module already emitted this instantiation
+        bool claim( const std::string& mangled ) { return emitted.insert( mangled ).second; }
+
+        bool isEmitted( const std::string& mangled ) const { return emitted.find( mangled ) != emitted.cend(); }
+
+        size_t emittedCount() const { return emitted.size(); }
+    private:
+        std::map< std::string, GenericTemplate > templates;
+        std::set< std::string > emitted;
+    };
+
+    // Generates a specialized class or function for every instantiation a
+    // module uses. The template tokens are copied with the type parameters
+    // substituted and the declaration renamed to its mangled name, then
+    // parsed like any other declaration and inserted into the module before
+    // the first declaration that uses it. Uses inside the new code are
+    // processed the same way until none are left. Every module gets its own
+    // copy of a class specialization; a function specialization another
+    // module already claimed is marked external, so only its declaration is
+    // generated.
+    class Monomorphizer
+    {
+    public:
+        Monomorphizer( ast::Program& program, GenericRegistry& registry ):
+            program( program ), registry( registry ) {}
+
+        // Returns the mangled names of the specializations added to this module
+        std::vector< std::string > run( const std::vector< Instantiation >& uses );
+    private:
+        ast::Program& program;
+        GenericRegistry& registry;
+        // Specializations already added to this module
+        std::set< std::string > generated;
+
+        static TokenList instantiate( const GenericTemplate& tmpl, const Instantiation& inst );
+    };
+}
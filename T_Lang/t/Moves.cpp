@@ -0,0 +1,163 @@
+#include "Moves.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        size_t MoveAnalyzer::analyze()
+        {
+            visitDeclarations( program.getBody() );
+            return moves;
+        }
+
+        bool MoveAnalyzer::isMovable( const ast::TypeName& type )
+        {
+            if ( type.isRef() || type.isPtr() )
+                return false;
+            const auto& name = type.getName();
+            return lexer::BUILTIN_CLASS_TYPES.find( name ) != lexer::BUILTIN_CLASS_TYPES.cend() ||
+                lexer::DEFAULT_TYPES.find( name ) == lexer::DEFAULT_TYPES.cend();
+        }
+
+        void MoveAnalyzer::visitDeclarations( ast::StatementList& body )
+        {
+            for ( auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                auto expr = stmt.as< ast::Expression >();
+                if ( auto func = expr->as< ast::FunctionDeclaration >() )
+                    analyzeFunction( *func );
+                else if ( auto cls = expr->as< ast::ClassDeclaration >() )
+                    for ( auto& method : cls->getMethods() )
+                        analyzeFunction( method.func );
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                    visitDeclarations( nsp->getBody() );
+            }
+        }
+
+        void MoveAnalyzer::declare( const std::string& name, const ast::TypeName& type )
+        {
+            current[ name ] = variables.size();
+            variables.push_back( Variable { name, isMovable( type ), loopDepth, {} } );
+        }
+
+        void MoveAnalyzer::analyzeFunction( const ast::FunctionDeclaration& func )
+        {
+            variables.clear();
+            current.clear();
+
+            for ( const auto& param : func.getParamList() )
+                declare( param.getIdentifier().getSymbol(), param.getTypeName() );
+            visitBlock( func.getBody() );
+
+            for ( const auto& var : variables )
+            {
+                for ( size_t idx = 0; idx < var.uses.size(); idx++ )
+                {
+                    const auto& use = var.uses[ idx ];
+                    const bool last = idx + 1 == var.uses.size();
+                    const bool shared = ( idx && var.uses[ idx - 1 ].statement == use.statement ) ||
+                        ( !last && var.uses[ idx + 1 ].statement == use.statement );
+                    if ( use.id->getOwnership() == ast::Ownership::ExplicitMove && use.repeated )
+                        throw std::runtime_error( "cannot move '" + var.name + "' inside a loop it was declared outside of" );
+                    if ( use.id->getOwnership() == ast::Ownership::ExplicitMove && !last )
+                        throw std::runtime_error( "use of '" + var.name + "' after it was moved" );
+                    if ( use.id->getOwnership() == ast::Ownership::ExplicitMove && shared )
+                        throw std::runtime_error( "use of '" + var.name + "' in the statement that moves it" );
+                    if ( last && !shared && var.movable && use.consuming && !use.repeated && use.id->getOwnership() == ast::Ownership::Copy )
+                    {
+                        // The analyzer was handed a mutable program, only the walk is const
+                        const_cast< ast::Identifier* >( use.id )->setOwnership( ast::Ownership::ImplicitMove );
+                        moves++;
+                    }
+                }
+            }
+        }
+
+        void MoveAnalyzer::visit( const ast::Statement& stmt )
+        {
+            if ( stmt.is< ast::Type::Scope >() )
+            {
+                visitBlock( *stmt.as< ast::StatementList >() );
+            }
+            else if ( stmt.is< ast::Type::Expression >() )
+            {
+                statements++;
+                visit( stmt.as< ast::Expression >(), false );
+            }
+        }
+
+        void MoveAnalyzer::visitBlock( const ast::StatementList& body )
+        {
+            auto outer = current;
+            for ( const auto& stmt : body )
+                visit( stmt );
+            current = std::move( outer );
+        }
+
+        void MoveAnalyzer::visit( const ast::Expression* expr, bool consuming )
+        {
+            if ( !expr )
+                return;
+            if ( auto id = expr->as< ast::Identifier >() )
+            {
+                const auto it = current.find( id->getSymbol() );
+                if ( it != current.cend() )
+                {
+                    auto& var = variables[ it->second ];
+                    var.uses.push_back( Use { id, consuming, loopDepth > var.loopDepth, statements } );
+                }
+                else if ( id->getOwnership() == ast::Ownership::ExplicitMove )
+                    throw std::runtime_error( "only local variables can be moved, '" + id->getSymbol() + "' is not local" );
+            }
+            else if ( auto var = expr->as< ast::VariableDeclaration >() )
+            {
+                visit( var->getValue(), true );
+                declare( var->getIdentifier().getSymbol(), var->getType() );
+            }
+            else if ( auto assign = expr->as< ast::AssignmentExpression >() )
+            {
+                visit( assign->getRhs(), true );
+                visit( assign->getLhs(), false );
+            }
+            else if ( auto bin = expr->as< ast::BinaryExpression >() )
+            {
+                visit( bin->getLhs(), false );
+                visit( bin->getRhs(), false );
+            }
+            else if ( auto concat = expr->as< ast::ConcatExpression >() )
+            {
+                for ( const auto& part : concat->getParts() )
+                    visit( part.get(), false );
+            }
+            else if ( auto call = expr->as< ast::FunctionCall >() )
+            {
+                for ( const auto& arg : call->getParameters() )
+                    if ( arg.is< ast::Type::Expression >() )
+                        visit( arg.as< ast::Expression >(), true );
+            }
+            else if ( auto ret = expr->as< ast::ReturnStatement >() )
+            {
+                const auto& inner = ret->getStatement();
+                if ( inner.is< ast::Type::Expression >() )
+                    visit( inner.as< ast::Expression >(), true );
+            }
+            else if ( auto ifstmt = expr->as< ast::IfStatement >() )
+            {
+                visit( ifstmt->getCondition(), false );
+                visitBlock( ifstmt->getBody() );
+            }
+            else if ( auto loop = expr->as< ast::ForInStatement >() )
+            {
+                visit( loop->getRange(), false );
+                loopDepth++;
+                auto outer = current;
+                declare( loop->getVariable().getSymbol(), loop->getType() );
+                visitBlock( loop->getBody() );
+                current = std::move( outer );
+                loopDepth--;
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <unordered_map>
+
+#include "AST.h"
+#include "Lexer.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        // Turns the last use of a local String or class value into a move
+        // when the value is handed on (returned, passed as an argument,
+        // used as an initializer or assigned). Loops are the only back edges,
+        // so outside of them the last use in evaluation order is the last use
+        // on every path. A variable is never moved inside a loop that it was
+        // declared outside of. An explicit `move` that is followed by another
+        // use of the same variable is rejected. Arguments are evaluated in no
+        // particular order, so a use is never moved when the same statement
+        // uses the variable again, and neither can it be moved explicitly.
+        class MoveAnalyzer
+        {
+        public:
+            MoveAnalyzer( ast::Program& program ):
+                program( program ) {}
+
+            // Returns the number of uses turned into implicit moves
+            size_t analyze();
+        private:
+            struct Use
+            {
+                const ast::Identifier* id;
+                bool consuming;
+                // Inside a loop the variable was declared outside of
+                bool repeated;
+                // The statement the use is part of
+                size_t statement;
+            };
+
+            struct Variable
+            {
+                std::string name;
+                bool movable;
+                size_t loopDepth;
+                std::vector< Use > uses;
+            };
+
+            ast::Program& program;
+            size_t moves = 0;
+            size_t loopDepth = 0;
+            size_t statements = 0;
+            std::vector< Variable > variables;
+            std::unordered_map< std::string, size_t > current;
+
+            static bool isMovable( const ast::TypeName& type );
+
+            void visitDeclarations( ast::StatementList& body );
+
+            void declare( const std::string& name, const ast::TypeName& type );
+
+            void analyzeFunction( const ast::FunctionDeclaration& func );
+
+            void visit( const ast::Statement& stmt );
+
+            // Names declared in a block go out of scope at its end, uncovering
+            // any variable they shadowed
+            void visitBlock( const ast::StatementList& body );
+
+            void visit( const ast::Expression* expr, bool consuming );
+        };
+    }
+}
@@ -0,0 +1,934 @@
+#include "Parser.h"
+
+#include <iterator>
+
+namespace t
+{
+    ast::Program Parser::produceAST()
+    {
+        ast::StatementList body;
+        while ( not_eof() )
+            body.push_back( parseStatement() );
+
+        return finish( std::move( body ) );
+    }
+
+    ast::Program Parser::produceAST( ThreadPool& pool )
+    {
+        // Small groups cost more to hand out than to parse
+        constexpr size_t MIN_GROUP_TOKENS = 2048;
+        const auto ranges = topLevelRanges( std::max( MIN_GROUP_TOKENS, tokens.size() / ( pool.size() * 4 ) ) );
+        if ( pool.size() == 1 || ranges.size() < 2 )
+            return produceAST();
+
+        struct Group
+        {
+            ast::StatementList body;
+            std::vector< GenericTemplate > templates;
+            std::vector< Instantiation > instantiations;
+        };
+        std::vector< Group > groups( ranges.size() );
+        try
+        {
+            pool.parallelFor( ranges.size(), [ & ]( size_t n ){
+                TokenList slice( tokens.cbegin() + ranges[ n ].first, tokens.cbegin() + ranges[ n ].second );
+                slice.push_back( lexer::Token( "", TokenType::EOF_ ) );
+                Parser parser { std::move( slice ) };
+                groups[ n ].body = std::move( parser.produceAST().getBody() );
+                groups[ n ].templates = std::move( parser.templates );
+                groups[ n ].instantiations = std::move( parser.instantiations );
+            } );
+        }
+        catch ( const std::exception& )
+        {
+            // Reparse in order so errors are exactly those of produceAST()
+            return produceAST();
+        }
+
+        ast::StatementList body;
+        for ( auto& group : groups )
+        {
+            std::move( group.body.begin(), group.body.end(), std::back_inserter( body ) );
+            std::move( group.templates.begin(), group.templates.end(), std::back_inserter( templates ) );
+            std::move( group.instantiations.begin(), group.instantiations.end(), std::back_inserter( instantiations ) );
+        }
+        i = tokens.size() - 1;
+
+        // Every group hashed its own declarations
+        return finish( std::move( body ), false );
+    }
+
+    ast::Program Parser::finish( ast::StatementList&& body, bool hash ) const
+    {
+        if ( hash )
+            ast::hashTree( body );
+        // Interned after the fact, so ids do not depend on how the groups were parsed
+        if ( hashCons )
+            hashCons->intern( body );
+        return ast::Program( std::move( body ) );
+    }
+
+    std::vector< std::pair< size_t, size_t > > Parser::topLevelRanges( size_t minTokens ) const
+    {
+        std::vector< std::pair< size_t, size_t > > ranges;
+        const auto end = tokens.size() - 1;
+        size_t start = 0;
+        int depth = 0;
+        for ( size_t at = 0; at < end; at++ )
+        {
+            switch ( tokens[ at ].type )
+            {
+            case TokenType::OParen:
+            case TokenType::OCurlyBrace:
+                depth++;
+                continue;
+            case TokenType::CParen:
+                depth--;
+                continue;
+            case TokenType::CCurlyBrace:
+                if ( --depth != 0 )
+                    continue;
+                break;
+            case TokenType::Semicolon:
+                if ( depth != 0 )
+                    continue;
+                break;
+            default:
+                continue;
+            }
+            if ( at + 1 - start >= minTokens )
+            {
+                ranges.emplace_back( start, at + 1 );
+                start = at + 1;
+            }
+        }
+        if ( start < end )
+            ranges.emplace_back( start, end );
+        return ranges;
+    }
+
+    std::string Parser::mangle( const std::string& name, const std::vector< std::string >& args )
+    {
+        std::string mangled = name + "<";
+        for ( size_t idx = 0; idx < args.size(); idx++ )
+            mangled += ( idx ? "," : "" ) + args[ idx ];
+        return mangled + ">";
+    }
+
+    std::pair< bool, bool > Parser::eatIfRefOrPtr()
+    {
+        const auto tkty = peek().type;
+        if ( tkty == TokenType::Reference )
+        {
+            eat();
+            return { true, false };
+        }
+        if ( tkty == TokenType::Pointer )
+        {
+            eat();
+            return { false, true };
+        }
+        return { false, false };
+    }
+
+    bool Parser::eatIfMutable()
+    {
+        auto const isMutable { peek().type == TokenType::mutable_ };
+        if ( isMutable )
+            eat();
+        return isMutable;
+    }
+
+    std::unique_ptr< ast::Expression > Parser::makeExpression( ast::Expression* expr )
+    {
+        return std::unique_ptr< ast::Expression >( expr );
+    }
+
+    size_t Parser::skipTypeArguments( size_t at ) const
+    {
+        const auto end = typeArgumentsEnd( at );
+        if ( end != std::string::npos )
+            return end;
+        for ( ; at < tokens.size(); at++ )
+        {
+            const auto ty = tokens[ at ].type;
+            if ( ty != TokenType::LessThan && ty != TokenType::GreaterThan && ty != TokenType::ShiftRight &&
+                ty != TokenType::ClassType && ty != TokenType::PrimitiveType && ty != TokenType::Comma )
+                throw std::runtime_error( "invalid type argument list" );
+        }
+        throw std::runtime_error( "unterminated type argument list" );
+    }
+
+    size_t Parser::typeArgumentsEnd( size_t at ) const
+    {
+        if ( peekTo( at ).type != TokenType::LessThan || !isTypeToken( at + 1 ) )
+            return at;
+        int depth = 0;
+        for ( ; at < tokens.size(); at++ )
+        {
+            const auto ty = tokens[ at ].type;
+            if ( ty == TokenType::LessThan )
+                depth++;
+            else if ( ty == TokenType::GreaterThan )
+                depth--;
+            else if ( ty == TokenType::ShiftRight )
+                depth -= 2;
+            else if ( ty != TokenType::ClassType && ty != TokenType::PrimitiveType && ty != TokenType::Comma )
+                return std::string::npos;
+            if ( depth <= 0 )
+                return at + 1;
+        }
+        return std::string::npos;
+    }
+
+    void Parser::classifyDeclarations()
+    {
+        shapes.assign( tokens.size(), DeclShape::None );
+        for ( size_t at = 0; at < tokens.size(); at++ )
+        {
+            if ( !isTypeToken( at ) )
+                continue;
+            auto next = typeArgumentsEnd( at + 1 );
+            if ( next == std::string::npos )
+                continue;
+            if ( peekTo( next ).isRefOrPtr() )
+                next++;
+            const auto ty = peekTo( next ).type;
+            if ( ty == TokenType::Equals )
+            {
+                shapes[ at ] = DeclShape::Assignment;
+            }
+            else if ( ty == TokenType::Identifier )
+            {
+                const auto after = peekTo( next + 1 ).type;
+                shapes[ at ] = after == TokenType::OParen ? DeclShape::Function :
+                    after == TokenType::Equals || after == TokenType::Semicolon ? DeclShape::Variable : DeclShape::Named;
+            }
+        }
+    }
+
+    Parser::Token Parser::expect( TokenType type, const std::string& err )
+    {
+        const auto tk = eat();
+        if ( tk.type != type )
+        {
+            throw std::runtime_error("Unexpected token type\n" + err );
+        }
+        return tk;
+    }
+
+    Parser::Token Parser::expect( TokenType type1, TokenType type2, const std::string& err )
+    {
+        const auto tk = eat();
+        if ( tk.type != type1 && tk.type != type2 )
+        {
+            throw std::runtime_error("Unexpected token type\n" + err );
+        }
+        return tk;
+    }
+
+    template< bool AllowDeclarations >
+    ast::Statement Parser::parseStatement()
+    {
+        switch ( peek().type )
+        {
+        case TokenType::if_:
+            return parseIfStatement();
+        case TokenType::for_:
+            return parseForInStatement();
+        case TokenType::namespace_:
+            if constexpr ( AllowDeclarations )
+                return parseNameSpaceDeclaration();
+            else throw std::runtime_error( "cannot create namespace inside of if statement" );
+        case TokenType::Identifier:
+            return handleIdentifier();
+        case TokenType::PrimitiveType:
+        case TokenType::ClassType:
+            return handleType();
+        case TokenType::mutable_:
+            return handleMutable();
+        case TokenType::constexpr_:
+            if constexpr ( AllowDeclarations )
+                return parseConstexprDeclaration();
+            else throw std::runtime_error( "cannot create constexpr declaration inside of if statement" );
+        case TokenType::return_:
+            return parseReturnStatement();
+        case TokenType::template_:
+            if constexpr ( AllowDeclarations )
+                return parseTemplateDeclaration();
+            else throw std::runtime_error( "cannot create template inside of if statement" );
+        case TokenType::memoize_:
+            if constexpr ( AllowDeclarations )
+                return parseMemoizedFunction();
+            else throw std::runtime_error( "cannot create function inside of if statement" );
+        case TokenType::class_:
+            if constexpr ( AllowDeclarations )
+                return parseClassDefinition();
+            else throw std::runtime_error( "cannot create class inside of if statement" );
+        default:
+            return parseExpression().release();
+        }
+    }
+
+#define NOT_VALID_IF_CONDITION !dynamic_cast<ast::BinaryExpression*>(condition.get()) &&\
+    !dynamic_cast<ast::BoolLiteral*>(condition.get()) &&\
+    !dynamic_cast<ast::NumericLiteral<int64_t>*>(condition.get()) &&\
+    !dynamic_cast<ast::NumericLiteral<uint64_t>*>(condition.get()) &&\
+    !dynamic_cast<ast::NumericLiteral<double>*>(condition.get())
+
+    ast::Statement Parser::parseIfStatement()
+    {
+        eat();
+
+        expect( TokenType::OParen, "expected opening paren to start if statement" );
+
+        auto condition = parseExpression< false >();
+
+        if ( NOT_VALID_IF_CONDITION )
+        {
+            throw std::runtime_error( "invalid if condition" );
+        }
+
+        expect( TokenType::CParen, "expected closing paren after condition" );
+
+        ast::StatementList stmts;
+
+        const auto multipleStatments = peek().type == TokenType::OCurlyBrace;
+
+        if ( multipleStatments )
+        {
+            eat();
+
+            while ( peek().type != TokenType::CCurlyBrace )
+            {
+                stmts.push_back( parseStatement< false >() );
+            }
+
+            expect( TokenType::CCurlyBrace, "expected closing brace of if statement body" );
+        }
+        else
+        {
+            stmts.push_back( parseStatement< false >() );
+        }
+
+        return new ast::IfStatement( std::move( condition ), std::move( stmts ) );
+    }
+#undef NOT_VALID_IF_CONDITION
+
+    ast::Statement Parser::parseForInStatement()
+    {
+        eat();
+
+        expect( TokenType::OParen, "expected opening paren to start for statement" );
+
+        // The loop variable is a copy of each element unless it is declared otherwise
+        const auto isMutable = eatIfMutable();
+        std::string typestr { "auto" };
+        if ( isTypeToken( i ) )
+            typestr = parseTypeString();
+        const auto [ isRef, isPtr ] = eatIfRefOrPtr();
+        ast::TypeName type { std::move( typestr ), isMutable, isRef, isPtr };
+
+        auto name = expect( TokenType::Identifier, "expected loop variable in for statement" ).value;
+
+        expect( TokenType::in_, "expected 'in' after for loop variable" );
+
+        auto range = parseExpression< false >();
+
+        expect( TokenType::CParen, "expected closing paren after for range" );
+
+        ast::StatementList stmts;
+
+        if ( peek().type == TokenType::OCurlyBrace )
+        {
+            eat();
+
+            while ( peek().type != TokenType::CCurlyBrace )
+            {
+                stmts.push_back( parseStatement< false >() );
+            }
+
+            expect( TokenType::CCurlyBrace, "expected closing brace of for statement body" );
+        }
+        else
+        {
+            stmts.push_back( parseStatement< false >() );
+        }
+
+        return new ast::ForInStatement( std::move( type ), ast::Identifier( std::move( name ) ), std::move( range ), std::move( stmts ) );
+    }
+
+    ast::Statement Parser::parseNameSpaceDeclaration()
+    {
+        eat();
+
+        auto nsp_name { expect( TokenType::Identifier, "namespace must have a name" ).value };
+
+        expect( TokenType::OCurlyBrace, "expected obening bracket to namespace declaration" );
+
+        ast::StatementList stmtList;
+
+        while ( peek().type != TokenType::CCurlyBrace )
+        {
+            stmtList.push_back( parseStatement() );
+        }
+
+        expect( TokenType::CCurlyBrace, "expected closing bracket to end namespace declaration" );
+
+        return new ast::NameSpaceDeclaration( std::move( nsp_name ), std::move( stmtList ) );
+    }
+
+    ast::Statement Parser::parseClassDefinition()
+    {
+        eat();
+
+        auto typestr { expect( TokenType::ClassType, "Class type must follow class keyword" ).value };
+
+        expect( TokenType::OCurlyBrace, "expected opening bracket to start class definition" );
+
+        ast::FieldList fields;
+
+        ast::MethodList methods;
+
+        ast::AccessSpecifier currentspec = ast::Public;
+
+        while ( peek().type != TokenType::CCurlyBrace )
+        {
+            auto tk = peek();
+
+            if ( tk.type.isAccessSpecifier() )
+            {
+                eat();
+                switch ( tk.type )
+                {
+                case TokenType::public_:
+                    currentspec = ast::Public;
+                    break;
+                case TokenType::protected_:
+                    currentspec = ast::Protected;
+                    break;
+                case TokenType::private_:
+                    currentspec = ast::Private;
+                    break;
+                default:
+                    break;
+                }
+                expect( TokenType::Colon, "expected colon after access specifier" );
+                tk = peek();
+            }
+
+            const auto memoized = tk.type == TokenType::memoize_;
+
+            if ( memoized )
+            {
+                eat();
+                tk = peek();
+            }
+
+            const auto typeAt = tk.type == TokenType::mutable_ ? i + 1 : i;
+            if ( !isTypeToken( typeAt ) )
+            {
+                throw std::runtime_error( "Inner class definition requires type name" );
+            }
+            if ( shapeAt( typeAt ) == DeclShape::Function )
+            {
+                auto stmt = parseFunctionDeclaration();
+                auto func = stmt.as< ast::FunctionDeclaration >();
+                func->setMemoized( memoized );
+                methods.push_back( ast::MethodDeclaration( std::move( *func ), currentspec ) );
+            }
+            else
+            {
+                if ( memoized )
+                    throw std::runtime_error( "only methods can be memoized" );
+                auto stmt = parseVariableDeclaration();
+                auto var = stmt.as< ast::VariableDeclaration >();
+                fields.push_back( ast::FieldDeclaration( std::move( *var ), currentspec ) );
+            }
+        }
+
+        expect( TokenType::CCurlyBrace, "expected closing bracket to class definition" );
+
+        ast::TypeName type { std::move( typestr ) };
+
+        return new ast::ClassDeclaration( std::move( type ), std::move( fields ), std::move( methods ) );
+    }
+
+    ast::Statement Parser::handleType()
+    {
+        switch ( shapeAt( i ) )
+        {
+        case DeclShape::Variable:
+            return parseVariableDeclaration();
+        case DeclShape::Function:
+        case DeclShape::Named:
+            return parseFunctionDeclaration();
+        default:
+            // Reports a malformed type argument list before the missing name
+            skipTypeArguments( i + 1 );
+            throw std::runtime_error( "Identifier expected after type" );
+        }
+    }
+
+    ast::Statement Parser::handleMutable()
+    {
+        if ( !isTypeToken( i + 1 ) )
+            throw std::runtime_error( "expected type after 'mutable' keyword" );
+
+        switch ( shapeAt( i + 1 ) )
+        {
+        case DeclShape::Assignment:
+            return parseAssignmentExpression().release();
+        case DeclShape::Variable:
+            return parseVariableDeclaration();
+        case DeclShape::Function:
+        case DeclShape::Named:
+            return parseFunctionDeclaration();
+        default:
+            skipTypeArguments( i + 2 );
+            throw std::runtime_error( "unkown token found" );
+        }
+    }
+
+    ast::Statement Parser::parseMemoizedFunction()
+    {
+        eat();
+
+        auto stmt = parseFunctionDeclaration();
+
+        stmt.as< ast::FunctionDeclaration >()->setMemoized( true );
+
+        return stmt;
+    }
+
+    ast::Statement Parser::parseConstexprDeclaration()
+    {
+        eat();
+
+        const auto tk = peek();
+
+        if ( tk.type != TokenType::ClassType && tk.type != TokenType::PrimitiveType )
+            throw std::runtime_error( "expected type after 'constexpr' keyword" );
+
+        auto stmt = handleType();
+
+        auto expr = stmt.as< ast::Expression >();
+
+        if ( auto func = expr->as< ast::FunctionDeclaration >() )
+        {
+            func->setConstexpr( true );
+        }
+        else if ( auto var = expr->as< ast::VariableDeclaration >() )
+        {
+            if ( !var->getValue() )
+                throw std::runtime_error( "constexpr variable must be initialized" );
+            var->setConstexpr( true );
+        }
+        return stmt;
+    }
+
+    ast::Statement Parser::parseTemplateDeclaration()
+    {
+        eat();
+
+        expect( TokenType::LessThan, "expected '<' after 'template'" );
+
+        GenericTemplate tmpl;
+
+        while ( true )
+        {
+            tmpl.params.push_back( expect( TokenType::Identifier, TokenType::ClassType, "template parameters must be names" ).value );
+            if ( peek().type != TokenType::Comma )
+                break;
+            eat();
+        }
+
+        expect( TokenType::GreaterThan, "expected '>' to close template parameter list" );
+
+        const size_t start = i;
+
+        size_t end = start;
+
+        while ( end < tokens.size() && tokens[ end ].type != TokenType::OCurlyBrace )
+            end++;
+
+        for ( int depth = 0; end < tokens.size(); )
+        {
+            const auto ty = tokens[ end++ ].type;
+            if ( ty == TokenType::OCurlyBrace )
+                depth++;
+            else if ( ty == TokenType::CCurlyBrace && --depth == 0 )
+                break;
+            else if ( ty == TokenType::EOF_ )
+                throw std::runtime_error( "template declaration is missing its body" );
+        }
+
+        tmpl.isClass = tokens[ start ].type == TokenType::class_;
+
+        for ( size_t at = start; at < end; at++ )
+        {
+            auto& tk = tokens[ at ];
+            if ( !tmpl.isClass && tmpl.name.empty() && tk.type == TokenType::Identifier && peekTo( at + 1 ).type == TokenType::OParen )
+                tmpl.name = tk.value;
+            if ( ( tk.type == TokenType::Identifier || tk.type == TokenType::ClassType ) &&
+                std::find( tmpl.params.cbegin(), tmpl.params.cend(), tk.value ) != tmpl.params.cend() )
+                tk.type = TokenType::ClassType;
+        }
+
+        if ( tmpl.isClass )
+            tmpl.name = peekTo( start + 1 ).value;
+
+        if ( tmpl.name.empty() )
+            throw std::runtime_error( "template must declare a class or function" );
+
+        tmpl.tokens.assign( tokens.begin() + start, tokens.begin() + end );
+
+        // Parse the pattern once so syntax errors surface at the declaration
+        auto pattern { tmpl.tokens };
+        pattern.push_back( lexer::Token( "", TokenType::EOF_ ) );
+        const auto parsed = Parser( std::move( pattern ) ).produceAST();
+
+        i = end;
+
+        auto decl = new ast::GenericDeclaration( std::string( tmpl.name ), std::vector< std::string >( tmpl.params ), tmpl.isClass );
+        decl->setPatternHash( ast::hashTree( parsed.getBody() ) );
+
+        templates.push_back( std::move( tmpl ) );
+
+        return decl;
+    }
+
+    std::string Parser::parseTypeArguments( std::string&& name )
+    {
+        expect( TokenType::LessThan, "expected '<' to start type arguments" );
+
+        Instantiation inst;
+        inst.name = std::move( name );
+        openTypeArguments++;
+
+        while ( true )
+        {
+            inst.args.push_back( parseTypeString() );
+            if ( peek().type != TokenType::Comma )
+                break;
+            eat();
+        }
+
+        // 'Box< Box< int32 >>' closes two lists with one token. The inner
+        // list takes the first half and leaves the token to the outer one.
+        if ( peek().type == TokenType::ShiftRight && pendingGreater )
+        {
+            pendingGreater = false;
+            eat();
+        }
+        else if ( peek().type == TokenType::ShiftRight && openTypeArguments > 1 )
+            pendingGreater = true;
+        else
+            expect( TokenType::GreaterThan, "expected '>' to end type arguments" );
+        openTypeArguments--;
+
+        inst.mangled = mangle( inst.name, inst.args );
+
+        instantiations.push_back( inst );
+
+        return std::move( inst.mangled );
+    }
+
+    std::string Parser::parseTypeString()
+    {
+        auto name = expect( TokenType::ClassType, TokenType::PrimitiveType, "expected type" ).value;
+
+        if ( peek().type == TokenType::LessThan )
+            return parseTypeArguments( std::move( name ) );
+
+        return name;
+    }
+
+    ast::Statement Parser::handleIdentifier()
+    {
+        return parseAssignmentExpression().release();
+    }
+
+    ast::Statement Parser::parseFunctionDeclaration()
+    {
+        auto const isMutable = eatIfMutable();
+
+        if ( !isTypeToken( i ) )
+            throw std::runtime_error( "Unexpected token type\nfunction must have return type" );
+
+        std::string f_rettype_str { parseTypeString() };
+
+        const auto [ isRef, isPtr ] = eatIfRefOrPtr();
+        
+        ast::TypeName f_rettype { std::move( f_rettype_str ), isMutable, isRef, isPtr };
+
+        ast::Identifier f_name = expect( TokenType::Identifier, "function must have name" ).value;
+
+        expect( TokenType::OParen, "missing open paren to start parameter list" );
+
+        ast::ParameterList f_p_list;
+        f_p_list.reserve( 10 );
+
+        // Generate param list
+        while ( peek().type == TokenType::ClassType || peek().type == TokenType::PrimitiveType || peek().type == TokenType::mutable_ )
+        {
+            auto const isMutable = eatIfMutable();
+
+            std::string p_type { parseTypeString() };
+
+            const auto [ isRef, isPtr ] = eatIfRefOrPtr();
+
+            std::string p_name { expect( TokenType::Identifier, "parameters must have a type and name" ).value };
+            
+            const auto maybe_comma = peek();
+
+            if ( maybe_comma.type == TokenType::Comma ) eat();
+            else if ( maybe_comma.type != TokenType::CParen )
+                throw std::runtime_error( "invalid parameter list for function " + f_name.getSymbol() );
+
+            f_p_list.push_back( ast::Parameter( isMutable, std::move( p_type ), isRef, isPtr, std::move( p_name ) ) );
+        }
+
+        f_p_list.shrink_to_fit();
+
+        expect( TokenType::CParen, "missing closing paren of parameter list" );
+        expect( TokenType::OCurlyBrace, "missing opening bracket of function body" );
+
+        ast::StatementList f_body;
+        f_body.reserve( 10 );
+
+        // Generate function body
+        while ( peek().type != TokenType::CCurlyBrace )
+        {
+            const auto tk = peek();
+            if ( tk.value == "return" )
+            {
+                f_body.push_back( parseReturnStatement() );
+                break;
+            }
+            f_body.push_back( parseStatement() );
+        }
+
+        f_body.shrink_to_fit();
+
+        expect( TokenType::CCurlyBrace, "No matching closing bracket on function " + f_name.getSymbol() );
+
+        return new ast::FunctionDeclaration( f_rettype, f_name, std::move( f_p_list ), std::move( f_body ) );
+    }
+
+    ast::Statement Parser::parseReturnStatement()
+    {
+        const auto ret = expect( TokenType::return_, "" );
+        return new ast::ReturnStatement( parseStatement() );
+    }
+
+    ast::Statement Parser::parseVariableDeclaration()
+    {
+        const auto isMutable = eatIfMutable();
+
+        if ( !isTypeToken( i ) )
+            throw std::runtime_error( "Unexpected token type\nexpected type in variable declaration" );
+
+        std::string typestr = parseTypeString();
+
+        const auto [ isRef, isPtr ] = eatIfRefOrPtr();
+
+        ast::TypeName type { std::move( typestr ), isMutable, isRef, isPtr };
+
+        std::string name = std::move( expect( TokenType::Identifier, "Expected an identifier for a variable" ).value );
+
+        if ( peek().type == TokenType::Semicolon )
+        {
+            eat();
+
+            return new ast::VariableDeclaration( false, std::move( type ), std::move( name ) );
+        }
+
+        expect( TokenType::Equals, "Expected an '=' after identifier." );
+        auto expr = parseExpression();
+        return new ast::VariableDeclaration( isMutable, std::move( type ), std::move( name ), std::move( expr ) );
+    }
+
+    template< bool TopCall >
+    std::unique_ptr< ast::Expression > Parser::parseExpression()
+    {
+        return parseAssignmentExpression< TopCall >();
+    }
+
+    template< bool TopCall >
+    std::unique_ptr< ast::Expression > Parser::parseAssignmentExpression()
+    {
+        if constexpr ( TopCall )
+        {
+            const auto next = peekNext().type;
+
+            if ( next == TokenType::ClassType || next == TokenType::PrimitiveType || next == TokenType::Reference || next == TokenType::Pointer )
+            {
+                return makeExpression( parseVariableDeclaration().release< ast::VariableDeclaration >() );
+            }
+        }
+
+        auto left = parseBooleanExpression();
+
+        if ( peek().type == TokenType::Equals )
+        {
+            eat();
+            auto right = parseAssignmentExpression< false >();
+            left = makeExpression( new ast::AssignmentExpression{ std::move( left ), std::move( right ) } );
+        }
+
+        if constexpr ( TopCall )
+            expect( TokenType::Semicolon, "must end statement with semicolon" );
+
+        return left;
+    }
+
+    template< bool isLoneCall >
+    std::unique_ptr< ast::Expression > Parser::parseFunctionCall()
+    {
+        auto f_name { expect( TokenType::Identifier, "Expected function name" ).value };
+
+        if ( peek().type == TokenType::LessThan )
+            f_name = parseTypeArguments( std::move( f_name ) );
+
+        expect( TokenType::OParen, "Function call must have open paren" );
+
+        auto param = peek();
+
+        ast::StatementList params;
+
+        while ( param.type != TokenType::CParen )
+        {
+            params.push_back( parseAdditiveExpression().release() );
+            const auto tkty = peek().type;
+            if ( tkty == TokenType::Comma )
+            {
+                eat();
+            }
+            param = peek();
+        }
+
+        expect( TokenType::CParen, "Expected closing paren to end function call" );
+
+        if constexpr ( isLoneCall )
+        {
+            expect( TokenType::Semicolon, "Expected semicolon to end statement" );
+        }
+
+        return makeExpression( new ast::FunctionCall( std::move( f_name ), std::move( params ) ) );
+    }
+
+    std::unique_ptr< ast::Expression > Parser::parseBooleanExpression()
+    {
+        auto left = parseAdditiveExpression();
+
+        while ( peek().type == TokenType::EqualsEquals || peek().type == TokenType::NotEquals )
+        {
+            auto op{ eat().value };
+            auto right = parseAdditiveExpression();
+            left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
+        }
+        return left;
+    }
+
+    std::unique_ptr< ast::Expression > Parser::parseAdditiveExpression()
+    {
+        auto left = parseMultiplicativeExpression();
+
+        while ( peek().value == "+" || peek().value == "-" )
+        {
+            auto op { eat().value };
+            auto right = parseMultiplicativeExpression();
+            left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
+        }
+        return left;
+    }
+
+    std::unique_ptr< ast::Expression > Parser::parseMultiplicativeExpression()
+    {
+        auto left = parseExponentialExpression();
+
+        while ( peek().isMultParseLevel() )
+        {
+            auto op { eat().value };
+            auto right = parseExponentialExpression();
+            left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
+        }
+        return left;
+    }
+
+    std::unique_ptr< ast::Expression > Parser::parseExponentialExpression()
+    {
+        auto left = parseDotExpression();
+
+        while ( peek().type == TokenType::Exponent )
+        {
+            auto op { eat().value };
+            auto right = parseDotExpression();
+            left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
+        }
+        return left;
+    }
+
+    std::unique_ptr< ast::Expression > Parser::parseDotExpression()
+    {
+        auto left = parsePrimaryExpression();
+
+        while ( peek().type == TokenType::Dot )
+        {
+            auto op{ eat().value };
+            auto right = parsePrimaryExpression();
+            left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
+        }
+        return left;
+    }
+
+    std::unique_ptr< ast::Expression > Parser::parsePrimaryExpression()
+    {
+        const auto tk = peek().type;
+        
+        switch ( tk )
+        {
+            case TokenType::Identifier:
+            {
+                if ( peekNext().type == TokenType::OParen || skipTypeArguments( i + 1 ) != i + 1 )
+                {
+                    return parseFunctionCall();
+                }
+                return makeExpression( new ast::Identifier( std::string( eat().value ) ) );
+            }
+            case TokenType::negative_integer_literal:
+                return makeExpression( new ast::NumericLiteral< int64_t >( atoll( eat().value.c_str() ) ) );
+            case TokenType::integer_literal:
+                return makeExpression( new ast::NumericLiteral< uint64_t >( atoll( eat().value.c_str() ) ) );
+            case TokenType::float_literal:
+                return makeExpression( new ast::NumericLiteral< double >( atof( eat().value.c_str() ) ) );
+            case TokenType::string_literal:
+                return makeExpression( new ast::StringLiteral( std::string( eat().value ) ) );
+            case TokenType::char_literal:
+                return makeExpression( new ast::CharacterLiteral( std::string( eat().value ) ) );
+            case TokenType::bool_literal:
+                return makeExpression( new ast::BoolLiteral( eat().value == "true" ) );
+            case TokenType::move_:
+            {
+                eat();
+                auto value = parsePrimaryExpression();
+                auto id = value->as< ast::Identifier >();
+                if ( !id )
+                    throw std::runtime_error( "'move' requires a variable name" );
+                id->setOwnership( ast::Ownership::ExplicitMove );
+                return value;
+            }
+            case TokenType::OParen:
+            {
+                eat();
+                auto value = parseExpression< false >();
+                expect( TokenType::CParen, "No closing paren!" );
+                return value;
+            }
+
+            default:
+                throw std::runtime_error( "Unexpected token found during parsing!" );
+        }
+    }
+}
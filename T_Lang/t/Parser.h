@@ -3,583 +3,178 @@
 #include <type_traits>
 
 #include "AST.h"
+#include "Diff.h"
+#include "HashCons.h"
 #include "Lexer.h"
+#include "ThreadPool.h"
 
 namespace t
 {
+    // The tokens of a `template` declaration, kept so every instantiation
+    // can be re-parsed with its type parameters substituted
+    struct GenericTemplate
+    {
+        std::string name;
+        std::vector< std::string > params;
+        TokenList tokens;
+        bool isClass = false;
+    };
+
+    // A use of a generic with concrete type arguments, e.g. Box< int32 >
+    struct Instantiation
+    {
+        std::string name;
+        std::vector< std::string > args;
+        std::string mangled;
+    };
+
     class Parser
     {
     public:
         Parser( const TokenList& tokens ):
-            tokens( tokens ) {}
+            tokens( tokens ) { classifyDeclarations(); }
         Parser( std::vector< lexer::Token >&& tokens ):
-            tokens( std::move( tokens ) ) {}
-        ast::Program produceAST()
-        {
-            ast::StatementList body;
-            while ( not_eof() )
-                body.push_back( parseStatement() );
+            tokens( std::move( tokens ) ) { classifyDeclarations(); }
+        ast::Program produceAST();
+
+        // Same result as produceAST(), but top-level statements are parsed
+        // in groups on the pool, each group by its own Parser
+        ast::Program produceAST( ThreadPool& pool );
+
+        // Interns the produced program into table, which may be shared by
+        // the parsers of several modules. Off when null.
+        void setHashConsing( ast::HashConsTable* table ) { hashCons = table; }
 
-            return ast::Program( std::move( body ) );
-        }
+        const std::vector< GenericTemplate >& getTemplates() const { return templates; }
+        const std::vector< Instantiation >& getInstantiations() const { return instantiations; }
+
+        static std::string mangle( const std::string& name, const std::vector< std::string >& args );
     private:
-        std::pair< bool, bool > eatIfRefOrPtr()
-        {
-            const auto tkty = peek().type;
-            if ( tkty == TokenType::Reference )
-            {
-                eat();
-                return { true, false };
-            }
-            if ( tkty == TokenType::Pointer )
-            {
-                eat();
-                return { false, true };
-            }
-            return { false, false };
-        }
-
-        bool eatIfMutable()
-        {
-            auto const isMutable { peek().type == TokenType::mutable_ };
-            if ( isMutable )
-                eat();
-            return isMutable;
-        }
+        std::pair< bool, bool > eatIfRefOrPtr();
 
-        std::unique_ptr< ast::Expression > makeExpression( ast::Expression* expr )
-        {
-            return std::unique_ptr< ast::Expression >( expr );
-        }
+        bool eatIfMutable();
+
+        std::unique_ptr< ast::Expression > makeExpression( ast::Expression* expr );
         using Token = lexer::Token;
         using TokenType = lexer::TokenType;
         TokenList tokens;
         size_t i = 0;
+        std::vector< GenericTemplate > templates;
+        std::vector< Instantiation > instantiations;
+        ast::HashConsTable* hashCons = nullptr;
 
-        Token peek() const { return tokens[ i ]; }
-        
-        Token eat()  { return tokens[ i++ ]; }
-
-        Token peekNext() const { return tokens[ i+1 ]; }
+        // Type argument lists being parsed, and whether the innermost one
+        // was closed by the first half of a '>>' that is still current
+        size_t openTypeArguments = 0;
+        bool pendingGreater = false;
 
-        Token peekTo( size_t i ) const { if ( i >= tokens.size() ) return tokens.back(); return tokens[i]; }
+        const Token& peek() const { return tokens[ i ]; }
         
-        bool not_eof() const { return tokens[ i ].type != TokenType::EOF_; }
+        const Token& eat()  { return tokens[ i++ ]; }
 
-        Token expect( TokenType type, const std::string& err )
-        {
-            const auto tk = eat();
-            if ( tk.type != type )
-            {
-                throw std::runtime_error("Unexpected token type\n" + err );
-            }
-            return tk;
-        }
-
-        Token expect( TokenType type1, TokenType type2, const std::string& err )
-        {
-            const auto tk = eat();
-            if ( tk.type != type1 && tk.type != type2 )
-            {
-                throw std::runtime_error("Unexpected token type\n" + err );
-            }
-            return tk;
-        }
-        
-        template< bool AllowDeclarations = true >
-        ast::Statement parseStatement()
-        {
-            switch ( peek().type )
-            {
-            case TokenType::if_:
-                return parseIfStatement();
-            case TokenType::namespace_:
-                if constexpr ( AllowDeclarations )
-                    return parseNameSpaceDeclaration();
-                else throw std::runtime_error( "cannot create namespace inside of if statement" );
-            case TokenType::Identifier:
-                return handleIdentifier();
-            case TokenType::PrimitiveType:
-            case TokenType::ClassType:
-                return handleType();
-            case TokenType::mutable_:
-                return handleMutable();
-            case TokenType::class_:
-                if constexpr ( AllowDeclarations )
-                    return parseClassDefinition();
-                else throw std::runtime_error( "cannot create class inside of if statement" );
-            default:
-                return parseExpression().release();
-            }
-        }
-
-#define NOT_VALID_IF_CONDITION !dynamic_cast<ast::BinaryExpression*>(condition.get()) &&\
-    !dynamic_cast<ast::BoolLiteral*>(condition.get()) &&\
-    !dynamic_cast<ast::NumericLiteral<int64_t>*>(condition.get()) &&\
-    !dynamic_cast<ast::NumericLiteral<uint64_t>*>(condition.get()) &&\
-    !dynamic_cast<ast::NumericLiteral<double>*>(condition.get())
-
-        ast::Statement parseIfStatement()
-        {
-            eat();
-
-            expect( TokenType::OParen, "expected opening paren to start if statement" );
-
-            auto condition = parseExpression< false >();
-
-            if ( NOT_VALID_IF_CONDITION )
-            {
-                throw std::runtime_error( "invalid if condition" );
-            }
-
-            expect( TokenType::CParen, "expected closing paren after condition" );
+        const Token& peekNext() const { return tokens[ i+1 ]; }
 
-            ast::StatementList stmts;
+        const Token& peekTo( size_t i ) const { if ( i >= tokens.size() ) return tokens.back(); return tokens[i]; }
 
-            const auto multipleStatments = peek().type == TokenType::OCurlyBrace;
+        bool isTypeToken( size_t at ) const { const auto ty = peekTo( at ).type; return ty == TokenType::ClassType || ty == TokenType::PrimitiveType; }
 
-            if ( multipleStatments )
-            {
-                eat();
+        // Index just past a type argument list starting at 'at', or 'at' if there is none
+        size_t skipTypeArguments( size_t at ) const;
 
-                while ( peek().type != TokenType::CCurlyBrace )
-                {
-                    stmts.push_back( parseExpression().release() );
-                }
+        // Like skipTypeArguments(), but returns npos instead of throwing
+        size_t typeArgumentsEnd( size_t at ) const;
 
-                expect( TokenType::CCurlyBrace, "expected closing brace of if statement body" );
-            }
-            else
-            {
-                stmts.push_back( parseStatement< false >() );
-            }
-
-            return new ast::IfStatement( std::move( condition ), std::move( stmts ) );
-        }
-#undef NOT_VALID_IF_CONDITION
-
-        ast::Statement parseNameSpaceDeclaration()
+        // What follows a type, found for every type token in one pass when
+        // the parser is created. A statement or class member that starts with
+        // a type is then told apart by the shape of its first type token
+        // instead of by peeking ahead past the type arguments and the name.
+        enum class DeclShape : uint8_t
         {
-            eat();
-
-            auto nsp_name { expect( TokenType::Identifier, "namespace must have a name" ).value };
+            None,
+            // type [~|->] name (
+            Function,
+            // type [~|->] name = or type [~|->] name ;
+            Variable,
+            // type [~|->] name followed by anything else
+            Named,
+            // type [~|->] =
+            Assignment,
+        };
 
-            expect( TokenType::OCurlyBrace, "expected obening bracket to namespace declaration" );
+        std::vector< DeclShape > shapes;
 
-            ast::StatementList stmtList;
+        // Hashes every node bottom-up and interns the tree if hash-consing is on
+        ast::Program finish( ast::StatementList&& body, bool hash = true ) const;
 
-            while ( peek().type != TokenType::CCurlyBrace )
-            {
-                stmtList.push_back( parseStatement() );
-            }
+        // Splits the tokens before EOF into ranges that end on a top-level
+        // statement boundary, each at least 'minTokens' long except the last
+        std::vector< std::pair< size_t, size_t > > topLevelRanges( size_t minTokens ) const;
 
-            expect( TokenType::CCurlyBrace, "expected closing bracket to end namespace declaration" );
+        void classifyDeclarations();
 
-            return new ast::NameSpaceDeclaration( std::move( nsp_name ), std::move( stmtList ) );
-        }
-
-        ast::Statement parseClassDefinition()
-        {
-            eat();
-
-            auto typestr { expect( TokenType::ClassType, "Class type must follow class keyword" ).value };
-
-            expect( TokenType::OCurlyBrace, "expected opening bracket to start class definition" );
-
-            ast::FieldList fields;
-
-            ast::MethodList methods;
-
-            ast::AccessSpecifier currentspec = ast::Public;
-
-            while ( peek().type != TokenType::CCurlyBrace )
-            {
-                auto tk = peek();
-
-                size_t idx = 0;
-
-                if ( tk.type == TokenType::mutable_ )
-                {
-                    idx++;
-                    tk = peekNext();
-                }
-                else if ( tk.type.isAccessSpecifier() )
-                {
-                    eat();
-                    switch ( tk.type )
-                    {
-                    case TokenType::public_:
-                        currentspec = ast::Public;
-                        break;
-                    case TokenType::protected_:
-                        currentspec = ast::Protected;
-                        break;
-                    case TokenType::private_:
-                        currentspec = ast::Private;
-                        break;
-                    }
-                    expect( TokenType::Colon, "expected colon after access specifier" );
-                    tk = peek();
-                }
-                if ( tk.type != TokenType::ClassType && tk.type != TokenType::PrimitiveType )
-                {
-                    throw std::runtime_error( "Inner class definition requires type name" );
-                }
-                auto tk2 = peekTo( i+1+idx );
-                if ( tk2.isRefOrPtr() )
-                {
-                    idx++;
-                    tk2 = peekTo( i + 1 + idx );
-                }
-                auto tk3 = peekTo( i+2+idx );
-                if ( tk3.type == TokenType::OParen )
-                {
-                    auto stmt = parseFunctionDeclaration();
-                    auto func = stmt.as< ast::FunctionDeclaration >();
-                    methods.push_back( ast::MethodDeclaration( std::move( *func ), currentspec ) );
-                }
-                else
-                {
-                    auto stmt = parseVariableDeclaration();
-                    auto var = stmt.as< ast::VariableDeclaration >();
-                    fields.push_back( ast::FieldDeclaration( std::move( *var ), currentspec ) );
-                }
-            }
-
-            expect( TokenType::CCurlyBrace, "expected closing bracket to class definition" );
-
-            ast::TypeName type { std::move( typestr ) };
-
-            return new ast::ClassDeclaration( std::move( type ), std::move( fields ), std::move( methods ) );
-        }
-
-        ast::Statement handleType()
-        {            
-            auto tk = peekNext();
-
-            size_t idx = 0;
-
-            if ( tk.isRefOrPtr() )
-            {
-                tk = peekTo( i + 2 );
-                ++idx;
-            }
-            if ( tk.type != TokenType::Identifier )
-            {
-                throw std::runtime_error( "Identifier expected after type" );
-            }
-            const auto tk2 = peekTo( i + 2 + idx );
-
-            if ( tk2.type == TokenType::Equals )
-            {
-                return parseVariableDeclaration();
-            }
-            return parseFunctionDeclaration();
-        }
-
-        ast::Statement handleMutable()
-        {
-            const auto tk = peekNext();
-
-            if ( tk.type != TokenType::ClassType && tk.type != TokenType::PrimitiveType )
-                throw std::runtime_error( "expected type after 'mutable' keyword" );
-
-            auto tk2 = peekTo( i+2 );
-
-            size_t idx = 0;
-
-            if ( tk2.isRefOrPtr() )
-            {
-                tk2 = peekTo( i+3 );
-                idx++;
-            }
-            if ( tk2.type == TokenType::Equals )
-            {
-                return parseAssignmentExpression().release();
-            }
-            if ( tk2.type == TokenType::Identifier )
-            {
-                const auto tk3 = peekTo( i+3 + idx ).type;
-                if ( tk3 == TokenType::Equals || tk3 == TokenType::Semicolon )
-                {
-                    return parseVariableDeclaration();
-                }
-                return parseFunctionDeclaration();
-            }
-            throw std::runtime_error( "unkown token found" );
-        }
-
-        ast::Statement handleIdentifier()
-        {
-            return parseAssignmentExpression().release();
-        }
-
-        ast::Statement parseFunctionDeclaration()
-        {
-            auto const isMutable = eatIfMutable();
-
-            auto type = expect( TokenType::ClassType, TokenType::PrimitiveType, "function must have return type" );
-
-            std::string f_rettype_str { std::move( type.value ) };
-
-            const auto [ isRef, isPtr ] = eatIfRefOrPtr();
-            
-            ast::TypeName f_rettype { std::move( f_rettype_str ), isMutable, isRef, isPtr };
-
-            ast::Identifier f_name = expect( TokenType::Identifier, "function must have name" ).value;
-
-            expect( TokenType::OParen, "missing open paren to start parameter list" );
-
-            ast::ParameterList f_p_list;
-            f_p_list.reserve( 10 );
-
-            // Generate param list
-            while ( peek().type == TokenType::ClassType || peek().type == TokenType::PrimitiveType || peek().type == TokenType::mutable_ )
-            {
-                auto const isMutable = eatIfMutable();
-
-                std::string p_type { eat().value };
-
-                const auto [ isRef, isPtr ] = eatIfRefOrPtr();
-
-                std::string p_name { expect( TokenType::Identifier, "parameters must have a type and name" ).value };
-                
-                const auto maybe_comma = peek();
-
-                if ( maybe_comma.type == TokenType::Comma ) eat();
-                else if ( maybe_comma.type != TokenType::CParen )
-                    throw std::runtime_error( "invalid parameter list for function " + f_name.getSymbol() );
+        DeclShape shapeAt( size_t at ) const { return at < shapes.size() ? shapes[ at ] : DeclShape::None; }
+        
+        bool not_eof() const { return tokens[ i ].type != TokenType::EOF_; }
 
-                f_p_list.push_back( ast::Parameter( isMutable, std::move( p_type ), isRef, isPtr, std::move( p_name ) ) );
-            }
+        Token expect( TokenType type, const std::string& err );
 
-            f_p_list.shrink_to_fit();
+        Token expect( TokenType type1, TokenType type2, const std::string& err );
+        
+        template< bool AllowDeclarations = true >
+        ast::Statement parseStatement();
 
-            expect( TokenType::CParen, "missing closing paren of parameter list" );
-            expect( TokenType::OCurlyBrace, "missing opening bracket of function body" );
+        ast::Statement parseIfStatement();
 
-            ast::StatementList f_body;
-            f_body.reserve( 10 );
+        ast::Statement parseForInStatement();
 
-            // Generate function body
-            while ( peek().type != TokenType::CCurlyBrace )
-            {
-                const auto tk = peek();
-                if ( tk.value == "return" )
-                {
-                    f_body.push_back( parseReturnStatement() );
-                    break;
-                }
-                f_body.push_back( parseStatement() );
-            }
+        ast::Statement parseNameSpaceDeclaration();
 
-            f_body.shrink_to_fit();
+        ast::Statement parseClassDefinition();
 
-            expect( TokenType::CCurlyBrace, "No matching closing bracket on function " + f_name.getSymbol() );
+        ast::Statement handleType();
 
-            return new ast::FunctionDeclaration( f_rettype, f_name, std::move( f_p_list ), std::move( f_body ) );
-        }
+        ast::Statement handleMutable();
 
-        ast::Statement parseReturnStatement()
-        {
-            const auto ret = expect( TokenType::return_, "" );
-            return new ast::ReturnStatement( parseStatement() );
-        }
+        ast::Statement parseMemoizedFunction();
 
-        ast::Statement parseVariableDeclaration()
-        {
-            const auto isMutable = eatIfMutable();
+        ast::Statement parseConstexprDeclaration();
 
-            std::string typestr = std::move( expect( TokenType::ClassType, TokenType::PrimitiveType, "expected type in variable declaration" ).value );
+        ast::Statement parseTemplateDeclaration();
 
-            const auto [ isRef, isPtr ] = eatIfRefOrPtr();
+        // Parses '< type, ... >' after a generic name and returns the mangled name
+        std::string parseTypeArguments( std::string&& name );
 
-            ast::TypeName type { std::move( typestr ), isMutable, isRef, isPtr };
+        std::string parseTypeString();
 
-            std::string name = std::move( expect( TokenType::Identifier, "Expected an identifier for a variable" ).value );
+        ast::Statement handleIdentifier();
 
-            if ( peek().type == TokenType::Semicolon )
-            {
-                eat();
+        ast::Statement parseFunctionDeclaration();
 
-                return new ast::VariableDeclaration( false, std::move( type ), std::move( name ) );
-            }
+        ast::Statement parseReturnStatement();
 
-            expect( TokenType::Equals, "Expected an '=' after identifier." );
-            auto expr = parseExpression();
-            return new ast::VariableDeclaration( isMutable, std::move( type ), std::move( name ), std::move( expr ) );
-        }
+        ast::Statement parseVariableDeclaration();
         
         template< bool TopCall = true >
-        std::unique_ptr< ast::Expression > parseExpression()
-        {
-            return parseAssignmentExpression< TopCall >();
-        }
+        std::unique_ptr< ast::Expression > parseExpression();
 
         template< bool TopCall = true >
-        std::unique_ptr< ast::Expression > parseAssignmentExpression()
-        {
-            if constexpr ( TopCall )
-            {
-                const auto next = peekNext().type;
-
-                if ( next == TokenType::ClassType || next == TokenType::PrimitiveType || next == TokenType::Reference || next == TokenType::Pointer )
-                {
-                    return makeExpression( parseVariableDeclaration().release< ast::VariableDeclaration >() );
-                }
-            }
-
-            auto left = parseBooleanExpression();
-
-            if ( peek().type == TokenType::Equals )
-            {
-                eat();
-                auto right = parseAssignmentExpression< false >();
-                left = makeExpression( new ast::AssignmentExpression{ std::move( left ), std::move( right ) } );
-            }
-
-            if constexpr ( TopCall )
-                expect( TokenType::Semicolon, "must end statement with semicolon" );
-
-            return left;
-        }
+        std::unique_ptr< ast::Expression > parseAssignmentExpression();
 
         template< bool isLoneCall = false >
-        std::unique_ptr< ast::Expression > parseFunctionCall()
-        {
-            auto f_name { expect( TokenType::Identifier, "Expected function name" ).value };
-
-            expect( TokenType::OParen, "Function call must have open paren" );
-
-            auto param = peek();
+        std::unique_ptr< ast::Expression > parseFunctionCall();
 
-            ast::StatementList params;
-
-            while ( param.type != TokenType::CParen )
-            {
-                params.push_back( parseAdditiveExpression().release() );
-                const auto tkty = peek().type;
-                if ( tkty == TokenType::Comma )
-                {
-                    eat();
-                }
-                param = peek();
-            }
+        // Recursive descent
 
-            expect( TokenType::CParen, "Expected closing paren to end function call" );
+        std::unique_ptr< ast::Expression > parseBooleanExpression();
 
-            if constexpr ( isLoneCall )
-            {
-                expect( TokenType::Semicolon, "Expected semicolon to end statement" );
-            }
+        std::unique_ptr< ast::Expression > parseAdditiveExpression();
 
-            return makeExpression( new ast::FunctionCall( std::move( f_name ), std::move( params ) ) );
-        }
+        std::unique_ptr< ast::Expression > parseMultiplicativeExpression();
 
-        // Recursive descent
+        std::unique_ptr< ast::Expression > parseExponentialExpression();
 
-        std::unique_ptr< ast::Expression > parseBooleanExpression()
-        {
-            auto left = parseAdditiveExpression();
-
-            while ( peek().type == TokenType::EqualsEquals || peek().type == TokenType::NotEquals )
-            {
-                auto op{ eat().value };
-                auto right = parseAdditiveExpression();
-                left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
-            }
-            return left;
-        }
-
-        std::unique_ptr< ast::Expression > parseAdditiveExpression()
-        {
-            auto left = parseMultiplicativeExpression();
-
-            while ( peek().value == "+" || peek().value == "-" )
-            {
-                auto op { eat().value };
-                auto right = parseMultiplicativeExpression();
-                left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
-            }
-            return left;
-        }
-
-        std::unique_ptr< ast::Expression > parseMultiplicativeExpression() 
-        {
-            auto left = parseExponentialExpression();
-
-            while ( peek().isMultParseLevel() )
-            {
-                auto op { eat().value };
-                auto right = parseExponentialExpression();
-                left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
-            }
-            return left;
-        }
-
-        std::unique_ptr< ast::Expression > parseExponentialExpression() 
-        {
-            auto left = parseDotExpression();
-
-            while ( peek().type == TokenType::Exponent )
-            {
-                auto op { eat().value };
-                auto right = parseDotExpression();
-                left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
-            }
-            return left;
-        }
-
-        std::unique_ptr< ast::Expression > parseDotExpression()
-        {
-            auto left = parsePrimaryExpression();
-
-            while ( peek().type == TokenType::Dot )
-            {
-                auto op{ eat().value };
-                auto right = parsePrimaryExpression();
-                left = makeExpression( new ast::BinaryExpression( std::move( left ), std::move( op ), std::move( right ) ) );
-            }
-            return left;
-        }
+        std::unique_ptr< ast::Expression > parseDotExpression();
         
-        std::unique_ptr< ast::Expression > parsePrimaryExpression() 
-        {
-            const auto tk = peek().type;
-            
-            switch ( tk )
-            {
-                case TokenType::Identifier:
-                {
-                    if ( peekNext().type == TokenType::OParen )
-                    {
-                        return parseFunctionCall();
-                    }
-                    return makeExpression( new ast::Identifier( eat().value ) );
-                }
-                case TokenType::negative_integer_literal:
-                    return makeExpression( new ast::NumericLiteral< int64_t >( atoll( eat().value.c_str() ) ) );
-                case TokenType::integer_literal:
-                    return makeExpression( new ast::NumericLiteral< uint64_t >( atoll( eat().value.c_str() ) ) );
-                case TokenType::float_literal:
-                    return makeExpression( new ast::NumericLiteral< double >( atof( eat().value.c_str() ) ) );
-                case TokenType::string_literal:
-                    return makeExpression( new ast::StringLiteral( eat().value ) );
-                case TokenType::char_literal:
-                    return makeExpression( new ast::CharacterLiteral( eat().value ) );
-                case TokenType::bool_literal:
-                    return makeExpression( new ast::BoolLiteral( eat().value == "true" ) );
-                case TokenType::OParen:
-                {
-                    eat();
-                    auto value = parseExpression< false >();
-                    expect( TokenType::CParen, "No closing paren!" );
-                    return value;
-                }
-
-                default:
-                    throw std::runtime_error( "Unexpected token found during parsing!" );
-            }
-        }
+        std::unique_ptr< ast::Expression > parsePrimaryExpression();
     };
 }
@@ -0,0 +1,118 @@
+#include "Serialize.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        SchemaBuilder::SchemaBuilder( const ast::Program& program )
+        {
+            collect( program.getBody(), "" );
+        }
+
+        const SchemaBuilder::Schema& SchemaBuilder::schemaFor( const std::string& qualifiedName )
+        {
+            const auto built = schemas.find( qualifiedName );
+            if ( built != schemas.cend() )
+                return built->second;
+            const auto it = classes.find( qualifiedName );
+            if ( it == classes.cend() )
+                throw std::runtime_error( "no class named " + qualifiedName );
+
+            Schema schema;
+            schema.name = qualifiedName;
+            std::unordered_set< std::string > open;
+            addFields( schema, it->second, "", open );
+            schema.layout();
+            return schemas.emplace( qualifiedName, std::move( schema ) ).first->second;
+        }
+
+        std::vector< const SchemaBuilder::Schema* > SchemaBuilder::buildAll()
+        {
+            std::vector< const Schema* > result;
+            for ( const auto& cls : classes )
+            {
+                try
+                {
+                    result.push_back( &schemaFor( cls.first ) );
+                }
+                catch ( const std::runtime_error& ) {}
+            }
+            return result;
+        }
+
+        void SchemaBuilder::collect( const ast::StatementList& body, const std::string& scope )
+        {
+            for ( const auto& stmt : body )
+            {
+                if ( stmt.isNot< ast::Type::Expression >() )
+                    continue;
+                auto expr = stmt.as< ast::Expression >();
+                if ( auto cls = expr->as< ast::ClassDeclaration >() )
+                    classes[ SymbolTable::qualify( scope, cls->getType().getName() ) ] = { cls, scope };
+                else if ( auto nsp = expr->as< ast::NameSpaceDeclaration >() )
+                    collect( nsp->getBody(), SymbolTable::qualify( scope, nsp->getName().getSymbol() ) );
+            }
+        }
+
+        const std::string* SchemaBuilder::resolveClass( std::string scope, const std::string& name ) const
+        {
+            while ( true )
+            {
+                const auto it = classes.find( SymbolTable::qualify( scope, name ) );
+                if ( it != classes.cend() )
+                    return &it->first;
+                if ( scope.empty() )
+                    return nullptr;
+                const auto sep = scope.rfind( "::" );
+                scope = sep == std::string::npos ? "" : scope.substr( 0, sep );
+            }
+        }
+
+        bool SchemaBuilder::primitiveKind( const std::string& name, runtime::serial::FieldKind& kind )
+        {
+            using runtime::serial::FieldKind;
+            static const std::map< std::string, FieldKind > kinds
+            {
+                { "bool", FieldKind::Bool }, { "char", FieldKind::Char },
+                { "int8", FieldKind::Int8 }, { "int16", FieldKind::Int16 },
+                { "int32", FieldKind::Int32 }, { "int64", FieldKind::Int64 },
+                { "uint8", FieldKind::UInt8 }, { "uint16", FieldKind::UInt16 },
+                { "uint32", FieldKind::UInt32 }, { "uint64", FieldKind::UInt64 },
+                { "float", FieldKind::Float }, { "double", FieldKind::Double },
+                { "String", FieldKind::String },
+            };
+            const auto it = kinds.find( name );
+            if ( it == kinds.cend() )
+                return false;
+            kind = it->second;
+            return true;
+        }
+
+        void SchemaBuilder::addFields( Schema& schema, const ClassInfo& info, const std::string& prefix, std::unordered_set< std::string >& open )
+        {
+            const auto& className = info.decl->getType().getName();
+            open.insert( SymbolTable::qualify( info.scope, className ) );
+            for ( const auto& field : info.decl->getFields() )
+            {
+                const auto& type = field.var.getType();
+                const auto name = prefix + field.var.getIdentifier().getSymbol();
+                if ( type.isRef() || type.isPtr() )
+                    throw std::runtime_error( "cannot serialize " + className + ": field " + name + " is a reference or pointer" );
+
+                runtime::serial::FieldKind kind;
+                if ( primitiveKind( type.getName(), kind ) )
+                {
+                    schema.fields.push_back( { name, kind, 0 } );
+                    continue;
+                }
+                const auto nested = resolveClass( info.scope, type.getName() );
+                if ( !nested )
+                    throw std::runtime_error( "cannot serialize " + className + ": field " + name + " has type " + type.getName() );
+                if ( open.count( *nested ) )
+                    throw std::runtime_error( "cannot serialize " + className + ": field " + name + " contains itself" );
+                addFields( schema, classes.at( *nested ), name + ".", open );
+            }
+            open.erase( SymbolTable::qualify( info.scope, className ) );
+        }
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <map>
+#include <unordered_set>
+
+#include "AST.h"
+#include "Effects.h"
+#include "runtime/Serial.h"
+
+namespace t
+{
+    namespace analysis
+    {
+        // Derives the binary record layout of every class in a program. A
+        // class can be serialized when all of its fields are primitives,
+        // Strings or by-value instances of other serializable classes; nested
+        // instances are flattened into the outer record, so reading a field
+        // never follows a pointer. References, pointers and Maps are refused.
+        class SchemaBuilder
+        {
+        public:
+            using Schema = runtime::serial::Schema;
+
+            SchemaBuilder( const ast::Program& program );
+
+            // The layout of one class, by the name it is declared with
+            // (qualified with its namespaces). Throws if it cannot be serialized.
+            const Schema& schemaFor( const std::string& qualifiedName );
+
+            // Every class that can be serialized, the others are skipped
+            std::vector< const Schema* > buildAll();
+        private:
+            struct ClassInfo
+            {
+                const ast::ClassDeclaration* decl;
+                std::string scope;
+            };
+
+            std::map< std::string, ClassInfo > classes;
+            std::map< std::string, Schema > schemas;
+
+            void collect( const ast::StatementList& body, const std::string& scope );
+
+            // Looks a class name up from the innermost scope outwards
+            const std::string* resolveClass( std::string scope, const std::string& name ) const;
+
+            static bool primitiveKind( const std::string& name, runtime::serial::FieldKind& kind );
+
+            void addFields( Schema& schema, const ClassInfo& info, const std::string& prefix, std::unordered_set< std::string >& open );
+        };
+    }
+}
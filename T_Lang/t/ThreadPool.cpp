@@ -0,0 +1,164 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace t
+{
+    namespace
+    {
+        // Set while a thread is running work for any pool
+        thread_local bool insideJob = false;
+    }
+
+    ThreadPool::ThreadPool( size_t threads )
+    {
+        if ( threads == 0 )
+            threads = std::max( 1u, std::thread::hardware_concurrency() );
+        for ( size_t n = 1; n < threads; n++ )
+            workers.emplace_back( [ this, n ]{ workerLoop( n ); } );
+    }
+
+    ThreadPool::Job::Job( const Task& fn, size_t count, size_t threads ):
+        fn( fn ),
+        threads( threads ),
+        shares( new Share[ threads ] )
+    {
+        for ( size_t n = 0; n < threads; n++ )
+        {
+            shares[ n ].begin = count * n / threads;
+            shares[ n ].end = count * ( n + 1 ) / threads;
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            stopping = true;
+        }
+        wake.notify_all();
+        for ( auto& worker : workers )
+            worker.join();
+    }
+
+    void ThreadPool::run( size_t count, const Task& fn )
+    {
+        if ( workers.empty() || insideJob || count == 1 )
+        {
+            Job current { fn, count, 1 };
+            const auto wasInside = insideJob;
+            insideJob = true;
+            work( current, 0 );
+            insideJob = wasInside;
+            if ( current.error )
+                std::rethrow_exception( current.error );
+            return;
+        }
+
+        Job current { fn, count, size() };
+        {
+            std::lock_guard< std::mutex > serial( submit );
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                job = &current;
+                generation++;
+            }
+            wake.notify_all();
+
+            insideJob = true;
+            work( current, 0 );
+            insideJob = false;
+
+            // Workers register under the mutex before touching the job, so
+            // once none is active no one can still reach it
+            std::unique_lock< std::mutex > lock( mutex );
+            idle.wait( lock, [ this ]{ return active == 0; } );
+            job = nullptr;
+        }
+
+        if ( current.error )
+            std::rethrow_exception( current.error );
+    }
+
+    void ThreadPool::work( Job& job, size_t thread )
+    {
+        auto& own = job.shares[ thread ];
+        while ( true )
+        {
+            size_t index = 0;
+            bool found = false;
+            {
+                std::lock_guard< std::mutex > lock( own.mutex );
+                if ( own.begin < own.end )
+                {
+                    index = own.begin++;
+                    found = true;
+                }
+            }
+            if ( !found )
+            {
+                if ( steal( job, thread ) )
+                    continue;
+                return;
+            }
+
+            try
+            {
+                job.fn( index, thread );
+            }
+            catch ( ... )
+            {
+                std::lock_guard< std::mutex > lock( job.errorMutex );
+                if ( !job.error || index < job.errorIndex )
+                {
+                    job.error = std::current_exception();
+                    job.errorIndex = index;
+                }
+            }
+        }
+    }
+
+    bool ThreadPool::steal( Job& job, size_t thread )
+    {
+        for ( size_t n = 1; n < job.threads; n++ )
+        {
+            auto& victim = job.shares[ ( thread + n ) % job.threads ];
+            size_t begin, end;
+            {
+                std::lock_guard< std::mutex > lock( victim.mutex );
+                if ( victim.begin == victim.end )
+                    continue;
+                end = victim.end;
+                victim.end -= ( victim.end - victim.begin + 1 ) / 2;
+                begin = victim.end;
+            }
+            auto& own = job.shares[ thread ];
+            std::lock_guard< std::mutex > lock( own.mutex );
+            own.begin = begin;
+            own.end = end;
+            return true;
+        }
+        return false;
+    }
+
+    void ThreadPool::workerLoop( size_t thread )
+    {
+        insideJob = true;
+        uint64_t seen = 0;
+        std::unique_lock< std::mutex > lock( mutex );
+        while ( true )
+        {
+            wake.wait( lock, [ & ]{ return stopping || ( job && generation != seen ); } );
+            if ( stopping )
+                return;
+            seen = generation;
+            auto& current = *job;
+            active++;
+            lock.unlock();
+            work( current, thread );
+            lock.lock();
+            if ( --active == 0 )
+                idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace t
+{
+    // Worker threads for the parallel phases of the compiler. Work is handed
+    // out as a parallelFor over indices; the thread that calls it takes part,
+    // so a pool of one thread runs everything inline. Every thread starts on
+    // its own contiguous share of the indices and, once that is used up,
+    // steals the back half of the share of another thread.
+    class ThreadPool
+    {
+    public:
+        // 0 uses one thread per core
+        explicit ThreadPool( size_t threads = 0 );
+        ~ThreadPool();
+
+        ThreadPool( const ThreadPool& ) = delete;
+        ThreadPool& operator=( const ThreadPool& ) = delete;
+
+        // Threads that run work, counting the caller of parallelFor()
+        size_t size() const { return workers.size() + 1; }
+
+        // Calls fn( index ) for every index below count and returns once all
+        // calls have finished. If calls throw, the exception of the lowest
+        // index is rethrown, so errors do not depend on scheduling. Called
+        // from inside a running parallelFor it runs inline.
+        //
+        // fn may also take fn( index, thread ), where thread is below size()
+        // and no two calls run on the same thread at once, to index per-thread
+        // state such as buffers.
+        template< typename F >
+        void parallelFor( size_t count, F&& fn )
+        {
+            if ( count == 0 )
+                return;
+            if constexpr ( std::is_invocable_v< F&, size_t, size_t > )
+            {
+                const Task call { std::ref( fn ) };
+                run( count, call );
+            }
+            else
+            {
+                const Task call { [ &fn ]( size_t index, size_t ){ fn( index ); } };
+                run( count, call );
+            }
+        }
+    private:
+        using Task = std::function< void( size_t, size_t ) >;
+
+        // The indices a thread has left, [ begin, end )
+        struct alignas( 64 ) Share
+        {
+            std::mutex mutex;
+            size_t begin = 0;
+            size_t end = 0;
+        };
+
+        struct Job
+        {
+            Job( const Task& fn, size_t count, size_t threads );
+
+            const Task& fn;
+            const size_t threads;
+            std::unique_ptr< Share[] > shares;
+            std::mutex errorMutex;
+            std::exception_ptr error;
+            size_t errorIndex = 0;
+        };
+
+        std::vector< std::thread > workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable idle;
+        // Serializes parallelFor calls from different threads
+        std::mutex submit;
+        Job* job = nullptr;
+        uint64_t generation = 0;
+        size_t active = 0;
+        bool stopping = false;
+
+        void run( size_t count, const Task& fn );
+        static void work( Job& job, size_t thread );
+        // Moves the back half of another thread's share to this one
+        static bool steal( Job& job, size_t thread );
+        void workerLoop( size_t thread );
+    };
+}
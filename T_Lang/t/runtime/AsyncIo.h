@@ -0,0 +1,420 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "../common.h"
+
+#if defined( __linux__ )
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define T_RUNTIME_IO_URING 1
+#endif
+
+#if defined( _WIN32 )
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace t
+{
+    namespace runtime
+    {
+        struct IoResult
+        {
+            // Bytes transferred, or -1 with 'error' set to the errno value
+            int64_t bytes = 0;
+            int error = 0;
+        };
+
+        using IoCallback = std::function< void( const IoResult& ) >;
+
+        // Reads are queued with read(), handed to the kernel in batches by
+        // submit() and completed by poll(). Callbacks always run on the thread
+        // that calls poll(), whichever backend performs the I/O. Destroying a
+        // backend finishes every queued request and runs its callback first.
+        class IoBackend
+        {
+        public:
+            virtual ~IoBackend() = default;
+
+            virtual const char* name() const = 0;
+
+            virtual void read( int fd, char* buffer, size_t len, uint64_t offset, IoCallback&& done ) = 0;
+
+            // Returns the number of requests handed over
+            virtual size_t submit() = 0;
+
+            // Runs the callbacks of finished requests, waiting for at least one
+            // if 'wait' is set and any are in flight. Returns how many ran.
+            virtual size_t poll( bool wait ) = 0;
+
+            // Queued or in flight
+            virtual size_t pending() const = 0;
+        };
+
+        // Reads with pread on a few worker threads. Used where io_uring is not
+        // available: other platforms, old kernels and sandboxes that block it.
+        class ThreadPoolIo : public IoBackend
+        {
+        public:
+            explicit ThreadPoolIo( size_t threads = 8 )
+            {
+                for ( size_t i = 0; i < std::max< size_t >( threads, 1 ); i++ )
+                    workers.emplace_back( [ this ]{ work(); } );
+            }
+
+            ~ThreadPoolIo() override
+            {
+                // Like UringIo, every queued request finishes and runs its callback
+                while ( pending() > 0 )
+                {
+                    submit();
+                    poll( true );
+                }
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    stopping = true;
+                }
+                wake.notify_all();
+                for ( auto& worker : workers )
+                    worker.join();
+            }
+
+            const char* name() const override { return "threads"; }
+
+            void read( int fd, char* buffer, size_t len, uint64_t offset, IoCallback&& done ) override
+            {
+                batch.push_back( Job { fd, buffer, len, offset, std::move( done ), {} } );
+            }
+
+            size_t submit() override
+            {
+                const auto count = batch.size();
+                if ( count == 0 )
+                    return 0;
+                {
+                    std::lock_guard< std::mutex > lock( mutex );
+                    for ( auto& job : batch )
+                        jobs.push_back( std::move( job ) );
+                    inFlight += count;
+                }
+                batch.clear();
+                wake.notify_all();
+                return count;
+            }
+
+            size_t poll( bool wait ) override
+            {
+                std::vector< Job > ready;
+                {
+                    std::unique_lock< std::mutex > lock( mutex );
+                    if ( wait && inFlight > 0 )
+                        finished.wait( lock, [ this ]{ return !completed.empty(); } );
+                    ready.swap( completed );
+                    inFlight -= ready.size();
+                }
+                for ( auto& job : ready )
+                    job.done( job.result );
+                return ready.size();
+            }
+
+            size_t pending() const override
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                return batch.size() + inFlight;
+            }
+        private:
+            struct Job
+            {
+                int fd;
+                char* buffer;
+                size_t len;
+                uint64_t offset;
+                IoCallback done;
+                IoResult result;
+            };
+
+            std::vector< std::thread > workers;
+            mutable std::mutex mutex;
+            std::condition_variable wake;
+            std::condition_variable finished;
+            std::deque< Job > jobs;
+            std::vector< Job > completed;
+            std::vector< Job > batch;
+            size_t inFlight = 0;
+            bool stopping = false;
+
+            static IoResult perform( const Job& job )
+            {
+#if defined( _WIN32 )
+                // No positional read in the CRT, each worker needs its own seek
+                static std::mutex seekMutex;
+                std::lock_guard< std::mutex > lock( seekMutex );
+                if ( _lseeki64( job.fd, static_cast< int64_t >( job.offset ), SEEK_SET ) < 0 )
+                    return IoResult { -1, errno };
+                const auto n = _read( job.fd, job.buffer, static_cast< unsigned >( job.len ) );
+#else
+                ssize_t n;
+                do
+                    n = ::pread( job.fd, job.buffer, job.len, static_cast< off_t >( job.offset ) );
+                while ( n < 0 && errno == EINTR );
+#endif
+                return n < 0 ? IoResult { -1, errno } : IoResult { n, 0 };
+            }
+
+            void work()
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                while ( true )
+                {
+                    wake.wait( lock, [ this ]{ return stopping || !jobs.empty(); } );
+                    if ( stopping )
+                        return;
+                    auto job = std::move( jobs.front() );
+                    jobs.pop_front();
+                    lock.unlock();
+                    job.result = perform( job );
+                    lock.lock();
+                    completed.push_back( std::move( job ) );
+                    finished.notify_one();
+                }
+            }
+        };
+
+#if T_RUNTIME_IO_URING
+        // io_uring through the raw system calls. Reads are written straight
+        // into the shared submission ring and one io_uring_enter both submits
+        // the whole batch and, when asked to, waits for completions.
+        class UringIo : public IoBackend
+        {
+        public:
+            explicit UringIo( unsigned entries = 256 )
+            {
+                io_uring_params params {};
+                ring = static_cast< int >( syscall( __NR_io_uring_setup, entries, &params ) );
+                if ( ring < 0 )
+                    throw std::runtime_error( std::string( "io_uring_setup failed: " ) + std::strerror( errno ) );
+
+                sqSize = params.sq_off.array + params.sq_entries * sizeof( uint32_t );
+                cqSize = params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+                const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+                if ( single )
+                    sqSize = cqSize = std::max( sqSize, cqSize );
+
+                sqRing = mapRing( sqSize, IORING_OFF_SQ_RING );
+                cqRing = single ? sqRing : mapRing( cqSize, IORING_OFF_CQ_RING );
+                sqes = static_cast< io_uring_sqe* >( mapRing( params.sq_entries * sizeof( io_uring_sqe ), IORING_OFF_SQES ) );
+                sqeBytes = params.sq_entries * sizeof( io_uring_sqe );
+
+                const auto sq = static_cast< char* >( sqRing );
+                sqHead = reinterpret_cast< unsigned* >( sq + params.sq_off.head );
+                sqTail = reinterpret_cast< unsigned* >( sq + params.sq_off.tail );
+                sqMask = *reinterpret_cast< unsigned* >( sq + params.sq_off.ring_mask );
+                sqArray = reinterpret_cast< unsigned* >( sq + params.sq_off.array );
+                sqEntries = params.sq_entries;
+
+                const auto cq = static_cast< char* >( cqRing );
+                cqHead = reinterpret_cast< unsigned* >( cq + params.cq_off.head );
+                cqTail = reinterpret_cast< unsigned* >( cq + params.cq_off.tail );
+                cqMask = *reinterpret_cast< unsigned* >( cq + params.cq_off.ring_mask );
+                cqes = reinterpret_cast< io_uring_cqe* >( cq + params.cq_off.cqes );
+                cqEntries = params.cq_entries;
+            }
+
+            ~UringIo() override
+            {
+                // Requests still in flight would write into freed buffers
+                while ( pending() > 0 )
+                {
+                    submit();
+                    poll( true );
+                }
+                if ( sqes )
+                    munmap( sqes, sqeBytes );
+                if ( cqRing && cqRing != sqRing )
+                    munmap( cqRing, cqSize );
+                if ( sqRing )
+                    munmap( sqRing, sqSize );
+                if ( ring >= 0 )
+                    ::close( ring );
+            }
+
+            const char* name() const override { return "io_uring"; }
+
+            void read( int fd, char* buffer, size_t len, uint64_t offset, IoCallback&& done ) override
+            {
+                // The completion ring must always have room for everything in flight
+                while ( inFlight + queued >= cqEntries )
+                {
+                    submit();
+                    poll( true );
+                }
+                while ( queued + unconsumed() >= sqEntries )
+                {
+                    submit();
+                    if ( queued + unconsumed() >= sqEntries )
+                        poll( true );
+                }
+
+                const auto slot = allocate( std::move( done ) );
+                const unsigned tail = *sqTail + queued;
+                const unsigned index = tail & sqMask;
+                auto& sqe = sqes[ index ];
+                std::memset( &sqe, 0, sizeof( sqe ) );
+                sqe.opcode = IORING_OP_READ;
+                sqe.fd = fd;
+                sqe.addr = reinterpret_cast< uint64_t >( buffer );
+                sqe.len = static_cast< uint32_t >( std::min< size_t >( len, UINT32_MAX ) );
+                sqe.off = offset;
+                sqe.user_data = slot;
+                sqArray[ index ] = index;
+                queued++;
+            }
+
+            size_t submit() override { return enter( 0 ); }
+
+            size_t poll( bool wait ) override
+            {
+                if ( wait && inFlight + queued > 0 && !hasCompletions() )
+                    enter( 1 );
+
+                size_t ran = 0;
+                // The head is read again for every entry: a callback that queues
+                // reads can poll from inside read() and consume entries itself
+                while ( hasCompletions() )
+                {
+                    const unsigned head = *cqHead;
+                    const auto& cqe = cqes[ head & cqMask ];
+                    const auto slot = static_cast< size_t >( cqe.user_data );
+                    const auto result = cqe.res < 0 ? IoResult { -1, -cqe.res } : IoResult { cqe.res, 0 };
+                    __atomic_store_n( cqHead, head + 1, __ATOMIC_RELEASE );
+                    inFlight--;
+
+                    auto done = std::move( callbacks[ slot ] );
+                    freeSlots.push_back( slot );
+                    done( result );
+                    ran++;
+                }
+                return ran;
+            }
+
+            size_t pending() const override { return queued + inFlight; }
+        private:
+            int ring = -1;
+            void* sqRing = nullptr;
+            void* cqRing = nullptr;
+            size_t sqSize = 0;
+            size_t cqSize = 0;
+            size_t sqeBytes = 0;
+            io_uring_sqe* sqes = nullptr;
+            io_uring_cqe* cqes = nullptr;
+            unsigned* sqHead = nullptr;
+            unsigned* sqTail = nullptr;
+            unsigned* sqArray = nullptr;
+            unsigned* cqHead = nullptr;
+            unsigned* cqTail = nullptr;
+            unsigned sqMask = 0;
+            unsigned cqMask = 0;
+            unsigned sqEntries = 0;
+            unsigned cqEntries = 0;
+            // Written to the ring but not yet submitted, and submitted but not completed
+            unsigned queued = 0;
+            size_t inFlight = 0;
+            std::vector< IoCallback > callbacks;
+            std::vector< size_t > freeSlots;
+
+            void* mapRing( size_t size, uint64_t offset )
+            {
+                void* p = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, static_cast< off_t >( offset ) );
+                if ( p == MAP_FAILED )
+                {
+                    const auto err = errno;
+                    ::close( ring );
+                    ring = -1;
+                    throw std::runtime_error( std::string( "io_uring mmap failed: " ) + std::strerror( err ) );
+                }
+                return p;
+            }
+
+            size_t allocate( IoCallback&& done )
+            {
+                if ( freeSlots.empty() )
+                {
+                    callbacks.push_back( std::move( done ) );
+                    return callbacks.size() - 1;
+                }
+                const auto slot = freeSlots.back();
+                freeSlots.pop_back();
+                callbacks[ slot ] = std::move( done );
+                return slot;
+            }
+
+            bool hasCompletions() const { return *cqHead != __atomic_load_n( cqTail, __ATOMIC_ACQUIRE ); }
+
+            // Published to the ring but not yet taken by the kernel
+            unsigned unconsumed() const { return *sqTail - __atomic_load_n( sqHead, __ATOMIC_ACQUIRE ); }
+
+            // Publishes the queued entries and enters the kernel once, which
+            // also retries anything an earlier call left in the ring
+            size_t enter( unsigned minComplete )
+            {
+                const auto count = queued;
+                if ( count )
+                {
+                    __atomic_store_n( sqTail, *sqTail + count, __ATOMIC_RELEASE );
+                    queued = 0;
+                    inFlight += count;
+                }
+                const auto toSubmit = unconsumed();
+                if ( toSubmit == 0 && minComplete == 0 )
+                    return 0;
+
+                const unsigned flags = minComplete ? IORING_ENTER_GETEVENTS : 0;
+                long submitted;
+                do
+                    submitted = syscall( __NR_io_uring_enter, ring, toSubmit, minComplete, flags, nullptr, 0 );
+                while ( submitted < 0 && errno == EINTR );
+                if ( submitted < 0 && errno != EAGAIN && errno != EBUSY )
+                    throw std::runtime_error( std::string( "io_uring_enter failed: " ) + std::strerror( errno ) );
+                return count;
+            }
+        };
+#endif
+
+        // The backend for this machine: io_uring when the kernel allows it,
+        // worker threads otherwise
+        inline std::unique_ptr< IoBackend > makeIoBackend( unsigned entries = 256 )
+        {
+#if T_RUNTIME_IO_URING
+            try
+            {
+                return std::make_unique< UringIo >( entries );
+            }
+            catch ( const std::runtime_error& ) {}
+#endif
+            ( void )entries;
+            return std::make_unique< ThreadPoolIo >();
+        }
+
+        // Runs callbacks until every request, including ones queued by the
+        // callbacks themselves, has finished
+        inline void drain( IoBackend& io )
+        {
+            while ( io.pending() > 0 )
+            {
+                io.submit();
+                io.poll( true );
+            }
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "../common.h"
+
+#if defined( __x86_64__ ) || defined( __i386__ ) || defined( _M_X64 ) || defined( _M_IX86 )
+#define T_RUNTIME_X86 1
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need per-function targets to emit wider instructions than
+// the build baseline, MSVC accepts the intrinsics anywhere
+#if T_RUNTIME_X86 && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#define T_TARGET_SSE42 __attribute__( ( target( "sse4.2" ) ) )
+#define T_TARGET_AVX2 __attribute__( ( target( "avx2" ) ) )
+#else
+#define T_TARGET_SSE42
+#define T_TARGET_AVX2
+#endif
+
+namespace t
+{
+    namespace runtime
+    {
+        struct CpuFeatures
+        {
+            bool sse2 = false;
+            bool sse42 = false;
+            bool avx2 = false;
+        };
+
+        inline CpuFeatures detectCpuFeatures()
+        {
+            CpuFeatures f;
+#if T_RUNTIME_X86 && defined( _MSC_VER )
+            int regs[ 4 ];
+            __cpuid( regs, 0 );
+            const int maxLeaf = regs[ 0 ];
+            __cpuid( regs, 1 );
+            f.sse2 = ( regs[ 3 ] >> 26 ) & 1;
+            f.sse42 = ( regs[ 2 ] >> 20 ) & 1;
+            const bool osxsave = ( regs[ 2 ] >> 27 ) & 1;
+            const bool avx = ( regs[ 2 ] >> 28 ) & 1;
+            // AVX state must also be enabled by the OS
+            const bool ymmEnabled = osxsave && avx && ( _xgetbv( 0 ) & 0x6 ) == 0x6;
+            if ( maxLeaf >= 7 )
+            {
+                __cpuidex( regs, 7, 0 );
+                f.avx2 = ymmEnabled && ( ( regs[ 1 ] >> 5 ) & 1 );
+            }
+#elif T_RUNTIME_X86
+            __builtin_cpu_init();
+            f.sse2 = __builtin_cpu_supports( "sse2" );
+            f.sse42 = __builtin_cpu_supports( "sse4.2" );
+            f.avx2 = __builtin_cpu_supports( "avx2" );
+#endif
+            return f;
+        }
+
+        // Detected once, the first time any kernel is dispatched
+        inline const CpuFeatures& cpuFeatures()
+        {
+            static const CpuFeatures features = detectCpuFeatures();
+            return features;
+        }
+    }
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <stdexcept>
+
+#include "String.h"
+
+#if defined( _WIN32 )
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace t
+{
+    namespace runtime
+    {
+        // A read-only view of a whole file. The pages are mapped rather than
+        // read, so opening costs nothing per byte and the kernel only loads
+        // what is touched. Strings taken from the file keep the mapping alive.
+        class MappedFile
+        {
+        public:
+            explicit MappedFile( const std::string& path ):
+                mapping( map( path ) ) {}
+
+            size_t size() const { return mapping->len; }
+
+            // The raw bytes, which may not be valid UTF-8
+            std::string_view bytes() const { return { mapping->data, mapping->len }; }
+
+            // The contents as a String without copying. The file is validated
+            // the first time this is called.
+            String text() const
+            {
+                if ( !validated )
+                {
+                    if ( !utf8::validate( bytes() ) )
+                        throw std::runtime_error( "file is not valid UTF-8" );
+                    validated = true;
+                }
+                return String::borrow( mapping, bytes() );
+            }
+
+            class Lines;
+
+            // `for ( line in file.lines() )`, each line without its line ending
+            Lines lines() const;
+        private:
+            struct Mapping
+            {
+                const char* data = "";
+                size_t len = 0;
+#if defined( _WIN32 )
+                HANDLE file = INVALID_HANDLE_VALUE;
+                HANDLE view = nullptr;
+#endif
+
+                Mapping() = default;
+                Mapping( const Mapping& ) = delete;
+                Mapping& operator=( const Mapping& ) = delete;
+
+                ~Mapping()
+                {
+#if defined( _WIN32 )
+                    if ( len )
+                        UnmapViewOfFile( data );
+                    if ( view )
+                        CloseHandle( view );
+                    if ( file != INVALID_HANDLE_VALUE )
+                        CloseHandle( file );
+#else
+                    if ( len )
+                        munmap( const_cast< char* >( data ), len );
+#endif
+                }
+            };
+
+            std::shared_ptr< const Mapping > mapping;
+            mutable bool validated = false;
+
+            static std::shared_ptr< const Mapping > map( const std::string& path )
+            {
+                auto m = std::make_shared< Mapping >();
+#if defined( _WIN32 )
+                m->file = CreateFileA( path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+                if ( m->file == INVALID_HANDLE_VALUE )
+                    throw std::runtime_error( "cannot open " + path );
+                LARGE_INTEGER size;
+                if ( !GetFileSizeEx( m->file, &size ) )
+                    throw std::runtime_error( "cannot read the size of " + path );
+                // Zero length files cannot be mapped and need no mapping
+                if ( size.QuadPart == 0 )
+                    return m;
+                m->view = CreateFileMappingA( m->file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+                if ( !m->view )
+                    throw std::runtime_error( "cannot map " + path );
+                const auto data = MapViewOfFile( m->view, FILE_MAP_READ, 0, 0, 0 );
+                if ( !data )
+                    throw std::runtime_error( "cannot map " + path );
+                m->data = static_cast< const char* >( data );
+                m->len = static_cast< size_t >( size.QuadPart );
+#else
+                const int fd = ::open( path.c_str(), O_RDONLY );
+                if ( fd < 0 )
+                    throw std::runtime_error( "cannot open " + path );
+                struct stat st;
+                if ( fstat( fd, &st ) != 0 )
+                {
+                    ::close( fd );
+                    throw std::runtime_error( "cannot read the size of " + path );
+                }
+                if ( st.st_size == 0 )
+                {
+                    ::close( fd );
+                    return m;
+                }
+                const auto len = static_cast< size_t >( st.st_size );
+#if defined( MAP_POPULATE )
+                // Fault the whole file in up front instead of one page at a time
+                const int flags = MAP_PRIVATE | MAP_POPULATE;
+#else
+                const int flags = MAP_PRIVATE;
+#endif
+                void* data = mmap( nullptr, len, PROT_READ, flags, fd, 0 );
+                // The mapping holds its own reference to the file
+                ::close( fd );
+                if ( data == MAP_FAILED )
+                    throw std::runtime_error( "cannot map " + path );
+                // Lines are read front to back, let the kernel read ahead
+                madvise( data, len, MADV_SEQUENTIAL );
+                m->data = static_cast< const char* >( data );
+                m->len = len;
+#endif
+                return m;
+            }
+        };
+
+        // Splits text into lines. Newlines are found 64 bytes at a time with
+        // the active matchMask kernel and then taken from the mask bit by
+        // bit, so short lines cost no more than long ones. Each line is a
+        // slice of the text, so iterating copies nothing.
+        class MappedFile::Lines
+        {
+        public:
+            explicit Lines( String text ):
+                text( std::move( text ) ) {}
+
+            class iterator
+            {
+            public:
+                iterator( const String* text, size_t at ):
+                    text( text ), at( at ), kernels( strings::activeKernels() ) { advance(); }
+
+                const String& operator*() const { return line; }
+                const String* operator->() const { return &line; }
+
+                iterator& operator++()
+                {
+                    advance();
+                    return *this;
+                }
+
+                bool operator==( const iterator& other ) const { return done == other.done && ( done || start == other.start ); }
+                bool operator!=( const iterator& other ) const { return !( *this == other ); }
+            private:
+                const String* text;
+                size_t at;
+                const strings::KernelTable* kernels;
+                // Newlines not yet consumed in the block at 'block', and where the next block starts
+                uint64_t mask = 0;
+                size_t block = 0;
+                size_t next = 0;
+                size_t start = 0;
+                bool done = false;
+                String line;
+
+                size_t nextNewline()
+                {
+                    const auto size = text->size();
+                    while ( !mask )
+                    {
+                        if ( next >= size )
+                            return size;
+                        block = next;
+                        next += 64;
+                        if ( next <= size )
+                        {
+                            mask = kernels->matchMask( text->data() + block, '\n' );
+                        }
+                        else
+                        {
+                            char tail[ 64 ] = {};
+                            std::memcpy( tail, text->data() + block, size - block );
+                            mask = kernels->matchMask( tail, '\n' );
+                        }
+                    }
+                    const auto pos = block + strings::lowestBit( mask );
+                    mask &= mask - 1;
+                    return pos;
+                }
+
+                void advance()
+                {
+                    if ( at >= text->size() )
+                    {
+                        done = true;
+                        return;
+                    }
+                    start = at;
+                    auto end = nextNewline();
+                    at = end + 1;
+                    if ( end > start && text->data()[ end - 1 ] == '\r' )
+                        end--;
+                    text->sliceInto( line, start, end );
+                }
+            };
+
+            iterator begin() const { return iterator( &text, 0 ); }
+            iterator end() const { return iterator( &text, text.size() ); }
+        private:
+            String text;
+        };
+
+        inline MappedFile::Lines MappedFile::lines() const { return Lines( text() ); }
+    }
+}
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "String.h"
+
+#if defined( _WIN32 )
+#include <io.h>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+namespace t
+{
+    namespace runtime
+    {
+        namespace io
+        {
+            inline void writeAll( int fd, const char* data, size_t len )
+            {
+                while ( len > 0 )
+                {
+#if defined( _WIN32 )
+                    const auto n = _write( fd, data, static_cast< unsigned >( std::min< size_t >( len, 1u << 30 ) ) );
+#else
+                    const auto n = ::write( fd, data, len );
+                    if ( n < 0 && errno == EINTR )
+                        continue;
+#endif
+                    if ( n <= 0 )
+                        throw std::runtime_error( "failed to write output" );
+                    data += n;
+                    len -= static_cast< size_t >( n );
+                }
+            }
+        }
+
+        // Collects output and hands it to the file descriptor in large writes.
+        // Each thread has its own buffer for stdout, so printing takes no locks;
+        // output of different threads is only ordered by their flushes.
+        class OutputBuffer
+        {
+        public:
+            static constexpr size_t CAPACITY = 1 << 16;
+
+            explicit OutputBuffer( int fd ):
+                fd( fd ), data( new char[ CAPACITY ] ) {}
+
+            OutputBuffer( const OutputBuffer& ) = delete;
+            OutputBuffer& operator=( const OutputBuffer& ) = delete;
+
+            ~OutputBuffer()
+            {
+                try { flush(); }
+                catch ( const std::runtime_error& ) {}
+            }
+
+            void write( const char* bytes, size_t len )
+            {
+                if ( used + len > CAPACITY )
+                {
+                    flush();
+                    // Too big to be worth copying
+                    if ( len >= CAPACITY / 2 )
+                        return io::writeAll( fd, bytes, len );
+                }
+                std::memcpy( data.get() + used, bytes, len );
+                used += len;
+            }
+
+            void write( char c )
+            {
+                if ( used == CAPACITY )
+                    flush();
+                data[ used++ ] = c;
+            }
+
+            void flush()
+            {
+                const auto len = used;
+                used = 0;
+                io::writeAll( fd, data.get(), len );
+            }
+
+            size_t pending() const { return used; }
+        private:
+            int fd;
+            std::unique_ptr< char[] > data;
+            size_t used = 0;
+        };
+
+        // This thread's buffer for standard output, flushed when it fills up,
+        // on flush() and when the thread exits
+        inline OutputBuffer& out()
+        {
+            thread_local OutputBuffer buffer { 1 };
+            return buffer;
+        }
+
+        inline void flush() { out().flush(); }
+
+        namespace detail
+        {
+            // Formatting into a std::string, for format()
+            struct StringWriter
+            {
+                std::string text;
+
+                void write( const char* bytes, size_t len ) { text.append( bytes, len ); }
+                void write( char c ) { text.push_back( c ); }
+            };
+
+            // One overload set per value kind, anything else is a compile error.
+            // The T types map to C++ types as follows: char is char, intN and
+            // uintN are the fixed width integers (so int8 prints as a number),
+            // float and double use the shortest text that reads back the same
+            // value, bool prints as true or false.
+            template< typename Writer, typename T >
+            void formatValue( Writer& w, const T& value )
+            {
+                if constexpr ( std::is_same_v< T, bool > )
+                {
+                    if ( value )
+                        w.write( "true", 4 );
+                    else
+                        w.write( "false", 5 );
+                }
+                else if constexpr ( std::is_same_v< T, char > )
+                {
+                    w.write( value );
+                }
+                else if constexpr ( std::is_integral_v< T > || std::is_floating_point_v< T > )
+                {
+                    char digits[ 32 ];
+                    const auto result = std::to_chars( digits, digits + sizeof( digits ), value );
+                    w.write( digits, static_cast< size_t >( result.ptr - digits ) );
+                }
+                else if constexpr ( std::is_same_v< T, String > )
+                {
+                    w.write( value.data(), value.size() );
+                }
+                else if constexpr ( std::is_convertible_v< const T&, std::string_view > )
+                {
+                    const std::string_view text { value };
+                    w.write( text.data(), text.size() );
+                }
+                else
+                {
+                    static_assert( sizeof( T ) == 0, "type cannot be formatted" );
+                }
+            }
+
+            template< typename Writer >
+            using Formatter = void ( * )( Writer&, const void* );
+
+            template< typename Writer, typename T >
+            void formatErased( Writer& w, const void* value ) { formatValue( w, *static_cast< const T* >( value ) ); }
+
+            // '{}' is replaced by the next argument, '{{' and '}}' are literal braces
+            template< typename Writer >
+            void formatInto( Writer& w, std::string_view fmt, const Formatter< Writer >* formatters, const void* const* values, size_t count )
+            {
+                size_t next = 0;
+                size_t i = 0;
+                while ( i < fmt.size() )
+                {
+                    const auto brace = fmt.find_first_of( "{}", i );
+                    if ( brace == std::string_view::npos )
+                        break;
+                    w.write( fmt.data() + i, brace - i );
+
+                    if ( brace + 1 < fmt.size() && fmt[ brace + 1 ] == fmt[ brace ] )
+                    {
+                        w.write( fmt[ brace ] );
+                        i = brace + 2;
+                        continue;
+                    }
+                    if ( fmt[ brace ] == '}' || brace + 1 == fmt.size() || fmt[ brace + 1 ] != '}' )
+                        throw std::runtime_error( "invalid format string" );
+                    if ( next == count )
+                        throw std::runtime_error( "format string has more placeholders than arguments" );
+                    formatters[ next ]( w, values[ next ] );
+                    next++;
+                    i = brace + 2;
+                }
+                w.write( fmt.data() + i, fmt.size() - i );
+                if ( next != count )
+                    throw std::runtime_error( "format string has fewer placeholders than arguments" );
+            }
+
+            template< typename Writer, typename... Args >
+            void format( Writer& w, std::string_view fmt, const Args&... args )
+            {
+                if constexpr ( sizeof...( Args ) == 0 )
+                {
+                    formatInto< Writer >( w, fmt, nullptr, nullptr, 0 );
+                }
+                else
+                {
+                    const Formatter< Writer > formatters[] = { &formatErased< Writer, Args >... };
+                    const void* const values[] = { &args... };
+                    formatInto( w, fmt, formatters, values, sizeof...( Args ) );
+                }
+            }
+        }
+
+        template< typename... Args >
+        void print( std::string_view fmt, const Args&... args )
+        {
+            detail::format( out(), fmt, args... );
+        }
+
+        template< typename... Args >
+        void print( OutputBuffer& to, std::string_view fmt, const Args&... args )
+        {
+            detail::format( to, fmt, args... );
+        }
+
+        template< typename... Args >
+        void println( std::string_view fmt, const Args&... args )
+        {
+            detail::format( out(), fmt, args... );
+            out().write( '\n' );
+        }
+
+        template< typename... Args >
+        String format( std::string_view fmt, const Args&... args )
+        {
+            detail::StringWriter w;
+            detail::format( w, fmt, args... );
+            return String( std::move( w.text ) );
+        }
+    }
+}
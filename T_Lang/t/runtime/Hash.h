@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstring>
+#include <string_view>
+
+#include "../common.h"
+
+namespace t
+{
+    namespace runtime
+    {
+        namespace hashing
+        {
+            inline uint64_t mix( uint64_t a, uint64_t b )
+            {
+#if defined( __SIZEOF_INT128__ )
+                const unsigned __int128 r = static_cast< unsigned __int128 >( a ) * b;
+                return static_cast< uint64_t >( r ) ^ static_cast< uint64_t >( r >> 64 );
+#else
+                // Folded 64x64 multiply without a 128-bit type
+                const uint64_t lo = a * b;
+                const uint64_t hi = ( a >> 32 ) * ( b >> 32 ) + ( ( ( a & 0xFFFFFFFF ) * ( b >> 32 ) ) >> 32 ) + ( ( ( a >> 32 ) * ( b & 0xFFFFFFFF ) ) >> 32 );
+                return lo ^ hi;
+#endif
+            }
+
+            inline uint64_t read64( const char* p ) { uint64_t v; std::memcpy( &v, p, 8 ); return v; }
+            inline uint64_t read32( const char* p ) { uint32_t v; std::memcpy( &v, p, 4 ); return v; }
+
+            constexpr uint64_t SEED0 = 0xA0761D6478BD642Full;
+            constexpr uint64_t SEED1 = 0xE7037ED1A0B428DBull;
+            constexpr uint64_t SEED2 = 0x8EBC6AF09C88C6E3ull;
+
+            // wyhash style: 16 bytes per round, short inputs in one multiply
+            inline uint64_t bytes( const char* data, size_t len )
+            {
+                uint64_t seed = SEED0 ^ mix( len, SEED1 );
+                uint64_t a = 0, b = 0;
+                if ( len <= 16 )
+                {
+                    if ( len >= 4 )
+                    {
+                        a = ( read32( data ) << 32 ) | read32( data + ( ( len >> 3 ) << 2 ) );
+                        b = ( read32( data + len - 4 ) << 32 ) | read32( data + len - 4 - ( ( len >> 3 ) << 2 ) );
+                    }
+                    else if ( len > 0 )
+                    {
+                        a = ( static_cast< uint64_t >( static_cast< uint8_t >( data[ 0 ] ) ) << 16 ) |
+                            ( static_cast< uint64_t >( static_cast< uint8_t >( data[ len >> 1 ] ) ) << 8 ) |
+                            static_cast< uint8_t >( data[ len - 1 ] );
+                    }
+                }
+                else
+                {
+                    size_t i = len;
+                    const char* p = data;
+                    for ( ; i > 16; i -= 16, p += 16 )
+                        seed = mix( read64( p ) ^ SEED1, read64( p + 8 ) ^ seed );
+                    a = read64( p + i - 16 );
+                    b = read64( p + i - 8 );
+                }
+                return mix( SEED1 ^ len, mix( a ^ SEED1, b ^ seed ) );
+            }
+
+            inline uint64_t integer( uint64_t v ) { return mix( v ^ SEED2, SEED1 ); }
+        }
+
+        template< typename T, typename = void >
+        struct Hash
+        {
+            uint64_t operator()( const T& value ) const { return hashing::integer( std::hash< T >()( value ) ); }
+        };
+
+        template< typename T >
+        struct Hash< T, std::enable_if_t< std::is_integral_v< T > || std::is_enum_v< T > > >
+        {
+            uint64_t operator()( T value ) const { return hashing::integer( static_cast< uint64_t >( value ) ); }
+        };
+
+        template< typename T >
+        struct Hash< T, std::enable_if_t< std::is_floating_point_v< T > > >
+        {
+            uint64_t operator()( T value ) const
+            {
+                // +0.0 and -0.0 compare equal so they must hash equal
+                if ( value == 0 )
+                    value = 0;
+                uint64_t bits = 0;
+                std::memcpy( &bits, &value, sizeof( T ) );
+                return hashing::integer( bits );
+            }
+        };
+
+        template<>
+        struct Hash< std::string_view >
+        {
+            uint64_t operator()( std::string_view s ) const { return hashing::bytes( s.data(), s.size() ); }
+        };
+
+        template<>
+        struct Hash< std::string >
+        {
+            uint64_t operator()( const std::string& s ) const { return hashing::bytes( s.data(), s.size() ); }
+        };
+    }
+}
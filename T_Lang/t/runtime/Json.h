@@ -0,0 +1,1298 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "Serial.h"
+#include "String.h"
+
+namespace t
+{
+    namespace runtime
+    {
+        namespace json
+        {
+            // Which bytes of a 64 byte block are of interest to the parser
+            struct BlockMasks
+            {
+                uint64_t quote;
+                uint64_t backslash;
+                // , : [ ] { }
+                uint64_t op;
+                uint64_t space;
+            };
+
+            namespace detail
+            {
+                // State carried from one block into the next
+                struct Carries
+                {
+                    uint64_t escape = 0;
+                    uint64_t inString = 0;
+                    uint64_t scalar = 0;
+                };
+
+                // Every bit from each quote up to, not including, the next one
+                inline uint64_t prefixXor( uint64_t x )
+                {
+                    x ^= x << 1;
+                    x ^= x << 2;
+                    x ^= x << 4;
+                    x ^= x << 8;
+                    x ^= x << 16;
+                    x ^= x << 32;
+                    return x;
+                }
+
+                // Characters preceded by an odd number of backslashes. A run of
+                // backslashes escapes the character after it when the run has
+                // odd length; adding the run starts to the runs finds the ends,
+                // and whether a run started on an even or odd bit tells which.
+                inline uint64_t escapedBits( uint64_t backslash, uint64_t& carry )
+                {
+                    constexpr uint64_t EVEN = 0x5555555555555555ull;
+                    backslash &= ~carry;
+                    const uint64_t followsEscape = ( backslash << 1 ) | carry;
+                    const uint64_t oddStarts = backslash & ~EVEN & ~followsEscape;
+                    const uint64_t evenEnds = oddStarts + backslash;
+                    carry = evenEnds < oddStarts ? 1 : 0;
+                    return ( EVEN ^ ( evenEnds << 1 ) ) & followsEscape;
+                }
+
+                // Operators and quotes outside of strings, and the first byte of
+                // every number and literal
+                inline uint64_t structuralBits( const BlockMasks& m, Carries& carries )
+                {
+                    const auto quote = m.quote & ~escapedBits( m.backslash, carries.escape );
+                    const auto inString = prefixXor( quote ) ^ carries.inString;
+                    carries.inString = uint64_t( int64_t( inString ) >> 63 );
+
+                    const auto scalar = ~( m.op | m.space );
+                    const auto nonQuoteScalar = scalar & ~quote;
+                    const auto scalarStart = scalar & ~( ( nonQuoteScalar << 1 ) | carries.scalar );
+                    carries.scalar = nonQuoteScalar >> 63;
+
+                    // Opening quotes come from scalarStart, closing ones from the last term
+                    const auto stringTail = inString ^ quote;
+                    return ( m.op & ~inString ) | ( scalarStart & ~stringTail ) | ( quote & ~inString );
+                }
+
+                inline uint32_t* flatten( uint32_t* out, uint64_t bits, uint32_t base )
+                {
+                    while ( bits )
+                    {
+                        *out++ = base + strings::lowestBit( bits );
+                        bits &= bits - 1;
+                    }
+                    return out;
+                }
+
+                inline bool needsEscape( char c )
+                {
+                    const auto u = static_cast< unsigned char >( c );
+                    return u == '"' || u == '\\' || u < 0x20;
+                }
+
+                // The part of the input that does not fill a whole block
+                inline size_t findEscapeTail( const char* data, size_t from, size_t len )
+                {
+                    for ( ; from < len; from++ )
+                        if ( needsEscape( data[ from ] ) )
+                            return from;
+                    return len;
+                }
+            }
+
+            // Each tier classifies whole 64 byte blocks. index() writes the
+            // structural positions of 'len' bytes (a multiple of 64) at 'base'
+            // onwards, findEscape() returns the first byte a writer must escape.
+            // The loops live in the tiers so the classifier is inlined into them.
+            namespace scalar
+            {
+                inline BlockMasks classify( const char* block )
+                {
+                    BlockMasks m { 0, 0, 0, 0 };
+                    for ( size_t i = 0; i < 64; i++ )
+                    {
+                        const uint64_t bit = uint64_t( 1 ) << i;
+                        switch ( block[ i ] )
+                        {
+                        case '"': m.quote |= bit; break;
+                        case '\\': m.backslash |= bit; break;
+                        case ',': case ':': case '[': case ']': case '{': case '}': m.op |= bit; break;
+                        case ' ': case '\t': case '\n': case '\r': m.space |= bit; break;
+                        default: break;
+                        }
+                    }
+                    return m;
+                }
+
+                inline uint64_t escapeMask( const char* block )
+                {
+                    uint64_t mask = 0;
+                    for ( size_t i = 0; i < 64; i++ )
+                        if ( detail::needsEscape( block[ i ] ) )
+                            mask |= uint64_t( 1 ) << i;
+                    return mask;
+                }
+
+                inline uint32_t* index( const char* data, size_t len, uint32_t base, uint32_t* out, detail::Carries& carries )
+                {
+                    for ( size_t i = 0; i < len; i += 64 )
+                        out = detail::flatten( out, detail::structuralBits( classify( data + i ), carries ), base + static_cast< uint32_t >( i ) );
+                    return out;
+                }
+
+                inline size_t findEscape( const char* data, size_t len )
+                {
+                    return detail::findEscapeTail( data, 0, len );
+                }
+            }
+
+#if T_RUNTIME_X86
+            // The operators are found with four compares instead of six: setting
+            // bit 5 turns '[' and ']' into '{' and '}' and leaves ',' and ':'
+            // alone. Two control characters also land on ',' and ':', which is
+            // harmless because the parser checks the byte at every position.
+            namespace sse42
+            {
+                T_TARGET_SSE42 inline uint64_t movemask( __m128i v ) { return static_cast< uint32_t >( _mm_movemask_epi8( v ) ); }
+
+                T_TARGET_SSE42 inline BlockMasks classify( const char* block )
+                {
+                    BlockMasks m { 0, 0, 0, 0 };
+                    for ( size_t i = 0; i < 64; i += 16 )
+                    {
+                        const auto v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( block + i ) );
+                        const auto lowered = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) );
+                        const auto op = _mm_or_si128(
+                            _mm_or_si128( _mm_cmpeq_epi8( lowered, _mm_set1_epi8( ',' ) ), _mm_cmpeq_epi8( lowered, _mm_set1_epi8( ':' ) ) ),
+                            _mm_or_si128( _mm_cmpeq_epi8( lowered, _mm_set1_epi8( '{' ) ), _mm_cmpeq_epi8( lowered, _mm_set1_epi8( '}' ) ) ) );
+                        const auto space = _mm_or_si128(
+                            _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '\t' ) ) ),
+                            _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\n' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '\r' ) ) ) );
+                        m.quote |= movemask( _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) ) ) << i;
+                        m.backslash |= movemask( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) ) << i;
+                        m.op |= movemask( op ) << i;
+                        m.space |= movemask( space ) << i;
+                    }
+                    return m;
+                }
+
+                T_TARGET_SSE42 inline uint64_t escapeMask( const char* block )
+                {
+                    uint64_t mask = 0;
+                    for ( size_t i = 0; i < 64; i += 16 )
+                    {
+                        const auto v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( block + i ) );
+                        const auto control = _mm_cmpeq_epi8( _mm_min_epu8( v, _mm_set1_epi8( 0x1F ) ), v );
+                        const auto special = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '"' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '\\' ) ) );
+                        mask |= movemask( _mm_or_si128( control, special ) ) << i;
+                    }
+                    return mask;
+                }
+
+                T_TARGET_SSE42 inline uint32_t* index( const char* data, size_t len, uint32_t base, uint32_t* out, detail::Carries& carries )
+                {
+                    for ( size_t i = 0; i < len; i += 64 )
+                        out = detail::flatten( out, detail::structuralBits( classify( data + i ), carries ), base + static_cast< uint32_t >( i ) );
+                    return out;
+                }
+
+                T_TARGET_SSE42 inline size_t findEscape( const char* data, size_t len )
+                {
+                    size_t i = 0;
+                    for ( ; i + 64 <= len; i += 64 )
+                        if ( const auto mask = escapeMask( data + i ) )
+                            return i + strings::lowestBit( mask );
+                    return detail::findEscapeTail( data, i, len );
+                }
+            }
+
+            namespace avx2
+            {
+                T_TARGET_AVX2 inline uint64_t movemask( __m256i v ) { return static_cast< uint32_t >( _mm256_movemask_epi8( v ) ); }
+
+                T_TARGET_AVX2 inline BlockMasks classify( const char* block )
+                {
+                    BlockMasks m { 0, 0, 0, 0 };
+                    for ( size_t i = 0; i < 64; i += 32 )
+                    {
+                        const auto v = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( block + i ) );
+                        const auto lowered = _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) );
+                        const auto op = _mm256_or_si256(
+                            _mm256_or_si256( _mm256_cmpeq_epi8( lowered, _mm256_set1_epi8( ',' ) ), _mm256_cmpeq_epi8( lowered, _mm256_set1_epi8( ':' ) ) ),
+                            _mm256_or_si256( _mm256_cmpeq_epi8( lowered, _mm256_set1_epi8( '{' ) ), _mm256_cmpeq_epi8( lowered, _mm256_set1_epi8( '}' ) ) ) );
+                        const auto space = _mm256_or_si256(
+                            _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ' ' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\t' ) ) ),
+                            _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\n' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\r' ) ) ) );
+                        m.quote |= movemask( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) ) ) << i;
+                        m.backslash |= movemask( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) ) ) << i;
+                        m.op |= movemask( op ) << i;
+                        m.space |= movemask( space ) << i;
+                    }
+                    return m;
+                }
+
+                T_TARGET_AVX2 inline uint64_t escapeMask( const char* block )
+                {
+                    uint64_t mask = 0;
+                    for ( size_t i = 0; i < 64; i += 32 )
+                    {
+                        const auto v = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( block + i ) );
+                        const auto control = _mm256_cmpeq_epi8( _mm256_min_epu8( v, _mm256_set1_epi8( 0x1F ) ), v );
+                        const auto special = _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '"' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\\' ) ) );
+                        mask |= movemask( _mm256_or_si256( control, special ) ) << i;
+                    }
+                    return mask;
+                }
+
+                T_TARGET_AVX2 inline uint32_t* index( const char* data, size_t len, uint32_t base, uint32_t* out, detail::Carries& carries )
+                {
+                    for ( size_t i = 0; i < len; i += 64 )
+                        out = detail::flatten( out, detail::structuralBits( classify( data + i ), carries ), base + static_cast< uint32_t >( i ) );
+                    return out;
+                }
+
+                T_TARGET_AVX2 inline size_t findEscape( const char* data, size_t len )
+                {
+                    size_t i = 0;
+                    for ( ; i + 64 <= len; i += 64 )
+                        if ( const auto mask = escapeMask( data + i ) )
+                            return i + strings::lowestBit( mask );
+                    return detail::findEscapeTail( data, i, len );
+                }
+            }
+#endif
+
+            struct KernelTable
+            {
+                const char* name;
+                uint32_t* ( *index )( const char* data, size_t len, uint32_t base, uint32_t* out, detail::Carries& carries );
+                size_t ( *findEscape )( const char* data, size_t len );
+            };
+
+            // Chosen once from the CPU features
+            inline const KernelTable& kernels()
+            {
+                static const KernelTable table = [] {
+#if T_RUNTIME_X86
+                    if ( cpuFeatures().avx2 )
+                        return KernelTable { "avx2", avx2::index, avx2::findEscape };
+                    if ( cpuFeatures().sse42 )
+                        return KernelTable { "sse4.2", sse42::index, sse42::findEscape };
+#endif
+                    return KernelTable { "scalar", scalar::index, scalar::findEscape };
+                }();
+                return table;
+            }
+
+            // Offset of the first byte that needs escaping, or len
+            inline size_t findEscape( const char* data, size_t len ) { return kernels().findEscape( data, len ); }
+
+            // The position of every operator, every string quote and the first
+            // byte of every number and literal outside of strings, found 64
+            // bytes per step without a branch per byte. Parsing then only visits
+            // those positions.
+            class StructuralIndex
+            {
+            public:
+                StructuralIndex() = default;
+
+                explicit StructuralIndex( std::string_view text ) { build( text ); }
+
+                // Keeps the buffer of the previous build when it is big enough
+                void build( std::string_view text )
+                {
+                    if ( text.size() >= UINT32_MAX - 64 )
+                        throw std::runtime_error( "JSON documents are limited to 4GB" );
+                    // Every byte may be structural, and the end of the text follows
+                    if ( capacity < text.size() + 1 )
+                    {
+                        capacity = text.size() + 1;
+                        positions.reset( new uint32_t[ capacity ] );
+                    }
+                    const auto index = kernels().index;
+                    detail::Carries carries;
+                    const auto whole = text.size() & ~size_t( 63 );
+                    auto out = index( text.data(), whole, 0, positions.get(), carries );
+                    if ( whole < text.size() )
+                    {
+                        // Spaces are neutral to every mask
+                        char tail[ 64 ];
+                        std::memset( tail, ' ', sizeof( tail ) );
+                        std::memcpy( tail, text.data() + whole, text.size() - whole );
+                        out = index( tail, 64, static_cast< uint32_t >( whole ), out, carries );
+                    }
+                    if ( carries.inString )
+                        throw std::runtime_error( "JSON string is not terminated" );
+                    count = static_cast< size_t >( out - positions.get() );
+                    positions[ count ] = static_cast< uint32_t >( text.size() );
+                }
+
+                size_t size() const { return count; }
+                uint32_t operator[]( size_t i ) const { return positions[ i ]; }
+                // Followed by one more position, the end of the text
+                const uint32_t* data() const { return positions.get(); }
+            private:
+                std::unique_ptr< uint32_t[] > positions;
+                size_t capacity = 0;
+                size_t count = 0;
+            };
+
+            enum class Kind : uint8_t
+            {
+                Null,
+                True,
+                False,
+                Number,
+                String,
+                Array,
+                Object,
+            };
+
+            class Document;
+
+            // A value in a parsed document. Nothing is converted until it is
+            // asked for: numbers are read from the text on access, strings
+            // without escapes are slices of the text and the others are
+            // unescaped (and their escapes checked) when they are read.
+            class Value
+            {
+            public:
+                Kind kind() const;
+                bool isNull() const { return kind() == Kind::Null; }
+                bool isBool() const { return kind() == Kind::True || kind() == Kind::False; }
+                bool isNumber() const { return kind() == Kind::Number; }
+                bool isString() const { return kind() == Kind::String; }
+                bool isArray() const { return kind() == Kind::Array; }
+                bool isObject() const { return kind() == Kind::Object; }
+
+                bool asBool() const
+                {
+                    expect( isBool(), "a bool" );
+                    return kind() == Kind::True;
+                }
+
+                int64_t asInt64() const { return integer< int64_t >(); }
+                uint64_t asUInt64() const { return integer< uint64_t >(); }
+
+                double asDouble() const
+                {
+                    expect( isNumber(), "a number" );
+                    const auto text = raw();
+                    double value = 0;
+                    const auto result = std::from_chars( text.data(), text.data() + text.size(), value );
+                    if ( result.ec == std::errc::result_out_of_range )
+                        throw std::runtime_error( "JSON number is out of range: " + std::string( text ) );
+                    return value;
+                }
+
+                String asString() const;
+
+                // The text of a number, or the bytes between the quotes of a string
+                std::string_view raw() const;
+
+                // Elements of an array, members of an object
+                size_t size() const
+                {
+                    expect( isArray() || isObject(), "an array or object" );
+                    return node().end;
+                }
+
+                // Linear in the index, iterate with elements() to visit them all
+                Value operator[]( size_t index ) const
+                {
+                    expect( isArray(), "an array" );
+                    if ( index >= node().end )
+                        throw std::out_of_range( "JSON array index out of range" );
+                    auto at = this->index + 1;
+                    while ( index-- )
+                        at = nodeAt( at ).next;
+                    return { doc, at };
+                }
+
+                std::optional< Value > find( std::string_view key ) const;
+
+                Value operator[]( std::string_view key ) const
+                {
+                    if ( auto value = find( key ) )
+                        return *value;
+                    throw std::runtime_error( "JSON object has no member " + std::string( key ) );
+                }
+
+                class Elements;
+                class Members;
+
+                // `for ( v in value.elements() )`
+                Elements elements() const;
+                // `for ( member in value.members() )`, member.key and member.value
+                Members members() const;
+            private:
+                friend class Document;
+
+                // Twelve bytes per value, the kind follows from the first byte
+                struct Node
+                {
+                    // The first byte of the value, the opening quote of a string
+                    uint32_t begin;
+                    // One past the last byte of a number or literal, the closing
+                    // quote of a string, the elements or members of an array or object
+                    uint32_t end;
+                    // The node after this value and everything inside it
+                    uint32_t next;
+                };
+
+                const Document* doc;
+                uint32_t index;
+
+                Value( const Document* doc, uint32_t index ):
+                    doc( doc ), index( index ) {}
+
+                const Node& node() const { return nodeAt( index ); }
+                const Node& nodeAt( uint32_t at ) const;
+
+                void expect( bool ok, const char* what ) const
+                {
+                    if ( !ok )
+                        throw std::runtime_error( std::string( "JSON value is not " ) + what );
+                }
+
+                template< typename T >
+                T integer() const
+                {
+                    expect( isNumber(), "a number" );
+                    const auto text = raw();
+                    T value = 0;
+                    const auto result = std::from_chars( text.data(), text.data() + text.size(), value );
+                    if ( result.ec == std::errc::result_out_of_range )
+                        throw std::runtime_error( "JSON number is out of range: " + std::string( text ) );
+                    if ( result.ec != std::errc() || result.ptr != text.data() + text.size() )
+                        throw std::runtime_error( "JSON number is not an integer: " + std::string( text ) );
+                    return value;
+                }
+            };
+
+            struct Member
+            {
+                Value key;
+                Value value;
+            };
+
+            // A parsed document. Parsing checks the UTF-8 and the structure;
+            // numbers and escapes are checked when they are read. The text is
+            // shared, not copied, so a document parsed from a mapped file
+            // keeps the mapping alive.
+            class Document
+            {
+            public:
+                explicit Document( String text ):
+                    data( std::make_unique< Data >() )
+                {
+                    data->text = std::move( text );
+                    parse();
+                }
+
+                explicit Document( std::string_view text ):
+                    Document( String( text ) ) {}
+
+                Value root() const { return { this, 0 }; }
+                const String& text() const { return data->text; }
+            private:
+                friend class Value;
+                friend class Parser;
+
+                Document():
+                    data( std::make_unique< Data >() ) {}
+
+                // Kept on the heap so values stay valid when the document moves
+                struct Data
+                {
+                    String text;
+                    // There is never more than one value per structural position
+                    std::unique_ptr< Value::Node[] > tape;
+                    size_t capacity = 0;
+                };
+
+                std::unique_ptr< Data > data;
+
+                static bool isDelimiter( const char* text, size_t len, size_t at )
+                {
+                    if ( at >= len )
+                        return true;
+                    switch ( text[ at ] )
+                    {
+                    case ' ': case '\t': case '\n': case '\r': case ',': case ':': case '[': case ']': case '{': case '}':
+                        return true;
+                    default:
+                        return false;
+                    }
+                }
+
+                static bool isDigit( char c ) { return c >= '0' && c <= '9'; }
+
+                // -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?, returns the end
+                static size_t scanNumber( const char* text, size_t len, size_t at )
+                {
+                    const auto fail = [ & ] { throw std::runtime_error( "invalid JSON number at offset " + std::to_string( at ) ); };
+                    auto i = at;
+                    if ( i < len && text[ i ] == '-' )
+                        i++;
+                    if ( i >= len || !isDigit( text[ i ] ) )
+                        fail();
+                    if ( text[ i++ ] != '0' )
+                        while ( i < len && isDigit( text[ i ] ) )
+                            i++;
+                    if ( i < len && text[ i ] == '.' )
+                    {
+                        if ( ++i >= len || !isDigit( text[ i ] ) )
+                            fail();
+                        while ( i < len && isDigit( text[ i ] ) )
+                            i++;
+                    }
+                    if ( i < len && ( text[ i ] == 'e' || text[ i ] == 'E' ) )
+                    {
+                        if ( ++i < len && ( text[ i ] == '+' || text[ i ] == '-' ) )
+                            i++;
+                        if ( i >= len || !isDigit( text[ i ] ) )
+                            fail();
+                        while ( i < len && isDigit( text[ i ] ) )
+                            i++;
+                    }
+                    if ( !isDelimiter( text, len, i ) )
+                        fail();
+                    return i;
+                }
+
+                static constexpr size_t MAX_DEPTH = 1024;
+
+                // Recursive descent over the structural positions. Every read
+                // past the last position gets the end of the text, where no
+                // expected character is found, so the index is never bounds checked.
+                struct Builder
+                {
+                    const char* text;
+                    size_t len;
+                    const uint32_t* positions;
+                    Value::Node* tape;
+                    uint32_t size = 0;
+
+                    char at( uint32_t pos ) const { return pos < len ? text[ pos ] : '\0'; }
+
+                    [[noreturn]] void fail( uint32_t pos ) const
+                    {
+                        if ( pos >= len )
+                            throw std::runtime_error( "unexpected end of JSON" );
+                        throw std::runtime_error( "unexpected '" + std::string( 1, text[ pos ] ) + "' in JSON at offset " + std::to_string( pos ) );
+                    }
+
+                    uint32_t push( uint32_t begin, uint32_t end )
+                    {
+                        tape[ size ] = { begin, end, size + 1 };
+                        return size++;
+                    }
+
+                    void literal( uint32_t pos, std::string_view word )
+                    {
+                        if ( std::string_view( text + pos, std::min< size_t >( word.size(), len - pos ) ) != word || !isDelimiter( text, len, pos + word.size() ) )
+                            fail( pos );
+                        push( pos, static_cast< uint32_t >( pos + word.size() ) );
+                    }
+
+                    void value( size_t depth )
+                    {
+                        const auto pos = *positions++;
+                        switch ( at( pos ) )
+                        {
+                        case '{': return object( pos, depth + 1 );
+                        case '[': return array( pos, depth + 1 );
+                        // The closing quote is always the next position
+                        case '"': push( pos, *positions++ ); return;
+                        case 't': return literal( pos, "true" );
+                        case 'f': return literal( pos, "false" );
+                        case 'n': return literal( pos, "null" );
+                        case '-': case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9':
+                            push( pos, static_cast< uint32_t >( scanNumber( text, len, pos ) ) );
+                            return;
+                        default:
+                            fail( pos );
+                        }
+                    }
+
+                    void object( uint32_t pos, size_t depth )
+                    {
+                        if ( depth > MAX_DEPTH )
+                            throw std::runtime_error( "JSON is nested too deeply" );
+                        const auto self = push( pos, 0 );
+                        if ( at( *positions ) == '}' )
+                        {
+                            positions++;
+                            tape[ self ].next = size;
+                            return;
+                        }
+                        while ( true )
+                        {
+                            const auto key = *positions++;
+                            if ( at( key ) != '"' )
+                                fail( key );
+                            push( key, *positions++ );
+                            const auto colon = *positions++;
+                            if ( at( colon ) != ':' )
+                                fail( colon );
+                            value( depth );
+                            tape[ self ].end++;
+                            const auto next = *positions++;
+                            const char c = at( next );
+                            if ( c == '}' )
+                                break;
+                            if ( c != ',' )
+                                fail( next );
+                        }
+                        tape[ self ].next = size;
+                    }
+
+                    void array( uint32_t pos, size_t depth )
+                    {
+                        if ( depth > MAX_DEPTH )
+                            throw std::runtime_error( "JSON is nested too deeply" );
+                        const auto self = push( pos, 0 );
+                        if ( at( *positions ) == ']' )
+                        {
+                            positions++;
+                            tape[ self ].next = size;
+                            return;
+                        }
+                        while ( true )
+                        {
+                            value( depth );
+                            tape[ self ].end++;
+                            const auto next = *positions++;
+                            const char c = at( next );
+                            if ( c == ']' )
+                                break;
+                            if ( c != ',' )
+                                fail( next );
+                        }
+                        tape[ self ].next = size;
+                    }
+                };
+
+                void parse()
+                {
+                    // The index is only needed while parsing. Reusing one per thread
+                    // matters for large documents, where faulting in a fresh buffer
+                    // costs more than the scan that fills it.
+                    thread_local StructuralIndex positions;
+                    positions.build( data->text.view() );
+                    if ( data->capacity < positions.size() + 1 )
+                    {
+                        data->capacity = positions.size() + 1;
+                        data->tape.reset( new Value::Node[ data->capacity ] );
+                    }
+                    Builder builder { data->text.data(), data->text.size(), positions.data(), data->tape.get() };
+                    builder.value( 0 );
+                    if ( builder.positions != positions.data() + positions.size() )
+                        builder.fail( *builder.positions );
+                }
+            };
+
+            // Parses documents one after another into the same memory, which
+            // saves faulting in a fresh tape for every large document. The
+            // document returned is valid until the next call to parse().
+            class Parser
+            {
+            public:
+                const Document& parse( String text )
+                {
+                    doc.data->text = std::move( text );
+                    doc.parse();
+                    return doc;
+                }
+            private:
+                Document doc;
+            };
+
+            inline const Value::Node& Value::nodeAt( uint32_t at ) const { return doc->data->tape[ at ]; }
+
+            inline Kind Value::kind() const
+            {
+                switch ( doc->data->text.data()[ node().begin ] )
+                {
+                case 'n': return Kind::Null;
+                case 't': return Kind::True;
+                case 'f': return Kind::False;
+                case '"': return Kind::String;
+                case '[': return Kind::Array;
+                case '{': return Kind::Object;
+                default: return Kind::Number;
+                }
+            }
+
+            inline std::string_view Value::raw() const
+            {
+                const auto& n = node();
+                const auto k = kind();
+                expect( k == Kind::Number || k == Kind::String, "a number or string" );
+                const auto begin = k == Kind::String ? n.begin + 1 : n.begin;
+                return doc->data->text.view().substr( begin, n.end - begin );
+            }
+
+            namespace detail
+            {
+                inline uint32_t hexDigits( std::string_view s, size_t at )
+                {
+                    if ( at + 4 > s.size() )
+                        throw std::runtime_error( "truncated \\u escape in JSON string" );
+                    uint32_t value = 0;
+                    for ( size_t i = at; i < at + 4; i++ )
+                    {
+                        const char c = s[ i ];
+                        value <<= 4;
+                        if ( c >= '0' && c <= '9' ) value |= c - '0';
+                        else if ( c >= 'a' && c <= 'f' ) value |= c - 'a' + 10;
+                        else if ( c >= 'A' && c <= 'F' ) value |= c - 'A' + 10;
+                        else throw std::runtime_error( "invalid \\u escape in JSON string" );
+                    }
+                    return value;
+                }
+
+                inline void appendUtf8( std::string& out, uint32_t cp )
+                {
+                    if ( cp < 0x80 )
+                    {
+                        out.push_back( static_cast< char >( cp ) );
+                    }
+                    else if ( cp < 0x800 )
+                    {
+                        out.push_back( static_cast< char >( 0xC0 | ( cp >> 6 ) ) );
+                        out.push_back( static_cast< char >( 0x80 | ( cp & 0x3F ) ) );
+                    }
+                    else if ( cp < 0x10000 )
+                    {
+                        out.push_back( static_cast< char >( 0xE0 | ( cp >> 12 ) ) );
+                        out.push_back( static_cast< char >( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) );
+                        out.push_back( static_cast< char >( 0x80 | ( cp & 0x3F ) ) );
+                    }
+                    else
+                    {
+                        out.push_back( static_cast< char >( 0xF0 | ( cp >> 18 ) ) );
+                        out.push_back( static_cast< char >( 0x80 | ( ( cp >> 12 ) & 0x3F ) ) );
+                        out.push_back( static_cast< char >( 0x80 | ( ( cp >> 6 ) & 0x3F ) ) );
+                        out.push_back( static_cast< char >( 0x80 | ( cp & 0x3F ) ) );
+                    }
+                }
+
+                // The code point of the u escape whose four digits start at i, with
+                // the low half of a surrogate pair; i is moved past both
+                inline uint32_t codePoint( std::string_view raw, size_t& i )
+                {
+                    auto cp = hexDigits( raw, i );
+                    i += 4;
+                    if ( cp >= 0xD800 && cp < 0xDC00 )
+                    {
+                        if ( i + 2 > raw.size() || raw[ i ] != '\\' || raw[ i + 1 ] != 'u' )
+                            throw std::runtime_error( "unpaired surrogate in JSON string" );
+                        const auto low = hexDigits( raw, i + 2 );
+                        if ( low < 0xDC00 || low >= 0xE000 )
+                            throw std::runtime_error( "unpaired surrogate in JSON string" );
+                        cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                        i += 6;
+                    }
+                    else if ( cp >= 0xDC00 && cp < 0xE000 )
+                    {
+                        throw std::runtime_error( "unpaired surrogate in JSON string" );
+                    }
+                    return cp;
+                }
+
+                // 'raw' starts at an escape or control character found by findEscape
+                inline std::string unescape( std::string_view raw, size_t first )
+                {
+                    std::string out { raw.substr( 0, first ) };
+                    out.reserve( raw.size() );
+                    size_t i = first;
+                    while ( i < raw.size() )
+                    {
+                        const auto next = i + findEscape( raw.data() + i, raw.size() - i );
+                        out.append( raw.data() + i, next - i );
+                        if ( next == raw.size() )
+                            break;
+                        if ( raw[ next ] != '\\' || next + 1 == raw.size() )
+                            throw std::runtime_error( "control character in JSON string" );
+                        i = next + 2;
+                        switch ( raw[ next + 1 ] )
+                        {
+                        case '"': out.push_back( '"' ); break;
+                        case '\\': out.push_back( '\\' ); break;
+                        case '/': out.push_back( '/' ); break;
+                        case 'b': out.push_back( '\b' ); break;
+                        case 'f': out.push_back( '\f' ); break;
+                        case 'n': out.push_back( '\n' ); break;
+                        case 'r': out.push_back( '\r' ); break;
+                        case 't': out.push_back( '\t' ); break;
+                        case 'u': appendUtf8( out, codePoint( raw, i ) ); break;
+                        default:
+                            throw std::runtime_error( "invalid escape in JSON string" );
+                        }
+                    }
+                    return out;
+                }
+
+                // Checks the escapes in 'raw' the way unescape() would, without
+                // building the text
+                inline void checkEscapes( std::string_view raw )
+                {
+                    size_t i = 0;
+                    while ( i < raw.size() )
+                    {
+                        const auto next = i + findEscape( raw.data() + i, raw.size() - i );
+                        if ( next == raw.size() )
+                            break;
+                        if ( raw[ next ] != '\\' || next + 1 == raw.size() )
+                            throw std::runtime_error( "control character in JSON string" );
+                        i = next + 2;
+                        switch ( raw[ next + 1 ] )
+                        {
+                        case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't': break;
+                        case 'u': codePoint( raw, i ); break;
+                        default:
+                            throw std::runtime_error( "invalid escape in JSON string" );
+                        }
+                    }
+                }
+            }
+
+            inline String Value::asString() const
+            {
+                expect( isString(), "a string" );
+                const auto text = raw();
+                const auto first = findEscape( text.data(), text.size() );
+                if ( first == text.size() )
+                    return doc->data->text.slice( node().begin + 1, node().end );
+                return String::fromValidated( detail::unescape( text, first ) );
+            }
+
+            inline std::optional< Value > Value::find( std::string_view key ) const
+            {
+                expect( isObject(), "an object" );
+                auto at = index + 1;
+                for ( uint32_t i = 0; i < node().end; i++ )
+                {
+                    const Value name { doc, at };
+                    const auto text = name.raw();
+                    // Unescaping only ever shortens a key
+                    if ( text == key || ( text.size() > key.size() && text.find( '\\' ) != std::string_view::npos && name.asString().view() == key ) )
+                        return Value { doc, at + 1 };
+                    at = nodeAt( at + 1 ).next;
+                }
+                return std::nullopt;
+            }
+
+            class Value::Elements
+            {
+            public:
+                class iterator
+                {
+                public:
+                    iterator( const Document* doc, uint32_t at, const Node* tape ):
+                        doc( doc ), at( at ), tape( tape ) {}
+                    Value operator*() const { return { doc, at }; }
+                    iterator& operator++()
+                    {
+                        at = tape[ at ].next;
+                        return *this;
+                    }
+                    bool operator==( const iterator& other ) const { return at == other.at; }
+                    bool operator!=( const iterator& other ) const { return at != other.at; }
+                private:
+                    const Document* doc;
+                    uint32_t at;
+                    const Node* tape;
+                };
+
+                Elements( const Value& array, const Node* tape ):
+                    array( array ), tape( tape ) {}
+
+                iterator begin() const { return { array.doc, array.index + 1, tape }; }
+                iterator end() const { return { array.doc, array.node().next, tape }; }
+            private:
+                Value array;
+                const Node* tape;
+            };
+
+            class Value::Members
+            {
+            public:
+                class iterator
+                {
+                public:
+                    iterator( const Document* doc, uint32_t at, const Node* tape ):
+                        doc( doc ), at( at ), tape( tape ) {}
+                    Member operator*() const { return { { doc, at }, { doc, at + 1 } }; }
+                    iterator& operator++()
+                    {
+                        at = tape[ at + 1 ].next;
+                        return *this;
+                    }
+                    bool operator==( const iterator& other ) const { return at == other.at; }
+                    bool operator!=( const iterator& other ) const { return at != other.at; }
+                private:
+                    const Document* doc;
+                    uint32_t at;
+                    const Node* tape;
+                };
+
+                Members( const Value& object, const Node* tape ):
+                    object( object ), tape( tape ) {}
+
+                iterator begin() const { return { object.doc, object.index + 1, tape }; }
+                iterator end() const { return { object.doc, object.node().next, tape }; }
+            private:
+                Value object;
+                const Node* tape;
+            };
+
+            inline Value::Elements Value::elements() const
+            {
+                expect( isArray(), "an array" );
+                return { *this, &nodeAt( 0 ) };
+            }
+
+            inline Value::Members Value::members() const
+            {
+                expect( isObject(), "an object" );
+                return { *this, &nodeAt( 0 ) };
+            }
+
+            // Fills a record of a class from a JSON object by field name, the
+            // way the compiler maps JSON onto T class instances. Nested objects
+            // fill the flattened fields of nested class values ("outer.inner").
+            // Unknown keys are ignored and missing fields keep their zero value.
+            class RecordBinder
+            {
+            public:
+                explicit RecordBinder( const serial::Schema& schema ):
+                    schema( schema ), writer( schema )
+                {
+                    for ( size_t i = 0; i < schema.fields.size(); i++ )
+                    {
+                        const auto& name = schema.fields[ i ].name;
+                        fields.emplace( name, i );
+                        for ( auto dot = name.find( '.' ); dot != std::string::npos; dot = name.find( '.', dot + 1 ) )
+                            prefixes.insert( name.substr( 0, dot + 1 ) );
+                    }
+                }
+
+                // The record, valid until the next call
+                std::string_view bind( const Value& object )
+                {
+                    writer.reset();
+                    bindObject( object, "" );
+                    return writer.finish();
+                }
+            private:
+                const serial::Schema& schema;
+                serial::RecordWriter writer;
+                std::unordered_map< std::string, size_t > fields;
+                // "outer." for every nested class value
+                std::unordered_set< std::string > prefixes;
+                std::string name;
+
+                void bindObject( const Value& object, const std::string& prefix )
+                {
+                    for ( const auto member : object.members() )
+                    {
+                        name = prefix;
+                        name += member.key.raw();
+                        if ( member.value.isObject() )
+                        {
+                            name += '.';
+                            if ( prefixes.count( name ) )
+                                bindObject( member.value, std::string( name ) );
+                            continue;
+                        }
+                        const auto it = fields.find( name );
+                        if ( it != fields.cend() )
+                            bindField( it->second, member.value );
+                    }
+                }
+
+                template< typename T >
+                void setInteger( size_t field, const Value& value )
+                {
+                    bool fits;
+                    T narrow;
+                    if constexpr ( std::is_signed_v< T > )
+                    {
+                        const auto wide = value.asInt64();
+                        fits = wide >= std::numeric_limits< T >::min() && wide <= std::numeric_limits< T >::max();
+                        narrow = static_cast< T >( wide );
+                    }
+                    else
+                    {
+                        const auto wide = value.asUInt64();
+                        fits = wide <= std::numeric_limits< T >::max();
+                        narrow = static_cast< T >( wide );
+                    }
+                    if ( !fits )
+                        throw std::runtime_error( "JSON number does not fit field " + schema.fields[ field ].name );
+                    writer.set( field, narrow );
+                }
+
+                void bindField( size_t field, const Value& value )
+                {
+                    using serial::FieldKind;
+                    switch ( schema.fields[ field ].kind )
+                    {
+                    case FieldKind::Bool: writer.set( field, value.asBool() ); break;
+                    case FieldKind::Char:
+                    {
+                        const auto text = value.asString();
+                        if ( text.size() != 1 )
+                            throw std::runtime_error( "field " + schema.fields[ field ].name + " needs a single character" );
+                        writer.set( field, text.data()[ 0 ] );
+                        break;
+                    }
+                    case FieldKind::Int8: setInteger< int8_t >( field, value ); break;
+                    case FieldKind::Int16: setInteger< int16_t >( field, value ); break;
+                    case FieldKind::Int32: setInteger< int32_t >( field, value ); break;
+                    case FieldKind::Int64: setInteger< int64_t >( field, value ); break;
+                    case FieldKind::UInt8: setInteger< uint8_t >( field, value ); break;
+                    case FieldKind::UInt16: setInteger< uint16_t >( field, value ); break;
+                    case FieldKind::UInt32: setInteger< uint32_t >( field, value ); break;
+                    case FieldKind::UInt64: setInteger< uint64_t >( field, value ); break;
+                    case FieldKind::Float: writer.set( field, static_cast< float >( value.asDouble() ) ); break;
+                    case FieldKind::Double: writer.set( field, value.asDouble() ); break;
+                    case FieldKind::String: writer.setString( field, value.asString() ); break;
+                    }
+                }
+            };
+
+            // Writes compact JSON. Commas and colons are inserted as values are
+            // added, and strings are copied in runs between the bytes that
+            // need escaping, which are found 64 at a time.
+            class Writer
+            {
+            public:
+                Writer& beginObject() { return open( '{', true ); }
+                Writer& endObject() { return close( '}', true ); }
+                Writer& beginArray() { return open( '[', false ); }
+                Writer& endArray() { return close( ']', false ); }
+
+                Writer& key( std::string_view name )
+                {
+                    beforeKey();
+                    quoted( name );
+                    out.push_back( ':' );
+                    return *this;
+                }
+
+                Writer& null() { return literal( "null" ); }
+                Writer& value( bool b ) { return literal( b ? "true" : "false" ); }
+                Writer& value( std::nullptr_t ) { return null(); }
+
+                Writer& value( double d )
+                {
+                    if ( !std::isfinite( d ) )
+                        throw std::runtime_error( "JSON cannot represent " + std::to_string( d ) );
+                    return number( d );
+                }
+
+                template< typename T, typename = std::enable_if_t< std::is_integral_v< T > && !std::is_same_v< T, bool > > >
+                Writer& value( T i ) { return number( i ); }
+
+                Writer& value( std::string_view s )
+                {
+                    beforeValue();
+                    quoted( s );
+                    return *this;
+                }
+
+                Writer& value( const char* s ) { return value( std::string_view( s ) ); }
+                Writer& value( const String& s ) { return value( s.view() ); }
+
+                // Copies a parsed value, its text is reused without reparsing
+                Writer& value( const Value& v )
+                {
+                    switch ( v.kind() )
+                    {
+                    case Kind::Null: return null();
+                    case Kind::True: return value( true );
+                    case Kind::False: return value( false );
+                    case Kind::Number:
+                    {
+                        beforeValue();
+                        const auto text = v.raw();
+                        out.append( text.data(), text.size() );
+                        return *this;
+                    }
+                    case Kind::String:
+                    {
+                        // Already escaped, but the parser leaves escapes to be
+                        // checked when they are read
+                        const auto text = v.raw();
+                        detail::checkEscapes( text );
+                        beforeValue();
+                        out.push_back( '"' );
+                        out.append( text.data(), text.size() );
+                        out.push_back( '"' );
+                        return *this;
+                    }
+                    case Kind::Array:
+                        beginArray();
+                        for ( const auto element : v.elements() )
+                            value( element );
+                        return endArray();
+                    case Kind::Object:
+                        beginObject();
+                        for ( const auto member : v.members() )
+                        {
+                            // Already escaped as well
+                            const auto name = member.key.raw();
+                            detail::checkEscapes( name );
+                            beforeKey();
+                            out.push_back( '"' );
+                            out.append( name.data(), name.size() );
+                            out.append( "\":", 2 );
+                            value( member.value );
+                        }
+                        return endObject();
+                    }
+                    return *this;
+                }
+
+                // The document, the writer is empty afterwards
+                String finish()
+                {
+                    if ( !scopes.empty() )
+                        throw std::runtime_error( "JSON array or object is not closed" );
+                    hasRoot = false;
+                    return String::fromValidated( std::move( out ) );
+                }
+
+                void reserve( size_t bytes ) { out.reserve( bytes ); }
+                size_t size() const { return out.size(); }
+            private:
+                struct Scope
+                {
+                    bool object;
+                    bool empty;
+                    // A key was written and its value has not been yet
+                    bool keyed;
+                };
+
+                std::string out;
+                std::vector< Scope > scopes;
+                bool hasRoot = false;
+
+                void separate()
+                {
+                    if ( !scopes.back().empty )
+                        out.push_back( ',' );
+                    scopes.back().empty = false;
+                }
+
+                void beforeKey()
+                {
+                    if ( scopes.empty() || !scopes.back().object || scopes.back().keyed )
+                        throw std::runtime_error( "JSON key outside of an object" );
+                    separate();
+                    scopes.back().keyed = true;
+                }
+
+                void beforeValue()
+                {
+                    if ( scopes.empty() )
+                    {
+                        if ( hasRoot )
+                            throw std::runtime_error( "JSON document already has a value" );
+                        hasRoot = true;
+                        return;
+                    }
+                    auto& scope = scopes.back();
+                    if ( scope.object )
+                    {
+                        if ( !scope.keyed )
+                            throw std::runtime_error( "JSON value in an object needs a key" );
+                        scope.keyed = false;
+                    }
+                    else
+                    {
+                        separate();
+                    }
+                }
+
+                Writer& open( char c, bool object )
+                {
+                    beforeValue();
+                    out.push_back( c );
+                    scopes.push_back( { object, true, false } );
+                    return *this;
+                }
+
+                Writer& close( char c, bool object )
+                {
+                    if ( scopes.empty() || scopes.back().object != object || scopes.back().keyed )
+                        throw std::runtime_error( std::string( "unbalanced '" ) + c + "' in JSON writer" );
+                    scopes.pop_back();
+                    out.push_back( c );
+                    return *this;
+                }
+
+                Writer& literal( std::string_view text )
+                {
+                    beforeValue();
+                    out.append( text.data(), text.size() );
+                    return *this;
+                }
+
+                template< typename T >
+                Writer& number( T n )
+                {
+                    beforeValue();
+                    char digits[ 32 ];
+                    const auto result = std::to_chars( digits, digits + sizeof( digits ), n );
+                    out.append( digits, static_cast< size_t >( result.ptr - digits ) );
+                    return *this;
+                }
+
+                void quoted( std::string_view s )
+                {
+                    out.push_back( '"' );
+                    size_t i = 0;
+                    while ( i < s.size() )
+                    {
+                        const auto next = i + findEscape( s.data() + i, s.size() - i );
+                        out.append( s.data() + i, next - i );
+                        if ( next == s.size() )
+                            break;
+                        const auto c = static_cast< unsigned char >( s[ next ] );
+                        switch ( c )
+                        {
+                        case '"': out.append( "\\\"", 2 ); break;
+                        case '\\': out.append( "\\\\", 2 ); break;
+                        case '\n': out.append( "\\n", 2 ); break;
+                        case '\r': out.append( "\\r", 2 ); break;
+                        case '\t': out.append( "\\t", 2 ); break;
+                        case '\b': out.append( "\\b", 2 ); break;
+                        case '\f': out.append( "\\f", 2 ); break;
+                        default:
+                        {
+                            static const char hex[] = "0123456789abcdef";
+                            const char escape[] = { '\\', 'u', '0', '0', hex[ c >> 4 ], hex[ c & 0xF ] };
+                            out.append( escape, sizeof( escape ) );
+                            break;
+                        }
+                        }
+                        i = next + 1;
+                    }
+                    out.push_back( '"' );
+                }
+            };
+        }
+    }
+}
@@ -0,0 +1,402 @@
+#pragma once
+
+#include <functional>
+
+#include "Hash.h"
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define T_RUNTIME_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+namespace t
+{
+    namespace runtime
+    {
+        namespace swiss
+        {
+            using ctrl_t = int8_t;
+
+            // Full slots hold the low 7 bits of their hash, so they are never negative
+            constexpr ctrl_t EMPTY = -128;
+            constexpr ctrl_t DELETED = -2;
+            constexpr size_t GROUP_WIDTH = 16;
+
+            inline uint32_t lowestBit( uint32_t mask )
+            {
+#if defined( _MSC_VER )
+                unsigned long idx;
+                _BitScanForward( &idx, mask );
+                return idx;
+#else
+                return __builtin_ctz( mask );
+#endif
+            }
+
+            // Sixteen control bytes compared at once, each match is one bit of the result
+            class Group
+            {
+            public:
+                explicit Group( const ctrl_t* ctrl )
+#if T_RUNTIME_SSE2
+                    : bytes( _mm_loadu_si128( reinterpret_cast< const __m128i* >( ctrl ) ) ) {}
+#else
+                    : ctrl( ctrl ) {}
+#endif
+
+                uint32_t match( ctrl_t h2 ) const
+                {
+#if T_RUNTIME_SSE2
+                    return _mm_movemask_epi8( _mm_cmpeq_epi8( bytes, _mm_set1_epi8( h2 ) ) );
+#else
+                    return scalar( [ h2 ]( ctrl_t c ){ return c == h2; } );
+#endif
+                }
+
+                uint32_t matchEmpty() const
+                {
+#if T_RUNTIME_SSE2
+                    return _mm_movemask_epi8( _mm_cmpeq_epi8( bytes, _mm_set1_epi8( EMPTY ) ) );
+#else
+                    return scalar( []( ctrl_t c ){ return c == EMPTY; } );
+#endif
+                }
+
+                uint32_t matchEmptyOrDeleted() const
+                {
+#if T_RUNTIME_SSE2
+                    return _mm_movemask_epi8( _mm_cmpgt_epi8( _mm_set1_epi8( -1 ), bytes ) );
+#else
+                    return scalar( []( ctrl_t c ){ return c < -1; } );
+#endif
+                }
+            private:
+#if T_RUNTIME_SSE2
+                __m128i bytes;
+#else
+                const ctrl_t* ctrl;
+
+                template< typename Pred >
+                uint32_t scalar( Pred pred ) const
+                {
+                    uint32_t mask = 0;
+                    for ( size_t i = 0; i < GROUP_WIDTH; i++ )
+                        mask |= static_cast< uint32_t >( pred( ctrl[ i ] ) ) << i;
+                    return mask;
+                }
+#endif
+            };
+
+            inline size_t groupCountFor( size_t elements, size_t maxLoadNum, size_t maxLoadDen )
+            {
+                size_t groups = 1;
+                while ( groups * GROUP_WIDTH * maxLoadNum / maxLoadDen < elements )
+                    groups *= 2;
+                return groups;
+            }
+        }
+
+        // Open-addressing hash map in the style of a Swiss table. Control
+        // bytes are probed sixteen at a time, so a lookup usually touches
+        // one group of control bytes and one slot.
+        template< typename K, typename V, typename H = Hash< K >, typename Eq = std::equal_to< K > >
+        class Map
+        {
+        public:
+            using value_type = std::pair< K, V >;
+
+            Map() = default;
+
+            Map( std::initializer_list< value_type > init )
+            {
+                reserve( init.size() );
+                for ( const auto& kv : init )
+                    insert( kv.first, kv.second );
+            }
+
+            Map( const Map& rhs )
+            {
+                reserve( rhs.size() );
+                rhs.forEach( [ this ]( const K& k, const V& v ){ insert( k, v ); } );
+            }
+
+            Map( Map&& rhs ) noexcept { swap( rhs ); }
+
+            Map& operator=( Map rhs ) noexcept { swap( rhs ); return *this; }
+
+            ~Map() { destroy(); }
+
+            void swap( Map& rhs ) noexcept
+            {
+                std::swap( ctrl, rhs.ctrl );
+                std::swap( slots, rhs.slots );
+                std::swap( capacity, rhs.capacity );
+                std::swap( count, rhs.count );
+                std::swap( growthLeft, rhs.growthLeft );
+            }
+
+            V* find( const K& key ) { return const_cast< V* >( static_cast< const Map* >( this )->find( key ) ); }
+
+            const V* find( const K& key ) const
+            {
+                const auto idx = findIndex( key );
+                return idx == NOT_FOUND ? nullptr : &slots[ idx ].second;
+            }
+
+            bool contains( const K& key ) const { return findIndex( key ) != NOT_FOUND; }
+
+            // Returns the stored value and whether it was newly inserted
+            template< typename KK, typename VV >
+            std::pair< V*, bool > insert( KK&& key, VV&& value )
+            {
+                const auto hash = H()( key );
+                if ( const auto idx = findIndex( key, hash ); idx != NOT_FOUND )
+                    return { &slots[ idx ].second, false };
+                if ( growthLeft == 0 )
+                {
+                    // Tables that are mostly tombstones are cleaned in place instead of grown
+                    const bool grow = capacity == 0 || ( count + 1 ) * 16 > capacity * 7;
+                    rehash( capacity == 0 ? swiss::GROUP_WIDTH : grow ? capacity * 2 : capacity );
+                }
+                const auto idx = findFreeIndex( hash );
+                if ( ctrl[ idx ] == swiss::EMPTY )
+                    growthLeft--;
+                ctrl[ idx ] = static_cast< swiss::ctrl_t >( hash & 0x7F );
+                new ( &slots[ idx ] ) value_type( std::forward< KK >( key ), std::forward< VV >( value ) );
+                count++;
+                return { &slots[ idx ].second, true };
+            }
+
+            V& operator[]( const K& key )
+            {
+                if ( auto v = find( key ) )
+                    return *v;
+                return *insert( key, V() ).first;
+            }
+
+            bool erase( const K& key )
+            {
+                const auto idx = findIndex( key );
+                if ( idx == NOT_FOUND )
+                    return false;
+                slots[ idx ].~value_type();
+                count--;
+                // No probe ever continued past a group that still has an empty slot
+                const swiss::Group group( ctrl + ( idx & ~( swiss::GROUP_WIDTH - 1 ) ) );
+                if ( group.matchEmpty() )
+                {
+                    ctrl[ idx ] = swiss::EMPTY;
+                    growthLeft++;
+                }
+                else
+                {
+                    ctrl[ idx ] = swiss::DELETED;
+                }
+                return true;
+            }
+
+            void reserve( size_t elements )
+            {
+                const auto groups = swiss::groupCountFor( elements, 7, 8 );
+                if ( groups * swiss::GROUP_WIDTH > capacity )
+                    rehash( groups * swiss::GROUP_WIDTH );
+            }
+
+            void clear()
+            {
+                destroy();
+                ctrl = nullptr;
+                slots = nullptr;
+                capacity = count = growthLeft = 0;
+            }
+
+            template< typename F >
+            void forEach( F&& f ) const
+            {
+                for ( size_t idx = 0; idx < capacity; idx++ )
+                    if ( ctrl[ idx ] >= 0 )
+                        f( slots[ idx ].first, slots[ idx ].second );
+            }
+
+            size_t size() const { return count; }
+            bool empty() const { return count == 0; }
+            size_t getCapacity() const { return capacity; }
+        private:
+            static constexpr size_t NOT_FOUND = static_cast< size_t >( -1 );
+
+            swiss::ctrl_t* ctrl = nullptr;
+            value_type* slots = nullptr;
+            size_t capacity = 0;
+            size_t count = 0;
+            size_t growthLeft = 0;
+
+            size_t findIndex( const K& key ) const { return findIndex( key, H()( key ) ); }
+
+            size_t findIndex( const K& key, uint64_t hash ) const
+            {
+                if ( capacity == 0 )
+                    return NOT_FOUND;
+                const auto h2 = static_cast< swiss::ctrl_t >( hash & 0x7F );
+                const size_t groupMask = capacity / swiss::GROUP_WIDTH - 1;
+                size_t group = ( hash >> 7 ) & groupMask;
+                for ( size_t probe = 1; ; probe++ )
+                {
+                    const auto base = group * swiss::GROUP_WIDTH;
+                    const swiss::Group g( ctrl + base );
+                    for ( auto mask = g.match( h2 ); mask; mask &= mask - 1 )
+                    {
+                        const auto idx = base + swiss::lowestBit( mask );
+                        if ( Eq()( slots[ idx ].first, key ) )
+                            return idx;
+                    }
+                    if ( g.matchEmpty() || probe > groupMask )
+                        return NOT_FOUND;
+                    // Triangular steps visit every group of a power-of-two table
+                    group = ( group + probe ) & groupMask;
+                }
+            }
+
+            size_t findFreeIndex( uint64_t hash ) const
+            {
+                const size_t groupMask = capacity / swiss::GROUP_WIDTH - 1;
+                size_t group = ( hash >> 7 ) & groupMask;
+                for ( size_t probe = 1; ; probe++ )
+                {
+                    const auto base = group * swiss::GROUP_WIDTH;
+                    if ( const auto mask = swiss::Group( ctrl + base ).matchEmptyOrDeleted() )
+                        return base + swiss::lowestBit( mask );
+                    group = ( group + probe ) & groupMask;
+                }
+            }
+
+            void rehash( size_t newCapacity )
+            {
+                auto oldCtrl = ctrl;
+                auto oldSlots = slots;
+                const auto oldCapacity = capacity;
+
+                ctrl = new swiss::ctrl_t[ newCapacity ];
+                std::memset( ctrl, static_cast< uint8_t >( swiss::EMPTY ), newCapacity );
+                slots = std::allocator< value_type >().allocate( newCapacity );
+                capacity = newCapacity;
+                growthLeft = newCapacity * 7 / 8 - count;
+
+                for ( size_t idx = 0; idx < oldCapacity; idx++ )
+                {
+                    if ( oldCtrl[ idx ] < 0 )
+                        continue;
+                    const auto hash = H()( oldSlots[ idx ].first );
+                    const auto target = findFreeIndex( hash );
+                    ctrl[ target ] = static_cast< swiss::ctrl_t >( hash & 0x7F );
+                    new ( &slots[ target ] ) value_type( std::move( oldSlots[ idx ] ) );
+                    oldSlots[ idx ].~value_type();
+                }
+
+                delete[] oldCtrl;
+                if ( oldSlots )
+                    std::allocator< value_type >().deallocate( oldSlots, oldCapacity );
+            }
+
+            void destroy()
+            {
+                for ( size_t idx = 0; idx < capacity; idx++ )
+                    if ( ctrl[ idx ] >= 0 )
+                        slots[ idx ].~value_type();
+                delete[] ctrl;
+                if ( slots )
+                    std::allocator< value_type >().deallocate( slots, capacity );
+            }
+        };
+
+        // Read-only map for non-mutable Map values that are built once.
+        // It is sized to at most half full so most lookups end in the first
+        // group, and keys are stored apart from values so probing only
+        // touches key memory.
+        template< typename K, typename V, typename H = Hash< K >, typename Eq = std::equal_to< K > >
+        class FrozenMap
+        {
+        public:
+            FrozenMap() = default;
+
+            explicit FrozenMap( const Map< K, V, H, Eq >& map )
+            {
+                build( map.size() );
+                map.forEach( [ this ]( const K& k, const V& v ){ place( k, v ); } );
+            }
+
+            // Later duplicates are ignored, the first occurrence of a key wins
+            explicit FrozenMap( const std::vector< std::pair< K, V > >& entries )
+            {
+                build( entries.size() );
+                for ( const auto& [ k, v ] : entries )
+                    if ( !find( k ) )
+                        place( k, v );
+            }
+
+            const V* find( const K& key ) const
+            {
+                if ( ctrl.empty() )
+                    return nullptr;
+                const auto hash = H()( key );
+                const auto h2 = static_cast< swiss::ctrl_t >( hash & 0x7F );
+                const size_t groupMask = ctrl.size() / swiss::GROUP_WIDTH - 1;
+                size_t group = ( hash >> 7 ) & groupMask;
+                for ( size_t probe = 1; ; probe++ )
+                {
+                    const auto base = group * swiss::GROUP_WIDTH;
+                    const swiss::Group g( ctrl.data() + base );
+                    for ( auto mask = g.match( h2 ); mask; mask &= mask - 1 )
+                    {
+                        const auto idx = base + swiss::lowestBit( mask );
+                        if ( Eq()( keys[ idx ], key ) )
+                            return &values[ idx ];
+                    }
+                    if ( g.matchEmpty() )
+                        return nullptr;
+                    group = ( group + probe ) & groupMask;
+                }
+            }
+
+            bool contains( const K& key ) const { return find( key ) != nullptr; }
+            size_t size() const { return count; }
+        private:
+            std::vector< swiss::ctrl_t > ctrl;
+            std::vector< K > keys;
+            std::vector< V > values;
+            size_t count = 0;
+
+            void build( size_t elements )
+            {
+                const auto cap = swiss::groupCountFor( elements, 1, 2 ) * swiss::GROUP_WIDTH;
+                ctrl.assign( cap, swiss::EMPTY );
+                keys.resize( cap );
+                values.resize( cap );
+            }
+
+            void place( const K& key, const V& value )
+            {
+                const auto hash = H()( key );
+                const size_t groupMask = ctrl.size() / swiss::GROUP_WIDTH - 1;
+                size_t group = ( hash >> 7 ) & groupMask;
+                for ( size_t probe = 1; ; probe++ )
+                {
+                    const auto base = group * swiss::GROUP_WIDTH;
+                    if ( const auto mask = swiss::Group( ctrl.data() + base ).matchEmpty() )
+                    {
+                        const auto idx = base + swiss::lowestBit( mask );
+                        ctrl[ idx ] = static_cast< swiss::ctrl_t >( hash & 0x7F );
+                        keys[ idx ] = key;
+                        values[ idx ] = value;
+                        count++;
+                        return;
+                    }
+                    group = ( group + probe ) & groupMask;
+                }
+            }
+        };
+    }
+}
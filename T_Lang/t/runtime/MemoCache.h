@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstring>
+#include <list>
+#include <unordered_map>
+
+#include "../common.h"
+
+namespace t
+{
+    namespace runtime
+    {
+        // Arguments of a memoized call. Only primitives are memoizable so
+        // each argument is kept as its raw bits.
+        class MemoKey
+        {
+        public:
+            MemoKey() = default;
+
+            template< typename... Args >
+            static MemoKey of( const Args&... args )
+            {
+                MemoKey key;
+                key.words.reserve( sizeof...( Args ) );
+                ( key.push( args ), ... );
+                return key;
+            }
+
+            template< typename T, typename = std::enable_if_t< std::is_arithmetic_v< T > > >
+            void push( T value )
+            {
+                uint64_t word = 0;
+                std::memcpy( &word, &value, sizeof( T ) );
+                words.push_back( word );
+            }
+
+            bool operator==( const MemoKey& rhs ) const { return words == rhs.words; }
+
+            size_t hash() const
+            {
+                uint64_t h = 0x9E3779B97F4A7C15ull ^ words.size();
+                for ( const auto w : words )
+                {
+                    h ^= w + 0x9E3779B97F4A7C15ull + ( h << 6 ) + ( h >> 2 );
+                    h *= 0xBF58476D1CE4E5B9ull;
+                }
+                return static_cast< size_t >( h ^ ( h >> 31 ) );
+            }
+        private:
+            std::vector< uint64_t > words;
+        };
+
+        struct MemoKeyHash
+        {
+            size_t operator()( const MemoKey& key ) const { return key.hash(); }
+        };
+
+        // Bounded least-recently-used cache for the results of one function.
+        // Not synchronized: a cache belongs to one thread, generated code
+        // keeps a thread_local one per memoized function.
+        template< typename Value >
+        class MemoCache
+        {
+        public:
+            explicit MemoCache( size_t capacity = 1024 ):
+                capacity( capacity == 0 ? 1 : capacity )
+            {
+                index.reserve( this->capacity );
+            }
+
+            const Value* find( const MemoKey& key )
+            {
+                const auto it = index.find( key );
+                if ( it == index.cend() )
+                    return nullptr;
+                entries.splice( entries.begin(), entries, it->second );
+                return &it->second->second;
+            }
+
+            const Value& insert( MemoKey&& key, Value&& value )
+            {
+                if ( const auto it = index.find( key ); it != index.cend() )
+                {
+                    it->second->second = std::move( value );
+                    entries.splice( entries.begin(), entries, it->second );
+                    return it->second->second;
+                }
+                if ( entries.size() == capacity )
+                {
+                    index.erase( entries.back().first );
+                    entries.pop_back();
+                }
+                entries.emplace_front( std::move( key ), std::move( value ) );
+                index.emplace( entries.front().first, entries.begin() );
+                return entries.front().second;
+            }
+
+            template< typename Compute >
+            Value getOrCompute( MemoKey&& key, Compute&& compute )
+            {
+                if ( const auto cached = find( key ) )
+                    return *cached;
+                return insert( std::move( key ), compute() );
+            }
+
+            void clear()
+            {
+                entries.clear();
+                index.clear();
+            }
+
+            size_t size() const { return entries.size(); }
+            size_t getCapacity() const { return capacity; }
+        private:
+            using Entry = std::pair< MemoKey, Value >;
+
+            size_t capacity;
+            std::list< Entry > entries;
+            std::unordered_map< MemoKey, typename std::list< Entry >::iterator, MemoKeyHash > index;
+        };
+    }
+}
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Hash.h"
+#include "String.h"
+
+namespace t
+{
+    namespace runtime
+    {
+        namespace serial
+        {
+            enum class FieldKind : uint8_t
+            {
+                Bool, Char,
+                Int8, Int16, Int32, Int64,
+                UInt8, UInt16, UInt32, UInt64,
+                Float, Double,
+                String,
+            };
+
+            // Bytes a field takes in the fixed part of a record. A String is an
+            // offset and a length into the variable part.
+            inline uint32_t sizeOf( FieldKind kind )
+            {
+                switch ( kind )
+                {
+                case FieldKind::Bool: case FieldKind::Char: case FieldKind::Int8: case FieldKind::UInt8: return 1;
+                case FieldKind::Int16: case FieldKind::UInt16: return 2;
+                case FieldKind::Int32: case FieldKind::UInt32: case FieldKind::Float: return 4;
+                case FieldKind::Int64: case FieldKind::UInt64: case FieldKind::Double: case FieldKind::String: return 8;
+                }
+                return 0;
+            }
+
+            template< typename T >
+            constexpr bool matches( FieldKind kind )
+            {
+                if constexpr ( std::is_same_v< T, bool > ) return kind == FieldKind::Bool;
+                else if constexpr ( std::is_same_v< T, char > ) return kind == FieldKind::Char;
+                else if constexpr ( std::is_same_v< T, int8_t > ) return kind == FieldKind::Int8;
+                else if constexpr ( std::is_same_v< T, int16_t > ) return kind == FieldKind::Int16;
+                else if constexpr ( std::is_same_v< T, int32_t > ) return kind == FieldKind::Int32;
+                else if constexpr ( std::is_same_v< T, int64_t > ) return kind == FieldKind::Int64;
+                else if constexpr ( std::is_same_v< T, uint8_t > ) return kind == FieldKind::UInt8;
+                else if constexpr ( std::is_same_v< T, uint16_t > ) return kind == FieldKind::UInt16;
+                else if constexpr ( std::is_same_v< T, uint32_t > ) return kind == FieldKind::UInt32;
+                else if constexpr ( std::is_same_v< T, uint64_t > ) return kind == FieldKind::UInt64;
+                else if constexpr ( std::is_same_v< T, float > ) return kind == FieldKind::Float;
+                else if constexpr ( std::is_same_v< T, double > ) return kind == FieldKind::Double;
+                else return false;
+            }
+
+            struct Field
+            {
+                // Fields of nested class values are flattened as "outer.inner"
+                std::string name;
+                FieldKind kind;
+                // From the start of the fixed part
+                uint32_t offset;
+            };
+
+            // The layout of one class. Fields are listed in declaration order;
+            // their offsets pack the widest first so nothing needs padding.
+            struct Schema
+            {
+                std::string name;
+                std::vector< Field > fields;
+                uint32_t fixedSize = 0;
+                // Changes whenever a field is added, removed, renamed or retyped
+                uint64_t fingerprint = 0;
+
+                size_t indexOf( std::string_view field ) const
+                {
+                    for ( size_t i = 0; i < fields.size(); i++ )
+                        if ( fields[ i ].name == field )
+                            return i;
+                    throw std::runtime_error( name + " has no field " + std::string( field ) );
+                }
+
+                // Assigns offsets and the fingerprint once the fields are known
+                void layout()
+                {
+                    fixedSize = 0;
+                    for ( const uint32_t width : { 8u, 4u, 2u, 1u } )
+                    {
+                        for ( auto& field : fields )
+                        {
+                            if ( sizeOf( field.kind ) != width )
+                                continue;
+                            field.offset = fixedSize;
+                            fixedSize += width;
+                        }
+                    }
+                    std::string signature = name;
+                    for ( const auto& field : fields )
+                        signature += ';' + field.name + ':' + std::to_string( static_cast< int >( field.kind ) );
+                    fingerprint = hashing::bytes( signature.data(), signature.size() );
+                }
+            };
+
+            // Every record starts with the schema fingerprint and its total size
+            constexpr uint32_t HEADER_SIZE = 12;
+
+            // Builds one record. Primitive fields are stored in place in the
+            // fixed part, String bytes are appended after it.
+            class RecordWriter
+            {
+            public:
+                explicit RecordWriter( const Schema& schema ):
+                    schema( schema ) { reset(); }
+
+                void reset()
+                {
+                    buffer.assign( HEADER_SIZE + schema.fixedSize, '\0' );
+                    std::memcpy( buffer.data(), &schema.fingerprint, 8 );
+                }
+
+                template< typename T >
+                RecordWriter& set( size_t field, T value )
+                {
+                    const auto& f = schema.fields[ field ];
+                    if ( !matches< T >( f.kind ) )
+                        throw std::runtime_error( "wrong type for field " + f.name );
+                    std::memcpy( buffer.data() + HEADER_SIZE + f.offset, &value, sizeof( T ) );
+                    return *this;
+                }
+
+                RecordWriter& setString( size_t field, std::string_view value )
+                {
+                    const auto& f = schema.fields[ field ];
+                    if ( f.kind != FieldKind::String )
+                        throw std::runtime_error( "wrong type for field " + f.name );
+                    const uint32_t slot[ 2 ] = { static_cast< uint32_t >( buffer.size() ), static_cast< uint32_t >( value.size() ) };
+                    std::memcpy( buffer.data() + HEADER_SIZE + f.offset, slot, 8 );
+                    buffer.append( value.data(), value.size() );
+                    return *this;
+                }
+
+                RecordWriter& setString( size_t field, const String& value ) { return setString( field, value.view() ); }
+
+                // The finished record, valid until the next reset()
+                std::string_view finish()
+                {
+                    const auto size = static_cast< uint32_t >( buffer.size() );
+                    std::memcpy( buffer.data() + 8, &size, 4 );
+                    return buffer;
+                }
+            private:
+                const Schema& schema;
+                std::string buffer;
+            };
+
+            // Reads a record in place. Opening checks the fingerprint, every
+            // bound and the UTF-8 of every String once, after which fields are
+            // plain loads and Strings are views into the record's bytes.
+            class RecordView
+            {
+            public:
+                RecordView( const Schema& schema, std::string_view bytes ):
+                    schema( schema ), bytes( bytes )
+                {
+                    if ( bytes.size() < HEADER_SIZE + schema.fixedSize )
+                        throw std::runtime_error( "record is truncated" );
+                    uint64_t fingerprint;
+                    uint32_t size;
+                    std::memcpy( &fingerprint, bytes.data(), 8 );
+                    std::memcpy( &size, bytes.data() + 8, 4 );
+                    if ( fingerprint != schema.fingerprint )
+                        throw std::runtime_error( "record was not written with the schema of " + schema.name );
+                    if ( size != bytes.size() )
+                        throw std::runtime_error( "record size does not match its header" );
+                    for ( size_t i = 0; i < schema.fields.size(); i++ )
+                    {
+                        if ( schema.fields[ i ].kind != FieldKind::String )
+                            continue;
+                        const auto [ offset, len ] = slot( i );
+                        if ( offset < HEADER_SIZE + schema.fixedSize || uint64_t( offset ) + len > size )
+                            throw std::runtime_error( "String field " + schema.fields[ i ].name + " is out of bounds" );
+                        if ( !utf8::validate( bytes.substr( offset, len ) ) )
+                            throw std::runtime_error( "String field " + schema.fields[ i ].name + " is not valid UTF-8" );
+                    }
+                }
+
+                template< typename T >
+                T get( size_t field ) const
+                {
+                    const auto& f = schema.fields[ field ];
+                    if ( !matches< T >( f.kind ) )
+                        throw std::runtime_error( "wrong type for field " + f.name );
+                    T value;
+                    std::memcpy( &value, bytes.data() + HEADER_SIZE + f.offset, sizeof( T ) );
+                    return value;
+                }
+
+                std::string_view getString( size_t field ) const
+                {
+                    if ( schema.fields[ field ].kind != FieldKind::String )
+                        throw std::runtime_error( "wrong type for field " + schema.fields[ field ].name );
+                    const auto [ offset, len ] = slot( field );
+                    return bytes.substr( offset, len );
+                }
+
+                // A String that shares 'owner', which must hold the record's bytes
+                String getString( size_t field, std::shared_ptr< const void > owner ) const { return String::borrow( std::move( owner ), getString( field ) ); }
+
+                const Schema& getSchema() const { return schema; }
+            private:
+                const Schema& schema;
+                std::string_view bytes;
+
+                std::pair< uint32_t, uint32_t > slot( size_t field ) const
+                {
+                    uint32_t s[ 2 ];
+                    std::memcpy( s, bytes.data() + HEADER_SIZE + schema.fields[ field ].offset, 8 );
+                    return { s[ 0 ], s[ 1 ] };
+                }
+            };
+        }
+    }
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Hash.h"
+#include "StringKernels.h"
+#include "Utf8.h"
+
+namespace t
+{
+    namespace runtime
+    {
+        // An immutable UTF-8 string. The bytes are validated once when the
+        // string is created and shared by every slice taken from it, so
+        // slicing by byte offset is O(1). The code point count is computed
+        // on first use and cached. The bytes are kept alive by an owner, which
+        // is usually a std::string but can be anything, such as a mapped file.
+        class String
+        {
+        public:
+            static constexpr size_t npos = strings::npos;
+
+            String() = default;
+
+            String( const String& ) = default;
+
+            String& operator=( const String& ) = default;
+
+            // The source is left empty rather than viewing bytes it no longer owns
+            String( String&& other ) noexcept:
+                owner( std::move( other.owner ) ), bytes( other.bytes ), len( other.len ), cachedCodePoints( other.cachedCodePoints )
+            {
+                other.reset();
+            }
+
+            String& operator=( String&& other ) noexcept
+            {
+                if ( this != &other )
+                {
+                    owner = std::move( other.owner );
+                    bytes = other.bytes;
+                    len = other.len;
+                    cachedCodePoints = other.cachedCodePoints;
+                    other.reset();
+                }
+                return *this;
+            }
+
+            explicit String( const char* text ):
+                String( std::string( text ) ) {}
+
+            explicit String( std::string_view text ):
+                String( std::string( text ) ) {}
+
+            explicit String( std::string&& text )
+            {
+                if ( !utf8::validate( text ) )
+                    throw std::runtime_error( "string is not valid UTF-8" );
+                *this = fromValidated( std::move( text ) );
+            }
+
+            // For bytes that are already known to be valid, such as the joined
+            // parts of other Strings
+            static String fromValidated( std::string&& text, size_t codePoints = npos )
+            {
+                auto owner = std::make_shared< const std::string >( std::move( text ) );
+                const std::string_view bytes { *owner };
+                return borrow( std::move( owner ), bytes, codePoints );
+            }
+
+            // Refers to validated bytes that 'owner' keeps alive, without copying them
+            static String borrow( std::shared_ptr< const void > owner, std::string_view bytes, size_t codePoints = npos )
+            {
+                String out;
+                out.owner = std::move( owner );
+                out.bytes = bytes.data();
+                out.len = bytes.size();
+                out.cachedCodePoints = codePoints;
+                return out;
+            }
+
+            // The count if it is already known, npos otherwise
+            size_t knownCodePoints() const { return cachedCodePoints; }
+
+            size_t size() const { return len; }
+
+            bool empty() const { return len == 0; }
+
+            const char* data() const { return bytes; }
+
+            std::string_view view() const { return { data(), len }; }
+
+            operator std::string_view() const { return view(); }
+
+            std::string str() const { return std::string( view() ); }
+
+            size_t codePoints() const
+            {
+                if ( cachedCodePoints == npos )
+                    cachedCodePoints = utf8::countCodePoints( view() );
+                return cachedCodePoints;
+            }
+
+            bool isAscii() const { return codePoints() == len; }
+
+            // Both offsets must fall on code point boundaries
+            String slice( size_t begin, size_t end = npos ) const
+            {
+                String out;
+                sliceInto( out, begin, end );
+                return out;
+            }
+
+            // Like slice(), but keeps the reference 'out' already holds when it
+            // shares this string's owner, which saves two atomic operations per
+            // call when a loop slices the same text over and over
+            void sliceInto( String& out, size_t begin, size_t end ) const
+            {
+                if ( out.owner != owner )
+                    out.owner = owner;
+                end = std::min( end, len );
+                if ( begin > end )
+                    throw std::out_of_range( "invalid string slice" );
+                if ( !isBoundary( begin ) || !isBoundary( end ) )
+                    throw std::runtime_error( "string slice splits a UTF-8 sequence" );
+                out.bytes = bytes + begin;
+                out.len = end - begin;
+                out.cachedCodePoints = cachedCodePoints == len ? out.len : npos;
+            }
+
+            size_t find( std::string_view needle, size_t from = 0 ) const { return strings::find( view(), needle, from ); }
+
+            bool contains( std::string_view needle ) const { return strings::contains( view(), needle ); }
+
+            bool startsWith( std::string_view prefix ) const { return strings::startsWith( view(), prefix ); }
+
+            bool endsWith( std::string_view suffix ) const { return strings::endsWith( view(), suffix ); }
+
+            bool operator==( const String& other ) const { return strings::equals( view(), other.view() ); }
+
+            bool operator!=( const String& other ) const { return !( *this == other ); }
+        private:
+            std::shared_ptr< const void > owner;
+            const char* bytes = "";
+            size_t len = 0;
+            mutable size_t cachedCodePoints = npos;
+
+            void reset()
+            {
+                owner.reset();
+                bytes = "";
+                len = 0;
+                cachedCodePoints = npos;
+            }
+
+            bool isBoundary( size_t at ) const { return at == len || !utf8::isContinuation( static_cast< unsigned char >( data()[ at ] ) ); }
+        };
+
+        template<>
+        struct Hash< String >
+        {
+            uint64_t operator()( const String& s ) const { return hashing::bytes( s.data(), s.size() ); }
+        };
+    }
+}
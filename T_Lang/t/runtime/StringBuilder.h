@@ -0,0 +1,112 @@
+#pragma once
+
+#include "String.h"
+
+namespace t
+{
+    namespace runtime
+    {
+        // Accumulates a String piece by piece, for loops that would otherwise
+        // concatenate one piece at a time and copy the whole prefix each time.
+        // Capacity at least doubles whenever it runs out, so n appends cost
+        // O(n) amortized.
+        class StringBuilder
+        {
+        public:
+            StringBuilder() = default;
+
+            explicit StringBuilder( size_t capacity ) { buffer.reserve( capacity ); }
+
+            StringBuilder& append( const String& s )
+            {
+                add( s.view() );
+                addCodePoints( s.knownCodePoints() );
+                return *this;
+            }
+
+            // Unchecked text has to be validated before it can join the result
+            StringBuilder& append( std::string_view s )
+            {
+                if ( !utf8::validate( s ) )
+                    throw std::runtime_error( "appended text is not valid UTF-8" );
+                add( s );
+                addCodePoints( String::npos );
+                return *this;
+            }
+
+            StringBuilder& append( char c )
+            {
+                if ( static_cast< unsigned char >( c ) >= 0x80 )
+                    throw std::runtime_error( "appended character is not valid UTF-8" );
+                grow( 1 );
+                buffer.push_back( c );
+                if ( codePoints != String::npos )
+                    codePoints++;
+                return *this;
+            }
+
+            template< typename T >
+            StringBuilder& operator<<( const T& value ) { return append( value ); }
+
+            void reserve( size_t capacity ) { buffer.reserve( capacity ); }
+
+            size_t size() const { return buffer.size(); }
+
+            size_t capacity() const { return buffer.capacity(); }
+
+            std::string_view view() const { return buffer; }
+
+            void clear()
+            {
+                buffer.clear();
+                codePoints = 0;
+            }
+
+            // Hands the bytes to the String without copying, the builder is empty afterwards
+            String build()
+            {
+                auto out = String::fromValidated( std::move( buffer ), codePoints );
+                buffer = std::string();
+                codePoints = 0;
+                return out;
+            }
+        private:
+            std::string buffer;
+            size_t codePoints = 0;
+
+            void grow( size_t extra )
+            {
+                const auto needed = buffer.size() + extra;
+                if ( needed > buffer.capacity() )
+                    buffer.reserve( std::max( needed, buffer.capacity() * 2 ) );
+            }
+
+            void add( std::string_view s )
+            {
+                grow( s.size() );
+                buffer.append( s.data(), s.size() );
+            }
+
+            void addCodePoints( size_t n )
+            {
+                codePoints = codePoints == String::npos || n == String::npos ? String::npos : codePoints + n;
+            }
+        };
+
+        namespace detail
+        {
+            inline size_t concatSize( const String& s ) { return s.size(); }
+            inline size_t concatSize( char ) { return 1; }
+        }
+
+        // What a fused ConcatExpression lowers to: every part is measured first
+        // so the result is allocated exactly once
+        template< typename... Parts >
+        String concat( const Parts&... parts )
+        {
+            StringBuilder builder { ( size_t( 0 ) + ... + detail::concatSize( parts ) ) };
+            ( builder.append( parts ), ... );
+            return builder.build();
+        }
+    }
+}
@@ -0,0 +1,370 @@
+#pragma once
+
+#include <cstring>
+#include <string_view>
+
+#include "Cpu.h"
+
+#if T_RUNTIME_X86
+#include <immintrin.h>
+#endif
+
+namespace t
+{
+    namespace runtime
+    {
+        namespace strings
+        {
+            constexpr size_t npos = std::string_view::npos;
+
+            inline uint32_t lowestBit( uint32_t mask )
+            {
+#if defined( _MSC_VER )
+                unsigned long idx;
+                _BitScanForward( &idx, mask );
+                return idx;
+#else
+                return __builtin_ctz( mask );
+#endif
+            }
+
+            inline uint32_t lowestBit( uint64_t mask )
+            {
+#if defined( _MSC_VER )
+                unsigned long idx;
+                _BitScanForward64( &idx, mask );
+                return idx;
+#else
+                return __builtin_ctzll( mask );
+#endif
+            }
+
+            // Kernels work on pointer and length so every tier has the same signature
+            struct KernelTable
+            {
+                const char* name;
+                bool ( *equals )( const char* a, const char* b, size_t len );
+                size_t ( *find )( const char* hay, size_t hlen, const char* needle, size_t nlen );
+                size_t ( *findByte )( const char* hay, size_t hlen, char c );
+                // Bit i is set where block[ i ] == c, for a 64 byte block. Scanners
+                // that stop at every match use this to pay one call per block.
+                uint64_t ( *matchMask )( const char* block, char c );
+            };
+
+            namespace scalar
+            {
+                inline bool equals( const char* a, const char* b, size_t len )
+                {
+                    size_t i = 0;
+                    for ( ; i + 8 <= len; i += 8 )
+                    {
+                        uint64_t x, y;
+                        std::memcpy( &x, a + i, 8 );
+                        std::memcpy( &y, b + i, 8 );
+                        if ( x != y )
+                            return false;
+                    }
+                    for ( ; i < len; i++ )
+                        if ( a[ i ] != b[ i ] )
+                            return false;
+                    return true;
+                }
+
+                inline size_t findByte( const char* hay, size_t hlen, char c )
+                {
+                    for ( size_t i = 0; i < hlen; i++ )
+                        if ( hay[ i ] == c )
+                            return i;
+                    return npos;
+                }
+
+                inline uint64_t matchMask( const char* block, char c )
+                {
+                    uint64_t mask = 0;
+                    for ( size_t i = 0; i < 64; i++ )
+                        mask |= uint64_t( block[ i ] == c ) << i;
+                    return mask;
+                }
+
+                // Checks the first and last byte before comparing the middle
+                inline size_t findFrom( const char* hay, size_t hlen, const char* needle, size_t nlen, size_t from )
+                {
+                    if ( nlen == 0 )
+                        return from <= hlen ? from : npos;
+                    if ( nlen > hlen )
+                        return npos;
+                    const char first = needle[ 0 ];
+                    const char last = needle[ nlen - 1 ];
+                    for ( size_t i = from; i + nlen <= hlen; i++ )
+                        if ( hay[ i ] == first && hay[ i + nlen - 1 ] == last && equals( hay + i + 1, needle + 1, nlen > 2 ? nlen - 2 : 0 ) )
+                            return i;
+                    return npos;
+                }
+
+                inline size_t find( const char* hay, size_t hlen, const char* needle, size_t nlen )
+                {
+                    return findFrom( hay, hlen, needle, nlen, 0 );
+                }
+            }
+
+#if T_RUNTIME_X86
+            namespace sse42
+            {
+                T_TARGET_SSE42 inline bool equals( const char* a, const char* b, size_t len )
+                {
+                    size_t i = 0;
+                    for ( ; i + 16 <= len; i += 16 )
+                    {
+                        const auto x = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a + i ) );
+                        const auto y = _mm_loadu_si128( reinterpret_cast< const __m128i* >( b + i ) );
+                        if ( _mm_movemask_epi8( _mm_cmpeq_epi8( x, y ) ) != 0xFFFF )
+                            return false;
+                    }
+                    return scalar::equals( a + i, b + i, len - i );
+                }
+
+                T_TARGET_SSE42 inline size_t findByte( const char* hay, size_t hlen, char c )
+                {
+                    const auto needle = _mm_set1_epi8( c );
+                    size_t i = 0;
+                    for ( ; i + 16 <= hlen; i += 16 )
+                    {
+                        const auto block = _mm_loadu_si128( reinterpret_cast< const __m128i* >( hay + i ) );
+                        if ( const uint32_t mask = _mm_movemask_epi8( _mm_cmpeq_epi8( block, needle ) ) )
+                            return i + lowestBit( mask );
+                    }
+                    const auto rest = scalar::findByte( hay + i, hlen - i, c );
+                    return rest == npos ? npos : i + rest;
+                }
+
+                T_TARGET_SSE42 inline uint64_t matchMask( const char* block, char c )
+                {
+                    const auto needle = _mm_set1_epi8( c );
+                    uint64_t mask = 0;
+                    for ( size_t i = 0; i < 64; i += 16 )
+                    {
+                        const auto v = _mm_loadu_si128( reinterpret_cast< const __m128i* >( block + i ) );
+                        mask |= uint64_t( static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( v, needle ) ) ) ) << i;
+                    }
+                    return mask;
+                }
+
+                // PCMPESTRI in equal-ordered mode finds needles of up to 16 bytes
+                // in one instruction per 16-byte window. A match that runs off the
+                // end of a window restarts the next window at that candidate.
+                T_TARGET_SSE42 inline size_t findShort( const char* hay, size_t hlen, const char* needle, size_t nlen )
+                {
+                    const auto n = _mm_loadu_si128( reinterpret_cast< const __m128i* >( needle ) );
+                    size_t off = 0;
+                    while ( off + 16 <= hlen )
+                    {
+                        const auto block = _mm_loadu_si128( reinterpret_cast< const __m128i* >( hay + off ) );
+                        const auto idx = static_cast< size_t >( _mm_cmpestri( n, static_cast< int >( nlen ), block, 16,
+                            _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ORDERED | _SIDD_LEAST_SIGNIFICANT ) );
+                        if ( idx == 16 )
+                            off += 16;
+                        else if ( idx + nlen <= 16 )
+                            return off + idx;
+                        else
+                            off += idx;
+                    }
+                    return scalar::findFrom( hay, hlen, needle, nlen, off );
+                }
+
+                T_TARGET_SSE42 inline size_t find( const char* hay, size_t hlen, const char* needle, size_t nlen )
+                {
+                    if ( nlen == 0 || nlen > hlen )
+                        return scalar::find( hay, hlen, needle, nlen );
+                    if ( nlen == 1 )
+                        return findByte( hay, hlen, needle[ 0 ] );
+                    // The needle register is loaded whole, so only needles that are
+                    // safe to over-read take the string instruction path
+                    if ( nlen <= 16 && hlen >= 16 )
+                    {
+                        char padded[ 16 ] = {};
+                        std::memcpy( padded, needle, nlen );
+                        return findShort( hay, hlen, padded, nlen );
+                    }
+                    const auto first = _mm_set1_epi8( needle[ 0 ] );
+                    const auto last = _mm_set1_epi8( needle[ nlen - 1 ] );
+                    size_t i = 0;
+                    for ( ; i + nlen - 1 + 16 <= hlen; i += 16 )
+                    {
+                        const auto blockFirst = _mm_loadu_si128( reinterpret_cast< const __m128i* >( hay + i ) );
+                        const auto blockLast = _mm_loadu_si128( reinterpret_cast< const __m128i* >( hay + i + nlen - 1 ) );
+                        uint32_t mask = _mm_movemask_epi8( _mm_and_si128( _mm_cmpeq_epi8( first, blockFirst ), _mm_cmpeq_epi8( last, blockLast ) ) );
+                        for ( ; mask; mask &= mask - 1 )
+                        {
+                            const auto pos = i + lowestBit( mask );
+                            if ( equals( hay + pos + 1, needle + 1, nlen - 2 ) )
+                                return pos;
+                        }
+                    }
+                    return scalar::findFrom( hay, hlen, needle, nlen, i );
+                }
+            }
+
+            namespace avx2
+            {
+                T_TARGET_AVX2 inline bool equals( const char* a, const char* b, size_t len )
+                {
+                    size_t i = 0;
+                    for ( ; i + 32 <= len; i += 32 )
+                    {
+                        const auto x = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( a + i ) );
+                        const auto y = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( b + i ) );
+                        if ( static_cast< uint32_t >( _mm256_movemask_epi8( _mm256_cmpeq_epi8( x, y ) ) ) != 0xFFFFFFFFu )
+                            return false;
+                    }
+                    return sse42::equals( a + i, b + i, len - i );
+                }
+
+                T_TARGET_AVX2 inline size_t findByte( const char* hay, size_t hlen, char c )
+                {
+                    const auto needle = _mm256_set1_epi8( c );
+                    size_t i = 0;
+                    for ( ; i + 32 <= hlen; i += 32 )
+                    {
+                        const auto block = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( hay + i ) );
+                        if ( const uint32_t mask = _mm256_movemask_epi8( _mm256_cmpeq_epi8( block, needle ) ) )
+                            return i + lowestBit( mask );
+                    }
+                    const auto rest = sse42::findByte( hay + i, hlen - i, c );
+                    return rest == npos ? npos : i + rest;
+                }
+
+                T_TARGET_AVX2 inline uint64_t matchMask( const char* block, char c )
+                {
+                    const auto needle = _mm256_set1_epi8( c );
+                    const auto lo = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( block ) );
+                    const auto hi = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( block + 32 ) );
+                    const uint32_t loMask = _mm256_movemask_epi8( _mm256_cmpeq_epi8( lo, needle ) );
+                    const uint32_t hiMask = _mm256_movemask_epi8( _mm256_cmpeq_epi8( hi, needle ) );
+                    return uint64_t( loMask ) | ( uint64_t( hiMask ) << 32 );
+                }
+
+                // Compares the needle's first and last byte at 32 positions at once
+                // and only verifies the middle where both match
+                T_TARGET_AVX2 inline size_t find( const char* hay, size_t hlen, const char* needle, size_t nlen )
+                {
+                    if ( nlen == 0 || nlen > hlen )
+                        return scalar::find( hay, hlen, needle, nlen );
+                    if ( nlen == 1 )
+                        return findByte( hay, hlen, needle[ 0 ] );
+                    const auto first = _mm256_set1_epi8( needle[ 0 ] );
+                    const auto last = _mm256_set1_epi8( needle[ nlen - 1 ] );
+                    size_t i = 0;
+                    for ( ; i + nlen - 1 + 32 <= hlen; i += 32 )
+                    {
+                        const auto blockFirst = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( hay + i ) );
+                        const auto blockLast = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( hay + i + nlen - 1 ) );
+                        uint32_t mask = _mm256_movemask_epi8( _mm256_and_si256( _mm256_cmpeq_epi8( first, blockFirst ), _mm256_cmpeq_epi8( last, blockLast ) ) );
+                        for ( ; mask; mask &= mask - 1 )
+                        {
+                            const auto pos = i + lowestBit( mask );
+                            if ( equals( hay + pos + 1, needle + 1, nlen - 2 ) )
+                                return pos;
+                        }
+                    }
+                    return scalar::findFrom( hay, hlen, needle, nlen, i );
+                }
+            }
+#endif
+
+            enum KernelTier : uint8_t
+            {
+                Scalar,
+                SSE42,
+                AVX2,
+            };
+
+            inline const KernelTable& kernelsFor( KernelTier tier )
+            {
+                static const KernelTable tables[] =
+                {
+                    { "scalar", scalar::equals, scalar::find, scalar::findByte, scalar::matchMask },
+#if T_RUNTIME_X86
+                    { "sse4.2", sse42::equals, sse42::find, sse42::findByte, sse42::matchMask },
+                    { "avx2", avx2::equals, avx2::find, avx2::findByte, avx2::matchMask },
+#endif
+                };
+                const auto& f = cpuFeatures();
+                if ( ( tier == AVX2 && !f.avx2 ) || ( tier == SSE42 && !f.sse42 ) )
+                    throw std::runtime_error( "string kernel tier is not supported by this CPU" );
+                return tables[ tier ];
+            }
+
+            inline KernelTier bestTier()
+            {
+                const auto& f = cpuFeatures();
+                return f.avx2 ? AVX2 : f.sse42 ? SSE42 : Scalar;
+            }
+
+            // Chosen on first use from the CPU features. Tests and benchmarks
+            // may pin a tier with useTier() before any other thread runs.
+            inline const KernelTable*& activeKernels()
+            {
+                static const KernelTable* active = &kernelsFor( bestTier() );
+                return active;
+            }
+
+            inline void useTier( KernelTier tier ) { activeKernels() = &kernelsFor( tier ); }
+
+            inline bool equals( std::string_view a, std::string_view b )
+            {
+                return a.size() == b.size() && activeKernels()->equals( a.data(), b.data(), a.size() );
+            }
+
+            inline size_t find( std::string_view hay, std::string_view needle, size_t from = 0 )
+            {
+                if ( from > hay.size() )
+                    return npos;
+                const auto pos = activeKernels()->find( hay.data() + from, hay.size() - from, needle.data(), needle.size() );
+                return pos == npos ? npos : pos + from;
+            }
+
+            inline size_t find( std::string_view hay, char c, size_t from = 0 )
+            {
+                if ( from >= hay.size() )
+                    return npos;
+                const auto pos = activeKernels()->findByte( hay.data() + from, hay.size() - from, c );
+                return pos == npos ? npos : pos + from;
+            }
+
+            inline bool contains( std::string_view hay, std::string_view needle ) { return find( hay, needle ) != npos; }
+
+            inline bool startsWith( std::string_view s, std::string_view prefix )
+            {
+                return s.size() >= prefix.size() && activeKernels()->equals( s.data(), prefix.data(), prefix.size() );
+            }
+
+            inline bool endsWith( std::string_view s, std::string_view suffix )
+            {
+                return s.size() >= suffix.size() && activeKernels()->equals( s.data() + s.size() - suffix.size(), suffix.data(), suffix.size() );
+            }
+
+            // Views into 's', so the source must outlive the result
+            inline std::vector< std::string_view > split( std::string_view s, char delim )
+            {
+                std::vector< std::string_view > parts;
+                size_t start = 0;
+                for ( size_t pos; ( pos = find( s, delim, start ) ) != npos; start = pos + 1 )
+                    parts.push_back( s.substr( start, pos - start ) );
+                parts.push_back( s.substr( start ) );
+                return parts;
+            }
+
+            inline std::vector< std::string_view > split( std::string_view s, std::string_view delim )
+            {
+                if ( delim.empty() )
+                    throw std::runtime_error( "cannot split on an empty delimiter" );
+                std::vector< std::string_view > parts;
+                size_t start = 0;
+                for ( size_t pos; ( pos = find( s, delim, start ) ) != npos; start = pos + delim.size() )
+                    parts.push_back( s.substr( start, pos - start ) );
+                parts.push_back( s.substr( start ) );
+                return parts;
+            }
+        }
+    }
+}
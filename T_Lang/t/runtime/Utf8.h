@@ -0,0 +1,347 @@
+#pragma once
+
+#include <cstring>
+#include <string_view>
+
+#include "Cpu.h"
+
+#if T_RUNTIME_X86
+#include <immintrin.h>
+#endif
+
+namespace t
+{
+    namespace runtime
+    {
+        namespace utf8
+        {
+            inline bool isContinuation( unsigned char c ) { return ( c & 0xC0 ) == 0x80; }
+
+            inline uint32_t popcount( uint32_t mask )
+            {
+#if defined( _MSC_VER )
+                return __popcnt( mask );
+#else
+                return __builtin_popcount( mask );
+#endif
+            }
+
+            namespace scalar
+            {
+                inline bool validate( const char* data, size_t len )
+                {
+                    const auto s = reinterpret_cast< const unsigned char* >( data );
+                    size_t i = 0;
+                    while ( i < len )
+                    {
+                        // Skip ASCII a word at a time
+                        if ( i + 8 <= len )
+                        {
+                            uint64_t word;
+                            std::memcpy( &word, s + i, 8 );
+                            if ( ( word & 0x8080808080808080ull ) == 0 )
+                            {
+                                i += 8;
+                                continue;
+                            }
+                        }
+                        const auto c = s[ i ];
+                        if ( c < 0x80 )
+                        {
+                            i++;
+                            continue;
+                        }
+                        size_t n;
+                        unsigned char lo = 0x80, hi = 0xBF;
+                        if ( c >= 0xC2 && c <= 0xDF ) n = 1;
+                        else if ( c == 0xE0 ) { n = 2; lo = 0xA0; }
+                        else if ( c == 0xED ) { n = 2; hi = 0x9F; }
+                        else if ( c >= 0xE1 && c <= 0xEF ) n = 2;
+                        else if ( c == 0xF0 ) { n = 3; lo = 0x90; }
+                        else if ( c == 0xF4 ) { n = 3; hi = 0x8F; }
+                        else if ( c >= 0xF1 && c <= 0xF3 ) n = 3;
+                        else return false;
+                        if ( i + n >= len )
+                            return false;
+                        if ( s[ i + 1 ] < lo || s[ i + 1 ] > hi )
+                            return false;
+                        for ( size_t k = 2; k <= n; k++ )
+                            if ( !isContinuation( s[ i + k ] ) )
+                                return false;
+                        i += n + 1;
+                    }
+                    return true;
+                }
+
+                inline size_t countCodePoints( const char* data, size_t len )
+                {
+                    size_t count = 0;
+                    for ( size_t i = 0; i < len; i++ )
+                        count += !isContinuation( static_cast< unsigned char >( data[ i ] ) );
+                    return count;
+                }
+            }
+
+#if T_RUNTIME_X86
+            // The lookup validator from Keiser and Lemire, "Validating UTF-8 In
+            // Less Than One Instruction Per Byte". Three nibble lookups classify
+            // every byte pair, a saturating subtract finds where the third and
+            // fourth bytes of a sequence must be, and any mismatch sets a bit.
+            namespace lookup
+            {
+                constexpr uint8_t TOO_SHORT = 1 << 0;
+                constexpr uint8_t TOO_LONG = 1 << 1;
+                constexpr uint8_t OVERLONG_3 = 1 << 2;
+                constexpr uint8_t TOO_LARGE = 1 << 3;
+                constexpr uint8_t SURROGATE = 1 << 4;
+                constexpr uint8_t OVERLONG_2 = 1 << 5;
+                constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+                constexpr uint8_t OVERLONG_4 = 1 << 6;
+                constexpr uint8_t TWO_CONTS = 1 << 7;
+                constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+                alignas( 16 ) constexpr uint8_t BYTE_1_HIGH[ 16 ] =
+                {
+                    TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+                    TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+                    TOO_SHORT | OVERLONG_2,
+                    TOO_SHORT,
+                    TOO_SHORT | OVERLONG_3 | SURROGATE,
+                    TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4,
+                };
+
+                alignas( 16 ) constexpr uint8_t BYTE_1_LOW[ 16 ] =
+                {
+                    CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+                    CARRY | OVERLONG_2,
+                    CARRY,
+                    CARRY,
+                    CARRY | TOO_LARGE,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                    CARRY | TOO_LARGE | TOO_LARGE_1000,
+                };
+
+                alignas( 16 ) constexpr uint8_t BYTE_2_HIGH[ 16 ] =
+                {
+                    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                    TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+                    TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+                };
+
+                // Non-zero where a block ends inside a multi-byte sequence
+                alignas( 16 ) constexpr uint8_t INCOMPLETE_MAX[ 32 ] =
+                {
+                    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+                    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+                    0xF0 - 1, 0xE0 - 1, 0xC0 - 1,
+                };
+            }
+
+            namespace sse
+            {
+                struct State
+                {
+                    __m128i error;
+                    __m128i prev;
+                    __m128i prevIncomplete;
+                };
+
+                T_TARGET_SSE42 inline __m128i table( const uint8_t* t ) { return _mm_load_si128( reinterpret_cast< const __m128i* >( t ) ); }
+
+                T_TARGET_SSE42 inline __m128i high( __m128i v ) { return _mm_and_si128( _mm_srli_epi16( v, 4 ), _mm_set1_epi8( 0x0F ) ); }
+
+                T_TARGET_SSE42 inline void step( State& st, __m128i input )
+                {
+                    if ( _mm_movemask_epi8( input ) == 0 )
+                    {
+                        st.error = _mm_or_si128( st.error, st.prevIncomplete );
+                        st.prevIncomplete = _mm_setzero_si128();
+                        st.prev = input;
+                        return;
+                    }
+                    const auto prev1 = _mm_alignr_epi8( input, st.prev, 15 );
+                    const auto prev2 = _mm_alignr_epi8( input, st.prev, 14 );
+                    const auto prev3 = _mm_alignr_epi8( input, st.prev, 13 );
+                    const auto b1h = _mm_shuffle_epi8( table( lookup::BYTE_1_HIGH ), high( prev1 ) );
+                    const auto b1l = _mm_shuffle_epi8( table( lookup::BYTE_1_LOW ), _mm_and_si128( prev1, _mm_set1_epi8( 0x0F ) ) );
+                    const auto b2h = _mm_shuffle_epi8( table( lookup::BYTE_2_HIGH ), high( input ) );
+                    const auto special = _mm_and_si128( _mm_and_si128( b1h, b1l ), b2h );
+                    const auto must23 = _mm_or_si128( _mm_subs_epu8( prev2, _mm_set1_epi8( char( 0xE0 - 0x80 ) ) ), _mm_subs_epu8( prev3, _mm_set1_epi8( char( 0xF0 - 0x80 ) ) ) );
+                    const auto must23_80 = _mm_and_si128( must23, _mm_set1_epi8( char( 0x80 ) ) );
+                    st.error = _mm_or_si128( st.error, _mm_xor_si128( must23_80, special ) );
+                    st.prevIncomplete = _mm_subs_epu8( input, _mm_loadu_si128( reinterpret_cast< const __m128i* >( lookup::INCOMPLETE_MAX + 16 ) ) );
+                    st.prev = input;
+                }
+
+                T_TARGET_SSE42 inline bool validate( const char* data, size_t len )
+                {
+                    State st { _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128() };
+                    size_t i = 0;
+                    for ( ; i + 16 <= len; i += 16 )
+                        step( st, _mm_loadu_si128( reinterpret_cast< const __m128i* >( data + i ) ) );
+                    if ( i < len )
+                    {
+                        alignas( 16 ) char tail[ 16 ] = {};
+                        std::memcpy( tail, data + i, len - i );
+                        step( st, _mm_load_si128( reinterpret_cast< const __m128i* >( tail ) ) );
+                    }
+                    st.error = _mm_or_si128( st.error, st.prevIncomplete );
+                    return _mm_testz_si128( st.error, st.error );
+                }
+
+                T_TARGET_SSE42 inline size_t countCodePoints( const char* data, size_t len )
+                {
+                    size_t count = 0;
+                    size_t i = 0;
+                    for ( ; i + 16 <= len; i += 16 )
+                    {
+                        const auto block = _mm_loadu_si128( reinterpret_cast< const __m128i* >( data + i ) );
+                        // Continuation bytes are exactly the signed bytes below -64
+                        count += popcount( _mm_movemask_epi8( _mm_cmpgt_epi8( block, _mm_set1_epi8( -65 ) ) ) );
+                    }
+                    return count + scalar::countCodePoints( data + i, len - i );
+                }
+            }
+
+            namespace avx2
+            {
+                struct State
+                {
+                    __m256i error;
+                    __m256i prev;
+                    __m256i prevIncomplete;
+                };
+
+                T_TARGET_AVX2 inline __m256i table( const uint8_t* t )
+                {
+                    return _mm256_broadcastsi128_si256( _mm_load_si128( reinterpret_cast< const __m128i* >( t ) ) );
+                }
+
+                T_TARGET_AVX2 inline __m256i high( __m256i v ) { return _mm256_and_si256( _mm256_srli_epi16( v, 4 ), _mm256_set1_epi8( 0x0F ) ); }
+
+                // Shifts 'input' right by N bytes across both lanes, filling from 'prev'
+                template< int N >
+                T_TARGET_AVX2 inline __m256i previous( __m256i input, __m256i prev )
+                {
+                    return _mm256_alignr_epi8( input, _mm256_permute2x128_si256( prev, input, 0x21 ), 16 - N );
+                }
+
+                T_TARGET_AVX2 inline void step( State& st, __m256i input )
+                {
+                    if ( _mm256_movemask_epi8( input ) == 0 )
+                    {
+                        st.error = _mm256_or_si256( st.error, st.prevIncomplete );
+                        st.prevIncomplete = _mm256_setzero_si256();
+                        st.prev = input;
+                        return;
+                    }
+                    const auto prev1 = previous< 1 >( input, st.prev );
+                    const auto prev2 = previous< 2 >( input, st.prev );
+                    const auto prev3 = previous< 3 >( input, st.prev );
+                    const auto b1h = _mm256_shuffle_epi8( table( lookup::BYTE_1_HIGH ), high( prev1 ) );
+                    const auto b1l = _mm256_shuffle_epi8( table( lookup::BYTE_1_LOW ), _mm256_and_si256( prev1, _mm256_set1_epi8( 0x0F ) ) );
+                    const auto b2h = _mm256_shuffle_epi8( table( lookup::BYTE_2_HIGH ), high( input ) );
+                    const auto special = _mm256_and_si256( _mm256_and_si256( b1h, b1l ), b2h );
+                    const auto must23 = _mm256_or_si256( _mm256_subs_epu8( prev2, _mm256_set1_epi8( char( 0xE0 - 0x80 ) ) ), _mm256_subs_epu8( prev3, _mm256_set1_epi8( char( 0xF0 - 0x80 ) ) ) );
+                    const auto must23_80 = _mm256_and_si256( must23, _mm256_set1_epi8( char( 0x80 ) ) );
+                    st.error = _mm256_or_si256( st.error, _mm256_xor_si256( must23_80, special ) );
+                    st.prevIncomplete = _mm256_subs_epu8( input, _mm256_loadu_si256( reinterpret_cast< const __m256i* >( lookup::INCOMPLETE_MAX ) ) );
+                    st.prev = input;
+                }
+
+                T_TARGET_AVX2 inline bool validate( const char* data, size_t len )
+                {
+                    State st { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+                    size_t i = 0;
+                    for ( ; i + 32 <= len; i += 32 )
+                        step( st, _mm256_loadu_si256( reinterpret_cast< const __m256i* >( data + i ) ) );
+                    if ( i < len )
+                    {
+                        alignas( 32 ) char tail[ 32 ] = {};
+                        std::memcpy( tail, data + i, len - i );
+                        step( st, _mm256_load_si256( reinterpret_cast< const __m256i* >( tail ) ) );
+                    }
+                    st.error = _mm256_or_si256( st.error, st.prevIncomplete );
+                    return _mm256_testz_si256( st.error, st.error );
+                }
+
+                T_TARGET_AVX2 inline size_t countCodePoints( const char* data, size_t len )
+                {
+                    size_t count = 0;
+                    size_t i = 0;
+                    for ( ; i + 32 <= len; i += 32 )
+                    {
+                        const auto block = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( data + i ) );
+                        count += popcount( _mm256_movemask_epi8( _mm256_cmpgt_epi8( block, _mm256_set1_epi8( -65 ) ) ) );
+                    }
+                    return count + sse::countCodePoints( data + i, len - i );
+                }
+            }
+#endif
+
+            // Decodes the code point starting at 'at' of already validated text
+            // and advances 'at' past it
+            inline uint32_t decode( std::string_view s, size_t& at )
+            {
+                const auto c = static_cast< unsigned char >( s[ at++ ] );
+                if ( c < 0x80 )
+                    return c;
+                const size_t n = c >= 0xF0 ? 3 : c >= 0xE0 ? 2 : 1;
+                uint32_t cp = c & ( 0x3F >> n );
+                for ( size_t k = 0; k < n && at < s.size(); k++ )
+                    cp = ( cp << 6 ) | ( static_cast< unsigned char >( s[ at++ ] ) & 0x3F );
+                return cp;
+            }
+
+            // Letters of any script may appear in identifiers. Without the full
+            // UAX #31 tables this accepts every non-ASCII code point except the
+            // blocks that are whitespace, punctuation, symbols or controls.
+            inline bool isIdentifierCodePoint( uint32_t cp )
+            {
+                if ( cp < 0x80 )
+                    return ( ( cp | 0x20 ) >= 'a' && ( cp | 0x20 ) <= 'z' ) || ( cp >= '0' && cp <= '9' ) || cp == '_';
+                if ( cp < 0xC0 )
+                    return cp == 0xAA || cp == 0xB5 || cp == 0xBA;
+                if ( cp == 0xD7 || cp == 0xF7 )
+                    return false;
+                if ( ( cp >= 0x2000 && cp <= 0x206F ) || ( cp >= 0x2190 && cp <= 0x2BFF ) || ( cp >= 0x2E00 && cp <= 0x2E7F ) )
+                    return false;
+                if ( ( cp >= 0x3000 && cp <= 0x3003 ) || cp == 0xFEFF || ( cp >= 0xFFF0 && cp <= 0xFFFF ) )
+                    return false;
+                return true;
+            }
+
+            inline bool validate( std::string_view s )
+            {
+#if T_RUNTIME_X86
+                static const auto impl = cpuFeatures().avx2 ? avx2::validate : cpuFeatures().sse42 ? sse::validate : scalar::validate;
+                return impl( s.data(), s.size() );
+#else
+                return scalar::validate( s.data(), s.size() );
+#endif
+            }
+
+            inline size_t countCodePoints( std::string_view s )
+            {
+#if T_RUNTIME_X86
+                static const auto impl = cpuFeatures().avx2 ? avx2::countCodePoints : cpuFeatures().sse42 ? sse::countCodePoints : scalar::countCodePoints;
+                return impl( s.data(), s.size() );
+#else
+                return scalar::countCodePoints( s.data(), s.size() );
+#endif
+            }
+        }
+    }
+}
@@ -1,3 +1,13 @@
 #pragma once
 
 #include "Parser.h"
+#include "Effects.h"
+#include "Moves.h"
+#include "Concat.h"
+#include "Serialize.h"
+#include "ConstEval.h"
+#include "Monomorphize.h"
+#include "Check.h"
+#include "CodeGen.h"
+#include "Diff.h"
+#include "Formatter.h"
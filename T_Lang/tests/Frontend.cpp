@@ -0,0 +1,788 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#include "../t/t.h"
+
+namespace
+{
+    std::vector< t::lexer::TokenType > types( const std::string& src )
+    {
+        std::vector< t::lexer::TokenType > result;
+        for ( const auto& token : t::Lexer( src ).tokenize() )
+            result.push_back( token.type );
+        return result;
+    }
+
+    t::ast::Program parse( const std::string& src )
+    {
+        return t::Parser( t::Lexer( src ).tokenize() ).produceAST();
+    }
+
+    // The passes tc runs before writing C++ with -o
+    std::string generate( const std::string& src, t::GenericRegistry& registry )
+    {
+        t::Parser parser { t::Lexer( src ).tokenize() };
+        auto program = parser.produceAST();
+        // Every module of the build declares the same templates
+        std::vector< t::GenericTemplate > templates;
+        for ( const auto& tmpl : parser.getTemplates() )
+            if ( !registry.findTemplate( tmpl.name ) )
+                templates.push_back( tmpl );
+        registry.addTemplates( templates );
+        t::Monomorphizer( program, registry ).run( parser.getInstantiations() );
+        t::eval::ConstEvaluator( program ).run();
+        auto table = t::analysis::EffectAnalyzer( program ).analyze();
+        t::analysis::selectMemoized( table, false );
+        t::analysis::ConcatFuser( program ).run();
+        t::analysis::MoveAnalyzer( program ).analyze();
+        return t::codegen::CppGenerator( program ).generate();
+    }
+
+    std::string generate( const std::string& src )
+    {
+        t::GenericRegistry registry;
+        return generate( src, registry );
+    }
+
+    // Whether the C++ compiler the tests were built with accepts cpp. True
+    // when the build did not say which compiler that is.
+    bool compiles( const std::string& cpp )
+    {
+#if defined( T_TEST_CXX ) && defined( T_TEST_ROOT )
+        const char* path = "t_tests_generated.cpp";
+        std::ofstream( path, std::ios::binary ) << cpp;
+        const auto command = std::string( "\"" ) + T_TEST_CXX + "\" -std=c++17 -fsyntax-only -Wno-psabi -I \"" + T_TEST_ROOT + "\" " + path;
+        const auto status = std::system( command.c_str() );
+        std::remove( path );
+        return status == 0;
+#else
+        return !cpp.empty();
+#endif
+    }
+}
+
+T_TEST( lexer_operators_and_literals )
+{
+    using T = t::lexer::TokenType;
+    const auto got = types( "x = -5 << 2 != .5; // comment\ny->z :: 'c' \"s\"" );
+    const std::vector< t::lexer::TokenType > expected {
+        T::Identifier, T::Equals, T::negative_integer_literal, T::ShiftLeft, T::integer_literal, T::NotEquals, T::float_literal, T::Semicolon,
+        T::Identifier, T::Pointer, T::Identifier, T::ColonColon, T::char_literal, T::string_literal, T::EOF_
+    };
+    T_CHECK( got == expected );
+}
+
+T_TEST( lexer_keywords_types_and_identifiers )
+{
+    const auto tokens = t::Lexer( "class Point {} Point p; mutable int32 caf\xC3\xA9 = 1" ).tokenize();
+    T_CHECK_EQ( tokens.size(), size_t( 13 ) );
+    T_CHECK( tokens[ 0 ].type == t::lexer::TokenType::class_ );
+    T_CHECK( tokens[ 4 ].type == t::lexer::TokenType::ClassType );
+    T_CHECK( tokens[ 7 ].type == t::lexer::TokenType::mutable_ );
+    T_CHECK( tokens[ 8 ].type == t::lexer::TokenType::PrimitiveType );
+    T_CHECK( tokens[ 9 ].type == t::lexer::TokenType::Identifier );
+    T_CHECK_EQ( tokens[ 9 ].value, std::string( "caf\xC3\xA9" ) );
+    T_CHECK( tokens[ 11 ].type == t::lexer::TokenType::integer_literal );
+}
+
+T_TEST( lexer_class_names_belong_to_one_module )
+{
+    t::Lexer first { "class Point {}" };
+    first.tokenize();
+    T_CHECK( first.getClassNames().count( "Point" ) == 1 );
+
+    // Another module only knows the names it is handed
+    T_CHECK( t::Lexer( "Point p;" ).tokenize()[ 0 ].type == t::lexer::TokenType::Identifier );
+    T_CHECK( t::Lexer( "Point p;", first.getClassNames() ).tokenize()[ 0 ].type == t::lexer::TokenType::ClassType );
+}
+
+T_TEST( lexer_rejects_invalid_utf8 )
+{
+    T_CHECK_THROWS( t::Lexer( "x = \xC3" ).tokenize() );
+}
+
+T_TEST( lexer_trivia_round_trips_source )
+{
+    const std::string src = "\xEF\xBB\xBF// header\r\nint32 x = -5;  // five\n\n\tString s = \"\" + \"a b\";\nchar c = '\\n';\n// end\n";
+    t::lexer::Trivia trivia;
+    const auto tokens = t::Lexer( src ).tokenize( trivia );
+    T_CHECK_EQ( trivia.size(), tokens.size() );
+
+    std::string rebuilt = "\xEF\xBB\xBF";
+    for ( size_t n = 0; n < trivia.size(); n++ )
+        rebuilt += std::string( trivia.leading( n ) ) + std::string( trivia.spelling( n ) );
+    T_CHECK( rebuilt == src );
+
+    // The token stream is the same as without capture
+    T_CHECK( types( src ) == types( trivia.getSource() ) );
+    T_CHECK_EQ( tokens.size(), size_t( 18 ) );
+    T_CHECK_EQ( std::string( trivia.spelling( 3 ) ), std::string( "-5" ) );
+    T_CHECK_EQ( std::string( trivia.spelling( 8 ) ), std::string( "\"\"" ) );
+    T_CHECK_EQ( tokens[ 15 ].value, std::string( "\\n" ) );
+    T_CHECK_EQ( trivia.comments( 0 ).size(), size_t( 1 ) );
+    T_CHECK_EQ( std::string( trivia.comments( 0 )[ 0 ] ), std::string( "// header" ) );
+    T_CHECK_EQ( std::string( trivia.comments( 5 )[ 0 ] ), std::string( "// five" ) );
+    T_CHECK_EQ( trivia.newlines( 5 ), size_t( 2 ) );
+    T_CHECK_EQ( std::string( trivia.comments( tokens.size() - 1 )[ 0 ] ), std::string( "// end" ) );
+}
+
+T_TEST( parser_top_level_declarations )
+{
+    const auto program = parse( "class Box { public: Box constructor() {} private: int32 size; }\n"
+                                "int32 twice( int32 x ) { return x * 2; }\n"
+                                "namespace geo { double pi = 3.14; }\n" );
+    const auto& body = program.getBody();
+    T_CHECK_EQ( body.size(), size_t( 3 ) );
+    const auto cls = body[ 0 ].as< t::ast::Expression >()->as< t::ast::ClassDeclaration >();
+    T_CHECK( cls != nullptr );
+    if ( cls )
+        T_CHECK_EQ( cls->getType().getName(), std::string( "Box" ) );
+    T_CHECK( body[ 1 ].as< t::ast::Expression >()->is< t::ast::FunctionDeclaration >() );
+    T_CHECK( body[ 2 ].as< t::ast::Expression >()->is< t::ast::NameSpaceDeclaration >() );
+}
+
+T_TEST( constexpr_folds_at_build_time )
+{
+    auto program = parse( "constexpr int64 square( int64 x ) { return x * x; }\nconstexpr int64 area = square( 7 );\n" );
+    t::eval::ConstEvaluator evaluator { program };
+    evaluator.run();
+    const auto& constants = evaluator.getConstants();
+    const auto it = constants.find( "area" );
+    T_CHECK( it != constants.cend() );
+    if ( it != constants.cend() )
+        T_CHECK( std::visit( []( const auto& v ){
+            using V = std::decay_t< decltype( v ) >;
+            if constexpr ( std::is_arithmetic_v< V > && !std::is_same_v< V, bool > )
+                return v == 49;
+            else
+                return false;
+        }, it->second ) );
+}
+
+T_TEST( schema_flattens_nested_classes )
+{
+    const auto program = parse( "class Point { public: double x; double y; }\n"
+                                "class Segment { public: Point a; Point b; uint8 width; }\n"
+                                "class Node { public: Node~ next; }\n" );
+    t::analysis::SchemaBuilder builder { program };
+    const auto& schema = builder.schemaFor( "Segment" );
+    T_CHECK_EQ( schema.fields.size(), size_t( 5 ) );
+    T_CHECK_EQ( schema.indexOf( "b.y" ), size_t( 3 ) );
+    T_CHECK_EQ( schema.fixedSize, uint32_t( 33 ) );
+    T_CHECK_THROWS( builder.schemaFor( "Node" ) );
+}
+
+T_TEST( generics_are_monomorphized_once )
+{
+    t::Parser parser { t::Lexer( "template< T > T identity( T x ) { return x; }\n"
+                                 "int32 a = identity< int32 >( 5 );\n"
+                                 "int32 b = identity< int32 >( 6 );\n" ).tokenize() };
+    auto program = parser.produceAST();
+    const auto before = program.getBody().size();
+    t::GenericRegistry registry;
+    registry.addTemplates( parser.getTemplates() );
+    const auto added = t::Monomorphizer( program, registry ).run( parser.getInstantiations() );
+    T_CHECK_EQ( added.size(), size_t( 1 ) );
+    T_CHECK_EQ( program.getBody().size(), before + 1 );
+    T_CHECK( registry.isEmitted( t::Parser::mangle( "identity", { "int32" } ) ) );
+}
+
+T_TEST( specializations_precede_their_first_use )
+{
+    const std::string templates =
+        "template< T > T identity( T x ) { return x; }\n"
+        "template< T > class Box { public: Box constructor() {} T get() { return v; } private: mutable T v; }\n";
+    t::GenericRegistry registry;
+    const auto first = generate( templates +
+        "class Holder { public: Holder constructor() {} private: Box< Box< int32 > > b; }\n"
+        "int32 q = identity< int32 >( 5 );\n", registry );
+    T_CHECK( first.find( "class Box__int32\n{" ) < first.find( "class Box__Box__int32\n{" ) );
+    T_CHECK( first.find( "class Box__Box__int32\n{" ) < first.find( "class Holder\n{" ) );
+    T_CHECK( first.find( "int32_t identity__int32(" ) < first.find( "q = identity__int32( 5 );" ) );
+    T_CHECK( compiles( first ) );
+
+    // A second module defines the class again but only declares the
+    // function the first one already defined
+    const auto second = generate( templates + "Box< int32 > box;\nint32 r = identity< int32 >( 6 );\n", registry );
+    T_CHECK( second.find( "class Box__int32\n{" ) != std::string::npos );
+    T_CHECK( second.find( "int32_t identity__int32( const int32_t x );" ) != std::string::npos );
+    T_CHECK( second.find( "int32_t identity__int32( const int32_t x )\n{" ) == std::string::npos );
+    T_CHECK( compiles( second ) );
+}
+
+T_TEST( declaration_shapes )
+{
+    const auto program = parse( "template< T > class Box { public: T value; }\n"
+                                "class Holder { public: mutable int32~ count; memoize int64 total( int64 n ) { return n; } Box< Box< int32 >> nested; }\n"
+                                "mutable String-> name;\n"
+                                "Box< int32 > make( int32 v ) { return v; }\n"
+                                "mutable double ratio = 0.5;\n" );
+    const auto& body = program.getBody();
+    T_CHECK_EQ( body.size(), size_t( 5 ) );
+    const auto holder = body[ 1 ].as< t::ast::Expression >()->as< t::ast::ClassDeclaration >();
+    T_CHECK( holder != nullptr );
+    if ( holder )
+    {
+        T_CHECK_EQ( holder->getFields().size(), size_t( 2 ) );
+        T_CHECK_EQ( holder->getMethods().size(), size_t( 1 ) );
+    }
+    T_CHECK( body[ 2 ].as< t::ast::Expression >()->is< t::ast::VariableDeclaration >() );
+    T_CHECK( body[ 3 ].as< t::ast::Expression >()->is< t::ast::FunctionDeclaration >() );
+    T_CHECK( body[ 4 ].as< t::ast::Expression >()->is< t::ast::VariableDeclaration >() );
+
+    T_CHECK_THROWS( parse( "int32 = 5;" ) );
+    T_CHECK_THROWS( parse( "Box< int32 x;" ) );
+    T_CHECK_THROWS( parse( "template< T > class Box { public: T value; }\nBox< int32 >> x;" ) );
+}
+
+T_TEST( parallel_parse_matches_sequential )
+{
+    std::string src = "template< T > class Box { public: T value; }\n";
+    for ( int n = 0; n < 400; n++ )
+    {
+        const auto id = std::to_string( n );
+        src += "class C" + id + " { public: int32 get() { return " + id + "; } private: int32 v; }\n";
+        src += "namespace ns" + id + " { double f( double x ) { if ( x == 1 ) { return x; } return x * 2; } }\n";
+        src += "template< T > T id" + id + "( T x ) { return x; }\n";
+        src += "mutable int64 v" + id + " = id" + id + "< int64 >( " + id + " );\n";
+        src += "Box< Box< Box< int" + std::to_string( 8 << n % 4 ) + " >>> box" + id + ";\n";
+    }
+    const auto tokens = t::Lexer( src ).tokenize();
+
+    const auto print = []( const t::ast::Program& program ){
+        std::ostringstream out;
+        const auto old = std::cout.rdbuf( out.rdbuf() );
+        program.print();
+        std::cout.rdbuf( old );
+        return out.str();
+    };
+
+    t::Parser sequential { tokens };
+    const auto expected = print( sequential.produceAST() );
+
+    t::ThreadPool pool { 4 };
+    t::Parser parallel { tokens };
+    const auto got = print( parallel.produceAST( pool ) );
+    T_CHECK( got == expected );
+    T_CHECK_EQ( parallel.getTemplates().size(), sequential.getTemplates().size() );
+    T_CHECK_EQ( parallel.getInstantiations().size(), sequential.getInstantiations().size() );
+    for ( size_t n = 0; n < sequential.getInstantiations().size(); n++ )
+        T_CHECK_EQ( parallel.getInstantiations()[ n ].mangled, sequential.getInstantiations()[ n ].mangled );
+
+    // An error in any group is reported as the sequential parser reports it
+    auto broken = src + "int32 = 4;\n" + src;
+    std::string sequentialError, parallelError;
+    try { t::Parser( t::Lexer( broken ).tokenize() ).produceAST(); } catch ( const std::exception& e ) { sequentialError = e.what(); }
+    try { t::Parser( t::Lexer( broken ).tokenize() ).produceAST( pool ); } catch ( const std::exception& e ) { parallelError = e.what(); }
+    T_CHECK( !sequentialError.empty() );
+    T_CHECK_EQ( parallelError, sequentialError );
+}
+
+T_TEST( thread_pool_runs_every_index )
+{
+    t::ThreadPool pool { 4 };
+    std::vector< int > hits( 10000 );
+    pool.parallelFor( hits.size(), [ & ]( size_t n ){ hits[ n ]++; } );
+    T_CHECK( std::all_of( hits.cbegin(), hits.cend(), []( int h ){ return h == 1; } ) );
+
+    // Uneven work gets stolen, every index still runs once on a valid thread
+    std::vector< size_t > threads( 2000, pool.size() );
+    pool.parallelFor( threads.size(), [ & ]( size_t n, size_t thread ){
+        if ( n < 10 )
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        threads[ n ] = thread;
+    } );
+    T_CHECK( std::all_of( threads.cbegin(), threads.cend(), [ & ]( size_t t ){ return t < pool.size(); } ) );
+
+    // The lowest failing index wins no matter which thread got there first
+    try
+    {
+        pool.parallelFor( 1000, []( size_t n ){ if ( n % 100 == 7 ) throw std::runtime_error( std::to_string( n ) ); } );
+        T_CHECK( false );
+    }
+    catch ( const std::runtime_error& e )
+    {
+        T_CHECK_EQ( std::string( e.what() ), std::string( "7" ) );
+    }
+}
+
+T_TEST( checker_reports_body_errors_in_declaration_order )
+{
+    std::string src = "class Counter { public: int32 next() { count = count + 1; return count; } void reset() { return count; } private: int32 count; }\n"
+                      "int32 add( int32 a, int32 b ) { return a + b; }\n"
+                      "int32 add( int32 a, int32 b, int32 c ) { return a + b + c; }\n"
+                      "template< T > T identity( T x ) { return x; }\n"
+                      "int32 ok( int32 v ) { int32 w = add( v, 1 ); for ( int32 e in w ) { w = e; } return identity< int32 >( w ); }\n"
+                      "namespace shapes { class Widget { public: int32 size; } }\n"
+                      "namespace maths { double half( double x ) { return x / 2; } double quarter( double x ) { return half( half( x ) ); } }\n"
+                      "int32 broken( Widget w ) { int32 n = add( 1 ); if ( n == 0 ) { int32 inner = 1; } return inner + missing( n ); }\n";
+    for ( int n = 0; n < 200; n++ )
+    {
+        const auto id = std::to_string( n );
+        src += "int32 f" + id + "( int32 x ) { return x + y" + id + "; }\n";
+    }
+    auto program = parse( src );
+
+    const auto sequential = t::analysis::Checker( program ).check();
+    std::vector< std::string > messages;
+    for ( const auto& diag : sequential )
+        messages.push_back( diag.function + ": " + diag.message );
+    T_CHECK_EQ( messages.size(), size_t( 205 ) );
+    if ( messages.size() == 205 )
+    {
+        T_CHECK_EQ( messages[ 0 ], std::string( "Counter::reset: void function returns a value" ) );
+        T_CHECK_EQ( messages[ 1 ], std::string( "broken: unknown type 'Widget'" ) );
+        T_CHECK_EQ( messages[ 2 ], std::string( "broken: no overload of 'add' takes 1 arguments" ) );
+        T_CHECK_EQ( messages[ 3 ], std::string( "broken: 'inner' is not declared" ) );
+        T_CHECK_EQ( messages[ 4 ], std::string( "broken: call to undeclared function 'missing'" ) );
+        T_CHECK_EQ( messages[ 5 ], std::string( "f0: 'y0' is not declared" ) );
+        T_CHECK_EQ( messages[ 204 ], std::string( "f199: 'y199' is not declared" ) );
+    }
+
+    t::ThreadPool pool { 4 };
+    const auto parallel = t::analysis::Checker( program ).check( pool );
+    T_CHECK_EQ( parallel.size(), sequential.size() );
+    for ( size_t n = 0; n < std::min( parallel.size(), sequential.size() ); n++ )
+        T_CHECK_EQ( parallel[ n ].function + ": " + parallel[ n ].message, messages[ n ] );
+}
+
+T_TEST( codegen_output_does_not_depend_on_threads )
+{
+    std::string src = "class Counter { public: Counter constructor() {} int32 get() { return count; } private: mutable int32 count; }\n"
+                      "memoize int64 square( int64 x ) { return x * x; }\n"
+                      "mutable Counter counter;\n";
+    for ( int n = 0; n < 300; n++ )
+    {
+        const auto id = std::to_string( n );
+        src += "namespace ns" + id + " { double f( double x ) { if ( x == 1 ) { return x ** 2; } return x / " + id + ".5; } }\n";
+    }
+    auto program = parse( src );
+
+    const auto sequential = t::codegen::CppGenerator( program ).generate();
+    t::ThreadPool pool { 4 };
+    T_CHECK( t::codegen::CppGenerator( program ).generate( pool ) == sequential );
+
+    const auto contains = [ & ]( const std::string& text ){ return sequential.find( text ) != std::string::npos; };
+    T_CHECK( contains( "class Counter\n{\npublic:\n    Counter();\n    int32_t get();\nprivate:\n    int32_t count;\n};\n" ) );
+    T_CHECK( contains( "static thread_local t::runtime::MemoCache< int64_t > memo;" ) );
+    T_CHECK( contains( "namespace ns299\n{\n    double f( const double x )\n" ) );
+    T_CHECK( contains( "        if ( x == 1 )\n        {\n            return std::pow( x, 2 );\n        }\n" ) );
+    T_CHECK( sequential.find( "ns0" ) < sequential.find( "ns1\n" ) );
+
+    T_CHECK_EQ( t::codegen::CppGenerator::cppName( "Box<Map<String,int32>>" ), std::string( "Box__Map__String_int32" ) );
+    T_CHECK_EQ( t::codegen::CppGenerator::cppType( t::ast::TypeName( "Map<String,int32>", false, true, false ) ),
+                std::string( "const t::runtime::Map< t::runtime::String, int32_t >&" ) );
+}
+
+T_TEST( codegen_methods_that_write_nothing_are_const )
+{
+    const auto cpp = generate(
+        "template< T > class Box { public: Box constructor() {} T get() { return v; } void set( T x ) { v = x; } "
+        "mutable T~ ref() { return v; } private: mutable T v; }\n"
+        "int32 use( Box< int32 >~ b ) { return b.get(); }\n" );
+    T_CHECK( cpp.find( "int32_t get() const;" ) != std::string::npos );
+    T_CHECK( cpp.find( "int32_t Box__int32::get() const\n" ) != std::string::npos );
+    T_CHECK( cpp.find( "void set( const int32_t x );" ) != std::string::npos );
+    T_CHECK( cpp.find( "int32_t& ref();" ) != std::string::npos );
+    T_CHECK( compiles( cpp ) );
+}
+
+T_TEST( codegen_escapes_names_the_output_relies_on )
+{
+    // Each of these would otherwise shadow or redefine t::runtime, std or
+    // the memo cache of a memoized function
+    const auto cpp = generate(
+        "namespace runtime { int64 twice( int64 memo ) { return memo * 2; } }\n"
+        "memoize int64 std( int64 t ) { return t + 1; }\n"
+        "String greet( String std_ ) { String t = std_ + \"!\"; return t; }\n" );
+    T_CHECK( cpp.find( "namespace runtime_\n" ) != std::string::npos );
+    T_CHECK( cpp.find( "int64_t twice( const int64_t memo_ )" ) != std::string::npos );
+    T_CHECK( cpp.find( "int64_t std_( const int64_t t_ )" ) != std::string::npos );
+    T_CHECK( cpp.find( "String greet( const t::runtime::String std__ )" ) != std::string::npos );
+    T_CHECK( compiles( cpp ) );
+}
+
+T_TEST( text_arena_pieces_survive_growth )
+{
+    t::codegen::TextArena arena { 16 };
+    std::vector< std::string_view > pieces;
+    for ( int n = 0; n < 100; n++ )
+    {
+        arena.append( "piece " );
+        arena.append( std::to_string( n ) );
+        pieces.push_back( arena.finish() );
+    }
+    for ( int n = 0; n < 100; n++ )
+        T_CHECK_EQ( std::string( pieces[ n ] ), "piece " + std::to_string( n ) );
+}
+
+T_TEST( hash_consing_shares_immutable_subtrees )
+{
+    t::ast::HashConsTable table;
+    t::Parser parser { t::Lexer( "int64 a = 1 + 2 * x;\n"
+                                 "int64 b = 1 + 2 * x;\n"
+                                 "int64 c = 1 + 2 * y;\n"
+                                 "int64 d = f( 1 + 2 * x );\n"
+                                 "mutable int64 e = z = 3;\n"
+                                 "int64 x = 4;\n"
+                                 "int64 y = 5;\n" ).tokenize() };
+    parser.setHashConsing( &table );
+    const auto program = parser.produceAST();
+    const auto value = [ & ]( size_t n ){
+        return program.getBody()[ n ].as< t::ast::Expression >()->as< t::ast::VariableDeclaration >()->getValue();
+    };
+
+    T_CHECK( value( 0 )->getConsId() != 0 );
+    T_CHECK( value( 0 )->sameStructure( *value( 1 ) ) );
+    T_CHECK( !value( 0 )->sameStructure( *value( 2 ) ) );
+    // A call is not interned, its arguments are
+    const auto call = value( 3 )->as< t::ast::FunctionCall >();
+    T_CHECK_EQ( call->getConsId(), uint32_t( 0 ) );
+    T_CHECK( call->getParameters()[ 0 ].as< t::ast::Expression >()->sameStructure( *value( 0 ) ) );
+    T_CHECK_EQ( value( 4 )->getConsId(), uint32_t( 0 ) );
+
+    // Every int64 type name is one shape
+    const auto type = [ & ]( size_t n ){
+        return &program.getBody()[ n ].as< t::ast::Expression >()->as< t::ast::VariableDeclaration >()->getType();
+    };
+    T_CHECK( type( 0 )->sameStructure( *type( 3 ) ) );
+    T_CHECK( !type( 0 )->sameStructure( *type( 4 ) ) );
+    T_CHECK( table.size() < table.internedNodes() );
+}
+
+T_TEST( hash_consing_keys_reads_by_binding )
+{
+    t::ast::HashConsTable table;
+    t::Parser parser { t::Lexer( "mutable int64 g = 1;\n"
+                                 "void f( int64 p )\n"
+                                 "{\n"
+                                 "    mutable int64 x = 1;\n"
+                                 "    int64 a = x + 1;\n"
+                                 "    x = 5;\n"
+                                 "    int64 b = x + 1;\n"
+                                 "    int64 c = g + 1;\n"
+                                 "    int64 d = p + 1;\n"
+                                 "    int64 e = p + 1;\n"
+                                 "    if ( p == 1 ) { int64 p = 2; int64 h = p + 1; }\n"
+                                 "}\n" ).tokenize() };
+    parser.setHashConsing( &table );
+    const auto program = parser.produceAST();
+    const auto& body = program.getBody()[ 1 ].as< t::ast::Expression >()->as< t::ast::FunctionDeclaration >()->getBody();
+    const auto value = [ & ]( const t::ast::StatementList& stmts, size_t n ){
+        return stmts[ n ].as< t::ast::Expression >()->as< t::ast::VariableDeclaration >()->getValue();
+    };
+
+    // Reads of a mutable local or global may see different values
+    T_CHECK_EQ( value( body, 1 )->getConsId(), uint32_t( 0 ) );
+    T_CHECK_EQ( value( body, 3 )->getConsId(), uint32_t( 0 ) );
+    T_CHECK_EQ( value( body, 4 )->getConsId(), uint32_t( 0 ) );
+    T_CHECK( value( body, 5 )->sameStructure( *value( body, 6 ) ) );
+
+    // The inner p is another binding with the same spelling
+    const auto& inner = body[ 7 ].as< t::ast::Expression >()->as< t::ast::IfStatement >()->getBody();
+    T_CHECK( value( inner, 1 )->getConsId() != 0 );
+    T_CHECK( !value( inner, 1 )->sameStructure( *value( body, 5 ) ) );
+}
+
+T_TEST( diff_reports_only_changed_declarations )
+{
+    const std::string before =
+        "namespace shapes { class Box { public: double area() { return w * w; } private: double w; } }\n"
+        "int64 twice( int64 x ) { return x * 2; }\n"
+        "int64 twice( double x ) { return 2; }\n"
+        "template< T > T id( T x ) { return x; }\n"
+        "mutable int64 total = twice( 3 );\n";
+    const auto base = parse( before );
+    T_CHECK( base.getBody()[ 1 ].as< t::ast::Expression >()->getHash() != 0 );
+
+    // Comments and layout do not reach the tree
+    T_CHECK( t::ast::diff( base, parse( "// sizes\n" + before + "\n\n" ) ).empty() );
+
+    const auto edited = parse(
+        "namespace shapes { class Box { public: double area() { return w * w * 1; } private: double w; } }\n"
+        "int64 twice( int64 x ) { return x * 2; }\n"
+        "int64 twice( double x ) { return 3; }\n"
+        "mutable int64 total = twice( 3 );\n"
+        "int64 half( int64 x ) { return x / 2; }\n" );
+    const auto changes = t::ast::diff( base, edited );
+    T_CHECK_EQ( changes.size(), size_t( 5 ) );
+    T_CHECK( changes[ 0 ].kind == t::ast::DeclarationChange::Changed );
+    T_CHECK_EQ( changes[ 0 ].name, std::string( "shapes::Box::area()" ) );
+    T_CHECK_EQ( changes[ 1 ].name, std::string( "twice(double)" ) );
+    T_CHECK( changes[ 2 ].kind == t::ast::DeclarationChange::Added );
+    T_CHECK_EQ( changes[ 2 ].name, std::string( "half(int64)" ) );
+    T_CHECK( changes[ 3 ].kind == t::ast::DeclarationChange::Removed );
+    T_CHECK_EQ( changes[ 3 ].name, std::string( "template id" ) );
+    // total calls twice, which has a changed overload
+    T_CHECK( changes[ 4 ].kind == t::ast::DeclarationChange::Affected );
+    T_CHECK_EQ( changes[ 4 ].name, std::string( "total" ) );
+
+    // Changes reach callers of callers and the methods of a changed class
+    const auto calls = [ & ]( const std::string& leaf, const std::string& field ){
+        return parse( "class Point { public: int64 sum() { return x + 1; } private: " + field + " x; }\n"
+                      "int64 leaf( int64 x ) { return " + leaf + "; }\n"
+                      "int64 middle( int64 x ) { return leaf( x ); }\n"
+                      "int64 top( int64 x ) { return middle( x ); }\n"
+                      "int64 other( int64 x ) { return x; }\n"
+                      "top( 1 );\n" );
+    };
+    const auto propagated = t::ast::diff( calls( "x", "int64" ), calls( "x + 1", "int32" ) );
+    std::vector< std::string > names;
+    for ( const auto& change : propagated )
+        names.push_back( change.name );
+    T_CHECK( names == std::vector< std::string >( { "Point", "leaf(int64)", "Point::sum()", "middle(int64)", "top(int64)", "statement #1" } ) );
+
+    // Groups parsed on the pool hash the same as one sequential parse
+    std::string src;
+    for ( int n = 0; n < 200; n++ )
+        src += before;
+    t::ThreadPool pool { 4 };
+    const auto tokens = t::Lexer( src ).tokenize();
+    const auto sequential = t::ast::declarationHashes( t::Parser( tokens ).produceAST() );
+    const auto parallel = t::ast::declarationHashes( t::Parser( tokens ).produceAST( pool ) );
+    T_CHECK_EQ( parallel.size(), sequential.size() );
+    for ( size_t n = 0; n < sequential.size(); n++ )
+    {
+        T_CHECK_EQ( parallel[ n ].name, sequential[ n ].name );
+        T_CHECK_EQ( parallel[ n ].hash, sequential[ n ].hash );
+    }
+}
+
+T_TEST( formatter_lays_out_tokens_and_keeps_comments )
+{
+    const std::string messy =
+        "namespace shapes{class Box{public:double area(){return w*w;}   // area\n\n\n\n"
+        "private:\n double w;}}\n"
+        "template<T> T id(T x){return x;}\n"
+        "mutable int64 v=id<int64>(3);\n"
+        "int32 f(int32 a,\n  // why\n  int32 b)\n{\n\n  if(a==b){\n    return a+b; // sum\n  }\n  return x . y;\n}\n";
+    const std::string expected =
+        "namespace shapes\n{\n\tclass Box\n\t{\n\tpublic:\n\t\tdouble area() { return w * w; } // area\n\n"
+        "\tprivate:\n\t\tdouble w;\n\t}\n}\n"
+        "template< T > T id( T x ) { return x; }\n"
+        "mutable int64 v = id< int64 >( 3 );\n"
+        "int32 f( int32 a,\n\t// why\n\tint32 b )\n{\n\tif ( a == b )\n\t{\n\t\treturn a + b; // sum\n\t}\n\treturn x.y;\n}\n";
+    const auto formatted = t::format::formatSource( messy );
+    T_CHECK( formatted == expected );
+    T_CHECK( t::format::formatSource( formatted ) == formatted );
+
+    t::format::Style spaces;
+    spaces.indentWidth = 4;
+    T_CHECK( t::format::formatSource( "if(a==b){\nc=1;\n}" , spaces ) == "if ( a == b )\n{\n    c = 1;\n}\n" );
+
+    // Formatting never changes what the source lexes to
+    std::string src;
+    for ( int n = 0; n < 50; n++ )
+        src += messy + "String-> p" + std::to_string( n ) + ";\nMap<String,int32> m" + std::to_string( n ) + ";\n";
+    const auto spelled = []( const std::string& text ){
+        t::lexer::Trivia trivia;
+        const auto tokens = t::Lexer( text ).tokenize( trivia );
+        std::vector< std::string > result;
+        for ( size_t n = 0; n < tokens.size(); n++ )
+            result.emplace_back( trivia.spelling( n ) );
+        return result;
+    };
+    T_CHECK( spelled( t::format::formatSource( src ) ) == spelled( src ) );
+}
+
+namespace
+{
+    const t::ast::FunctionDeclaration& function( const t::ast::Program& program, size_t n )
+    {
+        return *program.getBody()[ n ].as< t::ast::Expression >()->as< t::ast::FunctionDeclaration >();
+    }
+
+    const t::ast::Expression* statement( const t::ast::FunctionDeclaration& func, size_t n )
+    {
+        return func.getBody()[ n ].as< t::ast::Expression >();
+    }
+
+    t::ast::Ownership returned( const t::ast::FunctionDeclaration& func, size_t n )
+    {
+        return statement( func, n )->as< t::ast::ReturnStatement >()->getStatement().as< t::ast::Expression >()->as< t::ast::Identifier >()->getOwnership();
+    }
+}
+
+T_TEST( move_analysis_moves_last_uses_only )
+{
+    auto program = parse(
+        "void take( String a, String b ) {}\n"
+        "String passOn( String s ) { String t = s; return t; }\n"
+        "String shadowed( String s, int32 c ) { mutable String t = s; if ( c == 1 ) { String s = \"inner\"; } return s; }\n"
+        "void twice( String s ) { take( s, s ); }\n"
+        "void looped( String s, String xs ) { for ( char ch in xs ) { take( s, \"x\" ); } }\n" );
+    t::analysis::MoveAnalyzer( program ).analyze();
+    using t::ast::Ownership;
+    const auto initializer = []( const t::ast::FunctionDeclaration& func ){
+        return statement( func, 0 )->as< t::ast::VariableDeclaration >()->getValue()->as< t::ast::Identifier >()->getOwnership();
+    };
+
+    T_CHECK( initializer( function( program, 1 ) ) == Ownership::ImplicitMove );
+    T_CHECK( returned( function( program, 1 ), 1 ) == Ownership::ImplicitMove );
+
+    // The inner s goes out of scope with the if, the return is the outer s
+    T_CHECK( initializer( function( program, 2 ) ) == Ownership::Copy );
+    T_CHECK( returned( function( program, 2 ), 2 ) == Ownership::ImplicitMove );
+
+    const auto& args = statement( function( program, 3 ), 0 )->as< t::ast::FunctionCall >()->getParameters();
+    for ( const auto& arg : args )
+        T_CHECK( arg.as< t::ast::Expression >()->as< t::ast::Identifier >()->getOwnership() == Ownership::Copy );
+
+    const auto& loop = *statement( function( program, 4 ), 0 )->as< t::ast::ForInStatement >();
+    const auto call = loop.getBody()[ 0 ].as< t::ast::Expression >()->as< t::ast::FunctionCall >();
+    T_CHECK( call->getParameters()[ 0 ].as< t::ast::Expression >()->as< t::ast::Identifier >()->getOwnership() == Ownership::Copy );
+
+    auto moved = parse( "void take( String a, String b ) {}\nvoid f( String s ) { take( s, move s ); }\n" );
+    T_CHECK_THROWS( t::analysis::MoveAnalyzer( moved ).analyze() );
+    auto reused = parse( "String f( String s ) { String t = move s; return s; }\n" );
+    T_CHECK_THROWS( t::analysis::MoveAnalyzer( reused ).analyze() );
+}
+
+T_TEST( codegen_keeps_moved_locals_movable )
+{
+    auto program = parse(
+        "void take( String a ) {}\n"
+        "String passOn( String s ) { String t = s; return t; }\n"
+        "void kept( String s ) { String t = \"x\"; take( t ); if ( t == \"y\" ) {} take( s ); }\n" );
+    t::analysis::MoveAnalyzer( program ).analyze();
+    const auto out = t::codegen::CppGenerator( program ).generate();
+    const auto contains = [ & ]( const std::string& text ){ return out.find( text ) != std::string::npos; };
+
+    // A local named t would hide the t:: namespace, so it is escaped
+    T_CHECK( contains( "t::runtime::String passOn( t::runtime::String s )\n{\n    t::runtime::String t_ = std::move( s );\n    return t_;\n}\n" ) );
+    // t is only ever copied, so only s loses its const
+    T_CHECK( contains( "void kept( t::runtime::String s )\n{\n    const t::runtime::String t_ = t::runtime::String( \"x\" );\n" ) );
+    T_CHECK( contains( "    take( std::move( s ) );\n" ) );
+}
+
+T_TEST( effect_inference_scopes_locals_per_block )
+{
+    auto program = parse(
+        "mutable int32 g = 0;\n"
+        "int32 pure( int32 x ) { int32 y = x * 2; return y; }\n"
+        "int32 reads( int32 x ) { return x + g; }\n"
+        "void writes( int32 x ) { g = x; }\n"
+        "void afterIf( int32 c ) { if ( c == 1 ) { mutable int32 g = 2; g = 3; } g = 5; }\n"
+        "void afterLoop( int32 c ) { for ( int32 g in c ) {} g = 5; }\n"
+        "void shadowed( int32 c ) { if ( c == 1 ) { mutable int32 g = 2; g = 3; } }\n"
+        "int32 caller( int32 x ) { return reads( x ); }\n" );
+    const auto table = t::analysis::EffectAnalyzer( program ).analyze();
+    using t::ast::Effect;
+    T_CHECK( table.effectOf( "pure" ) == Effect::Pure );
+    T_CHECK( table.effectOf( "reads" ) == Effect::ReadOnly );
+    T_CHECK( table.effectOf( "writes" ) == Effect::Writes );
+    T_CHECK( table.effectOf( "afterIf" ) == Effect::Writes );
+    T_CHECK( table.effectOf( "afterLoop" ) == Effect::Writes );
+    T_CHECK( table.effectOf( "shadowed" ) == Effect::Pure );
+    T_CHECK( table.effectOf( "caller" ) == Effect::ReadOnly );
+}
+
+T_TEST( memoize_requires_a_pure_function )
+{
+    auto impure = parse( "mutable int32 g = 0;\nmemoize int32 bump( int32 x ) { g = g + x; return g; }\n" );
+    auto table = t::analysis::EffectAnalyzer( impure ).analyze();
+    T_CHECK_THROWS( t::analysis::selectMemoized( table, false ) );
+
+    auto pure = parse( "memoize int32 square( int32 x ) { return x * x; }\nint32 twice( int32 x ) { return x + x; }\nvoid none( int32 x ) {}\n" );
+    auto explicitOnly = t::analysis::EffectAnalyzer( pure ).analyze();
+    T_CHECK( t::analysis::selectMemoized( explicitOnly, false ) == std::vector< std::string > { "square" } );
+    auto automatic = t::analysis::EffectAnalyzer( pure ).analyze();
+    T_CHECK( ( t::analysis::selectMemoized( automatic, true ) == std::vector< std::string > { "square", "twice" } ) );
+
+    // The cache could not key on these, asking for one is an error rather than ignored
+    for ( const std::string src : { "memoize int32 size( String s ) { return 1; }\n",
+                                    "memoize int32 first( int32~ x ) { return x; }\n",
+                                    "memoize String name( int32 x ) { return \"n\"; }\n" } )
+    {
+        auto program = parse( src );
+        auto table = t::analysis::EffectAnalyzer( program ).analyze();
+        T_CHECK_THROWS( t::analysis::selectMemoized( table, false ) );
+    }
+}
+
+T_TEST( constexpr_reports_overflow_and_checks_declared_types )
+{
+    const auto fold = []( const std::string& src ){
+        auto program = parse( src );
+        t::eval::ConstEvaluator evaluator { program };
+        evaluator.run();
+        return evaluator.getConstants();
+    };
+    T_CHECK_THROWS( fold( "constexpr int64 m = -9223372036854775807 - 1;\nconstexpr int64 q = m / -1;\n" ) );
+    T_CHECK_THROWS( fold( "constexpr int64 big = 9223372036854775807 + 1;\n" ) );
+    T_CHECK_THROWS( fold( "constexpr int64 big = 3037000500 * 3037000500;\n" ) );
+    T_CHECK_THROWS( fold( "constexpr int64 big = 2 ** 63;\n" ) );
+    T_CHECK_THROWS( fold( "constexpr uint8 small = 200 + 100;\n" ) );
+    T_CHECK_THROWS( fold( "constexpr int32 half = 2.5;\n" ) );
+    T_CHECK_THROWS( fold( "constexpr int32 f() { return 3000000000; }\nconstexpr int64 x = f();\n" ) );
+    T_CHECK_THROWS( fold( "constexpr int64 f( uint8 b ) { return b; }\nconstexpr int64 x = f( 300 );\n" ) );
+    T_CHECK_THROWS( fold( "constexpr uint64 twice( uint64 v ) { return v + v; }\nconstexpr bool same = twice( 9223372036854775807 ) == -2;\n" ) );
+
+    const auto constants = fold( "constexpr int64 m = -9223372036854775807 - 1;\nconstexpr int64 r = m % -1;\n"
+                                 "constexpr uint8 small = 200 + 55;\nconstexpr int64 p = 2 ** 62;\nconstexpr double d = 3;\n" );
+    T_CHECK( std::get< int64_t >( constants.at( "r" ) ) == 0 );
+    T_CHECK( std::get< uint64_t >( constants.at( "small" ) ) == 255 );
+    T_CHECK( std::get< int64_t >( constants.at( "p" ) ) == int64_t( 1 ) << 62 );
+    T_CHECK( std::get< double >( constants.at( "d" ) ) == 3.0 );
+
+    // Arguments and results take the declared type, as they would at run time
+    const auto converted = fold( "constexpr double half( double v ) { return v / 2; }\nconstexpr double h = half( 3 );\n"
+                                 "constexpr uint8 id( uint8 b ) { return b; }\nconstexpr int64 i = id( 255 ) + -1;\n" );
+    T_CHECK( std::get< double >( converted.at( "h" ) ) == 1.5 );
+    T_CHECK( std::get< int64_t >( converted.at( "i" ) ) == 254 );
+}
+
+T_TEST( concat_fuses_nested_string_additions )
+{
+    auto program = parse(
+        "String greet( String name ) { return \"hi \" + name; }\n"
+        "void show( String s ) {}\n"
+        "String chain( String a, String b ) { return a + \"-\" + ( b + \"!\" ) + greet( a + b ); }\n"
+        "void nested( String a, String b ) { show( a + b + \"?\" ); }\n" );
+    T_CHECK_EQ( t::analysis::ConcatFuser( program ).run(), size_t( 4 ) );
+    const auto value = []( const t::ast::FunctionDeclaration& func ){
+        return statement( func, 0 )->as< t::ast::ReturnStatement >()->getStatement().as< t::ast::Expression >();
+    };
+
+    // The parenthesized chain is flattened into the outer one, the argument
+    // of greet is a chain of its own
+    const auto chain = value( function( program, 2 ) )->as< t::ast::ConcatExpression >();
+    T_CHECK( chain != nullptr );
+    T_CHECK_EQ( chain->getParts().size(), size_t( 5 ) );
+    T_CHECK( chain->getParts()[ 3 ]->is< t::ast::StringLiteral >() );
+    const auto call = chain->getParts()[ 4 ]->as< t::ast::FunctionCall >();
+    const auto inner = call->getParameters()[ 0 ].as< t::ast::Expression >()->as< t::ast::ConcatExpression >();
+    T_CHECK( inner != nullptr );
+    T_CHECK_EQ( inner->getParts().size(), size_t( 2 ) );
+
+    const auto argument = statement( function( program, 3 ), 0 )->as< t::ast::FunctionCall >()->getParameters()[ 0 ].as< t::ast::Expression >();
+    T_CHECK( argument->is< t::ast::ConcatExpression >() );
+    T_CHECK_EQ( argument->as< t::ast::ConcatExpression >()->getParts().size(), size_t( 3 ) );
+}
+
+T_TEST( concat_leaves_other_additions_alone )
+{
+    auto program = parse(
+        "String s = \"global\";\n"
+        "int64 count( int64 n ) { return n; }\n"
+        "int64 numbers( int64 x, int64 y ) { return x + y * 2; }\n"
+        "int64 shadowed( int64 s ) { return s + count( s + 1 ); }\n"
+        "double halves( double d ) { return d + 0.5; }\n"
+        "int64 inner( int64 x ) { if ( x == 1 ) { String x = \"a\"; } return x + 1; }\n"
+        "int64 looped( int64 x, String xs ) { for ( String x in xs ) {} return x + 1; }\n" );
+    T_CHECK_EQ( t::analysis::ConcatFuser( program ).run(), size_t( 0 ) );
+    const auto value = []( const t::ast::FunctionDeclaration& func ){
+        return statement( func, 0 )->as< t::ast::ReturnStatement >()->getStatement().as< t::ast::Expression >();
+    };
+    for ( size_t n = 2; n < 5; n++ )
+        T_CHECK( value( function( program, n ) )->is< t::ast::BinaryExpression >() );
+    // The String x declared in a block is out of scope at the return
+    T_CHECK( statement( function( program, 5 ), 1 )->as< t::ast::ReturnStatement >()->getStatement().as< t::ast::Expression >()->is< t::ast::BinaryExpression >() );
+    T_CHECK( statement( function( program, 6 ), 1 )->as< t::ast::ReturnStatement >()->getStatement().as< t::ast::Expression >()->is< t::ast::BinaryExpression >() );
+}
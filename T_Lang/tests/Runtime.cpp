@@ -0,0 +1,285 @@
+#include "Test.h"
+
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+
+#include "../t/runtime/AsyncIo.h"
+#include "../t/runtime/File.h"
+#include "../t/runtime/Format.h"
+#include "../t/runtime/Json.h"
+#include "../t/runtime/Map.h"
+#include "../t/runtime/Serial.h"
+#include "../t/runtime/StringKernels.h"
+
+using namespace t::runtime;
+
+T_TEST( utf8_validation_and_code_points )
+{
+    T_CHECK( utf8::validate( "caf\xC3\xA9 \xF0\x9F\x98\x80" ) );
+    T_CHECK( !utf8::validate( "\xC0\xAF" ) );
+    T_CHECK( !utf8::validate( "\xED\xA0\x80" ) );
+    const String s { std::string( "caf\xC3\xA9!" ) };
+    T_CHECK_EQ( s.codePoints(), size_t( 5 ) );
+    T_CHECK( s.slice( 3, 5 ).view() == "\xC3\xA9" );
+    T_CHECK_THROWS( s.slice( 3, 4 ) );
+    T_CHECK_THROWS( String( std::string( "\xFF" ) ) );
+}
+
+T_TEST( string_move_leaves_source_empty )
+{
+    String a { std::string( "a string long enough to live on the heap" ) };
+    const auto size = a.size();
+    String b { std::move( a ) };
+    T_CHECK_EQ( b.size(), size );
+    T_CHECK( a.empty() && a.view() == "" );
+    T_CHECK_EQ( a.codePoints(), size_t( 0 ) );
+
+    String c;
+    c = std::move( b );
+    T_CHECK_EQ( c.size(), size );
+    T_CHECK( b.empty() && b.view() == "" );
+    b = c;
+    T_CHECK( b == c );
+}
+
+T_TEST( string_kernels_match_string_view_on_every_tier )
+{
+    // Small alphabets so needles are found, lengths that end on either side
+    // of the 16, 32 and 64 byte blocks; the text is allocated to its exact
+    // size so a kernel that reads past the end shows up under a sanitizer
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    const auto next = [ & ]( uint64_t bound ){
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return ( state >> 33 ) % bound;
+    };
+    const auto text = [ & ]( size_t len ){
+        std::vector< char > bytes( len );
+        for ( auto& c : bytes )
+            c = "ab,c"[ next( 4 ) ];
+        return bytes;
+    };
+
+    for ( const auto tier : { strings::Scalar, strings::SSE42, strings::AVX2 } )
+    {
+        if ( ( tier == strings::SSE42 && !cpuFeatures().sse42 ) || ( tier == strings::AVX2 && !cpuFeatures().avx2 ) )
+            continue;
+        strings::useTier( tier );
+        for ( size_t len = 0; len < 200; len++ )
+        {
+            const auto hayBytes = text( len );
+            const std::string_view hay { hayBytes.data(), hayBytes.size() };
+            for ( size_t trial = 0; trial < 4; trial++ )
+            {
+                const auto needleBytes = text( next( 20 ) );
+                const std::string_view needle { needleBytes.data(), needleBytes.size() };
+                const auto from = next( len + 2 );
+                T_CHECK_EQ( strings::find( hay, needle, from ), hay.find( needle, from ) );
+                const auto byte = "ab,c"[ trial ];
+                T_CHECK_EQ( strings::find( hay, byte, from ), hay.find( byte, from ) );
+                T_CHECK_EQ( strings::startsWith( hay, needle ), hay.substr( 0, needle.size() ) == needle );
+
+                // Equal up to one changed byte
+                auto copy = hayBytes;
+                if ( len && trial )
+                    copy[ next( len ) ] ^= 1;
+                const std::string_view other { copy.data(), copy.size() };
+                T_CHECK_EQ( strings::equals( hay, other ), hay == other );
+            }
+            // A needle taken from the end of the text must be found there
+            if ( len )
+            {
+                const auto tail = hay.substr( len - 1 - next( len ) );
+                T_CHECK_EQ( strings::find( hay, tail ), hay.find( tail ) );
+            }
+
+            std::vector< std::string_view > expected;
+            size_t start = 0;
+            for ( size_t pos; ( pos = hay.find( ',', start ) ) != std::string_view::npos; start = pos + 1 )
+                expected.push_back( hay.substr( start, pos - start ) );
+            expected.push_back( hay.substr( start ) );
+            T_CHECK( strings::split( hay, ',' ) == expected );
+        }
+    }
+    strings::useTier( strings::bestTier() );
+}
+
+T_TEST( map_insert_find_erase )
+{
+    Map< std::string, int > map;
+    for ( int i = 0; i < 1000; i++ )
+        map.insert( std::to_string( i ), i );
+    T_CHECK_EQ( map.size(), size_t( 1000 ) );
+    T_CHECK( map.find( "500" ) && *map.find( "500" ) == 500 );
+    T_CHECK( map.erase( "500" ) );
+    T_CHECK( !map.find( "500" ) );
+    const FrozenMap< std::string, int > frozen { map };
+    T_CHECK( frozen.find( "999" ) && *frozen.find( "999" ) == 999 );
+    T_CHECK( !frozen.find( "500" ) );
+}
+
+T_TEST( format_placeholders )
+{
+    T_CHECK( format( "{} + {} = {}", 1, 2.5, std::string( "three" ) ).view() == "1 + 2.5 = three" );
+    T_CHECK_THROWS( format( "{}", 1, 2 ) );
+}
+
+T_TEST( json_round_trip )
+{
+    const std::string text = R"({"name":"café \"x\"","n":[1,-2.5e3,true,null],"o":{}})";
+    const json::Document doc { std::string_view( text ) };
+    const auto root = doc.root();
+    T_CHECK( root.isObject() );
+    T_CHECK( root[ "name" ].asString().view() == "caf\xC3\xA9 \"x\"" );
+    T_CHECK_EQ( root[ "n" ].size(), size_t( 4 ) );
+    T_CHECK_EQ( root[ "n" ][ 1 ].asDouble(), -2500.0 );
+    T_CHECK( root[ "n" ][ 3 ].isNull() );
+    T_CHECK( !root.find( "missing" ) );
+
+    json::Writer w;
+    w.value( root );
+    T_CHECK( w.finish().view() == text );
+    T_CHECK_THROWS( json::Document( std::string_view( "[1,]" ) ) );
+    T_CHECK_THROWS( json::Document( std::string_view( "{\"a\":1" ) ) );
+
+    // Escapes are checked when a string is copied, not only when it is read
+    const std::string escaped = R"(["a\n\u00e9\ud83d\ude00\/"])";
+    json::Writer copy;
+    copy.value( json::Document( std::string_view( escaped ) ).root() );
+    T_CHECK( copy.finish().view() == escaped );
+    for ( const std::string bad : { R"(["\q"])", "[\"\x01\"]", R"(["\ud83d"])", R"({"\x":1})" } )
+    {
+        const json::Document invalid { std::string_view( bad ) };
+        json::Writer out;
+        T_CHECK_THROWS( out.value( invalid.root() ) );
+    }
+}
+
+T_TEST( serial_record_round_trip )
+{
+    serial::Schema schema;
+    schema.name = "Person";
+    schema.fields = { { "name", serial::FieldKind::String, 0 }, { "age", serial::FieldKind::UInt8, 0 }, { "score", serial::FieldKind::Double, 0 } };
+    schema.layout();
+
+    serial::RecordWriter writer { schema };
+    const std::string record { writer.setString( 0, "Ada" ).set( 1, uint8_t( 36 ) ).set( 2, 9.5 ).finish() };
+    const serial::RecordView view { schema, record };
+    T_CHECK( view.getString( 0 ) == "Ada" );
+    T_CHECK_EQ( int( view.get< uint8_t >( 1 ) ), 36 );
+    T_CHECK_EQ( view.get< double >( 2 ), 9.5 );
+    T_CHECK_THROWS( view.get< int32_t >( 1 ) );
+    T_CHECK_THROWS( serial::RecordView( schema, std::string_view( record ).substr( 0, record.size() - 1 ) ) );
+}
+
+#if !defined( _WIN32 )
+namespace
+{
+    // Each finished read queues three more until 200 have been issued
+    void checkChainedReads( IoBackend& io, int fd )
+    {
+        constexpr size_t READS = 200;
+        std::vector< char > buffers( READS * 4 );
+        size_t issued = 0;
+        size_t finished = 0;
+        size_t bytes = 0;
+        std::function< void() > queue = [ & ]{
+            if ( issued == READS )
+                return;
+            const auto n = issued++;
+            io.read( fd, buffers.data() + n * 4, 4, n % 8, [ & ]( const IoResult& r ){
+                finished++;
+                bytes += r.bytes;
+                for ( int i = 0; i < 3; i++ )
+                    queue();
+            } );
+        };
+        queue();
+        drain( io );
+        T_CHECK_EQ( finished, READS );
+        T_CHECK_EQ( bytes, READS * 4 );
+        T_CHECK( std::string( buffers.data() + 4, 4 ) == "1234" );
+    }
+
+    void checkDestructorRunsCallbacks( std::unique_ptr< IoBackend > io, int fd )
+    {
+        char buffer[ 16 ];
+        size_t finished = 0;
+        for ( int i = 0; i < 4; i++ )
+            io->read( fd, buffer + i * 4, 4, 0, [ & ]( const IoResult& ){ finished++; } );
+        io->submit();
+        io.reset();
+        T_CHECK_EQ( finished, size_t( 4 ) );
+    }
+}
+
+T_TEST( async_reads_complete_on_every_backend )
+{
+    const char* path = "t_tests_async_io";
+    std::ofstream( path, std::ios::binary ) << "0123456789abcdef";
+    const int fd = ::open( path, O_RDONLY );
+    T_CHECK( fd >= 0 );
+
+    ThreadPoolIo threads { 2 };
+    checkChainedReads( threads, fd );
+    checkDestructorRunsCallbacks( std::make_unique< ThreadPoolIo >( 2 ), fd );
+
+#if T_RUNTIME_IO_URING
+    std::unique_ptr< UringIo > uring;
+    // Sandboxes may block io_uring, the thread backend is then all there is
+    try { uring = std::make_unique< UringIo >( 4 ); } catch ( const std::runtime_error& ) {}
+    if ( uring )
+    {
+        checkChainedReads( *uring, fd );
+        checkDestructorRunsCallbacks( std::move( uring ), fd );
+    }
+#endif
+
+    ::close( fd );
+    std::remove( path );
+}
+#endif
+
+namespace
+{
+    std::vector< std::string > fileLines( const std::string& contents )
+    {
+        const char* path = "t_tests_lines";
+        std::ofstream( path, std::ios::binary ) << contents;
+        std::vector< std::string > lines;
+        {
+            const MappedFile file { path };
+            for ( const auto& line : file.lines() )
+                lines.emplace_back( line.view() );
+        }
+        std::remove( path );
+        return lines;
+    }
+}
+
+T_TEST( mapped_file_lines_split_on_every_ending )
+{
+    using Lines = std::vector< std::string >;
+    const std::string wide( 63, 'x' );
+    for ( const auto tier : { strings::Scalar, strings::SSE42, strings::AVX2 } )
+    {
+        if ( ( tier == strings::SSE42 && !cpuFeatures().sse42 ) || ( tier == strings::AVX2 && !cpuFeatures().avx2 ) )
+            continue;
+        strings::useTier( tier );
+
+        T_CHECK( fileLines( "" ).empty() );
+        T_CHECK( fileLines( "\n" ) == Lines( { "" } ) );
+        T_CHECK( fileLines( "a\n\nb\n" ) == Lines( { "a", "", "b" } ) );
+        T_CHECK( fileLines( "last without newline" ) == Lines( { "last without newline" } ) );
+        T_CHECK( fileLines( "one\r\ntwo\r\n\r\nthree" ) == Lines( { "one", "two", "", "three" } ) );
+
+        // Newlines as the last byte of a block, the first of the next and a
+        // line spanning the whole of one, with and without a partial tail block
+        T_CHECK( fileLines( wide + "\n" + wide + "\n" ) == Lines( { wide, wide } ) );
+        T_CHECK( fileLines( wide + "x\n" + "y" ) == Lines( { wide + "x", "y" } ) );
+        T_CHECK( fileLines( "a\n" + wide + wide + "\r\nb" ) == Lines( { "a", wide + wide, "b" } ) );
+        T_CHECK( fileLines( wide + "\r\n" + std::string( 200, 'z' ) ) == Lines( { wide, std::string( 200, 'z' ) } ) );
+    }
+    strings::useTier( strings::bestTier() );
+}
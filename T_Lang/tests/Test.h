@@ -0,0 +1,66 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace test
+{
+    struct Case
+    {
+        std::string name;
+        void ( *run )();
+    };
+
+    inline std::vector< Case >& cases()
+    {
+        static std::vector< Case > list;
+        return list;
+    }
+
+    struct Register
+    {
+        Register( const char* name, void ( *run )() ) { cases().push_back( { name, run } ); }
+    };
+
+    // Failed checks of the case that is running
+    inline size_t& failures()
+    {
+        static size_t count = 0;
+        return count;
+    }
+
+    inline void fail( const char* file, int line, const std::string& message )
+    {
+        std::cout << "  " << file << ':' << line << ": " << message << '\n';
+        failures()++;
+    }
+}
+
+#define T_TEST( fn ) \
+    static void fn(); \
+    static const ::test::Register fn##_registration( #fn, fn ); \
+    static void fn()
+
+#define T_CHECK( cond ) \
+    do { if ( !( cond ) ) ::test::fail( __FILE__, __LINE__, "check failed: " #cond ); } while ( false )
+
+#define T_CHECK_EQ( lhs, rhs ) \
+    do { \
+        const auto& l_ = ( lhs ); \
+        const auto& r_ = ( rhs ); \
+        if ( !( l_ == r_ ) ) \
+        { \
+            std::ostringstream message_; \
+            message_ << #lhs " == " #rhs ": " << l_ << " != " << r_; \
+            ::test::fail( __FILE__, __LINE__, message_.str() ); \
+        } \
+    } while ( false )
+
+#define T_CHECK_THROWS( expr ) \
+    do { \
+        bool threw_ = false; \
+        try { ( void )( expr ); } catch ( const std::exception& ) { threw_ = true; } \
+        if ( !threw_ ) ::test::fail( __FILE__, __LINE__, "expected an exception: " #expr ); \
+    } while ( false )
@@ -0,0 +1,31 @@
+#include "Test.h"
+
+// Runs every registered test, or those whose name contains argv[1]. Exits
+// non-zero if any check failed or a test threw.
+int main( int argc, char** argv )
+{
+    const std::string filter = argc > 1 ? argv[ 1 ] : "";
+
+    size_t failed = 0, ran = 0;
+    for ( const auto& c : test::cases() )
+    {
+        if ( c.name.find( filter ) == std::string::npos )
+            continue;
+        ran++;
+        test::failures() = 0;
+        try
+        {
+            c.run();
+        }
+        catch ( const std::exception& e )
+        {
+            std::cout << "  threw: " << e.what() << '\n';
+            test::failures()++;
+        }
+        std::cout << ( test::failures() ? "FAIL " : "ok   " ) << c.name << '\n';
+        failed += test::failures() != 0;
+    }
+
+    std::cout << ran - failed << '/' << ran << " tests passed\n";
+    return failed ? 1 : 0;
+}
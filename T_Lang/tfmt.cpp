@@ -0,0 +1,139 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "t/Formatter.h"
+#include "t/ThreadPool.h"
+#include "t/runtime/File.h"
+
+// Usage: tfmt [-i | --check] [-j threads] [--indent spaces] [file or directory ...]
+// Formats T source. Directories are searched for .t files. Without -i the
+// result is written to stdout; with -i files are rewritten in place when
+// they change; with --check nothing is written and the files that would
+// change are listed, exiting with 1 if there are any. With no paths the
+// source is read from stdin. Files are read and formatted on -j threads,
+// 0 (the default) for one per core.
+int main( int c, char** argv )
+{
+    namespace fs = std::filesystem;
+
+    bool inPlace = false;
+    bool check = false;
+    size_t threads = 0;
+    t::format::Style style;
+    std::vector< std::string > paths;
+    for ( int arg = 1; arg < c; arg++ )
+    {
+        const std::string flag = argv[ arg ];
+        if ( flag == "-i" )
+            inPlace = true;
+        else if ( flag == "--check" )
+            check = true;
+        else if ( flag == "-j" && arg + 1 < c )
+            threads = std::stoul( argv[ ++arg ] );
+        else if ( flag == "--indent" && arg + 1 < c )
+            style.indentWidth = std::stoul( argv[ ++arg ] );
+        else if ( fs::is_directory( flag ) )
+        {
+            const auto start = paths.size();
+            for ( const auto& entry : fs::recursive_directory_iterator( flag ) )
+                if ( entry.is_regular_file() && entry.path().extension() == ".t" )
+                    paths.push_back( entry.path().string() );
+            std::sort( paths.begin() + start, paths.end() );
+        }
+        else
+            paths.push_back( flag );
+    }
+
+    if ( paths.empty() )
+    {
+        const std::string source { std::istreambuf_iterator< char >( std::cin ), std::istreambuf_iterator< char >() };
+        try
+        {
+            std::cout << t::format::formatSource( source, style );
+        }
+        catch ( const std::exception& e )
+        {
+            std::cerr << "tfmt: " << e.what() << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    struct File
+    {
+        std::string source;
+        t::TokenList tokens;
+        t::lexer::Trivia trivia;
+        std::string formatted;
+        std::string error;
+    };
+    std::vector< File > files( paths.size() );
+    t::ThreadPool pool { threads };
+
+    pool.parallelFor( files.size(), [ & ]( size_t n ){
+        try
+        {
+            files[ n ].source = std::string( t::runtime::MappedFile( paths[ n ] ).bytes() );
+        }
+        catch ( const std::exception& e )
+        {
+            files[ n ].error = e.what();
+        }
+    } );
+
+    // The lexer learns class names as it goes, so files are lexed one at a
+    // time and in order, each knowing the classes of those before it
+    std::set< std::string > classNames;
+    for ( auto& file : files )
+    {
+        if ( !file.error.empty() )
+            continue;
+        try
+        {
+            t::Lexer lexer { file.source, classNames };
+            file.tokens = lexer.tokenize( file.trivia );
+            classNames = lexer.getClassNames();
+            if ( file.tokens.empty() )
+                file.error = "source does not lex";
+        }
+        catch ( const std::exception& e )
+        {
+            file.error = e.what();
+        }
+    }
+
+    pool.parallelFor( files.size(), [ & ]( size_t n ){
+        auto& file = files[ n ];
+        if ( !file.error.empty() )
+            return;
+        file.formatted = t::format::Formatter( file.tokens, file.trivia, style ).run();
+        if ( inPlace && !check && file.formatted != file.source )
+        {
+            std::ofstream out( paths[ n ], std::ios::out | std::ios::binary );
+            out << file.formatted;
+            if ( !out )
+                file.error = "failed to write";
+        }
+    } );
+
+    int status = 0;
+    for ( size_t n = 0; n < files.size(); n++ )
+    {
+        const auto& file = files[ n ];
+        if ( !file.error.empty() )
+        {
+            std::cerr << "tfmt: " << paths[ n ] << ": " << file.error << '\n';
+            status = 1;
+        }
+        else if ( check && file.formatted != file.source )
+        {
+            std::cout << paths[ n ] << '\n';
+            status = 1;
+        }
+        else if ( !inPlace && !check )
+            std::cout << file.formatted;
+    }
+    return status;
+}